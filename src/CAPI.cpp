@@ -154,6 +154,7 @@ void getRange(const std::string& buf, bool bForwards, Dasher::EditDistance dist,
 #include <fstream>
 #include <locale.h>
 #include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <unordered_map>
@@ -165,30 +166,6 @@ static int lround_int(double v) {
     return (v - i >= 0.5) ? i + 1 : (v - i <= -0.5) ? i - 1 : i;
 }
 
-static int clamp_int(int v, int lo, int hi) {
-    if (v < lo) return lo;
-    if (v > hi) return hi;
-    return v;
-}
-
-static int32_t colorToARGB(const Dasher::ColorPalette::Color& c) {
-    int a = c.Alpha, r = c.Red, g = c.Green, b = c.Blue;
-
-    if (a >= 0 && a <= 1 && r >= 0 && r <= 1 && g >= 0 && g <= 1 && b >= 0 && b <= 1) {
-        a = a * 255;
-        r = r * 255;
-        g = g * 255;
-        b = b * 255;
-    }
-
-    a = clamp_int(a, 0, 255);
-    r = clamp_int(r, 0, 255);
-    g = clamp_int(g, 0, 255);
-    b = clamp_int(b, 0, 255);
-
-    return (a << 24) | (r << 16) | (g << 8) | b;
-}
-
 // ── Command-buffer screen ──────────────────────────────────────────────────
 
 class CommandScreen final : public Dasher::CDasherScreen {
@@ -198,52 +175,284 @@ class CommandScreen final : public Dasher::CDasherScreen {
 
     void SetSize(int width, int height) {
         resize(static_cast<Dasher::screenint>(width), static_cast<Dasher::screenint>(height));
+        m_bReset = true;
+        // Wrapped labels wrap to the screen width
+        InvalidateTextMetrics();
     }
 
     void BeginFrame() {
+        m_bEncoded = false;
         m_commands.clear();
         m_strings.clear();
         m_stringPtrs.clear();
+        m_pNode = nullptr;
+        m_bNodesRequested = false;
+        // Ids of labels deleted before the last frame began may be reused from this one
+        m_vFreeLabelIds.insert(m_vFreeLabelIds.end(), m_vRetiringLabelIds.begin(), m_vRetiringLabelIds.end());
+        m_vRetiringLabelIds.swap(m_vDeletedLabelIds);
+        m_vDeletedLabelIds.clear();
+        if (m_bDelta) {
+            m_iFrame++;
+            m_cmdIds.clear();
+            m_nodeOrdinals.clear();
+            m_iNullCommands = 0;
+            m_iNodeCommands = -1;
+        }
         push(0, 0, 0, 0, 0, static_cast<int32_t>(0xFF0D1117));
     }
 
-    void BuildStringPtrs() {
-        m_stringPtrs.resize(m_strings.size());
-        for (size_t i = 0; i < m_strings.size(); ++i)
-            m_stringPtrs[i] = m_strings[i].data();
+    // Finish the frame: in delta mode, work out the changes from the last one
+    void EndFrame() {
+        if (m_bDelta) BuildDelta();
+        const std::vector<std::string>& strings = m_bDelta ? m_deltaStrings : m_strings;
+        m_stringPtrs.resize(strings.size());
+        for (size_t i = 0; i < strings.size(); ++i)
+            m_stringPtrs[i] = const_cast<char*>(strings[i].data());
     }
 
-    const int32_t* GetCommands() const { return m_commands.data(); }
-    int GetCommandCount() const { return static_cast<int>(m_commands.size()); }
+    const int32_t* GetCommands() const { return m_bDelta ? m_delta.data() : m_commands.data(); }
+    int GetCommandCount() const { return static_cast<int>(m_bDelta ? m_delta.size() : m_commands.size()); }
     char* const* GetStringPtrs() const { return m_stringPtrs.data(); }
-    int GetStringCount() const { return static_cast<int>(m_strings.size()); }
+    int GetStringCount() const { return static_cast<int>(m_stringPtrs.size()); }
+
+    // The whole of the last frame, whether or not in delta mode
+    const int32_t* GetFullCommands() const { return m_bDelta ? m_prevCommands.data() : m_commands.data(); }
+    int GetFullCommandCount() const { return static_cast<int>(m_bDelta ? m_prevCommands.size() : m_commands.size()); }
+    char* const* GetFullStringPtrs() {
+        const std::vector<std::string>& strings = m_bDelta ? m_prevStrings : m_strings;
+        m_fullStringPtrs.resize(strings.size());
+        for (size_t i = 0; i < strings.size(); ++i)
+            m_fullStringPtrs[i] = const_cast<char*>(strings[i].data());
+        return m_fullStringPtrs.data();
+    }
+    int GetFullStringCount() const { return static_cast<int>(m_bDelta ? m_prevStrings.size() : m_strings.size()); }
+
+    // The whole of the last frame in the compact encoding (see dasher.h);
+    //  encoded when first asked for
+    const std::vector<uint8_t>& GetCompactFrame() {
+        if (!m_bEncoded) {
+            EncodeCompact(GetFullCommands(), GetFullCommandCount() / 6);
+            m_bEncoded = true;
+        }
+        return m_encoded;
+    }
+
+    // Delta frames: each frame gives only the changes to the commands of the last
+    void SetDeltaMode(bool bDelta) {
+        if (bDelta == m_bDelta) return;
+        m_bDelta = bDelta;
+        m_bReset = true;
+        m_bEncoded = false;
+        m_ids.clear();
+        m_idKeys.clear();
+        m_idFrames.clear();
+        m_prevIndex.clear();
+        m_freeIds.clear();
+        m_prevIds.clear();
+        m_prevCommands.clear();
+        m_prevStrings.clear();
+        m_iPrevNodeCommands = -1;
+    }
+    bool IsDeltaMode() const { return m_bDelta; }
+
+    // Make the next delta frame start again from scratch (with a reset op)
+    void RequestReset() { m_bReset = true; }
+
+    // Make the next frame redraw the nodes (a setting changed, which may change them)
+    void RequestNodes() { m_bNodesRequested = true; }
+
+    // Whether the next frame must redraw the nodes: asked to, or there are none
+    //  from the last frame to keep (or they must all be sent again)
+    bool NeedsNodes() const { return m_bNodesRequested || m_bReset || m_iPrevNodeCommands < 0; }
+
+    void SetDrawingNode(const Dasher::CDasherNode* pNode) override { m_pNode = pNode; }
+
+    void EndNodes(bool bRedrawn) override {
+        if (!m_bDelta) return;
+        if (!bRedrawn && m_iPrevNodeCommands >= 0) {
+            // Nothing moved: keep the node commands from the last frame (the
+            //  background clear is among them), and their ids and strings
+            m_commands.assign(m_prevCommands.begin(), m_prevCommands.begin() + m_iPrevNodeCommands * 6);
+            m_cmdIds.assign(m_prevIds.begin(), m_prevIds.begin() + m_iPrevNodeCommands);
+            m_strings.assign(m_prevStrings.begin(), m_prevStrings.begin() + m_iPrevNodeStrings);
+            for (int id : m_cmdIds)
+                m_idFrames[id] = m_iFrame;
+            m_nodeOrdinals.clear();
+            m_iNullCommands = m_iPrevNullOrdinal;
+            m_bNodesKept = true;
+        } else {
+            m_bNodesKept = false;
+        }
+        m_iNodeCommands = static_cast<int>(m_cmdIds.size());
+        m_iNodeStrings = static_cast<int>(m_strings.size());
+        m_iNullOrdinal = m_iNullCommands;
+    }
+
+    // ── Label table ─────────────────────────────────────────────────────────
+    // Every label made on this screen gets an id, its index in the table, for
+    // the life of the label. A deleted label's id is reused, so the table
+    // doesn't grow with every label ever made (e.g. the lock label, made again
+    // for each percent of training) - but only from the second frame after:
+    // until then, a text command from the frame it was deleted in, or the one
+    // a reader of the node arrays may still hold, means its text. The table
+    // changes only when labels are made or deleted; with label ids on, text
+    // commands give the id instead of copying the text into the strings array
+    // each frame.
+
+    class IdLabel : public Label {
+      public:
+        IdLabel(CommandScreen* pScreen, const std::string& strText, unsigned int iWrapSize)
+            : Label(strText, iWrapSize), m_pScreen(pScreen), m_iId(pScreen->NewLabelId()) {
+            m_pScreen->m_labels[m_iId] = this;
+            m_pScreen->m_iLabelVersion++;
+        }
+        ~IdLabel() {
+            m_pScreen->m_labels[m_iId] = nullptr;
+            m_pScreen->m_vDeletedLabelIds.push_back(m_iId);
+            m_pScreen->m_iLabelVersion++;
+        }
+
+        CommandScreen* const m_pScreen;
+        const int m_iId;
+
+        // Sizes measured by the frontend, by font size bucket
+        struct SMetrics {
+            unsigned int iBucket;
+            uint64_t iGeneration;
+            Dasher::screenint iWidth, iHeight;
+        };
+        std::vector<SMetrics> m_vMetrics;
+    };
+
+    Label* MakeLabel(const std::string& strText, unsigned int iWrapSize = 0) override {
+        return new IdLabel(this, strText, iWrapSize);
+    }
+
+    int GetLabelId(const Label* label) const override {
+        // All labels made on this screen are IdLabels
+        return label ? static_cast<const IdLabel*>(label)->m_iId : -1;
+    }
+
+    // Text commands give label ids (else indices into the strings of the frame)
+    void SetLabelIds(bool bLabelIds) {
+        if (bLabelIds == m_bLabelIds) return;
+        m_bLabelIds = bLabelIds;
+        // Commands kept from the last frame refer to their text the other way
+        m_bReset = true;
+    }
+
+    // The text of each label, by id (nullptr once deleted); rebuilt only when changed
+    char* const* GetLabelPtrs() {
+        if (m_iLabelPtrsVersion != m_iLabelVersion) {
+            m_labelPtrs.resize(m_labels.size());
+            for (size_t i = 0; i < m_labels.size(); ++i)
+                m_labelPtrs[i] = m_labels[i] ? const_cast<char*>(m_labels[i]->m_strText.c_str()) : nullptr;
+            m_iLabelPtrsVersion = m_iLabelVersion;
+        }
+        return m_labelPtrs.data();
+    }
+    int GetLabelCount() const { return static_cast<int>(m_labels.size()); }
+    uint64_t GetLabelVersion() const { return m_iLabelVersion; }
+
+    // An id for a new label: one free for reuse, else a new slot at the end of the table
+    int NewLabelId() {
+        if (m_vFreeLabelIds.empty()) {
+            m_labels.push_back(nullptr);
+            return static_cast<int>(m_labels.size()) - 1;
+        }
+        const int iId = m_vFreeLabelIds.back();
+        m_vFreeLabelIds.pop_back();
+        return iId;
+    }
+
+    // ── Text metrics ────────────────────────────────────────────────────────
+    // With a measuring callback, each label is measured once per font size
+    // bucket - eight per octave, so a label zooming through many sizes is
+    // measured at only a few - and the size scaled from the bucket's; the
+    // results are kept with the label until the fonts change (a new
+    // generation). Without one, sizes are estimated from the character count.
+
+    void SetTextMeasure(dasher_text_measure_callback callback, void* pUserData) {
+        m_measureCb = callback;
+        m_pMeasureUserData = pUserData;
+        InvalidateTextMetrics();
+    }
+
+    // Forget all sizes measured (the fonts changed)
+    void InvalidateTextMetrics() { m_iMetricsGeneration++; }
+
+    long long GetMetricsHits() const { return m_iMetricsHits; }
+    long long GetMetricsMisses() const { return m_iMetricsMisses; }
+
+    // The size a font size is measured at: itself below 16, else rounded down
+    //  to one of eight steps per octave (16, 18, 20, ... 30, 32, 36, ...)
+    static unsigned int FontSizeBucket(unsigned int iFontSize) {
+        if (iFontSize < 16) return iFontSize;
+        int iTop = 4;
+        while (iFontSize >> (iTop + 1))
+            iTop++;
+        return iFontSize & ~((1u << (iTop - 3)) - 1);
+    }
 
     std::pair<Dasher::screenint, Dasher::screenint> TextSize(Label* label, unsigned int iFontSize) override {
         if (!label) return std::make_pair(Dasher::screenint(0), Dasher::screenint(0));
-        return std::make_pair(static_cast<Dasher::screenint>(label->m_strText.size() * iFontSize / 2),
-                              static_cast<Dasher::screenint>(iFontSize));
+        if (!m_measureCb) {
+            // Half the font size per character (not byte: UTF-8 continuation bytes don't count)
+            size_t iChars = 0;
+            for (unsigned char c : label->m_strText)
+                iChars += (c & 0xC0) != 0x80;
+            return std::make_pair(static_cast<Dasher::screenint>(iChars * iFontSize / 2),
+                                  static_cast<Dasher::screenint>(iFontSize));
+        }
+        // All labels measured on this screen were made by it
+        IdLabel* pLabel = static_cast<IdLabel*>(label);
+        const unsigned int iBucket = FontSizeBucket(iFontSize);
+        IdLabel::SMetrics* pMetrics = nullptr;
+        for (IdLabel::SMetrics& metrics : pLabel->m_vMetrics)
+            if (metrics.iBucket == iBucket) pMetrics = &metrics;
+        if (pMetrics && pMetrics->iGeneration == m_iMetricsGeneration) {
+            m_iMetricsHits++;
+        } else {
+            m_iMetricsMisses++;
+            if (!pMetrics) {
+                pLabel->m_vMetrics.push_back({iBucket, 0, 0, 0});
+                pMetrics = &pLabel->m_vMetrics.back();
+            }
+            int iWidth = 0, iHeight = 0;
+            m_measureCb(label->m_strText.c_str(), static_cast<int>(iBucket), label->m_iWrapSize ? GetWidth() : 0,
+                        &iWidth, &iHeight, m_pMeasureUserData);
+            *pMetrics = {iBucket, m_iMetricsGeneration, std::max(iWidth, 0), std::max(iHeight, 0)};
+        }
+        if (iBucket == iFontSize || iBucket == 0) return std::make_pair(pMetrics->iWidth, pMetrics->iHeight);
+        return std::make_pair((pMetrics->iWidth * iFontSize + iBucket / 2) / iBucket,
+                              (pMetrics->iHeight * iFontSize + iBucket / 2) / iBucket);
     }
 
     void DrawString(Label* label, Dasher::screenint x, Dasher::screenint y, unsigned int iFontSize,
                     const Dasher::ColorPalette::Color& color) override {
         if (!label || label->m_strText.empty() || iFontSize == 0) return;
+        if (m_bLabelIds) {
+            // All labels drawn on this screen were made by it
+            push(5, x, y, static_cast<int>(iFontSize), static_cast<IdLabel*>(label)->m_iId, color.toARGB());
+            return;
+        }
         int idx = static_cast<int>(m_strings.size());
         m_strings.push_back(label->m_strText);
-        push(5, x, y, static_cast<int>(iFontSize), idx, colorToARGB(color));
+        push(5, x, y, static_cast<int>(iFontSize), idx, color.toARGB());
     }
 
     void DrawRectangle(Dasher::screenint x1, Dasher::screenint y1, Dasher::screenint x2, Dasher::screenint y2,
                        const Dasher::ColorPalette::Color& color, const Dasher::ColorPalette::Color& outlineColor,
                        int iThickness) override {
-        if (!color.isFullyTransparent()) push(4, x1, y1, x2, y2, colorToARGB(color));
-        if (iThickness > 0 && !outlineColor.isFullyTransparent()) push(3, x1, y1, x2, y2, colorToARGB(outlineColor));
+        if (!color.isFullyTransparent()) push(4, x1, y1, x2, y2, color.toARGB());
+        if (iThickness > 0 && !outlineColor.isFullyTransparent()) push(3, x1, y1, x2, y2, outlineColor.toARGB());
     }
 
     void DrawCircle(Dasher::screenint cx, Dasher::screenint cy, Dasher::screenint r,
                     const Dasher::ColorPalette::Color& fillColor, const Dasher::ColorPalette::Color& lineColor,
                     int iLineWidth) override {
-        if (!fillColor.isFullyTransparent()) push(1, cx, cy, r, 1, colorToARGB(fillColor));
-        if (iLineWidth > 0 && !lineColor.isFullyTransparent()) push(1, cx, cy, r, 0, colorToARGB(lineColor));
+        if (!fillColor.isFullyTransparent()) push(1, cx, cy, r, 1, fillColor.toARGB());
+        if (iLineWidth > 0 && !lineColor.isFullyTransparent()) push(1, cx, cy, r, 0, lineColor.toARGB());
     }
 
     void Polyline(Dasher::point* Points, int Number, int iWidth, const Dasher::ColorPalette::Color& color) override {
@@ -251,7 +460,7 @@ class CommandScreen final : public Dasher::CDasherScreen {
         // Opcode 6: set line width for subsequent line segments
         push(6, iWidth, 0, 0, 0, 0);
         for (int i = 1; i < Number; ++i)
-            push(2, Points[i - 1].x, Points[i - 1].y, Points[i].x, Points[i].y, colorToARGB(color));
+            push(2, Points[i - 1].x, Points[i - 1].y, Points[i].x, Points[i].y, color.toARGB());
     }
 
     void Polygon(Dasher::point* Points, int Number, const Dasher::ColorPalette::Color& fillColor,
@@ -259,13 +468,13 @@ class CommandScreen final : public Dasher::CDasherScreen {
         if (!Points || Number < 2) return;
         if (!fillColor.isFullyTransparent()) {
             for (int i = 1; i < Number; ++i)
-                push(2, Points[i - 1].x, Points[i - 1].y, Points[i].x, Points[i].y, colorToARGB(fillColor));
-            push(2, Points[Number - 1].x, Points[Number - 1].y, Points[0].x, Points[0].y, colorToARGB(fillColor));
+                push(2, Points[i - 1].x, Points[i - 1].y, Points[i].x, Points[i].y, fillColor.toARGB());
+            push(2, Points[Number - 1].x, Points[Number - 1].y, Points[0].x, Points[0].y, fillColor.toARGB());
         }
         if (lineWidth > 0 && !outlineColor.isFullyTransparent()) {
             for (int i = 1; i < Number; ++i)
-                push(2, Points[i - 1].x, Points[i - 1].y, Points[i].x, Points[i].y, colorToARGB(outlineColor));
-            push(2, Points[Number - 1].x, Points[Number - 1].y, Points[0].x, Points[0].y, colorToARGB(outlineColor));
+                push(2, Points[i - 1].x, Points[i - 1].y, Points[i].x, Points[i].y, outlineColor.toARGB());
+            push(2, Points[Number - 1].x, Points[Number - 1].y, Points[0].x, Points[0].y, outlineColor.toARGB());
         }
     }
 
@@ -282,8 +491,8 @@ class CommandScreen final : public Dasher::CDasherScreen {
         const int y1 = static_cast<int>(posY - sizeY / 2.0f);
         const int x2 = static_cast<int>(posX + sizeX / 2.0f);
         const int y2 = static_cast<int>(posY + sizeY / 2.0f);
-        if (!color.isFullyTransparent()) push(4, x1, y1, x2, y2, colorToARGB(color));
-        if (iThickness > 0 && !outlineColor.isFullyTransparent()) push(3, x1, y1, x2, y2, colorToARGB(outlineColor));
+        if (!color.isFullyTransparent()) push(4, x1, y1, x2, y2, color.toARGB());
+        if (iThickness > 0 && !outlineColor.isFullyTransparent()) push(3, x1, y1, x2, y2, outlineColor.toARGB());
     }
 
     void Draw3DLabel(Label* label, Dasher::screenint x, Dasher::screenint y, Dasher::screenint,
@@ -302,7 +511,7 @@ class CommandScreen final : public Dasher::CDasherScreen {
         const int y1 = static_cast<int>(posY - sizeY / 2);
         const int x2 = static_cast<int>(posX + sizeX / 2);
         const int y2 = static_cast<int>(posY + sizeY / 2);
-        if (!color.isFullyTransparent()) push(4, x1, y1, x2, y2, colorToARGB(color));
+        if (!color.isFullyTransparent()) push(4, x1, y1, x2, y2, color.toARGB());
     }
 
     void Display() override {}
@@ -318,11 +527,283 @@ class CommandScreen final : public Dasher::CDasherScreen {
         m_commands.push_back(c);
         m_commands.push_back(d);
         m_commands.push_back(colour);
+        if (m_bDelta) {
+            uint32_t& iOrdinal = m_pNode ? m_nodeOrdinals[m_pNode] : m_iNullCommands;
+            m_cmdIds.push_back(IdFor(m_pNode, iOrdinal++));
+        }
+    }
+
+    // ── Compact encoding ────────────────────────────────────────────────────
+    // Commands go in runs of up to 16 with the same opcode and colour, each
+    // run a tag byte (opcode, whether a colour index follows, run length),
+    // then the fields of each command as zigzag varints. Rectangles and lines
+    // give their far corner relative to the near one, so most fields take one
+    // or two bytes; colours are indices into a table of those used this frame.
+
+    static constexpr uint8_t COMPACT_VERSION = 1;
+    static constexpr int MAX_RUN = 16;
+
+    void putVarint(uint32_t v) {
+        while (v >= 0x80) {
+            m_encoded.push_back(static_cast<uint8_t>(v | 0x80));
+            v >>= 7;
+        }
+        m_encoded.push_back(static_cast<uint8_t>(v));
+    }
+    void putSigned(int32_t v) {
+        putVarint((static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31));
+    }
+
+    void EncodeCompact(const int32_t* pCmds, int iCount) {
+        m_encoded.clear();
+        m_encoded.push_back(COMPACT_VERSION);
+
+        // Colour table, in order of first use
+        m_colourIndex.clear();
+        m_colourTable.clear();
+        for (int i = 0; i < iCount; i++)
+            if (m_colourIndex.emplace(pCmds[i * 6 + 5], static_cast<uint32_t>(m_colourTable.size())).second)
+                m_colourTable.push_back(pCmds[i * 6 + 5]);
+        putVarint(static_cast<uint32_t>(m_colourTable.size()));
+        for (int32_t argb : m_colourTable)
+            for (int iShift = 0; iShift < 32; iShift += 8)
+                m_encoded.push_back(static_cast<uint8_t>(static_cast<uint32_t>(argb) >> iShift));
+
+        putVarint(static_cast<uint32_t>(iCount));
+        uint32_t iColour = UINT32_MAX;
+        for (int i = 0; i < iCount;) {
+            const int32_t* pRun = pCmds + i * 6;
+            int iRun = 1;
+            while (iRun < MAX_RUN && i + iRun < iCount && pRun[iRun * 6] == pRun[0] && pRun[iRun * 6 + 5] == pRun[5])
+                iRun++;
+            const uint32_t iRunColour = m_colourIndex[pRun[5]];
+            const bool bNewColour = iRunColour != iColour;
+            m_encoded.push_back(static_cast<uint8_t>(pRun[0] | (bNewColour ? 0x08 : 0) | ((iRun - 1) << 4)));
+            if (bNewColour) putVarint(iColour = iRunColour);
+            const bool bRelative = pRun[0] >= 2 && pRun[0] <= 4;
+            for (int j = 0; j < iRun; j++) {
+                const int32_t* p = pRun + j * 6;
+                putSigned(p[1]);
+                putSigned(p[2]);
+                putSigned(bRelative ? p[3] - p[1] : p[3]);
+                putSigned(bRelative ? p[4] - p[2] : p[4]);
+            }
+            i += iRun;
+        }
+    }
+
+    // ── Delta frames ────────────────────────────────────────────────────────
+    // A command's id is that of its key - the node it was drawn for, and its
+    // place among the commands drawn for that node - so stays the same from
+    // frame to frame while the node is drawn in the same way. Ids no longer
+    // drawn are recycled, and a reset numbers them afresh. The node pointers are never dereferenced: a node
+    // deleted and another made at the same address just updates its commands.
+
+    struct CommandKey {
+        const Dasher::CDasherNode* pNode;
+        uint32_t iOrdinal;
+        bool operator==(const CommandKey& other) const { return pNode == other.pNode && iOrdinal == other.iOrdinal; }
+    };
+    struct CommandKeyHash {
+        size_t operator()(const CommandKey& key) const {
+            return std::hash<const void*>()(key.pNode) ^ (static_cast<size_t>(key.iOrdinal) * 0x9e3779b97f4a7c15ULL);
+        }
+    };
+    static constexpr uint32_t NO_ORDINAL = UINT32_MAX;
+
+    int IdFor(const Dasher::CDasherNode* pNode, uint32_t iOrdinal) {
+        const CommandKey key = {pNode, iOrdinal};
+        auto it = m_ids.find(key);
+        if (it != m_ids.end() && m_idFrames[it->second] != m_iFrame) {
+            m_idFrames[it->second] = m_iFrame;
+            return it->second;
+        }
+        int id;
+        if (!m_freeIds.empty()) {
+            id = m_freeIds.back();
+            m_freeIds.pop_back();
+        } else {
+            id = static_cast<int>(m_idKeys.size());
+            m_idKeys.emplace_back();
+            m_idFrames.push_back(0);
+            m_prevIndex.push_back(-1);
+        }
+        m_idFrames[id] = m_iFrame;
+        if (it == m_ids.end()) {
+            m_ids.emplace(key, id);
+            m_idKeys[id] = key;
+        } else {
+            // Key already drawn this frame (a new node where one was kept): an id of its own
+            m_idKeys[id] = {nullptr, NO_ORDINAL};
+        }
+        return id;
+    }
+
+    bool SameCommand(size_t iPrev, size_t iCur) const {
+        const int32_t* pPrev = &m_prevCommands[iPrev * 6];
+        const int32_t* pCur = &m_commands[iCur * 6];
+        if (pCur[0] == 5 && !m_bLabelIds) {
+            return pPrev[0] == 5 && std::equal(pCur + 1, pCur + 4, pPrev + 1) && pPrev[5] == pCur[5] &&
+                   m_prevStrings[pPrev[4]] == m_strings[pCur[4]];
+        }
+        return std::equal(pCur, pCur + 6, pPrev);
+    }
+
+    // Append command iCur of this frame to the ops, its text (if any) to their strings
+    void pushCommand(size_t iCur) {
+        const int32_t* pCur = &m_commands[iCur * 6];
+        m_delta.insert(m_delta.end(), pCur, pCur + 6);
+        if (pCur[0] == 5 && !m_bLabelIds) {
+            m_delta.end()[-2] = static_cast<int32_t>(m_deltaStrings.size());
+            m_deltaStrings.push_back(m_strings[pCur[4]]);
+        }
+    }
+
+    // Append an insert (after prev) or update op for command iCur of this frame
+    void pushDelta(int op, int id, int prev, size_t iCur) {
+        m_delta.push_back(op);
+        m_delta.push_back(id);
+        if (op == 1) m_delta.push_back(prev);
+        pushCommand(iCur);
+    }
+
+    // Replace the ops with a reset giving the whole frame (see RenumberIds)
+    void pushReset(size_t iCount) {
+        m_delta.assign({0, static_cast<int32_t>(iCount)});
+        m_deltaStrings.clear();
+        for (size_t i = 0; i < iCount; i++)
+            pushCommand(i);
+    }
+
+    // After a reset, the commands of this frame have ids 0 to iCount - 1, in order
+    void RenumberIds(size_t iCount) {
+        std::vector<CommandKey> keys(iCount);
+        for (size_t i = 0; i < iCount; i++)
+            keys[i] = m_idKeys[m_cmdIds[i]];
+        m_idKeys.swap(keys);
+        m_ids.clear();
+        for (size_t i = 0; i < iCount; i++) {
+            if (m_idKeys[i].iOrdinal != NO_ORDINAL) m_ids.emplace(m_idKeys[i], static_cast<int>(i));
+            m_cmdIds[i] = static_cast<int>(i);
+        }
+        m_idFrames.assign(iCount, m_iFrame);
+        m_prevIndex.resize(iCount);
+        for (size_t i = 0; i < iCount; i++)
+            m_prevIndex[i] = static_cast<int>(i);
+        m_freeIds.clear();
+    }
+
+    void BuildDelta() {
+        m_delta.clear();
+        m_deltaStrings.clear();
+        const size_t iCount = m_cmdIds.size();
+        // Commands kept from the last frame are unchanged, and in the same order
+        const size_t iFrom = m_bNodesKept ? static_cast<size_t>(m_iNodeCommands) : 0;
+
+        // Surviving commands must be in the same order as last frame, or we start again
+        bool bReset = m_bReset;
+        int iLast = iFrom ? static_cast<int>(iFrom) - 1 : -1;
+        for (size_t i = iFrom; i < iCount && !bReset; i++) {
+            const int iPrev = m_prevIndex[m_cmdIds[i]];
+            if (iPrev < 0) continue;
+            if (iPrev <= iLast) bReset = true;
+            iLast = iPrev;
+        }
+
+        if (!bReset) {
+            for (size_t i = iFrom; i < m_prevIds.size(); i++)
+                if (m_idFrames[m_prevIds[i]] != m_iFrame) m_delta.insert(m_delta.end(), {3, m_prevIds[i]});
+            for (size_t i = iFrom; i < iCount; i++) {
+                const int iPrev = m_prevIndex[m_cmdIds[i]];
+                if (iPrev < 0)
+                    pushDelta(1, m_cmdIds[i], i ? m_cmdIds[i - 1] : -1, i);
+                else if (!SameCommand(iPrev, i))
+                    pushDelta(2, m_cmdIds[i], -1, i);
+            }
+            // Zooming changes most commands every frame: then a reset is smaller
+            //  (its strings are all the frame's, so no fewer than the ops')
+            bReset = m_delta.size() > 2 + 6 * iCount;
+        }
+        if (bReset) pushReset(iCount);
+
+        // Recycle the ids of commands no longer drawn, then this frame becomes the last
+        for (size_t i = iFrom; i < m_prevIds.size(); i++) {
+            const int id = m_prevIds[i];
+            m_prevIndex[id] = -1;
+            if (m_idFrames[id] == m_iFrame) continue;
+            if (m_idKeys[id].iOrdinal != NO_ORDINAL) m_ids.erase(m_idKeys[id]);
+            m_freeIds.push_back(id);
+        }
+        for (size_t i = iFrom; i < iCount; i++)
+            m_prevIndex[m_cmdIds[i]] = static_cast<int>(i);
+        if (bReset) RenumberIds(iCount);
+        m_prevIds.swap(m_cmdIds);
+        m_prevCommands.swap(m_commands);
+        m_prevStrings.swap(m_strings);
+        m_iPrevNodeCommands = m_iNodeCommands;
+        m_iPrevNodeStrings = m_iNodeStrings;
+        m_iPrevNullOrdinal = m_iNullOrdinal;
+        m_bNodesKept = false;
+        m_bReset = false;
     }
 
     std::vector<int32_t> m_commands;
     std::vector<std::string> m_strings;
     std::vector<char*> m_stringPtrs;
+    std::vector<char*> m_fullStringPtrs;
+
+    const Dasher::CDasherNode* m_pNode = nullptr;
+    bool m_bDelta = false;
+    bool m_bReset = true;
+    bool m_bNodesKept = false;
+    bool m_bNodesRequested = false;
+    uint64_t m_iFrame = 0;
+    // This frame: id of each command, and commands so far for each node
+    std::vector<int> m_cmdIds;
+    std::unordered_map<const Dasher::CDasherNode*, uint32_t> m_nodeOrdinals;
+    // ...and for no node (the background, decorations): not in the map, so frames
+    //  drawing only those make no heap allocations
+    uint32_t m_iNullCommands = 0;
+    // Commands and strings drawn for the nodes (before any decorations), -1 if not known
+    int m_iNodeCommands = -1, m_iNodeStrings = 0;
+    uint32_t m_iNullOrdinal = 0;
+    // Ids: of each key, and for each id its key, the last frame it was drawn in,
+    //  and its index in the last frame (-1 if not drawn)
+    std::unordered_map<CommandKey, int, CommandKeyHash> m_ids;
+    std::vector<CommandKey> m_idKeys;
+    std::vector<uint64_t> m_idFrames;
+    std::vector<int> m_prevIndex;
+    std::vector<int> m_freeIds;
+    // The last frame
+    std::vector<int> m_prevIds;
+    std::vector<int32_t> m_prevCommands;
+    std::vector<std::string> m_prevStrings;
+    int m_iPrevNodeCommands = -1, m_iPrevNodeStrings = 0;
+    uint32_t m_iPrevNullOrdinal = 0;
+    // Output: the ops, and the strings they use
+    std::vector<int32_t> m_delta;
+    std::vector<std::string> m_deltaStrings;
+
+    // The compact encoding of the last frame, and its colour table
+    bool m_bEncoded = false;
+    std::vector<uint8_t> m_encoded;
+    std::unordered_map<int32_t, uint32_t> m_colourIndex;
+    std::vector<int32_t> m_colourTable;
+
+    // Text measuring callback, and the generation of the sizes it gave
+    dasher_text_measure_callback m_measureCb = nullptr;
+    void* m_pMeasureUserData = nullptr;
+    uint64_t m_iMetricsGeneration = 1;
+    long long m_iMetricsHits = 0, m_iMetricsMisses = 0;
+
+    // Labels by id (nullptr once deleted), and their text for the C API
+    bool m_bLabelIds = false;
+    std::vector<IdLabel*> m_labels;
+    // Ids of deleted labels: since this frame began, since the last one began, and free for reuse
+    std::vector<int> m_vDeletedLabelIds, m_vRetiringLabelIds, m_vFreeLabelIds;
+    uint64_t m_iLabelVersion = 0;
+    std::vector<char*> m_labelPtrs;
+    uint64_t m_iLabelPtrsVersion = UINT64_MAX;
 };
 
 // ── Pointer input ─────────────────────────────────────────────────────────
@@ -367,6 +848,24 @@ static unsigned long nowMs() {
             .count());
 }
 
+// ── Localization ──────────────────────────────────────────────────────────
+
+// The translatable strings of a locale (from Strings/strings_<code>.json), and
+// the overrides set over them.
+struct LocaleStrings {
+    std::string code = "en";
+    std::unordered_map<std::string, std::string> strings;
+    std::unordered_map<std::string, std::string> overrides;
+
+    // The override for key, else the locale's string, else null
+    const std::string* find(const std::string& key) const {
+        auto it = overrides.find(key);
+        if (it != overrides.end()) return &it->second;
+        it = strings.find(key);
+        return it != strings.end() ? &it->second : nullptr;
+    }
+};
+
 // ── Session context ───────────────────────────────────────────────────────
 
 struct dasher_ctx {
@@ -393,6 +892,7 @@ struct dasher_ctx {
     std::string dataDir;
     std::string userDir;
     std::string stringBuf;
+    LocaleStrings locale; // set by dasher_set_locale / dasher_set_string_override
 
     // Buffers backing const char* returns from various getters. These
     // MUST live in dasher_ctx (not file-scope static) so that two
@@ -421,6 +921,8 @@ struct dasher_ctx {
     void* outputCbUserData = nullptr;
     dasher_message_callback messageCb = nullptr;
     void* messageCbUserData = nullptr;
+    dasher_text_measure_callback textMeasureCb = nullptr;
+    void* textMeasureCbUserData = nullptr;
     dasher_speak_callback speakCb = nullptr;
     void* speakCbUserData = nullptr;
     dasher_clipboard_callback clipboardCb = nullptr;
@@ -442,8 +944,13 @@ struct dasher_ctx {
     std::vector<CustomActionEntry> customActions;
 
     struct Interface : public Dasher::CDashIntfScreenMsgs {
-        Interface(Dasher::CSettingsStore* s, dasher_ctx* owner) : CDashIntfScreenMsgs(s), m_owner(owner) {
+        Interface(Dasher::CSettingsStore* s, const Dasher::FileUtils& fileUtils, dasher_ctx* owner)
+            : CDashIntfScreenMsgs(s, fileUtils), m_owner(owner) {
             s->OnParameterChanged.Subscribe(m_owner, [this](Dasher::Parameter param) {
+                if (m_owner->screen) {
+                    m_owner->screen->RequestNodes();
+                    if (param == Dasher::SP_DASHER_FONT) m_owner->screen->InvalidateTextMetrics();
+                }
                 if (m_owner->paramCb) m_owner->paramCb(static_cast<int>(param), m_owner->paramCbUserData);
             });
         }
@@ -731,10 +1238,18 @@ void ensureAppearanceInitialised(dasher_ctx* ctx) {
 
 extern "C" {
 
-static std::string s_errorString;
-static std::string s_localeCode = "en";
-static std::unordered_map<std::string, std::string> s_localeStrings;
-static std::unordered_map<std::string, std::string> s_overrideStrings;
+// (per thread, so contexts can be created on several at once; valid until the next failure on the same)
+static thread_local std::string s_errorString;
+// What dasher_get_parameter_info, taking no context, localizes with: a copy of the
+//  locale and overrides of whichever context last changed its own. Guarded, as
+//  contexts on any thread may replace it.
+static std::mutex s_defaultLocaleMutex;
+static LocaleStrings s_defaultLocale;
+
+static void publishDefaultLocale(const dasher_ctx* ctx) {
+    std::lock_guard<std::mutex> lock(s_defaultLocaleMutex);
+    s_defaultLocale = ctx->locale;
+}
 
 DASHER_API dasher_ctx* dasher_create(const char* data_dir, const char* user_dir, char** out_error) {
     if (out_error) *out_error = nullptr;
@@ -757,8 +1272,9 @@ DASHER_API dasher_ctx* dasher_create(const char* data_dir, const char* user_dir,
     // user-writable directory (logs, training deltas, settings)
     // distinct so we never leak library files into CWD. Closes the
     // dasher.log and training_english_GB.txt CWD leaks (Tier 1 #5).
-    Dasher::FileUtils::SetDataDirectory(dir);
-    Dasher::FileUtils::SetUserDataDirectory(writableDir);
+    // Each context has its own, so contexts for different users can
+    // run side by side.
+    const Dasher::FileUtils fileUtils(dir, writableDir);
 
     std::string settingsPath = writableDir;
 #ifdef _WIN32
@@ -770,7 +1286,7 @@ DASHER_API dasher_ctx* dasher_create(const char* data_dir, const char* user_dir,
     try {
         ctx->settings = std::make_unique<Dasher::XmlSettingsStore>(settingsPath, nullptr);
         ctx->settings->Load();
-        ctx->intf = new dasher_ctx::Interface(ctx->settings.get(), ctx);
+        ctx->intf = new dasher_ctx::Interface(ctx->settings.get(), fileUtils, ctx);
     } catch (const std::exception& e) {
         s_errorString = std::string("Failed to create Dasher session: ") + e.what();
         if (out_error) *out_error = s_errorString.data();
@@ -809,6 +1325,7 @@ DASHER_API void dasher_set_screen_size(dasher_ctx* ctx, int width, int height) {
 
     if (!ctx->screen) {
         ctx->screen = std::make_unique<CommandScreen>(width, height);
+        ctx->screen->SetTextMeasure(ctx->textMeasureCb, ctx->textMeasureCbUserData);
         ctx->intf->ChangeScreen(ctx->screen.get());
     } else {
         ctx->screen->SetSize(width, height);
@@ -918,9 +1435,12 @@ DASHER_API void dasher_frame(dasher_ctx* ctx, int64_t time_ms, int** out_command
     if (ctx->engineError) return;
 
     try {
+        // Delta frames leave it to the engine whether the nodes need redrawing
+        //  (unless there are none to keep); full frames always redraw them
+        const bool bRedraw = !ctx->screen->IsDeltaMode() || ctx->screen->NeedsNodes();
         ctx->screen->BeginFrame();
-        ctx->intf->NewFrame(static_cast<unsigned long>((time_ms > 0) ? time_ms : 0), true);
-        ctx->screen->BuildStringPtrs();
+        ctx->intf->NewFrame(static_cast<unsigned long>((time_ms > 0) ? time_ms : 0), bRedraw);
+        ctx->screen->EndFrame();
 
         if (out_commands) *out_commands = const_cast<int*>(reinterpret_cast<const int*>(ctx->screen->GetCommands()));
         if (out_command_count) *out_command_count = ctx->screen->GetCommandCount();
@@ -939,6 +1459,45 @@ DASHER_API int dasher_has_engine_error(dasher_ctx* ctx) {
     return (ctx && ctx->engineError) ? 1 : 0;
 }
 
+DASHER_API int dasher_set_delta_frames_enabled(dasher_ctx* ctx, int enabled) {
+    if (!ctx || !ctx->screen || !ctx->realized) return -1;
+    ctx->screen->SetDeltaMode(enabled != 0);
+    return 0;
+}
+
+DASHER_API int dasher_get_full_frame(dasher_ctx* ctx, int** out_commands, int* out_command_count, char*** out_strings,
+                                     int* out_string_count) {
+    if (!ctx || !ctx->screen || !ctx->realized) return -1;
+    if (out_commands) *out_commands = const_cast<int*>(reinterpret_cast<const int*>(ctx->screen->GetFullCommands()));
+    if (out_command_count) *out_command_count = ctx->screen->GetFullCommandCount();
+    if (out_strings) *out_strings = const_cast<char**>(ctx->screen->GetFullStringPtrs());
+    if (out_string_count) *out_string_count = ctx->screen->GetFullStringCount();
+    return 0;
+}
+
+DASHER_API int dasher_get_encoded_frame(dasher_ctx* ctx, int encoding, const uint8_t** out_bytes,
+                                        int* out_byte_count) {
+    if (!ctx || !ctx->screen || !ctx->realized || encoding != 1) return -1;
+    const std::vector<uint8_t>& encoded = ctx->screen->GetCompactFrame();
+    if (out_bytes) *out_bytes = encoded.data();
+    if (out_byte_count) *out_byte_count = static_cast<int>(encoded.size());
+    return 0;
+}
+
+DASHER_API int dasher_set_label_ids_enabled(dasher_ctx* ctx, int enabled) {
+    if (!ctx || !ctx->screen || !ctx->realized) return -1;
+    ctx->screen->SetLabelIds(enabled != 0);
+    ctx->screen->RequestNodes();
+    return 0;
+}
+
+DASHER_API long long dasher_get_label_table(dasher_ctx* ctx, char*** out_labels, int* out_label_count) {
+    if (!ctx || !ctx->screen || !ctx->realized) return -1;
+    if (out_labels) *out_labels = const_cast<char**>(ctx->screen->GetLabelPtrs());
+    if (out_label_count) *out_label_count = ctx->screen->GetLabelCount();
+    return static_cast<long long>(ctx->screen->GetLabelVersion());
+}
+
 DASHER_API const char* dasher_get_output_text(dasher_ctx* ctx) {
     if (!ctx) return "";
     ctx->tlString = ctx->editBuffer;
@@ -1002,20 +1561,17 @@ DASHER_API int dasher_get_language_model_id_at(int index) {
     return all[index].id;
 }
 
+// (the registry is not changed once contexts exist, so its strings can be returned as they are)
 DASHER_API const char* dasher_get_language_model_name(int id) {
-    static std::string s_buf;
     auto* desc = Dasher::LMRegistry::instance().get(id);
     if (!desc) return "Unknown";
-    s_buf = desc->name;
-    return s_buf.c_str();
+    return desc->name.c_str();
 }
 
 DASHER_API const char* dasher_get_language_model_description(int id) {
-    static std::string s_buf;
     auto* desc = Dasher::LMRegistry::instance().get(id);
     if (!desc) return "";
-    s_buf = desc->description;
-    return s_buf.c_str();
+    return desc->description.c_str();
 }
 
 DASHER_API int dasher_get_language_model_param_count(int id) {
@@ -1172,20 +1728,23 @@ DASHER_API int dasher_color_get_blue(int argb) {
 
 // ── Static schema data ────────────────────────────────────────────────────
 
-static std::vector<Dasher::Parameter> s_paramKeys;
-static std::string s_paramInfoName;
-static std::string s_paramInfoDesc;
-static std::string s_paramInfoGroup;
-static std::string s_paramInfoSubgroup;
-static std::vector<std::string> s_enumStrings;
-static std::vector<std::pair<std::string, int>> s_enumEntries;
-
-static void ensureParamKeys() {
-    if (!s_paramKeys.empty()) return;
-    for (const auto& [key, val] : Dasher::Settings::parameter_defaults) {
-        s_paramKeys.push_back(key);
-    }
-    std::sort(s_paramKeys.begin(), s_paramKeys.end());
+// (the strings last returned by dasher_get_parameter_info, per thread)
+static thread_local std::string s_paramInfoName;
+static thread_local std::string s_paramInfoDesc;
+static thread_local std::string s_paramInfoGroup;
+static thread_local std::string s_paramInfoSubgroup;
+
+static const std::vector<Dasher::Parameter>& paramKeys() {
+    // (built on first use, by whichever thread gets there first)
+    static const std::vector<Dasher::Parameter> keys = [] {
+        std::vector<Dasher::Parameter> sorted;
+        for (const auto& [key, val] : Dasher::Settings::parameter_defaults) {
+            sorted.push_back(key);
+        }
+        std::sort(sorted.begin(), sorted.end());
+        return sorted;
+    }();
+    return keys;
 }
 
 DASHER_API int dasher_get_parameter_count(void) {
@@ -1194,42 +1753,24 @@ DASHER_API int dasher_get_parameter_count(void) {
 
 DASHER_API int dasher_get_parameter_info(int index, dasher_parameter_info* out) {
     if (!out) return -1;
-    ensureParamKeys();
-    if (index < 0 || index >= static_cast<int>(s_paramKeys.size())) return -1;
+    const auto& keys = paramKeys();
+    if (index < 0 || index >= static_cast<int>(keys.size())) return -1;
 
-    auto key = s_paramKeys[index];
+    auto key = keys[index];
     auto it = Dasher::Settings::parameter_defaults.find(key);
     if (it == Dasher::Settings::parameter_defaults.end()) return -1;
 
     const auto& val = it->second;
     out->key = static_cast<int>(key);
 
-    std::string nameKey = val.enumKeyName + ".label";
-    auto nameIt = s_overrideStrings.find(nameKey);
-    if (nameIt != s_overrideStrings.end()) {
-        s_paramInfoName = nameIt->second;
-    } else {
-        nameIt = s_localeStrings.find(nameKey);
-        if (nameIt != s_localeStrings.end()) {
-            s_paramInfoName = nameIt->second;
-        } else {
-            s_paramInfoName = val.humanName.empty() ? val.storageName : val.humanName;
-        }
+    {
+        std::lock_guard<std::mutex> lock(s_defaultLocaleMutex);
+        const std::string* name = s_defaultLocale.find(val.enumKeyName + ".label");
+        s_paramInfoName = name ? *name : (val.humanName.empty() ? val.storageName : val.humanName);
+        const std::string* desc = s_defaultLocale.find(val.enumKeyName + ".description");
+        s_paramInfoDesc = desc ? *desc : val.humanDescription;
     }
     out->name = s_paramInfoName.c_str();
-
-    std::string descKey = val.enumKeyName + ".description";
-    auto descIt = s_overrideStrings.find(descKey);
-    if (descIt != s_overrideStrings.end()) {
-        s_paramInfoDesc = descIt->second;
-    } else {
-        descIt = s_localeStrings.find(descKey);
-        if (descIt != s_localeStrings.end()) {
-            s_paramInfoDesc = descIt->second;
-        } else {
-            s_paramInfoDesc = val.humanDescription;
-        }
-    }
     out->desc = s_paramInfoDesc.c_str();
     out->type = static_cast<int>(val.type);
     out->ui_type = static_cast<int>(val.suggestedUI);
@@ -1255,10 +1796,8 @@ DASHER_API const char* dasher_get_parameter_enum_name(int key, int index) {
     if (it == Dasher::Settings::parameter_defaults.end()) return "";
     int i = 0;
     for (const auto& [name, value] : it->second.possibleValues) {
-        if (i == index) {
-            s_enumStrings.push_back(name);
-            return s_enumStrings.back().c_str();
-        }
+        // (parameter_defaults is constant, so its names can be returned as they are)
+        if (i == index) return name.c_str();
         i++;
     }
     return "";
@@ -1324,7 +1863,7 @@ DASHER_API int dasher_get_palette_preview_colors(dasher_ctx* ctx, int index, int
     if (!palette) return -1;
     const auto& preview = palette->GetUIPreviewColors();
     for (int i = 0; i < 4; i++) {
-        out_colors[i] = colorToARGB(preview[i]);
+        out_colors[i] = preview[i].toARGB();
     }
     return 0;
 }
@@ -1565,6 +2104,10 @@ DASHER_API void dasher_reset_settings(dasher_ctx* ctx) {
     }
 }
 
+DASHER_API void dasher_invalidate_file_index(void) {
+    Dasher::FileUtils::InvalidateFileIndex();
+}
+
 // ── Localization ──────────────────────────────────────────────────────────
 
 static std::unordered_map<std::string, std::string> parseStringsJson(const std::string& content) {
@@ -1633,8 +2176,9 @@ DASHER_API int dasher_set_locale(dasher_ctx* ctx, const char* locale) {
     if (!ctx) return -1;
 
     if (!locale || std::string(locale) == "en" || std::string(locale) == "") {
-        s_localeCode = "en";
-        s_localeStrings.clear();
+        ctx->locale.code = "en";
+        ctx->locale.strings.clear();
+        publishDefaultLocale(ctx);
         return 0;
     }
 
@@ -1652,39 +2196,34 @@ DASHER_API int dasher_set_locale(dasher_ctx* ctx, const char* locale) {
 
     std::stringstream ss;
     ss << file.rdbuf();
-    s_localeStrings = parseStringsJson(ss.str());
-    s_localeCode = localeStr;
+    ctx->locale.strings = parseStringsJson(ss.str());
+    ctx->locale.code = localeStr;
+    publishDefaultLocale(ctx);
     return 0;
 }
 
 DASHER_API const char* dasher_get_locale(dasher_ctx* ctx) {
     if (!ctx) return "en";
-    ctx->stringBuf = s_localeCode;
+    ctx->stringBuf = ctx->locale.code;
     return ctx->stringBuf.c_str();
 }
 
 DASHER_API void dasher_set_string_override(dasher_ctx* ctx, const char* key, const char* value) {
     if (!ctx || !key) return;
     if (value) {
-        s_overrideStrings[key] = value;
+        ctx->locale.overrides[key] = value;
     } else {
-        s_overrideStrings.erase(key);
+        ctx->locale.overrides.erase(key);
     }
+    publishDefaultLocale(ctx);
 }
 
 DASHER_API const char* dasher_get_localized_string(dasher_ctx* ctx, const char* key) {
     if (!ctx || !key) return nullptr;
-    auto it = s_overrideStrings.find(key);
-    if (it != s_overrideStrings.end()) {
-        ctx->stringBuf = it->second;
-        return ctx->stringBuf.c_str();
-    }
-    it = s_localeStrings.find(key);
-    if (it != s_localeStrings.end()) {
-        ctx->stringBuf = it->second;
-        return ctx->stringBuf.c_str();
-    }
-    return nullptr;
+    const std::string* value = ctx->locale.find(key);
+    if (!value) return nullptr;
+    ctx->stringBuf = *value;
+    return ctx->stringBuf.c_str();
 }
 
 DASHER_API void dasher_set_output_callback(dasher_ctx* ctx, dasher_output_callback callback, void* user_data) {
@@ -1712,6 +2251,45 @@ DASHER_API void dasher_set_speak_callback(dasher_ctx* ctx, dasher_speak_callback
     ctx->speakCbUserData = user_data;
 }
 
+DASHER_API void dasher_set_text_measure_callback(dasher_ctx* ctx, dasher_text_measure_callback callback,
+                                                 void* user_data) {
+    if (!ctx) return;
+    ctx->textMeasureCb = callback;
+    ctx->textMeasureCbUserData = user_data;
+    if (ctx->screen) {
+        ctx->screen->SetTextMeasure(callback, user_data);
+        ctx->screen->RequestNodes();
+    }
+}
+
+DASHER_API void dasher_invalidate_text_metrics(dasher_ctx* ctx) {
+    if (!ctx || !ctx->screen) return;
+    ctx->screen->InvalidateTextMetrics();
+    ctx->screen->RequestNodes();
+}
+
+DASHER_API int dasher_get_text_metrics_stats(dasher_ctx* ctx, long long* out_hits, long long* out_misses) {
+    if (!ctx || !ctx->screen) return -1;
+    if (out_hits) *out_hits = ctx->screen->GetMetricsHits();
+    if (out_misses) *out_misses = ctx->screen->GetMetricsMisses();
+    return 0;
+}
+
+DASHER_API int dasher_get_render_stats(dasher_ctx* ctx, int* out_visited, int* out_drawn, int* out_skipped) {
+    if (!ctx || !ctx->intf || !ctx->realized) return -1;
+    try {
+        auto* view = ctx->intf->GetView();
+        if (!view) return -1;
+        const auto stats = view->GetRenderStats();
+        if (out_visited) *out_visited = stats.iVisited;
+        if (out_drawn) *out_drawn = stats.iDrawn;
+        if (out_skipped) *out_skipped = stats.iSkipped;
+        return 0;
+    } catch (...) {
+        return -1;
+    }
+}
+
 DASHER_API void dasher_set_clipboard_callback(dasher_ctx* ctx, dasher_clipboard_callback callback, void* user_data) {
     if (!ctx) return;
     ctx->clipboardCb = callback;
@@ -1850,6 +2428,68 @@ DASHER_API int dasher_import_training_text(dasher_ctx* ctx, const char* text) {
     }
 }
 
+DASHER_API int dasher_get_training_progress(dasher_ctx* ctx) {
+    if (!ctx || !ctx->intf || !ctx->realized) return -1;
+    return ctx->intf->GetTrainingProgress();
+}
+
+DASHER_API int dasher_get_prob_cache_stats(dasher_ctx* ctx, long long* out_hits, long long* out_misses) {
+    if (!ctx || !ctx->intf || !ctx->realized) return -1;
+    uint64_t iHits, iMisses;
+    if (!ctx->intf->GetProbCacheStats(iHits, iMisses)) return -1;
+    if (out_hits) *out_hits = static_cast<long long>(iHits);
+    if (out_misses) *out_misses = static_cast<long long>(iMisses);
+    return 0;
+}
+
+DASHER_API int dasher_get_node_pool_stats(dasher_ctx* ctx, long long* out_live, long long* out_free,
+                                          long long* out_allocated, long long* out_freed) {
+    if (!ctx || !ctx->intf || !ctx->realized) return -1;
+    uint64_t iLive, iFree, iAllocated, iFreed;
+    if (!ctx->intf->GetNodePoolStats(iLive, iFree, iAllocated, iFreed)) return -1;
+    if (out_live) *out_live = static_cast<long long>(iLive);
+    if (out_free) *out_free = static_cast<long long>(iFree);
+    if (out_allocated) *out_allocated = static_cast<long long>(iAllocated);
+    if (out_freed) *out_freed = static_cast<long long>(iFreed);
+    return 0;
+}
+
+DASHER_API int dasher_get_subtree_cache_stats(dasher_ctx* ctx, long long* out_hits, long long* out_misses,
+                                              long long* out_evicted, long long* out_bytes) {
+    if (!ctx || !ctx->intf || !ctx->realized) return -1;
+    uint64_t iHits, iMisses, iEvicted, iBytes;
+    if (!ctx->intf->GetSubtreeCacheStats(iHits, iMisses, iEvicted, iBytes)) return -1;
+    if (out_hits) *out_hits = static_cast<long long>(iHits);
+    if (out_misses) *out_misses = static_cast<long long>(iMisses);
+    if (out_evicted) *out_evicted = static_cast<long long>(iEvicted);
+    if (out_bytes) *out_bytes = static_cast<long long>(iBytes);
+    return 0;
+}
+
+DASHER_API int dasher_get_expansion_time_stats(dasher_ctx* ctx, long long* out_expanded,
+                                               long long* out_microseconds) {
+    if (!ctx || !ctx->intf || !ctx->realized) return -1;
+    uint64_t iExpanded, iMicroseconds;
+    ctx->intf->GetExpansionTimeStats(iExpanded, iMicroseconds);
+    if (out_expanded) *out_expanded = static_cast<long long>(iExpanded);
+    if (out_microseconds) *out_microseconds = static_cast<long long>(iMicroseconds);
+    return 0;
+}
+
+DASHER_API int dasher_get_lookahead_stats(dasher_ctx* ctx, long long* out_forced, long long* out_ahead) {
+    if (!ctx || !ctx->intf || !ctx->realized) return -1;
+    uint64_t iForced, iAhead;
+    ctx->intf->GetLookaheadStats(iForced, iAhead);
+    if (out_forced) *out_forced = static_cast<long long>(iForced);
+    if (out_ahead) *out_ahead = static_cast<long long>(iAhead);
+    return 0;
+}
+
+DASHER_API long long dasher_get_settings_lookup_count(dasher_ctx* ctx) {
+    if (!ctx || !ctx->settings) return -1;
+    return ctx->settings->GetLookupCount();
+}
+
 DASHER_API int dasher_get_offset(dasher_ctx* ctx) {
     if (!ctx || !ctx->intf || !ctx->realized) return -1;
     auto* model = ctx->intf->GetModel();
@@ -1919,8 +2559,8 @@ DASHER_API int dasher_get_visible_nodes(dasher_ctx* ctx, dasher_node_info* out_n
             out.screen_y1 = n.screen_y1;
             out.screen_x2 = n.screen_x2;
             out.screen_y2 = n.screen_y2;
-            out.fill_argb = colorToARGB(n.fill);
-            out.outline_argb = colorToARGB(n.outline);
+            out.fill_argb = n.fill.toARGB();
+            out.outline_argb = n.outline.toARGB();
             if (!n.label.empty()) {
                 ctx->nodeLabelStrings.push_back(n.label);
                 out.label_index = static_cast<int>(ctx->nodeLabelStrings.size() - 1);
@@ -1967,6 +2607,58 @@ DASHER_API int dasher_get_viewport(dasher_ctx* ctx, dasher_viewport* out) {
     }
 }
 
+DASHER_API int dasher_set_visible_node_arrays_enabled(dasher_ctx* ctx, int enabled) {
+    if (!ctx || !ctx->intf || !ctx->realized) return -1;
+    auto* view = ctx->intf->GetView();
+    if (!view) return -1;
+    view->SetVisibleNodeArraysCapture(enabled != 0);
+    return 0;
+}
+
+// (may be called from another thread than dasher_frame(): the view lives as long as the
+//  context, and the arrays are guarded by their own mutex)
+DASHER_API int dasher_acquire_visible_node_arrays(dasher_ctx* ctx, dasher_node_arrays* out) {
+    if (!ctx || !ctx->intf || !ctx->realized || !out) return -1;
+    if (out->struct_size < static_cast<int>(sizeof(dasher_node_arrays))) return -1;
+    auto* view = ctx->intf->GetView();
+    Dasher::CVisibleNodeArrays* pBuffer = view ? view->GetVisibleNodeArrays() : nullptr;
+    const Dasher::SVisibleNodeArrays* pArrays = pBuffer ? pBuffer->Acquire() : nullptr;
+    if (!pArrays) return -1;
+    out->struct_size = static_cast<int>(sizeof(dasher_node_arrays));
+    out->count = static_cast<int>(pArrays->size());
+    out->frame = static_cast<long long>(pArrays->iFrame);
+    out->dasher_y1 = pArrays->vY1.data();
+    out->dasher_y2 = pArrays->vY2.data();
+    out->depth = pArrays->vDepth.data();
+    out->screen_x1 = pArrays->vScreenX1.data();
+    out->screen_y1 = pArrays->vScreenY1.data();
+    out->screen_x2 = pArrays->vScreenX2.data();
+    out->screen_y2 = pArrays->vScreenY2.data();
+    out->fill_argb = pArrays->vFill.data();
+    out->outline_argb = pArrays->vOutline.data();
+    out->symbol = pArrays->vSymbol.data();
+    out->flags = pArrays->vFlags.data();
+    out->label_id = pArrays->vLabelId.data();
+    return out->count;
+}
+
+DASHER_API int dasher_release_visible_node_arrays(dasher_ctx* ctx) {
+    if (!ctx || !ctx->intf || !ctx->realized) return -1;
+    auto* view = ctx->intf->GetView();
+    Dasher::CVisibleNodeArrays* pBuffer = view ? view->GetVisibleNodeArrays() : nullptr;
+    return pBuffer && pBuffer->Release() ? 0 : -1;
+}
+
+DASHER_API int dasher_get_visible_node_arrays_stats(dasher_ctx* ctx, long long* out_frames, long long* out_dropped) {
+    if (!ctx || !ctx->intf || !ctx->realized) return -1;
+    auto* view = ctx->intf->GetView();
+    Dasher::CVisibleNodeArrays* pBuffer = view ? view->GetVisibleNodeArrays() : nullptr;
+    if (!pBuffer) return -1;
+    if (out_frames) *out_frames = static_cast<long long>(pBuffer->GetFrameCount());
+    if (out_dropped) *out_dropped = static_cast<long long>(pBuffer->GetDroppedCount());
+    return 0;
+}
+
 // ── Custom actions ─────────────────────────────────────────────────────────
 
 DASHER_API void dasher_register_action(dasher_ctx* ctx, const char* name, dasher_action_callback callback,
@@ -20,10 +20,14 @@
 
 #include "AlphIO.h"
 #include "DasherCore/ControlManager.h"
+#include "DasherCore/FileUtils.h"
+#include "DasherCore/Common/TempFile.h"
 
 #include <string>
 #include <cstring>
 #include <algorithm>
+#include <filesystem>
+#include <fstream>
 #include <sstream>
 
 using namespace Dasher;
@@ -235,24 +239,214 @@ bool Dasher::CAlphIO::Parse(pugi::xml_document& document, const std::string, boo
     return true;
 }
 
+namespace {
+
+// Records the files ScanFiles finds, without opening them
+class CFileLister : public AbstractParser {
+  public:
+    CFileLister() : AbstractParser(nullptr) {}
+    bool ParseFile(const std::string& strPath, bool bUser) override {
+        m_vFiles.emplace_back(strPath, bUser);
+        return true;
+    }
+    bool Parse(const std::string&, std::istream&, bool) override { return false; }
+    std::vector<std::pair<std::string, bool>> m_vFiles;
+};
+
+// What the catalogue cache records about each file: enough to tell whether it has changed since
+struct SCachedFile {
+    uintmax_t iSize;
+    long long iModified;
+    char cKind; // '6' for an <alphabet> root, '5' for an <alphabets> (v5) wrapper, '-' for neither
+    std::string strID;
+};
+
+const char* const CATALOGUE_MAGIC = "DasherAlphabetCatalogue 1";
+
+// An alphabet's start tag is near the top of its file; what follows it (the characters) is not needed
+const size_t HEADER_LENGTH = 64 * 1024;
+
+/// Finds the ID of the alphabet the file defines, just as Parse would, by parsing the whole file.
+bool ParseAlphabetID(const std::string& strPath, std::string& strID, bool& bV5) {
+    pugi::xml_document doc;
+    if (!doc.load_file(strPath.c_str())) return false;
+    pugi::xml_node alphabet = doc.document_element();
+    bV5 = (std::strcmp(alphabet.name(), "alphabets") == 0);
+    if (bV5) alphabet = alphabet.child("alphabet");
+    if (!alphabet || std::strcmp(alphabet.name(), "alphabet") != 0) return false;
+    strID = alphabet.attribute("name").as_string();
+    return true;
+}
+
+/// Finds the ID of the alphabet the file defines from the start tag of its <alphabet>
+///  element alone, falling back to ParseAlphabetID for anything out of the ordinary.
+bool ReadAlphabetID(const std::string& strPath, std::string& strID, bool& bV5) {
+    std::ifstream in(strPath.c_str(), std::ios::binary);
+    std::string strHead(HEADER_LENGTH, '\0');
+    in.read(&strHead[0], HEADER_LENGTH);
+    strHead.resize(static_cast<size_t>(in.gcount()));
+
+    bV5 = false;
+    size_t i = (strHead.compare(0, 3, "\xEF\xBB\xBF") == 0) ? 3 : 0;
+    while ((i = strHead.find('<', i)) != std::string::npos) {
+        if (strHead.compare(i, 4, "<!--") == 0) {
+            if ((i = strHead.find("-->", i + 4)) == std::string::npos) break;
+            i += 3;
+        } else if (strHead.compare(i, 2, "<?") == 0) {
+            if ((i = strHead.find("?>", i + 2)) == std::string::npos) break;
+            i += 2;
+        } else if (strHead.compare(i, 2, "<!") == 0) {
+            // DOCTYPE, perhaps with an internal subset in brackets
+            for (int iDepth = 0; i < strHead.size(); i++) {
+                if (strHead[i] == '<') iDepth++;
+                else if (strHead[i] == '>' && --iDepth == 0) break;
+            }
+            if (i++ == strHead.size()) break;
+        } else {
+            // A start tag, ending at the first '>' outside quotes
+            size_t j = i + 1;
+            for (char cQuote = 0; j < strHead.size() && (cQuote || strHead[j] != '>'); j++) {
+                if (cQuote ? strHead[j] == cQuote : (strHead[j] == '"' || strHead[j] == '\''))
+                    cQuote = cQuote ? 0 : strHead[j];
+            }
+            if (j == strHead.size()) break;
+            std::string strTag = strHead.substr(i, j - i);
+            const std::string strName = strTag.substr(1, strTag.find_first_of(" \t\r\n/") - 1);
+            if (strName == "alphabets" && !bV5 && strTag.back() != '/') {
+                bV5 = true;
+                i = j + 1;
+                continue;
+            }
+            if (strName != "alphabet") break;
+            if (strTag.back() != '/') strTag += '/';
+            strTag += '>';
+            pugi::xml_document doc;
+            if (!doc.load_buffer(strTag.data(), strTag.size())) break;
+            strID = doc.document_element().attribute("name").as_string();
+            return true;
+        }
+    }
+    return ParseAlphabetID(strPath, strID, bV5);
+}
+
+} // namespace
+
+void CAlphIO::LoadCatalogue(const FileUtils& fileUtils, const std::string& strCacheFile) {
+    std::map<std::string, SCachedFile> cache;
+    std::ifstream in(strCacheFile.c_str(), std::ios::binary);
+    std::string strLine;
+    if (std::getline(in, strLine) && strLine == CATALOGUE_MAGIC) {
+        while (std::getline(in, strLine)) {
+            // size, modification time, kind, path and ID, separated by tabs
+            size_t iTabs[4], iPos = 0;
+            bool bValid = true;
+            for (size_t& iTab : iTabs) {
+                iTab = strLine.find('\t', iPos);
+                if (iTab == std::string::npos) {
+                    bValid = false;
+                    break;
+                }
+                iPos = iTab + 1;
+            }
+            if (!bValid || iTabs[2] != iTabs[1] + 2) continue;
+            SCachedFile& entry = cache[strLine.substr(iTabs[2] + 1, iTabs[3] - iTabs[2] - 1)];
+            entry.iSize = std::strtoull(strLine.c_str(), nullptr, 10);
+            entry.iModified = std::strtoll(strLine.c_str() + iTabs[0] + 1, nullptr, 10);
+            entry.cKind = strLine[iTabs[1] + 1];
+            entry.strID = strLine.substr(iTabs[3] + 1);
+        }
+    }
+    in.close();
+
+    CFileLister files;
+    fileUtils.ScanFiles(&files, "alphabet.*.xml");
+
+    bool bChanged = (cache.size() != files.m_vFiles.size());
+    std::vector<std::pair<std::string, SCachedFile>> vEntries;
+    for (const auto& [strPath, bUser] : files.m_vFiles) {
+        std::error_code ec;
+        SCachedFile file;
+        file.iSize = std::filesystem::file_size(strPath, ec);
+        if (ec) continue;
+        file.iModified =
+            static_cast<long long>(std::filesystem::last_write_time(strPath, ec).time_since_epoch().count());
+        if (ec) continue;
+
+        auto it = cache.find(strPath);
+        if (it != cache.end() && it->second.iSize == file.iSize && it->second.iModified == file.iModified) {
+            file.cKind = it->second.cKind;
+            file.strID = it->second.strID;
+        } else {
+            bool bV5;
+            file.cKind = ReadAlphabetID(strPath, file.strID, bV5) ? (bV5 ? '5' : '6') : '-';
+            bChanged = true;
+        }
+
+        // Which file defines each alphabet is settled just as by parsing them all in turn (see Parse):
+        //  a later file overrides an earlier one, unless it is in the v5 format.
+        if (file.cKind != '-') {
+            const bool bExists = (m_Catalogue.count(file.strID) != 0 || Alphabets.count(file.strID) != 0);
+            if (!bExists || file.cKind == '6') m_Catalogue[file.strID] = SCatalogueEntry{strPath, bUser};
+        }
+        if (strPath.find_first_of("\t\n") == std::string::npos && file.strID.find('\n') == std::string::npos)
+            vEntries.emplace_back(strPath, file);
+    }
+    if (!bChanged) return;
+
+    const std::string strTemp = UniqueTempName(strCacheFile);
+    {
+        std::ofstream out(strTemp.c_str(), std::ios::binary | std::ios::trunc);
+        if (!out) return;
+        out << CATALOGUE_MAGIC << '\n';
+        for (const auto& [strPath, file] : vEntries)
+            out << file.iSize << '\t' << file.iModified << '\t' << file.cKind << '\t' << strPath << '\t' << file.strID
+                << '\n';
+        out.close();
+        if (!out) {
+            std::remove(strTemp.c_str());
+            return;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(strTemp, strCacheFile, ec);
+    if (ec) std::remove(strTemp.c_str());
+}
+
 void CAlphIO::GetAlphabets(std::vector<std::string>* AlphabetList) const {
     AlphabetList->clear();
 
     for (const auto& [AlphabetID, Alphabet] : Alphabets) {
         AlphabetList->push_back(Alphabet->AlphID);
     }
+    for (const auto& [AlphabetID, Entry] : m_Catalogue) {
+        if (Alphabets.count(AlphabetID) == 0) AlphabetList->push_back(AlphabetID);
+    }
+    std::sort(AlphabetList->begin(), AlphabetList->end());
 }
 
 std::string CAlphIO::GetDefault() const {
     std::string DefaultExternalAlphabet = "English with limited punctuation";
-    if (Alphabets.count(DefaultExternalAlphabet) != 0) {
+    if (Alphabets.count(DefaultExternalAlphabet) != 0 || m_Catalogue.count(DefaultExternalAlphabet) != 0) {
         return DefaultExternalAlphabet;
     }
 
     return "Default";
 }
 
-const CAlphInfo* CAlphIO::GetInfo(const std::string& AlphabetID) const {
+const CAlphInfo* CAlphIO::GetInfo(const std::string& AlphabetID) {
+    // Parse the file defining the alphabet (or the default), if not done already
+    for (const std::string& strID : {AlphabetID, GetDefault()}) {
+        auto cat = m_Catalogue.find(strID);
+        if (cat == m_Catalogue.end()) {
+            if (Alphabets.count(strID)) break;
+            continue;
+        }
+        const SCatalogueEntry entry = cat->second;
+        m_Catalogue.erase(cat);
+        ParseFile(entry.strPath, entry.bUser);
+        if (Alphabets.count(strID)) break;
+    }
+
     auto it = Alphabets.find(AlphabetID);
     if (it == Alphabets.end())             // if we don't have the alphabet they ask for,
         it = Alphabets.find(GetDefault()); // give them default - it's better than nothing
@@ -31,16 +31,20 @@
 
 namespace Dasher {
 class CAlphIO;
+class FileUtils;
 }
 
 /// \ingroup Alphabet
 /// @{
 
 /// This class is used to read in alphabet definitions from all files
-/// alphabet.*.xml at startup (realization) time; it creates one CAlphInfo
-/// object per alphabet at this time, and stores them in a map from AlphID
-/// string until shutdown/destruction. (CAlphIO is a friend of CAlphInfo,
-/// so can create/manipulate instances.)
+/// alphabet.*.xml. At startup (realization) time it only catalogues them
+/// (LoadCatalogue), reading just the ID of the alphabet each defines; an
+/// alphabet is parsed into a CAlphInfo object the first time it is asked
+/// for (GetInfo), and kept in a map from AlphID string until
+/// shutdown/destruction. Files may also be parsed outright (e.g. by
+/// ScanFiles, as in low-memory mode, which skips the catalogue). (CAlphIO
+/// is a friend of CAlphInfo, so can create/manipulate instances.)
 class Dasher::CAlphIO : public AbstractXMLParser {
   public:
     CAlphIO(CMessageDisplay* pMsgs);
@@ -48,12 +52,24 @@ class Dasher::CAlphIO : public AbstractXMLParser {
 
     virtual bool Parse(pugi::xml_document& document, const std::string filePath, bool bUser) override;
 
+    /// Catalogues every alphabet.*.xml in the directories of fileUtils. The catalogue is
+    ///  kept between sessions in strCacheFile, so that only files added or changed (in size
+    ///  or modification time) since it was written need be opened at all.
+    void LoadCatalogue(const FileUtils& fileUtils, const std::string& strCacheFile);
+
+    /// IDs of all alphabets, catalogued or parsed
     void GetAlphabets(std::vector<std::string>* AlphabetList) const;
-    const CAlphInfo* GetInfo(const std::string& AlphID) const;
+    /// Parses the alphabet first if only catalogued so far
+    const CAlphInfo* GetInfo(const std::string& AlphID);
     std::string GetDefault() const;
 
   private:
     std::map<std::string, const CAlphInfo*> Alphabets; // map AlphabetID to AlphabetInfo.
+    struct SCatalogueEntry {
+        std::string strPath;
+        bool bUser;
+    };
+    std::map<std::string, SCatalogueEntry> m_Catalogue; // AlphabetID to file, for those not yet parsed
     static CAlphInfo*
     CreateDefault(); // Give the user an English alphabet rather than nothing if anything goes horribly wrong.
 
@@ -25,6 +25,7 @@
 #include "DasherNode.h"
 #include "FileUtils.h"
 #include "NodeCreationManager.h"
+#include "ParallelTrainer.h"
 #include "LanguageModelling/PPMLanguageModel.h"
 #include "LanguageModelling/WordLanguageModel.h"
 #include "LanguageModelling/MixtureLanguageModel.h"
@@ -32,10 +33,16 @@
 #include "LanguageModelling/LMRegistry.h"
 #include "FileWordGenerator.h"
 
+#include <thread>
 #include <vector>
 
 using namespace Dasher;
 
+namespace {
+// Contexts whose probabilities are kept: more than a few screens' worth of nodes with children
+const size_t PROB_CACHE_SIZE = 128;
+} // namespace
+
 CNodeManager* Dasher::CAlphBase::mgr() const {
     return m_pMgr;
 }
@@ -47,7 +54,26 @@ CDasherInterfaceBase* Dasher::CSymbolNode::GetInterface() {
 CAlphabetManager::CAlphabetManager(CSettingsStore* pSettingsStore, CDasherInterfaceBase* pInterface,
                                    CNodeCreationManager* pNCManager, const CAlphInfo* pAlphabet)
     : m_pBaseGroup(NULL), m_pInterface(pInterface), m_pLanguageModel(nullptr), m_pNCManager(pNCManager),
-      m_pAlphabet(pAlphabet), m_pSettingsStore(pSettingsStore), m_pLastOutput(NULL) {
+      m_pAlphabet(pAlphabet), m_pSettingsStore(pSettingsStore), m_pLastOutput(NULL), m_probCache(PROB_CACHE_SIZE) {
+    m_pSettingsStore->OnParameterChanged.Subscribe(this, [this](Parameter parameter) {
+        // The cached probabilities depend on these (and on the model, which SetLanguageModel replaces)
+        switch (parameter) {
+        case LP_LM_ALPHA:
+        case LP_LM_BETA:
+        case LP_UNIFORM:
+        case LP_LM_MAX_ORDER:
+        case LP_LM_EXCLUSION:
+        case LP_LM_UPDATE_EXCLUSION:
+        case LP_LM_MIXTURE:
+        case LP_LM_WORD_ALPHA:
+        case LP_LM_NODE_BUDGET:
+        case LP_LANGUAGE_MODEL_ID:
+            m_probCache.Clear();
+            break;
+        default:
+            break;
+        }
+    });
     m_pSettingsStore->OnPreParameterChange.Subscribe(
         this, [this](Parameter parameter, const std::variant<bool, long, std::string>& newValue) {
             if (parameter == SP_ALPHABET_ID) {
@@ -93,7 +119,7 @@ void CAlphabetManager::Setup() {
     // else, if all single-octet chars are in alphabet - leave m_sDelim==""
     //  (and we'll find a delimiter for each context)
 
-    CreateLanguageModel();
+    m_pLanguageModel = CreateLanguageModel();
 }
 
 void CAlphabetManager::InitMap() {
@@ -120,15 +146,26 @@ void CAlphabetManager::InitMap() {
      */
 }
 
-void CAlphabetManager::CreateLanguageModel() {
+CLanguageModel* CAlphabetManager::CreateLanguageModel() {
     const int lmId = m_pSettingsStore->GetLongParameter(LP_LANGUAGE_MODEL_ID);
     CLanguageModel* lm =
         LMRegistry::instance().create(lmId, m_pSettingsStore, m_pAlphabet, &m_map, m_pAlphabet->iEnd - 1);
-    m_pLanguageModel = lm ? lm : new CPPMLanguageModel(m_pSettingsStore, m_pAlphabet->iEnd - 1);
+    return lm ? lm : new CPPMLanguageModel(m_pSettingsStore, m_pAlphabet->iEnd - 1);
 }
 
-CTrainer* CAlphabetManager::GetTrainer() {
-    return new CTrainer(m_pInterface, m_pLanguageModel, m_pAlphabet, &m_map);
+void CAlphabetManager::SetLanguageModel(CLanguageModel* pLanguageModel) {
+    delete m_pLanguageModel;
+    m_pLanguageModel = pLanguageModel;
+    m_probCache.Clear();
+}
+
+CTrainer* CAlphabetManager::GetTrainer(CLanguageModel* pLanguageModel, CMessageDisplay* pMsgs) {
+    long iThreads = m_pSettingsStore->GetLongParameter(LP_TRAINING_THREADS);
+    if (iThreads == 0) iThreads = std::thread::hardware_concurrency();
+    if (iThreads > 1)
+        if (CPPMLanguageModel* pPPM = dynamic_cast<CPPMLanguageModel*>(pLanguageModel))
+            return new CParallelTrainer(pMsgs, pPPM, m_pAlphabet, &m_map, static_cast<int>(iThreads));
+    return new CTrainer(pMsgs, pLanguageModel, m_pAlphabet, &m_map);
 }
 
 void CAlphabetManager::MakeLabels(CDasherScreen* pScreen) {
@@ -228,11 +265,11 @@ CWordGeneratorBase* CAlphabetManager::GetGameWords() {
         if (pos != std::string::npos) {
             gamemodeFile.replace(pos, 9, "gamemode_");
         }
-        Dasher::FileUtils::ScanFiles(pGen, gamemodeFile);
+        m_pInterface->GetFileUtils().ScanFiles(pGen, gamemodeFile);
     }
     if (pGen->HasLines()) return pGen;
     pGen->setAcceptUser(false);
-    Dasher::FileUtils::ScanFiles(pGen, m_pAlphabet->GetTrainingFile());
+    m_pInterface->GetFileUtils().ScanFiles(pGen, m_pAlphabet->GetTrainingFile());
     if (pGen->HasLines()) return pGen;
     delete pGen;
     return NULL;
@@ -260,6 +297,7 @@ CAlphabetManager::~CAlphabetManager() {
     m_pBaseGroup = nullptr;
 
     m_pSettingsStore->OnPreParameterChange.Unsubscribe(this);
+    m_pSettingsStore->OnParameterChanged.Unsubscribe(this);
 }
 
 void CAlphabetManager::WriteTrainFileFull(CDasherInterfaceBase* pInterface) {
@@ -422,7 +460,7 @@ void CAlphabetManager::GetProbs(vector<unsigned int>* pProbInfo, CLanguageModel:
     // Use alphabet normalization budget (NORMALIZATION minus control node space if active)
     const unsigned long iNorm(m_pNCManager->GetAlphNodeNormalization());
     const unsigned int iUniformAdd =
-        max(1ul, ((iNorm * m_pSettingsStore->GetLongParameter(LP_UNIFORM)) / 1000) / iSymbols);
+        max(1ul, ((iNorm * m_pSettingsStore->GetRenderSettings().iUniform) / 1000) / iSymbols);
     const unsigned long iNonUniformNorm = iNorm - static_cast<unsigned long>(iSymbols) * iUniformAdd;
     //  m_pLanguageModel->GetProbs(context, Probs, iNorm, ((iNorm * uniform) / 1000));
 
@@ -446,15 +484,33 @@ void CAlphabetManager::GetProbs(vector<unsigned int>* pProbInfo, CLanguageModel:
 #endif
 }
 
+void CAlphabetManager::GetCumulativeProbs(vector<unsigned int>* pProbInfo, CLanguageModel::Context context) {
+    CProbCache::Key key;
+    const bool bCache = m_pLanguageModel->GetContextKey(context, key.context);
+    if (bCache) {
+        key.iGeneration = m_pLanguageModel->GetGeneration();
+        key.iNorm = m_pNCManager->GetAlphNodeNormalization();
+        key.iUniform = static_cast<unsigned int>(m_pSettingsStore->GetRenderSettings().iUniform);
+        if (const vector<unsigned int>* pCached = m_probCache.Find(key)) {
+            *pProbInfo = *pCached;
+            return;
+        }
+    }
+
+    GetProbs(pProbInfo, context);
+
+    // work out cumulative probs in place
+    for (unsigned int i = 1; i < pProbInfo->size(); i++) {
+        (*pProbInfo)[i] += (*pProbInfo)[i - 1];
+    }
+
+    if (bCache) m_probCache.Insert(key, *pProbInfo);
+}
+
 std::vector<unsigned int>* CAlphNode::GetProbInfo() {
     if (!m_pProbInfo) {
         m_pProbInfo = new std::vector<unsigned int>();
-        m_pMgr->GetProbs(m_pProbInfo, iContext);
-
-        // work out cumulative probs in place
-        for (unsigned int i = 1; i < m_pProbInfo->size(); i++) {
-            (*m_pProbInfo)[i] += (*m_pProbInfo)[i - 1];
-        }
+        m_pMgr->GetCumulativeProbs(m_pProbInfo, iContext);
     }
     return m_pProbInfo;
 }
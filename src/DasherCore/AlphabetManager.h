@@ -23,6 +23,7 @@
 #include <map>
 
 #include "LanguageModelling/LanguageModel.h"
+#include "LanguageModelling/ProbCache.h"
 #include "DasherNode.h"
 #include "NodeManager.h"
 #include "Trainer.h"
@@ -223,13 +224,27 @@ class CAlphabetManager : public CNodeManager {
 
     /// Must be called after construction, before the AlphMgr is used. Calls
     ///  InitMap(), looks for a usable context-switch delimiter, and
-    ///  calls CreateLanguageModel.
+    ///  calls CreateLanguageModel for m_pLanguageModel.
     void Setup();
 
     virtual void MakeLabels(CDasherScreen* pScreen);
-    /// Gets a new trainer to train this LM. Caller is responsible for deallocating the
-    ///  trainer later.
-    virtual CTrainer* GetTrainer();
+    /// Gets a new trainer to train pLanguageModel, which must be this manager's LM or
+    ///  another created by CreateLanguageModel. Caller is responsible for deallocating
+    ///  the trainer later.
+    ///  \param pMsgs where the trainer reports problems with the training text
+    virtual CTrainer* GetTrainer(CLanguageModel* pLanguageModel, CMessageDisplay* pMsgs);
+
+    /// Creates a new, untrained LM for this alphabet (caller takes ownership).
+    ///  Setup() uses this to create the manager's own LM.
+    ///  Default implementation switches on LP_LANGUAGE_MODEL_ID.
+    ///  Note subclasses changing the interpretation of the AlphInfo, should override
+    ///  this to take account of its new meaning.
+    virtual CLanguageModel* CreateLanguageModel();
+
+    /// Replaces (and deletes) this manager's LM, e.g. with one trained in the background.
+    ///  Every node created by this manager must have been deleted first, as they hold
+    ///  contexts in the old LM.
+    void SetLanguageModel(CLanguageModel* pLanguageModel);
 
     /// Gets a (Game) Word Generator to make target sentences for the current alphabet
     CWordGeneratorBase* GetGameWords();
@@ -250,12 +265,6 @@ class CAlphabetManager : public CNodeManager {
     ///  characters have distinct texts.
     virtual void InitMap();
 
-    /// Creates the LM, and stores in m_pLanguageModel.
-    ///  Default implementation switches on LP_LANGUAGE_MODEL_ID.
-    ///  Note subclasses changing the interpretation of the AlphInfo, should override
-    ///  this to take account of its new meaning.
-    virtual void CreateLanguageModel();
-
     /// Base of all group+character information presented to the user;
     ///  created by calling copyGroups on the alphabet.
     SGroupInfo* m_pBaseGroup;
@@ -292,6 +301,13 @@ class CAlphabetManager : public CNodeManager {
 
     CDasherInterfaceBase* GetInterface() const { return m_pInterface; }
 
+    /// The LM created by CreateLanguageModel (owned by this manager)
+    CLanguageModel* GetLanguageModel() const { return m_pLanguageModel; }
+
+    /// Cumulative probabilities recently computed for nodes' contexts (see GetCumulativeProbs);
+    ///  its hit and miss counts are for profiling.
+    const CProbCache& GetProbCache() const { return m_probCache; }
+
   protected:
     /// Called to get the symbols in the context for (preceding) a new node
     ///  \param pParent node to assume has been output, when obtaining context
@@ -330,6 +346,10 @@ class CAlphabetManager : public CNodeManager {
     ///  Returns array of non-cumulative probs. Should this be protected and/or virtual???
     void GetProbs(std::vector<unsigned int>* pProbs, CLanguageModel::Context iContext);
 
+    /// As GetProbs, but cumulative, and from m_probCache if a context in the same state
+    ///  (so long as the LM says what that is) had them computed recently. For CAlphNode::GetProbInfo.
+    void GetCumulativeProbs(std::vector<unsigned int>* pProbs, CLanguageModel::Context iContext);
+
     /// Constructs child nodes under the specified parent according to provided group.
     ///  Nodes are created by calling CreateSymbolNode and CreateGroupNode, unless buildAround is non-null.
     ///  \param pParentGroup group describing which symbols and/or subgroups should be constructed
@@ -356,6 +376,10 @@ class CAlphabetManager : public CNodeManager {
     /// A character, 33<=c<=255, not in the alphabet; used to delimit contexts.
     ///"" if no such could be found (=> will be found on a per-context basis)
     std::string m_sDelim;
+
+    /// Keyed by LM state and normalisation; cleared on a new LM, or any parameter change
+    ///  (as the LM may depend on some, e.g. LP_LM_ALPHA, which aren't in the key)
+    CProbCache m_probCache;
 };
 /// @}
 
@@ -1,5 +1,6 @@
 #include "ColorPalette.h"
 
+#include <algorithm>
 #include <regex>
 #include <string>
 
@@ -49,6 +50,19 @@ ColorPalette::Color ColorPalette::Color::toGrayScale() const {
     return ColorPalette::Color(avg, avg, avg, this->Alpha);
 }
 
+int32_t ColorPalette::Color::toARGB() const {
+    int a = Alpha, r = Red, g = Green, b = Blue;
+    if (a >= 0 && a <= 1 && r >= 0 && r <= 1 && g >= 0 && g <= 1 && b >= 0 && b <= 1) {
+        a *= 255;
+        r *= 255;
+        g *= 255;
+        b *= 255;
+    }
+    const auto clamp = [](int v) { return std::min(std::max(v, 0), 255); };
+    return static_cast<int32_t>((static_cast<uint32_t>(clamp(a)) << 24) | (clamp(r) << 16) | (clamp(g) << 8) |
+                                clamp(b));
+}
+
 ColorPalette::Color ColorPalette::Color::lerp(const Color& ColorB, float a) const {
     return lerp(ColorB, *this, a);
 }
@@ -11,6 +11,7 @@
 #include <unordered_map>
 #include <vector>
 #include <array>
+#include <cstdint>
 #include <string>
 
 namespace Dasher {
@@ -66,6 +67,9 @@ class ColorPalette {
         bool isFullyTransparent() const { return Alpha == 0; }
         bool isFullyOpaque() const { return Alpha == 255; }
         Color toGrayScale() const;
+        // 0xAARRGGBB, each channel clamped to 0-255 (the constants black and white, given
+        //  in 0-1, are scaled up)
+        int32_t toARGB() const;
 
         // self * (1 - a) + ColorB * a
         Color lerp(const Color& ColorB, float a) const;
@@ -0,0 +1,143 @@
+// FrameArena.h
+//
+// Bump allocator for memory needed only until the end of a frame.
+
+#pragma once
+
+// CFrameArena hands out memory for objects that live only until the end of a
+// frame, by bumping a pointer through large blocks. Nothing is freed
+// individually: Reset (at the start of the next frame) makes all the memory
+// available again at once, merging the blocks used into one big enough for
+// them all - so once a frame as busy as any before it has been seen,
+// allocating from the arena never touches the heap.
+//
+// Objects created by New are never destroyed, so must be trivially
+// destructible. CFrameArena::Allocator lets standard containers (whose
+// destructors run as usual) take their storage from the arena.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+class CFrameArena {
+  public:
+    // Construct with the size of the first block (allocated when first needed)
+    explicit CFrameArena(std::size_t iBlockSize = 64 * 1024) : m_iBlockSize(iBlockSize) {}
+
+    CFrameArena(const CFrameArena&) = delete;
+    CFrameArena& operator=(const CFrameArena&) = delete;
+
+    // Return iBytes of uninitialized memory aligned to iAlign (a power of two)
+    void* Allocate(std::size_t iBytes, std::size_t iAlign = alignof(std::max_align_t));
+
+    // Give back p, if it was the last allocation made (else nothing happens)
+    void Release(void* p, std::size_t iBytes);
+
+    // Construct a T, which will never be destroyed
+    template <typename T, typename... Args>
+    T* New(Args&&... args) {
+        static_assert(std::is_trivially_destructible<T>::value, "arena objects are never destroyed");
+        return new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    // Uninitialized storage for n Ts
+    template <typename T>
+    T* NewArray(std::size_t n) {
+        static_assert(std::is_trivially_destructible<T>::value, "arena objects are never destroyed");
+        return static_cast<T*>(Allocate(n * sizeof(T), alignof(T)));
+    }
+
+    // Make all memory allocated available again (invalidating everything allocated from it)
+    void Reset();
+
+    // Bytes in all blocks
+    std::size_t GetCapacity() const;
+    std::size_t GetBlockCount() const { return m_vBlocks.size(); }
+
+    // Standard allocator over an arena. Deallocation is a no-op unless it was the
+    //  last allocation (as when a vector grows), and the arena must outlive the frame.
+    template <typename T>
+    class Allocator {
+      public:
+        typedef T value_type;
+        explicit Allocator(CFrameArena& arena) : m_pArena(&arena) {}
+        template <typename U>
+        Allocator(const Allocator<U>& other) : m_pArena(other.m_pArena) {}
+
+        T* allocate(std::size_t n) { return static_cast<T*>(m_pArena->Allocate(n * sizeof(T), alignof(T))); }
+        void deallocate(T* p, std::size_t n) { m_pArena->Release(p, n * sizeof(T)); }
+
+        template <typename U>
+        bool operator==(const Allocator<U>& other) const {
+            return m_pArena == other.m_pArena;
+        }
+        template <typename U>
+        bool operator!=(const Allocator<U>& other) const {
+            return m_pArena != other.m_pArena;
+        }
+
+      private:
+        template <typename U>
+        friend class Allocator;
+        CFrameArena* m_pArena;
+    };
+
+  private:
+    struct SBlock {
+        std::unique_ptr<char[]> pData;
+        std::size_t iSize;
+    };
+
+    std::size_t m_iBlockSize;
+    // Blocks in order of use; all but the last are full
+    std::vector<SBlock> m_vBlocks;
+    // Offset of the free space in the last block
+    std::size_t m_iUsed = 0;
+    // Offset of the last allocation in the last block (for Release)
+    std::size_t m_iLast = 0;
+};
+
+inline void* CFrameArena::Allocate(std::size_t iBytes, std::size_t iAlign) {
+    if (!m_vBlocks.empty()) {
+        SBlock& block = m_vBlocks.back();
+        const std::uintptr_t iBase = reinterpret_cast<std::uintptr_t>(block.pData.get());
+        const std::size_t iStart = ((iBase + m_iUsed + iAlign - 1) & ~(std::uintptr_t(iAlign) - 1)) - iBase;
+        if (iStart + iBytes <= block.iSize) {
+            m_iLast = iStart;
+            m_iUsed = iStart + iBytes;
+            return block.pData.get() + iStart;
+        }
+    }
+    // Start another block; operator new[] aligns it for any fundamental type
+    const std::size_t iSize = std::max(m_iBlockSize, iBytes + iAlign);
+    m_vBlocks.push_back({std::unique_ptr<char[]>(new char[iSize]), iSize});
+    m_iUsed = 0;
+    return Allocate(iBytes, iAlign);
+}
+
+inline void CFrameArena::Release(void* p, std::size_t iBytes) {
+    if (m_vBlocks.empty() || p != m_vBlocks.back().pData.get() + m_iLast || m_iLast + iBytes != m_iUsed) return;
+    m_iUsed = m_iLast;
+}
+
+inline void CFrameArena::Reset() {
+    if (m_vBlocks.size() > 1) {
+        // Replace them with one block that would have held everything
+        m_iBlockSize = std::max(m_iBlockSize, GetCapacity());
+        m_vBlocks.clear();
+        m_vBlocks.push_back({std::unique_ptr<char[]>(new char[m_iBlockSize]), m_iBlockSize});
+    }
+    m_iUsed = m_iLast = 0;
+}
+
+inline std::size_t CFrameArena::GetCapacity() const {
+    std::size_t iTotal = 0;
+    for (const SBlock& block : m_vBlocks)
+        iTotal += block.iSize;
+    return iTotal;
+}
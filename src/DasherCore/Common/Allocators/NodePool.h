@@ -0,0 +1,166 @@
+// NodePool.h
+//
+// Recycles the memory of objects of a few sizes, such as Dasher nodes.
+
+#pragma once
+
+// CNodePool hands out memory for objects of a few sizes (say, the subclasses of
+// CDasherNode), carving it from large slabs, and keeps what is freed on a free
+// list per size class, to be handed out again. So once as many objects as ever
+// before are alive, making and deleting them - as expanding and collapsing nodes
+// does, over and over - never touches the heap.
+//
+// Each allocation is preceded by a header recording the pool it came from, so
+// Free needs no pool. Allocate, given no pool (none is current), or too many
+// bytes for a size class, takes the memory from the heap instead, and Free
+// gives it back there.
+//
+// A pool is used by one thread at a time (that of the model it belongs to).
+// Objects are allocated from it while a Scope for it is open on that thread.
+// The owner gives it up with Detach: it is deleted once the last object
+// allocated from it is freed (at once, if there is none).
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+class CNodePool {
+  public:
+    // Construct with the size of each slab (allocated when needed)
+    explicit CNodePool(std::size_t iSlabSize = 64 * 1024) : m_iSlabSize(iSlabSize) {}
+
+    CNodePool(const CNodePool&) = delete;
+    CNodePool& operator=(const CNodePool&) = delete;
+
+    // Return iBytes of uninitialized memory, from pPool if any
+    static void* Allocate(CNodePool* pPool, std::size_t iBytes);
+
+    // Give back memory returned by Allocate, to the pool it came from
+    static void Free(void* p);
+
+    // Bytes of the size class memory returned by Allocate came from; 0 if from the heap
+    static std::size_t SizeOf(const void* p);
+
+    // Delete the pool when nothing allocated from it remains
+    void Detach();
+
+    // Makes a pool current on this thread while open (and the last current again after)
+    class Scope {
+      public:
+        explicit Scope(CNodePool* pPool) : m_pPrev(Current()) { Current() = pPool; }
+        ~Scope() { Current() = m_pPrev; }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+      private:
+        CNodePool* m_pPrev;
+    };
+
+    // The pool current on this thread, if any
+    static CNodePool*& Current() {
+        thread_local CNodePool* pCurrent = nullptr;
+        return pCurrent;
+    }
+
+    // Objects allocated and not yet freed
+    std::size_t GetLiveCount() const { return m_iLive; }
+    // Freed objects waiting to be reused
+    std::size_t GetFreeCount() const { return m_iFree; }
+    // Objects allocated and freed since construction
+    std::uint64_t GetAllocatedCount() const { return m_iAllocated; }
+    std::uint64_t GetFreedCount() const { return m_iFreed; }
+    // Bytes in all slabs
+    std::size_t GetCapacity() const { return m_vSlabs.size() * m_iSlabSize; }
+
+  private:
+    // Size classes are multiples of the alignment; anything bigger comes from the heap
+    static constexpr std::size_t ALIGN = alignof(std::max_align_t);
+    static constexpr std::size_t CLASSES = 32;
+
+    // Precedes each allocation (so keeps what follows aligned)
+    struct alignas(ALIGN) SHeader {
+        CNodePool* pPool; // nullptr if from the heap
+        std::size_t iClass;
+    };
+    // Overlays a freed allocation's header
+    struct SFree {
+        SFree* pNext;
+    };
+
+    ~CNodePool() = default;
+    void* Take(std::size_t iClass);
+    void Give(SHeader* pHeader);
+
+    std::size_t m_iSlabSize;
+    std::vector<std::unique_ptr<char[]>> m_vSlabs;
+    // Offset of the free space in the last slab
+    std::size_t m_iUsed = 0;
+    SFree* m_apFree[CLASSES] = {};
+    std::size_t m_iLive = 0, m_iFree = 0;
+    std::uint64_t m_iAllocated = 0, m_iFreed = 0;
+    bool m_bDetached = false;
+};
+
+inline void* CNodePool::Allocate(CNodePool* pPool, std::size_t iBytes) {
+    const std::size_t iClass = (iBytes + ALIGN - 1) / ALIGN;
+    if (pPool && iClass < CLASSES) return pPool->Take(iClass);
+    SHeader* pHeader = static_cast<SHeader*>(::operator new(sizeof(SHeader) + iBytes));
+    pHeader->pPool = nullptr;
+    pHeader->iClass = 0;
+    return pHeader + 1;
+}
+
+inline void CNodePool::Free(void* p) {
+    if (!p) return;
+    SHeader* pHeader = static_cast<SHeader*>(p) - 1;
+    if (pHeader->pPool)
+        pHeader->pPool->Give(pHeader);
+    else
+        ::operator delete(pHeader);
+}
+
+inline std::size_t CNodePool::SizeOf(const void* p) {
+    const SHeader* pHeader = static_cast<const SHeader*>(p) - 1;
+    return pHeader->pPool ? pHeader->iClass * ALIGN : 0;
+}
+
+inline void CNodePool::Detach() {
+    m_bDetached = true;
+    if (!m_iLive) delete this;
+}
+
+inline void* CNodePool::Take(std::size_t iClass) {
+    SHeader* pHeader;
+    if (SFree* pFree = m_apFree[iClass]) {
+        m_apFree[iClass] = pFree->pNext;
+        m_iFree--;
+        pHeader = reinterpret_cast<SHeader*>(pFree);
+    } else {
+        const std::size_t iBytes = sizeof(SHeader) + iClass * ALIGN;
+        if (m_vSlabs.empty() || m_iUsed + iBytes > m_iSlabSize) {
+            // (operator new[] aligns it for any fundamental type; the rest of the last slab is wasted)
+            m_vSlabs.emplace_back(new char[m_iSlabSize]);
+            m_iUsed = 0;
+        }
+        pHeader = reinterpret_cast<SHeader*>(m_vSlabs.back().get() + m_iUsed);
+        m_iUsed += iBytes;
+    }
+    pHeader->pPool = this;
+    pHeader->iClass = iClass;
+    m_iLive++;
+    m_iAllocated++;
+    return pHeader + 1;
+}
+
+inline void CNodePool::Give(SHeader* pHeader) {
+    const std::size_t iClass = pHeader->iClass;
+    SFree* pFree = reinterpret_cast<SFree*>(pHeader);
+    pFree->pNext = m_apFree[iClass];
+    m_apFree[iClass] = pFree;
+    m_iFree++;
+    m_iLive--;
+    m_iFreed++;
+    if (m_bDetached && !m_iLive) delete this;
+}
@@ -5,10 +5,11 @@
 #pragma once
 
 // CSimplePooledAlloc allocates objects T in fixed-size blocks (specified)
-// Alloc returns a default-constructed T*
+// Alloc returns a default-constructed T* (new T[] per block), never reused
 // Memory is only freed on destruction of the allocator
 
 #include <cstddef>
+#include <utility>
 #include <vector>
 
 template <typename T>
@@ -19,9 +20,18 @@ class CSimplePooledAlloc {
 
     ~CSimplePooledAlloc();
 
-    // Return an uninitialized object
+    // Return a default-constructed object, never one handed out before
     T* Alloc();
 
+    std::size_t GetBlockSize() const { return m_iBlockSize; }
+
+    // Exchange everything allocated (and still to be freed) with other
+    void swap(CSimplePooledAlloc& other) {
+        m_vPool.swap(other.m_vPool);
+        std::swap(m_iBlockSize, other.m_iBlockSize);
+        std::swap(m_iCurrent, other.m_iCurrent);
+    }
+
   private:
     class CPool {
       public:
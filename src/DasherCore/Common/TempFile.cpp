@@ -0,0 +1,26 @@
+// TempFile.cpp
+//
+// Names for files written alongside their destination, then renamed into place.
+
+#include "TempFile.h"
+
+#include <atomic>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+std::string Dasher::UniqueTempName(const std::string& strFile) {
+    static std::atomic<unsigned long> s_iCount{0};
+#ifdef _WIN32
+    const unsigned long iProcess = GetCurrentProcessId();
+#else
+    const unsigned long iProcess = static_cast<unsigned long>(getpid());
+#endif
+    return strFile + ".tmp." + std::to_string(iProcess) + "." + std::to_string(s_iCount++);
+}
@@ -0,0 +1,22 @@
+// TempFile.h
+//
+// Names for files written alongside their destination, then renamed into place.
+
+#pragma once
+
+// Files the engine persists (PPM snapshots and images, the alphabet catalogue,
+// the file index) are written to a temporary file in the same directory and
+// renamed over the old one, so a reader never sees one half-written. Several
+// contexts, or processes, sharing a user directory may write the same file at
+// once: each must write its own temporary file, or one could rename the other's
+// before it is complete.
+
+#include <string>
+
+namespace Dasher {
+
+// A name next to strFile for a temporary file no other writer - thread or
+// process - will use: strFile + ".tmp." + process id + "." + a per-process count
+std::string UniqueTempName(const std::string& strFile);
+
+} // namespace Dasher
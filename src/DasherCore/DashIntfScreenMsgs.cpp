@@ -3,7 +3,8 @@
 
 using namespace Dasher;
 
-CDashIntfScreenMsgs::CDashIntfScreenMsgs(CSettingsStore* pSettingsStore) : CDashIntfSettings(pSettingsStore) {}
+CDashIntfScreenMsgs::CDashIntfScreenMsgs(CSettingsStore* pSettingsStore, const FileUtils& fileUtils)
+    : CDashIntfSettings(pSettingsStore, fileUtils) {}
 
 void CDashIntfScreenMsgs::Message(const std::string& strText, bool bInterrupt) {
     // Just store the messages for Redraw...
@@ -33,7 +33,7 @@ namespace Dasher {
 ///  combine via multiple inheritance?? (from CSettingsUser, not DashIntfBase!)
 class CDashIntfScreenMsgs : public CDashIntfSettings {
   public:
-    CDashIntfScreenMsgs(CSettingsStore* pSettingsStore);
+    CDashIntfScreenMsgs(CSettingsStore* pSettingsStore, const FileUtils& fileUtils = FileUtils());
 
     /// Stores messages for Redraw to render onto the Screen on top of the view.
     /// For modal messages (bInterrupt=true), pauses Dasher, and keeps the message
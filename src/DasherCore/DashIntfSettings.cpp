@@ -2,7 +2,8 @@
 
 using namespace Dasher;
 
-CDashIntfSettings::CDashIntfSettings(CSettingsStore* pSettingsStore) : CDasherInterfaceBase(pSettingsStore) {}
+CDashIntfSettings::CDashIntfSettings(CSettingsStore* pSettingsStore, const FileUtils& fileUtils)
+    : CDasherInterfaceBase(pSettingsStore, fileUtils) {}
 
 bool CDashIntfSettings::GetBoolParameter(Parameter iParameter) const {
     return m_pSettingsStore->GetBoolParameter(iParameter);
@@ -36,7 +36,7 @@ namespace Dasher {
 ///  inheritance?
 class CDashIntfSettings : public CDasherInterfaceBase {
   public:
-    CDashIntfSettings(CSettingsStore* pSettingsStore);
+    CDashIntfSettings(CSettingsStore* pSettingsStore, const FileUtils& fileUtils = FileUtils());
 
     bool GetBoolParameter(Parameter iParameter) const;
     long GetLongParameter(Parameter iParameter) const;
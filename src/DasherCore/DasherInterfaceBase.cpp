@@ -48,6 +48,7 @@
 #include <sstream>
 #include <algorithm>
 #include <cctype>
+#include <cmath>
 
 static std::string alphabetIdToFilename(const std::string& alphId) {
     std::string lower = alphId;
@@ -67,9 +68,9 @@ CControlManager* CDasherInterfaceBase::GetControlManager() {
     return m_pNCManager ? m_pNCManager->GetControlManager() : nullptr;
 }
 
-CDasherInterfaceBase::CDasherInterfaceBase(CSettingsStore* pSettingsStore)
+CDasherInterfaceBase::CDasherInterfaceBase(CSettingsStore* pSettingsStore, const FileUtils& fileUtils)
     : m_pDasherModel(std::make_unique<CDasherModel>()), m_pFramerate(std::make_unique<CFrameRate>(pSettingsStore)),
-      m_pSettingsStore(pSettingsStore), m_pModuleManager(std::make_unique<CModuleManager>()) {
+      m_pSettingsStore(pSettingsStore), m_pModuleManager(std::make_unique<CModuleManager>()), m_fileUtils(fileUtils) {
 
     m_pSettingsStore->OnParameterChanged.Subscribe(this, [this](Parameter p) { HandleParameterChange(p); });
 
@@ -104,17 +105,18 @@ void CDasherInterfaceBase::Realize(unsigned long ulTime) {
         // Load only the selected alphabet (or default) to save ~5-10MB
         std::string alphId = m_pSettingsStore->GetStringParameter(SP_ALPHABET_ID);
         if (alphId.empty()) alphId = "English with limited punctuation";
-        Dasher::FileUtils::ScanFiles(m_AlphIO.get(), alphabetIdToFilename(alphId));
+        m_fileUtils.ScanFiles(m_AlphIO.get(), alphabetIdToFilename(alphId));
         // If the specific file wasn't found, fall back to the default
         if (!m_AlphIO->GetInfo(alphId))
-            Dasher::FileUtils::ScanFiles(m_AlphIO.get(), alphabetIdToFilename("English with limited punctuation"));
+            m_fileUtils.ScanFiles(m_AlphIO.get(), alphabetIdToFilename("English with limited punctuation"));
     } else {
-        Dasher::FileUtils::ScanFiles(m_AlphIO.get(), "alphabet.*.xml");
+        // Alphabets are only parsed once selected; the catalogue of them all is cached between sessions
+        m_AlphIO->LoadCatalogue(m_fileUtils, m_fileUtils.ResolveUserDataPath("alphabets.cache"));
     }
 
     m_ColorIO = std::make_unique<CColorIO>(this);
-    Dasher::FileUtils::ScanFiles(m_ColorIO.get(), "color.*.xml");
-    Dasher::FileUtils::ScanFiles(m_ColorIO.get(), "colour.*.xml");
+    m_fileUtils.ScanFiles(m_ColorIO.get(), "color.*.xml");
+    m_fileUtils.ScanFiles(m_ColorIO.get(), "colour.*.xml");
     m_ColorIO->RelinkParents();
 
     ChangeView();
@@ -138,6 +140,7 @@ void CDasherInterfaceBase::Realize(unsigned long ulTime) {
     //  So tell it the setting has changed...
 
     HandleParameterChange(LP_NODE_BUDGET);
+    HandleParameterChange(LP_SUBTREE_CACHE);
     HandleParameterChange(BP_SPEAK_WORDS);
 
     // FIXME - need to rationalise this sort of thing.
@@ -212,8 +215,22 @@ void CDasherInterfaceBase::HandleParameterChange(Parameter parameter) {
         ScheduleRedraw();
         break;
     case LP_NODE_BUDGET:
-        m_defaultPolicy.reset(
-            new AmortizedPolicy(m_pDasherModel.get(), m_pSettingsStore->GetLongParameter(LP_NODE_BUDGET)));
+    case LP_LOOKAHEAD_FRAMES:
+    case LP_LOOKAHEAD_TIME:
+    case LP_EXPANSION_TIME: {
+        const unsigned int iBudget = m_pSettingsStore->GetLongParameter(LP_NODE_BUDGET);
+        const int iLookahead = static_cast<int>(m_pSettingsStore->GetLongParameter(LP_LOOKAHEAD_FRAMES));
+        AmortizedPolicy* pPolicy =
+            iLookahead ? new LookaheadPolicy(m_pDasherModel.get(), iBudget, iLookahead,
+                                             static_cast<int>(m_pSettingsStore->GetLongParameter(LP_LOOKAHEAD_TIME)))
+                       : new AmortizedPolicy(m_pDasherModel.get(), iBudget);
+        pPolicy->SetTimeBudget(static_cast<int>(m_pSettingsStore->GetLongParameter(LP_EXPANSION_TIME)));
+        m_defaultPolicy.reset(pPolicy);
+        break;
+    }
+    case LP_SUBTREE_CACHE:
+        m_pDasherModel->GetSubtreeCache().SetCapacity(
+            static_cast<std::size_t>(m_pSettingsStore->GetLongParameter(LP_SUBTREE_CACHE)) * 1024);
         break;
     case BP_CONTROL_MODE:
         // Rebuild control box first (deletes old CControlManager/templates),
@@ -310,10 +327,74 @@ void CDasherInterfaceBase::CreateNCManager() {
         SetOffset(m_pDasherModel->GetOffset(), true);
     } // else, if there is no screen, the model should not contain any nodes from the old NCManager. (Assert, somehow?)
 
+    // Lock until the new manager's LM is trained; or, if it's the old one we were waiting for, give up
+    if (m_pNCManager->IsTraining())
+        UpdateBackgroundTraining(false);
+    else if (oldMgr && oldMgr->IsTraining())
+        SetLockStatus("", -1);
+
     //...so now we can delete the old manager
     oldMgr.reset();
 }
 
+void CDasherInterfaceBase::UpdateBackgroundTraining(bool bWait) {
+    if (!m_pNCManager || !m_pNCManager->IsTraining()) return;
+    if (!bWait && !m_pNCManager->IsTrainingFinished()) {
+        SetLockStatus(m_pNCManager->GetTrainingMessage(), m_pNCManager->GetTrainingProgress());
+        return;
+    }
+    // The nodes hold contexts in the untrained LM, so must go before it does
+    const int iOffset = m_pDasherModel->GetOffset();
+    m_pDasherModel->DeleteNodes();
+    m_pNCManager->AdoptTrainedModel();
+    SetLockStatus("", -1);
+    if (m_DasherScreen) SetOffset(iOffset, true);
+}
+
+int CDasherInterfaceBase::GetTrainingProgress() {
+    return m_pNCManager ? m_pNCManager->GetTrainingProgress() : -1;
+}
+
+bool CDasherInterfaceBase::GetProbCacheStats(uint64_t& iHits, uint64_t& iMisses) {
+    if (!m_pNCManager || !m_pNCManager->GetAlphabetManager()) return false;
+    const CProbCache& cache = m_pNCManager->GetAlphabetManager()->GetProbCache();
+    iHits = cache.GetHits();
+    iMisses = cache.GetMisses();
+    return true;
+}
+
+bool CDasherInterfaceBase::GetNodePoolStats(uint64_t& iLive, uint64_t& iFree, uint64_t& iAllocated,
+                                            uint64_t& iFreed) const {
+    if (!m_pDasherModel) return false;
+    const CNodePool& pool = m_pDasherModel->GetNodePool();
+    iLive = pool.GetLiveCount();
+    iFree = pool.GetFreeCount();
+    iAllocated = pool.GetAllocatedCount();
+    iFreed = pool.GetFreedCount();
+    return true;
+}
+
+bool CDasherInterfaceBase::GetSubtreeCacheStats(uint64_t& iHits, uint64_t& iMisses, uint64_t& iEvicted,
+                                                uint64_t& iBytes) const {
+    if (!m_pDasherModel) return false;
+    const CSubtreeCache& cache = m_pDasherModel->GetSubtreeCache();
+    iHits = cache.GetHits();
+    iMisses = cache.GetMisses();
+    iEvicted = cache.GetEvicted();
+    iBytes = cache.GetBytes();
+    return true;
+}
+
+void CDasherInterfaceBase::GetExpansionTimeStats(uint64_t& iExpanded, uint64_t& iMicroseconds) const {
+    iExpanded = m_iPolicyExpanded;
+    iMicroseconds = static_cast<uint64_t>(std::llround(m_dPolicyExpandMicroseconds));
+}
+
+void CDasherInterfaceBase::GetLookaheadStats(uint64_t& iForced, uint64_t& iAhead) const {
+    iForced = m_iForcedExpansions;
+    iAhead = m_iExpandedAhead;
+}
+
 bool CDasherInterfaceBase::hasDone() {
     return (m_pSettingsStore->GetBoolParameter(BP_COPY_ALL_ON_STOP) && SupportsClipboard()) ||
            (m_pSettingsStore->GetBoolParameter(BP_SPEAK_ALL_ON_STOP) && SupportsSpeech());
@@ -346,15 +427,16 @@ void CDasherInterfaceBase::CreateInput() {
 
 void CDasherInterfaceBase::NewFrame(unsigned long iTime, bool bForceRedraw) {
     // Prevent NewFrame from being reentered. This can happen occasionally and
-    // cause crashes.
-    static bool bReentered = false;
-    if (bReentered) {
+    // cause crashes. (Per interface: another's NewFrame may be running on another thread.)
+    if (m_bInNewFrame) {
 #ifdef DEBUG
         std::cout << "CDasherInterfaceBase::NewFrame was re-entered" << std::endl;
 #endif
         return;
     }
-    bReentered = true;
+    m_bInNewFrame = true;
+
+    UpdateBackgroundTraining(false);
 
     if (m_DasherScreen) {
         // ok, can draw _something_. Try and see what we can :).
@@ -362,10 +444,9 @@ void CDasherInterfaceBase::NewFrame(unsigned long iTime, bool bForceRedraw) {
         bool bBlit = false; // set to true if we actually render anything different i.e. that needs blitting to display
 
         if (isLocked() || !m_pDasherView) {
-            // Hmmm. If we're locked, NewFrame is never actually called - the thread
-            //  that would be rendering frames, is the same one doing the training.
-            //  So the following is never actually executed atm, but may be a simple
-            //  template if/when we ever implement multithreading widely/properly...
+            // Locked while the LM trains on a background thread (BP_BACKGROUND_TRAINING).
+            //  (When training in the foreground, NewFrame isn't called until it's done -
+            //  the thread that would be rendering frames, is the one doing the training.)
             const screenint iSW = m_DasherScreen->GetWidth(), iSH = m_DasherScreen->GetHeight();
             m_DasherScreen->DrawRectangle(0, 0, iSW, iSH, m_pDasherView->GetNamedColor(NamedColor::infoTextBackground),
                                           ColorPalette::noColor, 0); // fill in colour 0 = white
@@ -409,7 +490,7 @@ void CDasherInterfaceBase::NewFrame(unsigned long iTime, bool bForceRedraw) {
         if (bBlit) m_DasherScreen->Display();
     }
 
-    bReentered = false;
+    m_bInNewFrame = false;
 
     ExecuteDelayedActions();
 }
@@ -427,19 +508,28 @@ void CDasherInterfaceBase::onUnpause(unsigned long lTime) {
 
 bool CDasherInterfaceBase::Redraw(unsigned long ulTime, bool bRedrawNodes, CExpansionPolicy& policy) {
     DASHER_ASSERT(m_pDasherView);
+    m_pDasherView->ResetFrameArena();
 
     // Draw the nodes
     if (bRedrawNodes) {
         if (m_pDasherModel) {
             m_pDasherModel->RenderToView(m_pDasherView.get(), policy);
+            m_iForcedExpansions += m_pDasherView->GetRenderStats().iForced;
             // if anything was expanded or collapsed render at least one more
             // frame after this
             if (policy.apply()) ScheduleRedraw();
+            if (const AmortizedPolicy* pAmortized = dynamic_cast<const AmortizedPolicy*>(&policy)) {
+                m_iPolicyExpanded += pAmortized->GetExpanded();
+                m_dPolicyExpandMicroseconds += pAmortized->GetExpandMicroseconds();
+            }
+            if (const LookaheadPolicy* pLookahead = dynamic_cast<const LookaheadPolicy*>(&policy))
+                m_iExpandedAhead += pLookahead->GetExpandedAhead();
         }
         if (m_pGameModule) {
             m_pGameModule->DecorateView(ulTime, m_pDasherView.get(), m_pDasherModel.get());
         }
     }
+    m_DasherScreen->EndNodes(bRedrawNodes);
 
     // From here on, we'll use bRedrawNodes just to denote whether we need to blit the display...
 
@@ -462,7 +552,7 @@ void CDasherInterfaceBase::ChangeAlphabet() {
     if (m_bLowMemoryMode && m_AlphIO) {
         std::string alphId = m_pSettingsStore->GetStringParameter(SP_ALPHABET_ID);
         if (!m_AlphIO->GetInfo(alphId)) {
-            Dasher::FileUtils::ScanFiles(m_AlphIO.get(), alphabetIdToFilename(alphId));
+            m_fileUtils.ScanFiles(m_AlphIO.get(), alphabetIdToFilename(alphId));
         }
     }
 
@@ -699,9 +789,11 @@ const char* CDasherInterfaceBase::ClSet(const std::string& strKey, const std::st
 }
 
 void CDasherInterfaceBase::ImportTrainingText(const std::string& strPath) {
+    // Train on top of the full model, not the placeholder we'd discard
+    UpdateBackgroundTraining(true);
     if (m_pNCManager) m_pNCManager->ImportTrainingText(strPath);
 }
 
 void CDasherInterfaceBase::WriteTrainFile(const std::string& filename, const std::string& strNewText) {
-    Dasher::FileUtils::WriteUserDataFile(filename, strNewText, true);
+    m_fileUtils.WriteUserDataFile(filename, strNewText, true);
 };
\ No newline at end of file
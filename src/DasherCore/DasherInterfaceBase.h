@@ -39,6 +39,7 @@
 #include "FrameRate.h"
 #include "DasherModel.h"
 #include "ControlManager.h"
+#include "FileUtils.h"
 #include <functional>
 #include <memory>
 #include <vector>
@@ -72,8 +73,9 @@ class CNodeCreationManager;
 /// CDashIntfScreenMsgs instead.
 class Dasher::CDasherInterfaceBase : public CMessageDisplay, private NoClones {
   public:
-    /// Create a new interface by providing the only-and-only settings store that will be used throughout.
-    CDasherInterfaceBase(CSettingsStore* pSettingsStore);
+    /// Create a new interface by providing the only-and-only settings store that will be used throughout,
+    ///  and the directories its files are read from and written to (the current one, by default).
+    CDasherInterfaceBase(CSettingsStore* pSettingsStore, const FileUtils& fileUtils = FileUtils());
     virtual ~CDasherInterfaceBase();
 
     /// @name Access to internal member classes
@@ -112,6 +114,9 @@ class Dasher::CDasherInterfaceBase : public CMessageDisplay, private NoClones {
 
     CColorIO* GetColorIO() { return m_ColorIO.get(); }
 
+    /// Where this interface reads and writes its files (never changed, so may be used from any thread)
+    const FileUtils& GetFileUtils() const { return m_fileUtils; }
+
     //@}
 
     /// Called when a parameter changes - but *after* components have been notified.
@@ -143,6 +148,32 @@ class Dasher::CDasherInterfaceBase : public CMessageDisplay, private NoClones {
     /// needs to be threadsafe, which neither this nor BP_TRAINING is (I don't think!)...
     inline bool isLocked() { return !m_strLockMessage.empty(); }
 
+    /// Progress (0-100) of training the language model in the background (see
+    ///  BP_BACKGROUND_TRAINING), or -1 if it isn't being trained. Once training
+    ///  has finished, the next NewFrame swaps the trained model in and unlocks.
+    int GetTrainingProgress();
+
+    /// Hit and miss counts of the alphabet manager's cache of nodes' probabilities
+    ///  (see CProbCache), for profiling. False if there is no alphabet manager yet.
+    bool GetProbCacheStats(uint64_t& iHits, uint64_t& iMisses);
+
+    /// Counts of the model's node pool (see CNodePool): nodes alive and freed for reuse,
+    ///  and those allocated and freed since the model was created. False if there is no model.
+    bool GetNodePoolStats(uint64_t& iLive, uint64_t& iFree, uint64_t& iAllocated, uint64_t& iFreed) const;
+
+    /// Counts of the model's subtree cache (see CSubtreeCache, LP_SUBTREE_CACHE): nodes re-expanded
+    ///  with the children parked for them, and anew, sets of children evicted, and the bytes parked
+    ///  now. False if there is no model.
+    bool GetSubtreeCacheStats(uint64_t& iHits, uint64_t& iMisses, uint64_t& iEvicted, uint64_t& iBytes) const;
+
+    /// Nodes expanded by the expansion policy after rendering, and the microseconds it spent
+    ///  expanding them (see LP_EXPANSION_TIME), since creation
+    void GetExpansionTimeStats(uint64_t& iExpanded, uint64_t& iMicroseconds) const;
+
+    /// Nodes expanded as they came to cover the crosshair, while rendering (forced), and
+    ///  those expanded ahead of it by LookaheadPolicy (LP_LOOKAHEAD_FRAMES), since creation
+    void GetLookaheadStats(uint64_t& iForced, uint64_t& iAhead) const;
+
     /// Does this subclass support speech (i.e. the speak(string) method?)
     ///  Default is just to return false.
     virtual bool SupportsSpeech() { return false; }
@@ -492,6 +523,11 @@ class Dasher::CDasherInterfaceBase : public CMessageDisplay, private NoClones {
     void CreateModel(int iOffset);
     void CreateNCManager();
 
+    /// If the LM is being trained in the background: once it has finished (or, if bWait,
+    ///  after waiting for it to), rebuilds the tree of nodes around the trained model and
+    ///  unlocks; until then, keeps the lock message up to date with the training progress.
+    void UpdateBackgroundTraining(bool bWait);
+
     void ChangeAlphabet();
     void ChangeColors();
     void ChangeView();
@@ -533,6 +569,17 @@ class Dasher::CDasherInterfaceBase : public CMessageDisplay, private NoClones {
     /// Whether we moved anywhere in the last call to NewFrame.
     bool m_bLastMoved = false;
 
+    /// Whether NewFrame is running (to stop it being reentered)
+    bool m_bInNewFrame = false;
+
+    const FileUtils m_fileUtils;
+
+    /// Counts for GetLookaheadStats
+    uint64_t m_iForcedExpansions = 0, m_iExpandedAhead = 0;
+    /// Counts for GetExpansionTimeStats
+    uint64_t m_iPolicyExpanded = 0;
+    double m_dPolicyExpandMicroseconds = 0.0;
+
     /// Low-memory mode flag: load only selected alphabet + minimal modules.
     bool m_bLowMemoryMode = false;
 
@@ -64,6 +64,7 @@ CDasherModel::~CDasherModel() {
         delete m_Root;
         m_Root = NULL;
     }
+    m_pNodePool->Detach();
 }
 
 // Function reimplemented from description:
@@ -118,6 +119,7 @@ bool CDasherModel::Reparent_root() {
     CDasherNode* pNewRoot;
 
     if (oldroots.size() == 0) {
+        CNodePool::Scope scope(m_pNodePool);
         pNewRoot = m_Root->RebuildParent();
         // Fail if there's no existing parent and no way of recreating one
         if (pNewRoot == NULL) return false;
@@ -184,6 +186,7 @@ void CDasherModel::ClearRootQueue() {
 void CDasherModel::SetNode(CDasherNode* pNewRoot) {
 
     AbortOffset();
+    m_bMoving = false;
     ClearRootQueue();
     delete m_Root;
 
@@ -209,6 +212,13 @@ void CDasherModel::SetNode(CDasherNode* pNewRoot) {
     m_Rootmax = MAX_Y / 2 + iWidth / 2;
 }
 
+void CDasherModel::DeleteNodes() {
+    AbortOffset();
+    ClearRootQueue();
+    delete m_Root;
+    m_pLastOutput = m_Root = NULL;
+}
+
 int CDasherModel::GetOffset() {
     return m_pLastOutput ? m_pLastOutput->offset() + 1 : m_Root ? m_Root->offset() + 1 : 0;
 }
@@ -218,6 +228,8 @@ CDasherNode* CDasherModel::Get_node_under_crosshair() {
 }
 
 bool CDasherModel::NextScheduledStep() {
+    const bool bWasMoving = m_bMoving;
+    m_bMoving = false;
     if (m_deGotoQueue.size() == 0) return false;
     myint newRootmin(m_deGotoQueue.front().first), newRootmax(m_deGotoQueue.front().second);
     m_deGotoQueue.pop_front();
@@ -282,6 +294,14 @@ bool CDasherModel::NextScheduledStep() {
     // (as is trying to go back beyond the earliest char in the current
     // alphabet, if there are preceding characters not in that alphabet)
     if ((newRootmax - newRootmin) > MAX_Y / 4) {
+        // Record the step for PredictCrosshair: the (affine) map taking the old root coordinates to the new
+        //  (the same before and after any Make_root above, as both move the root's coordinates alike)
+        const double dScale = (newRootmax - newRootmin) / static_cast<double>(m_Rootmax - m_Rootmin);
+        const double dShift = newRootmin - dScale * m_Rootmin;
+        m_dStepScale = bWasMoving ? (m_dStepScale + dScale) / 2 : dScale;
+        m_dStepShift = bWasMoving ? (m_dStepShift + dShift) / 2 : dShift;
+        m_bMoving = true;
+
         m_Rootmax = newRootmax;
         m_Rootmin = newRootmin;
         return true;
@@ -290,6 +310,21 @@ bool CDasherModel::NextScheduledStep() {
     return false;
 }
 
+bool CDasherModel::PredictCrosshair(int iFrames, myint& iY, double& dZoom) const {
+    if (!m_bMoving) return false;
+    // Undo the step iFrames times, from the crosshair (in root coordinates, i.e. without the display offset)
+    double dY = static_cast<double>(ORIGIN_Y - m_iDisplayOffset);
+    dZoom = 1.0;
+    for (int i = 0; i < iFrames; i++) {
+        dY = (dY - m_dStepShift) / m_dStepScale;
+        dZoom *= m_dStepScale;
+    }
+    // (Anything beyond the root's permitted range is as good as infinitely far away)
+    iY = static_cast<myint>(std::clamp(dY, static_cast<double>(m_Rootmin_min), static_cast<double>(m_Rootmax_max))) +
+         m_iDisplayOffset;
+    return true;
+}
+
 /// A very approximate square root. Finds the square root of (just) the
 ///  most significant bit, then two iterations of Newton.
 inline dasherint mysqrt(dasherint in) {
@@ -471,9 +506,21 @@ else // conditional - only do one of exact/approx
             return;
         }
 
+        if (m_subtreeCache.Revive(pNode)) {
+            // (whatever was on the game's path then may not be now)
+            for (CDasherNode* pChild : pNode->GetChildren())
+                pChild->SetFlag(CDasherNode::NF_GAME, false);
+            pNode->SetFlag(CDasherNode::NF_COLLAPSED, false);
+            OnNodeChildrenCreated.Broadcast(pNode);
+            return;
+        }
+
         // TODO: Do we really need to delete all of the children at this point?
         pNode->DeleteChildren(); // trial commented out - pconlon
 
+        CNodePool::Scope scope(m_pNodePool);
+        pNode->ReserveChildren(static_cast<unsigned int>(std::max(0, pNode->ExpectedNumChildren())));
+
 #ifdef DEBUG
         unsigned int iExpect = pNode->ExpectedNumChildren();
 #endif
@@ -486,6 +533,7 @@ else // conditional - only do one of exact/approx
 #endif
 
         pNode->SetFlag(CDasherNode::NF_ALLCHILDREN, true);
+        pNode->SetFlag(CDasherNode::NF_COLLAPSED, false);
 
         OnNodeChildrenCreated.Broadcast(pNode);
     }
@@ -27,6 +27,7 @@
 #include "DasherTypes.h"
 #include "Event.h"
 #include "ExpansionPolicy.h"
+#include "SubtreeCache.h"
 
 namespace Dasher {
 class CDasherModel;
@@ -142,6 +143,13 @@ class Dasher::CDasherModel : private NoClones {
     ///
     bool NextScheduledStep();
 
+    /// Where the crosshair is heading, if the model keeps moving as in its last few steps.
+    /// \param iFrames how many more frames (steps) of that movement to look ahead
+    /// \param iY set to the Y coordinate (as rendered now) of the point that will then be under the crosshair
+    /// \param dZoom set to the factor by which everything there will have grown by then
+    /// \return false if the last frame did not move the model (so there's nothing to go on)
+    bool PredictCrosshair(int iFrames, myint& iY, double& dZoom) const;
+
     /// @}
 
     /// Returns the node that was under the crosshair in the
@@ -149,6 +157,13 @@ class Dasher::CDasherModel : private NoClones {
     /// node output.)
     CDasherNode* Get_node_under_crosshair();
 
+    /// Returns the root node, and sets its Y coordinates as rendered
+    CDasherNode* GetRoot(myint& iRootMin, myint& iRootMax) const {
+        iRootMin = m_Rootmin + m_iDisplayOffset;
+        iRootMax = m_Rootmax + m_iDisplayOffset;
+        return m_Root;
+    }
+
     ///
     /// This is pretty horrible - a rethink of the start/reset mechanism
     /// is definitely in order. Used to prevent the root node from being
@@ -163,6 +178,13 @@ class Dasher::CDasherModel : private NoClones {
 
     void SetNode(CDasherNode* pNewRoot);
 
+    ///
+    /// Delete the whole tree of nodes, e.g. before replacing the language model
+    /// their contexts came from. SetNode must be called before the model is used again.
+    ///
+
+    void DeleteNodes();
+
     ///
     /// The current offset of the cursor/insertion point in the text buffer
     /// - measured in (unicode) characters, _not_ octets.
@@ -170,13 +192,30 @@ class Dasher::CDasherModel : private NoClones {
 
     int GetOffset();
 
-    /// Create the children of a Dasher node
+    /// Create the children of a Dasher node - or give it back those parked when it was collapsed
     void ExpandNode(CDasherNode* pNode);
 
+    /// Delete the children of a Dasher node, or park them in the subtree cache, if it has room
+    void CollapseNode(CDasherNode* pNode) { m_subtreeCache.Collapse(pNode); }
+
+    /// Where the nodes the model creates get their memory (see CNodePool)
+    const CNodePool& GetNodePool() const { return *m_pNodePool; }
+
+    /// Where collapsed nodes' children are kept, to give back if expanded again (see CSubtreeCache)
+    CSubtreeCache& GetSubtreeCache() { return m_subtreeCache; }
+    const CSubtreeCache& GetSubtreeCache() const { return m_subtreeCache; }
+
     /// broadcasts a pointer to a CDasherNode when the node's children are created.
     Event<CDasherNode*> OnNodeChildrenCreated;
 
   private:
+    // Recycles the memory of nodes collapsed, for nodes expanded; detached (so deleted once
+    //  the last node is) on destruction
+    CNodePool* m_pNodePool = new CNodePool();
+
+    // Children of collapsed nodes (all deleted with the tree, before this)
+    CSubtreeCache m_subtreeCache;
+
     // The root of the Dasher tree
     CDasherNode* m_Root;
 
@@ -207,6 +246,11 @@ class Dasher::CDasherModel : private NoClones {
     // of min/max coordinates for root node
     std::deque<std::pair<myint, myint>> m_deGotoQueue;
 
+    // Recent steps, averaged: each moved Y coordinate y to (m_dStepScale * y + m_dStepShift).
+    //  Only valid if m_bMoving, i.e. the last call to NextScheduledStep moved.
+    double m_dStepScale = 1.0, m_dStepShift = 0.0;
+    bool m_bMoving = false;
+
     /// TODO: Not sure what this actually does
     double m_dAddProb;
 
@@ -22,28 +22,21 @@
 
 #include "DasherInterfaceBase.h"
 
-using namespace Dasher;
-
-static int iNumNodes = 0;
+#include <algorithm>
 
-int Dasher::currentNumNodeObjects() {
-    return iNumNodes;
-}
+using namespace Dasher;
 
 // TODO this used to be inline - should we make it so again?
 CDasherNode::CDasherNode(int iOffset, CDasherScreen::Label* pLabel)
     : onlyChildRendered(NULL), m_iLbnd(0), m_iHbnd(CDasherModel::NORMALIZATION), m_pParent(NULL),
-      m_iFlags(DEFAULT_FLAGS), m_iOffset(iOffset), m_pLabel(pLabel) {
-    iNumNodes++;
-}
+      m_iFlags(DEFAULT_FLAGS), m_iOffset(iOffset), m_pLabel(pLabel) {}
 
 // TODO: put this back to being inlined
 CDasherNode::~CDasherNode() {
     // Release any storage that the node manager has allocated,
     // unreference ref counted stuff etc.
     DeleteChildren();
-
-    iNumNodes--;
+    if (m_pParked) CSubtreeCache::Discard(m_pParked);
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -89,13 +82,13 @@ void CDasherNode::SetFlag(int iFlag, bool bValue) {
 //- Reset the NF_ALLCHILDREN flag on the called node
 
 void CDasherNode::OrphanChild(CDasherNode* pChild) {
-    for (CDasherNode* child : Children()) { // Children is an std::deque
+    for (CDasherNode* child : GetChildren()) {
         if (child != pChild) {
             child->DeleteChildren();
             delete (child);
         }
     }
-    Children().clear();
+    FreeChildren();
     pChild->m_pParent = nullptr;
     SetFlag(NF_ALLCHILDREN, false);
 }
@@ -114,7 +107,23 @@ void CDasherNode::OrphanChild(CDasherNode* pChild) {
 //  Asserts skipped since Dasher_Assert is defined as ((void)true)
 void CDasherNode::Reparent(CDasherNode* pNewParent, unsigned int iLower, unsigned int iUpper) {
     m_pParent = pNewParent;
-    m_pParent->Children().push_back(this);
+    if (m_pParent->m_iChildCount == m_pParent->m_iChildCapacity) {
+        // More children than expected (or none were): grow the array, by half
+        const unsigned int iCount = m_pParent->m_iChildCount;
+        CDasherNode** ppOld = m_pParent->m_ppChildren;
+        const CArrayView<unsigned int> vOldHbnds = m_pParent->GetChildHbnds();
+        m_pParent->m_ppChildren = nullptr;
+        m_pParent->m_iChildCount = m_pParent->m_iChildCapacity = 0;
+        m_pParent->ReserveChildren(iCount ? iCount + (iCount + 1) / 2 : 4);
+        std::copy(ppOld, ppOld + iCount, m_pParent->m_ppChildren);
+        std::copy(vOldHbnds.begin(), vOldHbnds.end(),
+                  reinterpret_cast<unsigned int*>(m_pParent->m_ppChildren + m_pParent->m_iChildCapacity));
+        m_pParent->m_iChildCount = iCount;
+        ::operator delete(ppOld);
+    }
+    const unsigned int i = m_pParent->m_iChildCount++;
+    m_pParent->m_ppChildren[i] = this;
+    reinterpret_cast<unsigned int*>(m_pParent->m_ppChildren + m_pParent->m_iChildCapacity)[i] = iUpper;
     m_iLbnd = iLower;
     m_iHbnd = iUpper;
 }
@@ -122,10 +131,10 @@ void CDasherNode::Reparent(CDasherNode* pNewParent, unsigned int iLower, unsigne
 // Delete nephews of the child which has the specified symbol
 // TODO: Need to allow for subnode
 void CDasherNode::DeleteNephews(CDasherNode* pChild) {
-    DASHER_ASSERT(Children().size() > 0);
+    DASHER_ASSERT(ChildCount() > 0);
 
     ChildMap::iterator i;
-    for (i = Children().begin(); i != Children().end(); i++) {
+    for (i = GetChildren().begin(); i != GetChildren().end(); i++) {
         if (*i != pChild) {
             (*i)->DeleteChildren();
         }
@@ -137,19 +146,31 @@ void CDasherNode::DeleteNephews(CDasherNode* pChild) {
 //- Reset the NF_ALLCHILDREN flag
 //- Set the OnlyChildRendered to nullptr
 void CDasherNode::DeleteChildren() {
-    for (CDasherNode* child : Children()) {
+    for (CDasherNode* child : GetChildren()) {
         delete (child);
     }
-    Children().clear();
+    FreeChildren();
     SetFlag(NF_ALLCHILDREN, false); // NOLINT(clang-analyzer-optin.cplusplus.VirtualCall)
     onlyChildRendered = nullptr;
 }
 
+void CDasherNode::ReserveChildren(unsigned int iCount) {
+    if (m_ppChildren || !iCount) return;
+    m_ppChildren = static_cast<CDasherNode**>(::operator new(iCount * (sizeof(CDasherNode*) + sizeof(unsigned int))));
+    m_iChildCapacity = iCount;
+}
+
+void CDasherNode::FreeChildren() {
+    ::operator delete(m_ppChildren);
+    m_ppChildren = nullptr;
+    m_iChildCount = m_iChildCapacity = 0;
+}
+
 int CDasherNode::MostProbableChild() {
     int iMax(0);
     int iCurrent;
 
-    for (ChildMap::iterator it(m_mChildren.begin()); it != m_mChildren.end(); ++it) {
+    for (ChildMap::iterator it(GetChildren().begin()); it != GetChildren().end(); ++it) {
         iCurrent = (*it)->Range();
 
         if (iCurrent > iMax) iMax = iCurrent;
@@ -159,7 +180,7 @@ int CDasherNode::MostProbableChild() {
 }
 
 bool CDasherNode::GameSearchChildren(symbol sym) {
-    for (ChildMap::iterator i = Children().begin(); i != Children().end(); i++) {
+    for (ChildMap::iterator i = GetChildren().begin(); i != GetChildren().end(); i++) {
         if ((*i)->GameSearchNode(sym)) return true;
     }
     return false;
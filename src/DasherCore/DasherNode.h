@@ -21,18 +21,40 @@
 #pragma once
 
 #include "DasherCore/Common/NoClones.h"
+#include "DasherCore/Common/Allocators/NodePool.h"
 // Includes needed for used classes
 #include "NodeManager.h"
 #include "Alphabet/AlphabetMap.h"
 #include "DasherScreen.h"
+#include "SubtreeCache.h"
 
 // CDasherNode represents a rectangle and character
 
 namespace Dasher {
 class CDasherNode;
 class CDasherInterfaceBase;
+
+/// Read-only view of a contiguous array - a node's children, or their Hbnds
+template <typename T>
+class CArrayView {
+  public:
+    typedef const T* const_iterator;
+    typedef const T* iterator;
+    CArrayView(const T* pBegin, std::size_t iSize) : m_pBegin(pBegin), m_iSize(iSize) {}
+    const T* begin() const { return m_pBegin; }
+    const T* end() const { return m_pBegin + m_iSize; }
+    std::size_t size() const { return m_iSize; }
+    bool empty() const { return m_iSize == 0; }
+    const T& operator[](std::size_t i) const { return m_pBegin[i]; }
+    const T& front() const { return m_pBegin[0]; }
+    const T& back() const { return m_pBegin[m_iSize - 1]; }
+
+  private:
+    const T* m_pBegin;
+    std::size_t m_iSize;
+};
 } // namespace Dasher
-#include <deque>
+#include <cstddef>
 #include <vector>
 
 /// \ingroup Model
@@ -75,6 +97,10 @@ class Dasher::CDasherNode : private NoClones {
         /// to be made the new root)
         NF_SUPER = 32,
 
+        /// NF_COLLAPSED - Node's children have been collapsed (deleted, or parked in
+        /// the model's CSubtreeCache) since it was last expanded
+        NF_COLLAPSED = 64,
+
         /// Flags to assign to a newly created node:
         DEFAULT_FLAGS = 0
     };
@@ -100,8 +126,9 @@ class Dasher::CDasherNode : private NoClones {
     CDasherNode* onlyChildRendered; // cache that only one child was rendered (as it filled the screen)
 
     /// Container type for storing children. Note that it's worth
-    /// optimising this as lookup happens a lot
-    typedef std::deque<CDasherNode*> ChildMap;
+    /// optimising this as lookup happens a lot: so the children are kept in
+    /// one array (see ReserveChildren), which this views
+    typedef CArrayView<CDasherNode*> ChildMap;
 
     /// @brief Constructor
     ///
@@ -118,6 +145,11 @@ class Dasher::CDasherNode : private NoClones {
     ///
     virtual ~CDasherNode();
 
+    /// Nodes take their memory from the pool current on the thread, if any (see CNodePool) -
+    ///  the model's, while it expands nodes - so collapsing and expanding recycles it
+    static void* operator new(std::size_t iBytes) { return CNodePool::Allocate(CNodePool::Current(), iBytes); }
+    static void operator delete(void* p) { CNodePool::Free(p); }
+
     void Trace() const; // diagnostic
 
     /// @name Routines for manipulating node status
@@ -177,10 +209,19 @@ class Dasher::CDasherNode : private NoClones {
     /// @name Routines for manipulating relatives
     /// @{
 
-    inline const ChildMap& GetChildren() const;
+    inline ChildMap GetChildren() const;
+    /// Hbnd of each child, in the same order: kept together in one array, so the
+    ///  view can binary search it for the first child on screen without visiting the rest
+    inline CArrayView<unsigned int> GetChildHbnds() const;
     inline unsigned int ChildCount() const;
     inline CDasherNode* Parent() const;
 
+    /// Makes room for iCount children (and their Hbnds), in one allocation, before the
+    ///  first is added: nodes get all their children at once (see NF_ALLCHILDREN), so the
+    ///  model calls this with ExpectedNumChildren() before PopulateChildren(). Any more
+    ///  children than that grow the array. Does nothing if there are children already.
+    void ReserveChildren(unsigned int iCount);
+
     /// Makes the node be the child of a new parent, and set its range amongst
     /// that parent's children. This node will be positioned AFTER any/all
     /// existing children of the new parent; so TODO - iLower redundant?
@@ -282,12 +323,22 @@ class Dasher::CDasherNode : private NoClones {
     /// @}
 
   private:
-    inline ChildMap& Children();
+    /// Moves children in and out of m_ppChildren, and m_pParked
+    friend class CSubtreeCache;
+
+    /// Deletes the array of children (not the children)
+    void FreeChildren();
 
     unsigned int m_iLbnd;
     unsigned int m_iHbnd; // the cumulative lower and upper bound prob relative to parent
 
-    ChildMap m_mChildren;   // pointer to array of children
+    // Array of children, followed (after room for m_iChildCapacity of them) by their Hbnds, in
+    //  the same order; NULL if no room has been made. (Nodes are many, and mostly have no
+    //  children: so the array is allocated only for children, and no bigger than needed.)
+    CDasherNode** m_ppChildren = nullptr;
+    unsigned int m_iChildCount = 0, m_iChildCapacity = 0;
+    // Children collapsed, and parked in the model's CSubtreeCache until this is expanded again, if any
+    SParkedChildren* m_pParked = nullptr;
     CDasherNode* m_pParent; // pointer to parent
 
     // Binary flags representing the state of the node
@@ -300,11 +351,6 @@ class Dasher::CDasherNode : private NoClones {
 };
 /// @}
 
-namespace Dasher {
-/// Return the number of CDasherNode objects currently in existence.
-int currentNumNodeObjects();
-} // namespace Dasher
-
 /////////////////////////////////////////////////////////////////////////////
 // Inline functions
 /////////////////////////////////////////////////////////////////////////////
@@ -325,16 +371,17 @@ inline unsigned int CDasherNode::Range() const {
 
 /////////////////////////////////////////////////////////////////////////////
 
-inline CDasherNode::ChildMap& CDasherNode::Children() {
-    return m_mChildren;
+inline CDasherNode::ChildMap CDasherNode::GetChildren() const {
+    return ChildMap(m_ppChildren, m_iChildCount);
 }
 
-inline const CDasherNode::ChildMap& CDasherNode::GetChildren() const {
-    return m_mChildren;
+inline CArrayView<unsigned int> CDasherNode::GetChildHbnds() const {
+    return CArrayView<unsigned int>(reinterpret_cast<const unsigned int*>(m_ppChildren + m_iChildCapacity),
+                                    m_iChildCount);
 }
 
 inline unsigned int CDasherNode::ChildCount() const {
-    return static_cast<unsigned int>(m_mChildren.size());
+    return m_iChildCount;
 }
 
 inline bool CDasherNode::GetFlag(int iFlag) const {
@@ -14,6 +14,7 @@
 // Also make CDasher screen operate in UTF8 strings only
 
 namespace Dasher {
+class CDasherNode;
 class CDasherScreen;
 class CLabelListScreen;
 class CDasherInterfaceBase;
@@ -83,6 +84,11 @@ class Dasher::CDasherScreen {
         return new Label(strText, iWrapSize);
     }
 
+    /// An id for a Label previously created by MakeLabel, by which a frontend can look up
+    ///  its text without it being copied each frame: the same for as long as the label
+    ///  exists, and never given to another. -1 if this screen gives labels no ids.
+    virtual int GetLabelId(const Label* label) const { return -1; }
+
     /// Get Width and Height of a Label previously created by MakeLabel. Note behaviour
     ///  undefined if the Label is not one returned from a call to MakeLabel _on_this_Screen_.
     virtual std::pair<screenint, screenint> TextSize(Label* label, unsigned int iFontSize) = 0;
@@ -157,6 +163,16 @@ class Dasher::CDasherScreen {
     //! Signal that a frame is finished - the screen should be updated
     virtual void Display() = 0;
 
+    /// Say which node the drawing calls that follow are for (NULL: none - backgrounds,
+    ///  the crosshair, decorations, messages). Lets a screen that keeps what it drew
+    ///  last frame match up what it draws this frame; the default ignores it.
+    virtual void SetDrawingNode(const CDasherNode* pNode) {}
+
+    /// Called once the nodes have been drawn for a frame, before any decorations.
+    ///  \param bRedrawn false if the nodes were not redrawn this frame (nothing
+    ///  moved), so only decorations follow, to go over the nodes drawn last time.
+    virtual void EndNodes(bool bRedrawn) {}
+
     // Returns true if point on screen is not obscured by another window
     virtual bool IsPointVisible(screenint x, screenint y) = 0;
 
@@ -39,15 +39,12 @@ void CDasherView::ChangeScreen(CDasherScreen* NewScreen) {
 void CDasherView::DasherSpaceLine(myint x1, myint y1, myint x2, myint y2, int iWidth,
                                   const ColorPalette::Color& color) const {
     if (!ClipLineToVisible(x1, y1, x2, y2)) return;
-    std::vector<point> vPoints;
+    PointList vPoints(NewPointList());
     point p;
     Dasher2Screen(x1, y1, p.x, p.y);
     vPoints.push_back(p);
     DasherLine2Screen(x1, y1, x2, y2, vPoints);
-    point* pts = new point[vPoints.size()];
-    for (int i = static_cast<int>(vPoints.size()); i-- > 0;)
-        pts[i] = vPoints[i];
-    Screen()->Polyline(pts, static_cast<int>(vPoints.size()), iWidth, color);
+    Screen()->Polyline(vPoints.data(), static_cast<int>(vPoints.size()), iWidth, color);
 }
 
 bool CDasherView::ClipLineToVisible(myint& x1, myint& y1, myint& x2, myint& y2) const {
@@ -90,21 +87,19 @@ bool CDasherView::ClipLineToVisible(myint& x1, myint& y1, myint& x2, myint& y2)
 
 void CDasherView::DasherPolyline(myint* x, myint* y, int n, int iWidth, const ColorPalette::Color& color) const {
 
-    point* ScreenPoints = new point[n];
+    point* ScreenPoints = FrameArena().NewArray<point>(n);
 
     for (int i(0); i < n; ++i)
         Dasher2Screen(x[i], y[i], ScreenPoints[i].x, ScreenPoints[i].y);
 
     Screen()->Polyline(ScreenPoints, n, iWidth, color);
-
-    delete[] ScreenPoints;
 }
 
 // Draw a polyline with an arrow on the end
 void CDasherView::DasherPolyarrow(myint* x, myint* y, int n, int iWidth, const ColorPalette::Color& color,
                                   double dArrowSizeFactor) const {
 
-    point* ScreenPoints = new point[n + 3];
+    point* ScreenPoints = FrameArena().NewArray<point>(n + 3);
 
     for (int i(0); i < n; ++i)
         Dasher2Screen(x[i], y[i], ScreenPoints[i].x, ScreenPoints[i].y);
@@ -120,8 +115,6 @@ void CDasherView::DasherPolyarrow(myint* x, myint* y, int n, int iWidth, const C
     ScreenPoints[n + 2].y = ScreenPoints[n - 1].y + iXvec + iYvec;
 
     Screen()->Polyline(ScreenPoints, n + 3, iWidth, color);
-
-    delete[] ScreenPoints;
 }
 
 // Draw a box specified in Dasher co-ordinates
@@ -167,7 +160,7 @@ void CDasherView::SetColorScheme(const ColorPalette* pColorScheme) {
     m_pColorPalette = pColorScheme;
 }
 
-const ColorPalette::Color& CDasherView::GetNamedColor(NamedColor::knownColorName color) const {
+const ColorPalette::Color& CDasherView::GetNamedColor(const NamedColor::knownColorName& color) const {
     if (color.empty() || !m_pColorPalette) return ColorPalette::noColor;
     return m_pColorPalette->GetNamedColor(color);
 }
@@ -14,6 +14,8 @@ class CDasherNode;
 #include "DasherScreen.h"
 #include "Event.h"
 #include "ColorPalette.h"
+#include "VisibleNodeArrays.h"
+#include "Common/Allocators/FrameArena.h"
 
 #include <string>
 #include <vector>
@@ -169,8 +171,28 @@ class Dasher::CDasherView {
     /// capture is enabled). Returned by value; valid until the next Render().
     virtual std::vector<VisibleNode> GetVisibleNodes() const { return {}; }
 
+    /// The same nodes, recorded as parallel arrays (SVisibleNodeArrays) into a double
+    /// buffer another thread can read from while the next frame is rendered, without
+    /// copying (see CVisibleNodeArrays). Also off by default, and independent of the above.
+    virtual void SetVisibleNodeArraysCapture(bool /*enabled*/) {}
+    virtual bool IsVisibleNodeArraysCaptureEnabled() const { return false; }
+    /// The double buffer the arrays are recorded into (nullptr if this view records none)
+    virtual CVisibleNodeArrays* GetVisibleNodeArrays() { return nullptr; }
+
     /// @}
 
+    /// Counts from the most recent Render(): nodes whose extent on screen was
+    ///  worked out (visited), nodes drawn, children wholly above the
+    ///  screen, skipped by binary search without being visited, and nodes
+    ///  covering the crosshair without children, so expanded there and then.
+    struct RenderStats {
+        int iVisited = 0;
+        int iDrawn = 0;
+        int iSkipped = 0;
+        int iForced = 0;
+    };
+    virtual RenderStats GetRenderStats() const { return {}; }
+
     ////// Return a reference to the screen - can't be protected due to circlestarthandler
 
     CDasherScreen* Screen() const { return m_pScreen; }
@@ -235,7 +257,7 @@ class Dasher::CDasherView {
     ///
     virtual void SetColorScheme(const ColorPalette* pColorScheme);
 
-    const ColorPalette::Color& GetNamedColor(NamedColor::knownColorName color) const;
+    const ColorPalette::Color& GetNamedColor(const NamedColor::knownColorName& color) const;
 
     /// Clips a line (specified in Dasher co-ordinates) to the visible region
     /// by intersecting with all boundaries.
@@ -243,7 +265,21 @@ class Dasher::CDasherView {
     /// exactly that part false if the line would be entirely outside the visible region; x1, y1, x2, y2 undefined.
     bool ClipLineToVisible(myint& x1, myint& y1, myint& x2, myint& y2) const;
 
+    /// Memory for everything drawing one frame needs only until the next (text
+    ///  requests, polygon points...); reset by ResetFrameArena, so a frame no busier
+    ///  than those before it allocates nothing from the heap.
+    const CFrameArena& GetFrameArena() const { return m_FrameArena; }
+    /// Call at the start of every frame, whether or not it renders the nodes:
+    ///  decorations (e.g. the mouse line) are drawn from the arena too.
+    void ResetFrameArena() { m_FrameArena.Reset(); }
+
   protected:
+    /// Screen points for a polyline or polygon, stored in the frame arena
+    typedef std::vector<point, CFrameArena::Allocator<point>> PointList;
+    PointList NewPointList() const { return PointList(CFrameArena::Allocator<point>(m_FrameArena)); }
+
+    CFrameArena& FrameArena() const { return m_FrameArena; }
+
     /// Convert a straight line in Dasher-space, to coordinates for a corresponding polyline on the screen
     ///  (because of nonlinearity, this may require multiple line segments)
     ///  \param x1 , y1 Dasher co-ordinates of start of line segment; note that these are guaranteed within
@@ -252,13 +288,14 @@ class Dasher::CDasherView {
     ///  \param vPoints vector to which to add screen points. Note that at the point that DasherLine2Screen is called,
     ///  the screen coordinates of the first point should already have been added to this vector; DasherLine2Screen
     ///  will then add exactly one point for each line segment required.
-    virtual void DasherLine2Screen(myint x1, myint y1, myint x2, myint y2, std::vector<point>& vPoints) const = 0;
+    virtual void DasherLine2Screen(myint x1, myint y1, myint x2, myint y2, PointList& vPoints) const = 0;
 
     const ColorPalette* m_pColorPalette = nullptr;
 
   private:
     Options::ScreenOrientations m_Orientation;
     CDasherScreen* m_pScreen; // provides the graphics (text, lines, rectangles):
+    mutable CFrameArena m_FrameArena;
 };
 
 /// @}
@@ -72,14 +72,17 @@ void CDasherViewSquare::SetOrientation(Options::ScreenOrientations newOrient) {
 
 CDasherNode* CDasherViewSquare::Render(CDasherNode* pRoot, myint iRootMin, myint iRootMax, CExpansionPolicy& policy) {
     DASHER_ASSERT(pRoot != 0);
+    Screen()->SetDrawingNode(nullptr);
+    m_renderStats = RenderStats();
     if (m_captureVisibleNodes) m_visibleNodes.clear();
+    m_pNodeArraysFrame = m_captureNodeArrays ? &m_nodeArrays.BeginFrame() : nullptr;
     const DasherCoordScreenRegion visibleRegion = VisibleRegion();
     const ScreenRegion screenRegion = {0, 0, Screen()->GetWidth(), Screen()->GetHeight()};
 
     CDasherNode* currentTopCenterNode = pRoot->Parent(); // Node under crosshair
 
     // Blank the region around the root node:
-    if (m_pSettingsStore->GetLongParameter(LP_SHAPE_TYPE) == Options::DISJOINT_RECTANGLE) {
+    if (m_pSettingsStore->GetRenderSettings().iShapeType == Options::DISJOINT_RECTANGLE) {
         // disjoint rects, so go round root
         if (iRootMin > visibleRegion.minY)
             DasherDrawRectangle(visibleRegion.maxX, visibleRegion.minY, visibleRegion.minX, iRootMin,
@@ -102,7 +105,7 @@ CDasherNode* CDasherViewSquare::Render(CDasherNode* pRoot, myint iRootMin, myint
         // and render root.
         DisjointRender(pRoot, iRootMin, iRootMax, nullptr, policy, std::numeric_limits<double>::infinity(),
                        currentTopCenterNode);
-    } else if (m_pSettingsStore->GetLongParameter(LP_SHAPE_TYPE) == Options::CUBE) {
+    } else if (m_pSettingsStore->GetRenderSettings().iShapeType == Options::CUBE) {
         // Render white box to left side of screen if other nodes do not completely cover the screen
         if (IsSpaceAroundNode(iRootMin, iRootMax))
             DasherDrawCube(visibleRegion.maxX, visibleRegion.minY, 0, visibleRegion.maxY, {-1, 0}, {-1, -1},
@@ -112,6 +115,7 @@ CDasherNode* CDasherViewSquare::Render(CDasherNode* pRoot, myint iRootMin, myint
         m_CrosshairCubeLevel = -1;
         NewRender(pRoot, iRootMin, iRootMax, nullptr, policy, std::numeric_limits<double>::infinity(),
                   currentTopCenterNode, {0, 0}, {-1, 0}, screenRegion);
+        Screen()->SetDrawingNode(nullptr);
 
         // to right (margin)
         DasherDrawCube(0, visibleRegion.minY, visibleRegion.minX, visibleRegion.maxY, {m_CrosshairCubeLevel, 0},
@@ -133,12 +137,14 @@ CDasherNode* CDasherViewSquare::Render(CDasherNode* pRoot, myint iRootMin, myint
             DoDelayedText(text.root_node, text.extrusionLevel, text.groupRecursionDepth);
         }
         m_Delayed3DTexts.clear();
+        Screen()->SetDrawingNode(nullptr);
 
         // Backshift all cubes and letters
         Screen()->FinishRender3D(originX, originY, m_CrosshairCubeLevel);
 
         // Finally decorate the view
         // Crosshair();
+        EndCapture();
         return currentTopCenterNode;
     } else {
         // overlapping rects/shapes
@@ -166,9 +172,11 @@ CDasherNode* CDasherViewSquare::Render(CDasherNode* pRoot, myint iRootMin, myint
     for (auto& m_DelayedText : m_DelayedTexts)
         DoDelayedText(m_DelayedText);
     m_DelayedTexts.clear();
+    Screen()->SetDrawingNode(nullptr);
 
     // Finally decorate the view
     Crosshair();
+    EndCapture();
     return currentTopCenterNode;
 }
 
@@ -177,6 +185,7 @@ CDasherNode* CDasherViewSquare::Render(CDasherNode* pRoot, myint iRootMin, myint
 /// the leading edge of the containing box.
 
 CDasherViewSquare::CTextString* CDasherViewSquare::DasherDrawText(myint iDasherMaxX, myint iDasherMidY,
+                                                                  const CDasherNode* pNode,
                                                                   CDasherScreen::Label* pLabel,
                                                                   const ColorPalette::Color& Color) const {
     screenint x, y;
@@ -189,12 +198,12 @@ CDasherViewSquare::CTextString* CDasherViewSquare::DasherDrawText(myint iDasherM
     // m_pSettingsStore->GetLongParameter(LP_DASHER_FONTSIZE) / iMaxY;
 
     // New formulation, where fontSize gives the maximum font size, which is reached at the crosshair
-    const float fSize = static_cast<float>(m_pSettingsStore->GetLongParameter(LP_DASHER_FONTSIZE));
+    const float fSize = static_cast<float>(m_pSettingsStore->GetRenderSettings().iFontSize);
     const float iSize = std::min(fSize, fSize * (0.6f * static_cast<float>(iDasherMaxX) / CDasherModel::ORIGIN_X +
                                                  0.4f)); // linear function passing through (0, fSize/2.5) and
                                                          // (CDasherModel::ORIGIN_X, fSize), capped at fSize
 
-    return new CTextString(pLabel, x, y, static_cast<int>(iSize), Color);
+    return FrameArena().New<CTextString>(pNode, pLabel, x, y, static_cast<int>(iSize), Color);
 }
 
 void CDasherViewSquare::DoDelayedText(CTextString* pText, myint extrusionLevel, myint groupRecursionDepth) {
@@ -210,11 +219,12 @@ void CDasherViewSquare::DoDelayedText(CTextString* pText, myint extrusionLevel,
     //  x gives the coordinate of the side of the corresponding box
     //  y gives the midpoint in y direction
     screenint x(pText->m_ix), y(pText->m_iy);
+    Screen()->SetDrawingNode(pText->m_pNode);
     std::pair<screenint, screenint> textDims = Screen()->TextSize(pText->m_pLabel, pText->m_iSize);
-    const bool extrudedText = m_pSettingsStore->GetLongParameter(LP_SHAPE_TYPE) == Options::CUBE;
+    const bool extrudedText = m_pSettingsStore->GetRenderSettings().iShapeType == Options::CUBE;
 
     screenint textInset =
-        m_pSettingsStore->GetLongParameter(LP_OUTLINE_WIDTH) + m_pSettingsStore->GetLongParameter(LP_TEXT_PADDING);
+        m_pSettingsStore->GetRenderSettings().iOutlineWidth + m_pSettingsStore->GetRenderSettings().iTextPadding;
 
     switch (GetOrientation()) {
     case Options::LeftToRight: {
@@ -228,11 +238,10 @@ void CDasherViewSquare::DoDelayedText(CTextString* pText, myint extrusionLevel,
                                      pText->m_Color);
             }
         }
-        for (const auto& pChild : pText->m_children) {
+        for (CTextString* pChild = pText->m_pFirstChild; pChild; pChild = pChild->m_pNext) {
             pChild->m_ix = std::max(pChild->m_ix, iRight);
             DoDelayedText(pChild, extrusionLevel + 1, 0);
         }
-        pText->m_children.clear();
         break;
     }
     case Options::RightToLeft: {
@@ -246,11 +255,10 @@ void CDasherViewSquare::DoDelayedText(CTextString* pText, myint extrusionLevel,
                                      pText->m_Color);
             }
         }
-        for (const auto& pChild : pText->m_children) {
+        for (CTextString* pChild = pText->m_pFirstChild; pChild; pChild = pChild->m_pNext) {
             pChild->m_ix = std::min(pChild->m_ix, iLeft);
             DoDelayedText(pChild, extrusionLevel + 1, 0);
         }
-        pText->m_children.clear();
         break;
     }
     case Options::TopToBottom: {
@@ -264,11 +272,10 @@ void CDasherViewSquare::DoDelayedText(CTextString* pText, myint extrusionLevel,
                                      pText->m_Color);
             }
         }
-        for (const auto& pChild : pText->m_children) {
+        for (CTextString* pChild = pText->m_pFirstChild; pChild; pChild = pChild->m_pNext) {
             pChild->m_iy = std::max(pChild->m_iy, iBottom);
             DoDelayedText(pChild, extrusionLevel + 1, 0);
         }
-        pText->m_children.clear();
         break;
     }
     case Options::BottomToTop: {
@@ -283,22 +290,14 @@ void CDasherViewSquare::DoDelayedText(CTextString* pText, myint extrusionLevel,
                                      pText->m_Color);
             }
         }
-        for (const auto& pChild : pText->m_children) {
+        for (CTextString* pChild = pText->m_pFirstChild; pChild; pChild = pChild->m_pNext) {
             DoDelayedText(pChild, extrusionLevel + 1, 0);
         }
-        pText->m_children.clear();
         break;
     }
     default:
         break;
     }
-    delete pText;
-}
-
-CDasherViewSquare::CTextString::~CTextString() {
-    for (auto& child : m_children) {
-        delete child;
-    }
 }
 
 void CDasherViewSquare::TruncateTri(myint x, myint y1, myint y2, myint midy1, myint midy2,
@@ -345,7 +344,8 @@ void CDasherViewSquare::TruncateTri(myint x, myint y1, myint y2, myint midy1, my
         }
     }
     // midy1,x1 is now start point
-    std::vector<point> pts(1);
+    PointList pts(NewPointList());
+    pts.emplace_back();
     Dasher2Screen(x1, midy1, pts[0].x, pts[0].y);
     DasherLine2Screen(x1, midy1, tempx1, y1, pts);
     if (tempx1) {
@@ -379,18 +379,14 @@ void CDasherViewSquare::TruncateTri(myint x, myint y1, myint y2, myint midy1, my
     } else
         DASHER_ASSERT(pts.back().x == pts[0].x && pts.back().y == pts[0].y);
 
-    auto p_array = new point[pts.size()];
-    for (unsigned int i = 0; i < pts.size(); i++)
-        p_array[i] = pts[i];
-    Screen()->Polygon(p_array, static_cast<int>(pts.size()), fillColor, outlineColor, lineWidth);
-    delete[] p_array;
+    Screen()->Polygon(pts.data(), static_cast<int>(pts.size()), fillColor, outlineColor, lineWidth);
 }
 
 #define sq(X) ((X) * (X))
 
 void CDasherViewSquare::Circle(myint Range, myint y1, myint y2, const ColorPalette::Color& fillColor,
                                const ColorPalette::Color& outlineColor, int lineWidth) const {
-    std::vector<point> pts;
+    PointList pts(NewPointList());
     myint cy((y1 + y2) / 2), r(Range / 2), x1, x2;
     const DasherCoordScreenRegion visibleRegion = VisibleRegion();
 
@@ -432,15 +428,11 @@ void CDasherViewSquare::Circle(myint Range, myint y1, myint y2, const ColorPalet
         Dasher2Screen(0, visibleRegion.maxX, p.x, p.y);
         pts.push_back(p);
     }
-    auto p_array = new point[pts.size()];
-    for (unsigned int i = 0; i < pts.size(); i++)
-        p_array[i] = pts[i];
-    Screen()->Polygon(p_array, static_cast<int>(pts.size()), fillColor, outlineColor, lineWidth);
-    delete[] p_array;
+    Screen()->Polygon(pts.data(), static_cast<int>(pts.size()), fillColor, outlineColor, lineWidth);
 }
 
 void CDasherViewSquare::CircleTo(myint cy, myint r, myint y1, myint x1, myint y3, myint x3, point dest,
-                                 std::vector<point>& pts, double dXMul, int depth) const {
+                                 PointList& pts, double dXMul, int depth) const {
     // Termination guards:
     //  - depth <= 0: hard cap on recursion so the stack can never be exhausted.
     //    Approximating the remaining arc with a straight line is always fine at
@@ -478,7 +470,7 @@ void CDasherViewSquare::DasherSpaceArc(myint cy, myint r, myint x1, myint y1, my
     point p;
     // start point
     Dasher2Screen(x1, y1, p.x, p.y);
-    std::vector<point> pts;
+    PointList pts(NewPointList());
     pts.push_back(p);
     // if circle goes behind crosshair and we want the point of max-x, force division into two sections with that point
     // as boundary
@@ -490,10 +482,7 @@ void CDasherViewSquare::DasherSpaceArc(myint cy, myint r, myint x1, myint y1, my
     }
     Dasher2Screen(x2, y2, p.x, p.y);
     CircleTo(cy, r, y1, x1, y2, x2, p, pts, 1.0);
-    auto p_array = new point[pts.size()];
-    for (unsigned int i = 0; i < pts.size(); i++)
-        p_array[i] = pts[i];
-    Screen()->Polyline(p_array, static_cast<int>(pts.size()), iLineWidth, color);
+    Screen()->Polyline(pts.data(), static_cast<int>(pts.size()), iLineWidth, color);
 }
 
 void CDasherViewSquare::Quadric(myint Range, myint lowY, myint highY, const ColorPalette::Color& fillColor,
@@ -546,7 +535,7 @@ bool CDasherViewSquare::IsSpaceAroundNode(myint y1, myint y2) const {
     // circles/ellipses) can span the full visible height yet legitimately miss
     // the crosshair, so CoversCrosshair can validly return false for them and
     // the assertion must not fire. (Circle mode used to SIGABRT here.)
-    switch (m_pSettingsStore->GetLongParameter(LP_SHAPE_TYPE)) {
+    switch (m_pSettingsStore->GetRenderSettings().iShapeType) {
     case Options::DISJOINT_RECTANGLE:
     case Options::OVERLAPPING_RECTANGLE:
     case Options::CUBE:
@@ -556,7 +545,7 @@ bool CDasherViewSquare::IsSpaceAroundNode(myint y1, myint y2) const {
         break;
     }
 
-    switch (m_pSettingsStore->GetLongParameter(LP_SHAPE_TYPE)) {
+    switch (m_pSettingsStore->GetRenderSettings().iShapeType) {
     case Options::DISJOINT_RECTANGLE:
     case Options::OVERLAPPING_RECTANGLE:
     case Options::CUBE:
@@ -598,17 +587,24 @@ void CDasherViewSquare::DisjointRender(CDasherNode* pRender, myint y1, myint y2,
     // area.
 
     const DasherCoordScreenRegion visibleRegion = VisibleRegion();
+    m_renderStats.iDrawn++;
     pRender->SetFlag(CDasherNode::NF_SUPER,
                      (y2 - y1 >= visibleRegion.maxX) && (y1 <= visibleRegion.minY) && (y2 >= visibleRegion.maxY));
 
-    if (m_captureVisibleNodes) CaptureNode(pRender, y1, y2, 0);
+    if (m_captureVisibleNodes || m_pNodeArraysFrame) CaptureNode(pRender, y1, y2, 0);
+    Screen()->SetDrawingNode(pRender);
 
     if (pRender->getLabel()) {
         myint ny1 = std::min(visibleRegion.maxY, std::max(visibleRegion.minY, y1)),
               ny2 = std::min(visibleRegion.maxY, std::max(visibleRegion.minY, y2));
         CTextString* pText =
-            DasherDrawText(y2 - y1, (ny1 + ny2) / 2, pRender->getLabel(), pRender->getLabelColor(m_pColorPalette));
-        ((pPrevText) ? pPrevText->m_children : m_DelayedTexts).push_back(pText); // add text at appropriate queue
+            DasherDrawText(y2 - y1, (ny1 + ny2) / 2, pRender, pRender->getLabel(),
+                           pRender->getLabelColor(m_pColorPalette));
+        // add text at appropriate queue
+        if (pPrevText)
+            pPrevText->AddChild(pText);
+        else
+            m_DelayedTexts.push_back(pText);
 
         if (pRender->bShove()) pPrevText = pText;
     }
@@ -622,6 +618,7 @@ void CDasherViewSquare::DisjointRender(CDasherNode* pRender, myint y1, myint y2,
         if (pRender->ChildCount() == 0) {
             // covers crosshair! forcibly populate, now!
             policy.ExpandNode(pRender);
+            m_renderStats.iForced++;
         }
     }
     if (pRender->ChildCount() == 0) {
@@ -651,6 +648,7 @@ void CDasherViewSquare::DisjointRender(CDasherNode* pRender, myint y1, myint y2,
 
         if (CDasherNode* pChild = pRender->onlyChildRendered) {
             // if child still covers screen, render _just_ it and return
+            m_renderStats.iVisited++;
             myint newy1 = y1 + (Range * pChild->Lbnd()) / CDasherModel::NORMALIZATION;
             myint newy2 = y1 + (Range * pChild->Hbnd()) / CDasherModel::NORMALIZATION;
             if (newy1 < visibleRegion.minY && newy2 > visibleRegion.maxY) {
@@ -663,6 +661,7 @@ void CDasherViewSquare::DisjointRender(CDasherNode* pRender, myint y1, myint y2,
                                         pRender->getNodeColor(m_pColorPalette),
                                         pRender->getOutlineColor(m_pColorPalette), 0);
                 DisjointRender(pChild, newy1, newy2, pPrevText, policy, dMaxCost, pOutput);
+                Screen()->SetDrawingNode(pRender);
                 // leave pRender->onlyChildRendered set, so remaining children are skipped
             } else
                 pRender->onlyChildRendered = nullptr;
@@ -674,6 +673,7 @@ void CDasherViewSquare::DisjointRender(CDasherNode* pRender, myint y1, myint y2,
             for (auto i = pRender->GetChildren().begin(); i != pRender->GetChildren().end(); ++i) {
                 id++;
                 CDasherNode* pChild = *i;
+                m_renderStats.iVisited++;
 
                 myint newy1 = y1 + (Range * pChild->Lbnd()) / CDasherModel::NORMALIZATION;
                 myint newy2 = y1 + (Range * pChild->Hbnd()) / CDasherModel::NORMALIZATION;
@@ -693,14 +693,15 @@ void CDasherViewSquare::DisjointRender(CDasherNode* pRender, myint y1, myint y2,
                                             pRender->getNodeColor(m_pColorPalette),
                                             pRender->getOutlineColor(m_pColorPalette), 0);
                     DisjointRender(pChild, newy1, newy2, pPrevText, policy, dMaxCost, pOutput);
+                    Screen()->SetDrawingNode(pRender);
                     // ensure we don't blank over this child in "finishing off" the parent (!)
                     lasty = newy2;
                     // all remaining children are offscreen. quickly delete, avoid recomputing ranges...
                     while ((++i) != pRender->GetChildren().end())
-                        if (!(*i)->GetFlag(CDasherNode::NF_SEEN)) (*i)->DeleteChildren();
+                        if (!(*i)->GetFlag(CDasherNode::NF_SEEN)) policy.CollapseNode(*i);
                     break;
                 }
-                if (newy2 - newy1 >= m_pSettingsStore->GetLongParameter(LP_MIN_NODE_SIZE) // simple test if big enough
+                if (newy2 - newy1 >= m_pSettingsStore->GetRenderSettings().iMinNodeSize // simple test if big enough
                     && newy1 <= visibleRegion.maxY && newy2 >= visibleRegion.minY)        // at least partly on screen
                 {
                     // child should be rendered!
@@ -717,10 +718,11 @@ void CDasherViewSquare::DisjointRender(CDasherNode* pRender, myint y1, myint y2,
                                             pRender->getOutlineColor(m_pColorPalette), 0);
                     lasty = newy2;
                     DisjointRender(pChild, newy1, newy2, pPrevText, policy, dMaxCost, pOutput);
+                    Screen()->SetDrawingNode(pRender);
                 } else {
                     // We get here if the node is too small to render or is off-screen.
                     // So, collapse it immediately.
-                    if (!pChild->GetFlag(CDasherNode::NF_SEEN)) pChild->DeleteChildren();
+                    if (!pChild->GetFlag(CDasherNode::NF_SEEN)) policy.CollapseNode(pChild);
                 }
             }
             // all children rendered.
@@ -734,12 +736,12 @@ void CDasherViewSquare::DisjointRender(CDasherNode* pRender, myint y1, myint y2,
         // end rendering children, fall through to outline
     }
     // Lastly, draw the outline
-    if (m_pSettingsStore->GetLongParameter(LP_OUTLINE_WIDTH) &&
+    if (m_pSettingsStore->GetRenderSettings().iOutlineWidth &&
         !pRender->getOutlineColor(m_pColorPalette).isFullyTransparent()) {
         DasherDrawRectangle(std::min(Range, visibleRegion.maxX), std::max(y1, visibleRegion.minY), 0,
                             std::min(y2, visibleRegion.maxY), ColorPalette::noColor,
                             pRender->getOutlineColor(m_pColorPalette),
-                            labs(m_pSettingsStore->GetLongParameter(LP_OUTLINE_WIDTH)));
+                            labs(m_pSettingsStore->GetRenderSettings().iOutlineWidth));
     }
 }
 
@@ -778,7 +780,7 @@ void CDasherViewSquare::DasherDrawCube(myint iDasherMaxX, myint iDasherMinY, myi
 
 bool CDasherViewSquare::CoversCrosshair(myint Range, myint y1, myint y2) const {
     if (Range > CDasherModel::ORIGIN_X && y1 < CDasherModel::ORIGIN_Y && y2 > CDasherModel::ORIGIN_Y) {
-        switch (m_pSettingsStore->GetLongParameter(LP_SHAPE_TYPE)) {
+        switch (m_pSettingsStore->GetRenderSettings().iShapeType) {
         case Options::DISJOINT_RECTANGLE:
         case Options::OVERLAPPING_RECTANGLE:
         case Options::CUBE:
@@ -869,10 +871,34 @@ void CDasherViewSquare::CaptureNode(CDasherNode* node, myint y1, myint y2, int d
     }
     rec.has_children = node->ChildCount() > 0 ? 1 : 0;
     rec.is_game_node = node->GetFlag(CDasherNode::NF_GAME) ? 1 : 0;
+    if (m_pNodeArraysFrame) {
+        // Written once, here, to be read in place (by another thread, while the next frame is rendered)
+        SVisibleNodeArrays& arrays = *m_pNodeArraysFrame;
+        arrays.vY1.push_back(y1);
+        arrays.vY2.push_back(y2);
+        arrays.vDepth.push_back(depth);
+        arrays.vScreenX1.push_back(rec.screen_x1);
+        arrays.vScreenY1.push_back(rec.screen_y1);
+        arrays.vScreenX2.push_back(rec.screen_x2);
+        arrays.vScreenY2.push_back(rec.screen_y2);
+        arrays.vFill.push_back(rec.fill.toARGB());
+        arrays.vOutline.push_back(rec.outline.toARGB());
+        arrays.vSymbol.push_back(rec.symbol);
+        arrays.vFlags.push_back((rec.has_children ? SVisibleNodeArrays::HAS_CHILDREN : 0) |
+                                (rec.is_game_node ? SVisibleNodeArrays::GAME : 0));
+        arrays.vLabelId.push_back(node->getLabel() ? Screen()->GetLabelId(node->getLabel()) : -1);
+    }
+    if (!m_captureVisibleNodes) return;
     if (auto* label = node->getLabel()) rec.label = label->m_strText;
     m_visibleNodes.push_back(rec);
 }
 
+void CDasherViewSquare::EndCapture() {
+    if (!m_pNodeArraysFrame) return;
+    m_pNodeArraysFrame = nullptr;
+    m_nodeArrays.EndFrame();
+}
+
 void CDasherViewSquare::NewRender(CDasherNode* pCurrentNode, myint y1, myint y2, CTextString* pPrevText,
                                   CExpansionPolicy& policy, double dMaxCost, CDasherNode*& pCurrentTopCenterNode,
                                   CubeDepthLevel nodeDepth, CubeDepthLevel parentDepth,
@@ -880,6 +906,7 @@ void CDasherViewSquare::NewRender(CDasherNode* pCurrentNode, myint y1, myint y2,
     DASHER_ASSERT_VALIDPTR_RW(pCurrentNode);
 
     const DasherCoordScreenRegion visibleRegion = VisibleRegion();
+    m_renderStats.iDrawn++;
 
     // Set the NF_SUPER flag if this node entirely frames the visual area.
     // This causes the model to adjust its root. Do not change the root node, if it would be fully transparent
@@ -897,14 +924,14 @@ void CDasherViewSquare::NewRender(CDasherNode* pCurrentNode, myint y1, myint y2,
     if (pCurrentNode->getLabel()) {
         myint ny1 = std::min(visibleRegion.maxY, std::max(visibleRegion.minY, y1)),
               ny2 = std::min(visibleRegion.maxY, std::max(visibleRegion.minY, y2));
-        CTextString* pText = DasherDrawText(y2 - y1, (ny1 + ny2) / 2, pCurrentNode->getLabel(),
+        CTextString* pText = DasherDrawText(y2 - y1, (ny1 + ny2) / 2, pCurrentNode, pCurrentNode->getLabel(),
                                             pCurrentNode->getLabelColor(m_pColorPalette));
 
         // add text at appropriate queue
         if (pPrevText) {
-            pPrevText->m_children.push_back(pText);
+            pPrevText->AddChild(pText);
         } else {
-            if (m_pSettingsStore->GetLongParameter(LP_SHAPE_TYPE) == Options::CUBE) {
+            if (m_pSettingsStore->GetRenderSettings().iShapeType == Options::CUBE) {
                 m_Delayed3DTexts.push_back({pText, nodeDepth.extrusionLevel, nodeDepth.groupRecursionDepth});
             } else {
                 m_DelayedTexts.push_back(pText);
@@ -928,18 +955,20 @@ void CDasherViewSquare::NewRender(CDasherNode* pCurrentNode, myint y1, myint y2,
     // color schemes)
     if (!pCurrentNode->getNodeColor(m_pColorPalette).isFullyTransparent()) {
         // outline width 0 = fill only; >0 = fill + outline; <0 = outline only
-        const int line_width = labs(m_pSettingsStore->GetLongParameter(LP_OUTLINE_WIDTH));
+        const int line_width = labs(m_pSettingsStore->GetRenderSettings().iOutlineWidth);
         const ColorPalette::Color& fill_color = line_width < 0
                                                     ? ColorPalette::noColor
-                                                    : (m_pSettingsStore->GetBoolParameter(BP_SIMULATE_TRANSPARENCY)
+                                                    : (m_pSettingsStore->GetRenderSettings().bSimulateTransparency
                                                            ? SimulateTransparency(pCurrentNode)
                                                            : pCurrentNode->getNodeColor(m_pColorPalette));
         const ColorPalette::Color& outline_color =
             line_width == 0 ? ColorPalette::noColor : pCurrentNode->getOutlineColor(m_pColorPalette);
 
-        if (m_captureVisibleNodes) CaptureNode(pCurrentNode, y1, y2, static_cast<int>(nodeDepth.extrusionLevel));
+        if (m_captureVisibleNodes || m_pNodeArraysFrame)
+            CaptureNode(pCurrentNode, y1, y2, static_cast<int>(nodeDepth.extrusionLevel));
+        Screen()->SetDrawingNode(pCurrentNode);
 
-        switch (m_pSettingsStore->GetLongParameter(LP_SHAPE_TYPE)) {
+        switch (m_pSettingsStore->GetRenderSettings().iShapeType) {
         case Options::OVERLAPPING_RECTANGLE:
             DasherDrawRectangle(std::min(Range, visibleRegion.maxX), std::max(y1, visibleRegion.minY), 0,
                                 std::min(y2, visibleRegion.maxY), fill_color, outline_color, line_width);
@@ -978,6 +1007,7 @@ void CDasherViewSquare::NewRender(CDasherNode* pCurrentNode, myint y1, myint y2,
         if (pCurrentTopCenterNode == pCurrentNode) {
             // covers crosshair! forcibly populate, now!
             policy.ExpandNode(pCurrentNode);
+            m_renderStats.iForced++;
         } else {
             // allow empty node to be expanded, it's big enough.
             policy.pushNode(pCurrentNode, static_cast<int>(y1), static_cast<int>(y2), true, dMaxCost);
@@ -1002,6 +1032,7 @@ void CDasherViewSquare::NewRender(CDasherNode* pCurrentNode, myint y1, myint y2,
     // first check if there's only one child we need to render
     if (CDasherNode* pChild = pCurrentNode->onlyChildRendered) {
         // if child still covers screen, render _just_ it and return
+        m_renderStats.iVisited++;
         myint newy1 = y1 + (Range * pChild->Lbnd()) / CDasherModel::NORMALIZATION;
         myint newy2 = y1 + (Range * pChild->Hbnd()) / CDasherModel::NORMALIZATION;
         if ((newy1 < visibleRegion.minY && newy2 > visibleRegion.maxY)) {
@@ -1014,11 +1045,25 @@ void CDasherViewSquare::NewRender(CDasherNode* pCurrentNode, myint y1, myint y2,
         pCurrentNode->onlyChildRendered = nullptr;
     }
 
-    // ok, need to render all children...
+    // ok, need to render all children... from the first not wholly above the
+    //  screen: those before it need nothing doing, so binary search past them
+    //  (unless game mode might want to hear of one)
     myint newy1 = y1;
     auto I = pCurrentNode->GetChildren().begin(), E = pCurrentNode->GetChildren().end();
+    if (!pCurrentNode->GetFlag(CDasherNode::NF_GAME)) {
+        const CArrayView<unsigned int> vHbnds = pCurrentNode->GetChildHbnds();
+        const auto itFirst = std::partition_point(vHbnds.begin(), vHbnds.end(), [&](unsigned int iHbnd) {
+            return y1 + (Range * iHbnd) / CDasherModel::NORMALIZATION < visibleRegion.minY;
+        });
+        if (itFirst != vHbnds.begin()) {
+            newy1 = y1 + (Range * itFirst[-1]) / CDasherModel::NORMALIZATION;
+            I += itFirst - vHbnds.begin();
+            m_renderStats.iSkipped += static_cast<int>(itFirst - vHbnds.begin());
+        }
+    }
     while (I != E) {
         CDasherNode* pChild(*I);
+        m_renderStats.iVisited++;
 
         myint newy2 = y1 + (Range * pChild->Hbnd()) / CDasherModel::NORMALIZATION;
         if (pChild->GetFlag(CDasherNode::NF_GAME)) {
@@ -1026,12 +1071,12 @@ void CDasherViewSquare::NewRender(CDasherNode* pCurrentNode, myint y1, myint y2,
         }
         if (newy1 <= visibleRegion.maxY && newy2 >= visibleRegion.minY) {
             // onscreen
-            if (newy2 - newy1 > m_pSettingsStore->GetLongParameter(LP_MIN_NODE_SIZE)) {
+            if (newy2 - newy1 > m_pSettingsStore->GetRenderSettings().iMinNodeSize) {
                 // definitely big enough to render.
                 NewRender(pChild, newy1, newy2, pPrevText, policy, dMaxCost, pCurrentTopCenterNode, nextLevel,
                           nodeDepth, parentScreenBounds);
             } else if (!pChild->GetFlag(CDasherNode::NF_SEEN))
-                pChild->DeleteChildren();
+                policy.CollapseNode(pChild);
             if (newy2 > visibleRegion.maxY && !pCurrentNode->GetFlag(CDasherNode::NF_GAME)) {
                 // remaining children offscreen and no game-mode child we might skip
                 //  (among the remainder, or any previous off the top of the screen)
@@ -1046,7 +1091,7 @@ void CDasherViewSquare::NewRender(CDasherNode* pCurrentNode, myint y1, myint y2,
     if (I != E) {
         // broke out of loop. Possibly more to delete...
         while (++I != E)
-            if (!(*I)->GetFlag(CDasherNode::NF_SEEN)) (*I)->DeleteChildren();
+            if (!(*I)->GetFlag(CDasherNode::NF_SEEN)) policy.CollapseNode(*I);
     }
     // all children rendered.
 }
@@ -1095,7 +1140,7 @@ void CDasherViewSquare::ComputeScaleFactor() {
 
     // set log scaling coefficient (unused if LP_NONLINEAR_X==0)
     //  note previous value = 1/0.2, i.e. a value of LP_NONLINEAR_X =~= 4.8
-    m_dXlogCoeff = exp(m_pSettingsStore->GetLongParameter(LP_NONLINEAR_X) / 3.0);
+    m_dXlogCoeff = exp(m_pSettingsStore->GetRenderSettings().iNonlinearX / 3.0);
 
     const bool bHoriz(GetOrientation() == Options::LeftToRight || GetOrientation() == Options::RightToLeft);
     const screenint iScreenWidth(Screen()->GetWidth()), iScreenHeight(Screen()->GetHeight());
@@ -1106,7 +1151,7 @@ void CDasherViewSquare::ComputeScaleFactor() {
     double dScaleFactorY(dPixelsY / CDasherModel::MAX_Y);
     double dScaleFactorX(dPixelsX / static_cast<double>(CDasherModel::MAX_Y + iMarginWidth));
 
-    switch (m_pSettingsStore->GetLongParameter(LP_GEOMETRY)) {
+    switch (m_pSettingsStore->GetRenderSettings().iGeometry) {
     case Options::ScreenGeometry::old_style: {
         // old style
         if (dScaleFactorX < dScaleFactorY) {
@@ -1144,7 +1189,7 @@ void CDasherViewSquare::ComputeScaleFactor() {
                             : (1.0 / dScaleFactorY)); // square or wide+low
         iMarginWidth = static_cast<myint>(iMarginWidth /
                                           0.9); // this comes from the old scaling by m_dXmpc=0.9. Drop in new scheme?
-        if (m_pSettingsStore->GetLongParameter(LP_GEOMETRY) == Options::ScreenGeometry::squish_and_log) {
+        if (m_pSettingsStore->GetRenderSettings().iGeometry == Options::ScreenGeometry::squish_and_log) {
             // make whole screen logarithmic (but keep xhair in same place)
             myint crosshair(xmap(2048)); // should be 2048...
             m_iXlogThres = 0;
@@ -1238,10 +1283,10 @@ void CDasherViewSquare::Dasher2Polar(myint iDasherX, myint iDasherY, double& r,
     r = sqrt(x * x + y * y);
 }
 
-void CDasherViewSquare::DasherLine2Screen(myint x1, myint y1, myint x2, myint y2, std::vector<point>& vPoints) const {
+void CDasherViewSquare::DasherLine2Screen(myint x1, myint y1, myint x2, myint y2, PointList& vPoints) const {
     if (x1 != x2 && y1 != y2) {
         // only diagonal lines ever get changed...
-        if (m_pSettingsStore->GetBoolParameter(BP_NONLINEAR_Y)) {
+        if (m_pSettingsStore->GetRenderSettings().bNonlinearY) {
             if ((y1 < m_Y3 && y2 > m_Y3) || (y2 < m_Y3 && y1 > m_Y3)) {
                 // crosses bottom non-linearity border
                 myint x_mid = x1 + (x2 - x1) * (m_Y3 - y1) / (y2 - y1);
@@ -1257,7 +1302,7 @@ void CDasherViewSquare::DasherLine2Screen(myint x1, myint y1, myint x2, myint y2
                 y1 = m_Y2;
             }
         }
-        if (m_pSettingsStore->GetLongParameter(LP_NONLINEAR_X) && (x1 > m_iXlogThres || x2 > m_iXlogThres)) {
+        if (m_pSettingsStore->GetRenderSettings().iNonlinearX && (x1 > m_iXlogThres || x2 > m_iXlogThres)) {
             // into logarithmic section
             point pStart, pScreenMid, pEnd;
             Dasher2Screen(x2, y2, pEnd.x, pEnd.y);
@@ -1364,7 +1409,7 @@ inline void CDasherViewSquare::Crosshair() {
 
 inline myint CDasherViewSquare::ixmap(myint x) const {
     x -= iMarginWidth;
-    if (m_pSettingsStore->GetLongParameter(LP_NONLINEAR_X) > 0 && x >= m_iXlogThres) {
+    if (m_pSettingsStore->GetRenderSettings().iNonlinearX > 0 && x >= m_iXlogThres) {
         double dx = (x - m_iXlogThres) / static_cast<double>(CDasherModel::MAX_Y);
         dx = (exp(dx * m_dXlogCoeff) - 1) / m_dXlogCoeff;
         x = myint(dx * CDasherModel::MAX_Y) + m_iXlogThres;
@@ -1373,7 +1418,7 @@ inline myint CDasherViewSquare::ixmap(myint x) const {
 }
 
 inline myint CDasherViewSquare::xmap(myint x) const {
-    if (m_pSettingsStore->GetLongParameter(LP_NONLINEAR_X) && x >= m_iXlogThres) {
+    if (m_pSettingsStore->GetRenderSettings().iNonlinearX && x >= m_iXlogThres) {
         double dx = log(1 + (x - m_iXlogThres) * m_dXlogCoeff / CDasherModel::MAX_Y) / m_dXlogCoeff;
         dx = (dx * CDasherModel::MAX_Y) + m_iXlogThres;
         x = myint(dx > 0 ? ceil(dx) : floor(dx));
@@ -1382,7 +1427,7 @@ inline myint CDasherViewSquare::xmap(myint x) const {
 }
 
 inline myint CDasherViewSquare::ymap(myint y) const {
-    if (m_pSettingsStore->GetBoolParameter(BP_NONLINEAR_Y)) {
+    if (m_pSettingsStore->GetRenderSettings().bNonlinearY) {
         if (y > m_Y2)
             return m_Y2 + (y - m_Y2) / m_Y1;
         else if (y < m_Y3)
@@ -1392,7 +1437,7 @@ inline myint CDasherViewSquare::ymap(myint y) const {
 }
 
 inline myint CDasherViewSquare::iymap(myint ydash) const {
-    if (m_pSettingsStore->GetBoolParameter(BP_NONLINEAR_Y)) {
+    if (m_pSettingsStore->GetRenderSettings().bNonlinearY) {
         if (ydash > m_Y2)
             return (ydash - m_Y2) * m_Y1 + m_Y2;
         else if (ydash < m_Y3)
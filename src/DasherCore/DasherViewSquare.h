@@ -109,8 +109,8 @@ class Dasher::CDasherViewSquare : public CDasherView {
     ///   midpoint, integer-rounding stall) cannot exhaust the stack. At the
     ///   budget the remaining arc is approximated by a straight line, which is
     ///   visually fine at the granularity reached.
-    void CircleTo(myint cy, myint r, myint y1, myint x1, myint y3, myint x3, point dest, std::vector<point>& pts,
-                  double dXMul, int depth = kMaxCircleSubdivisionDepth) const;
+    void CircleTo(myint cy, myint r, myint y1, myint x1, myint y3, myint x3, point dest, PointList& pts, double dXMul,
+                  int depth = kMaxCircleSubdivisionDepth) const;
     /// Maximum recursion depth for CircleTo(). 2^20 segments is far more than any
     /// real arc needs (a screen-sized circle resolves to pixel accuracy in ~13
     /// levels), yet keeps the worst-case call count bounded if convergence ever
@@ -124,20 +124,31 @@ class Dasher::CDasherViewSquare : public CDasherView {
     ///  (all in Dasher coords).
     void Triangle(myint x, myint y1, myint y2, int fillColor, int outlineColor, int lineWidth) const;
 
+    /// A request to draw a label, made while rendering nodes and carried out afterwards
+    ///  (so labels go on top). Lives in the frame arena, as do any (linked) children.
     class CTextString {
       public: // to CDasherViewSquare...
         /// Creates a request that label will be drawn.
         ///  x,y are screen coords of midpoint of leading edge;
-        ///  iSize is desired size (already computed from requested position)
-        CTextString(CDasherScreen::Label* pLabel, screenint x, screenint y, int iSize,
+        ///  iSize is desired size (already computed from requested position);
+        ///  pNode is the node labelled
+        CTextString(const CDasherNode* pNode, CDasherScreen::Label* pLabel, screenint x, screenint y, int iSize,
                     const ColorPalette::Color& iColor)
-            : m_pLabel(pLabel), m_ix(x), m_iy(y), m_iSize(iSize), m_Color(iColor) {}
+            : m_pNode(pNode), m_pLabel(pLabel), m_ix(x), m_iy(y), m_iSize(iSize), m_Color(iColor) {}
 
-        ~CTextString();
+        /// Adds a label to draw after (and shoved out of the way of) this one
+        void AddChild(CTextString* pChild) {
+            (m_pLastChild ? m_pLastChild->m_pNext : m_pFirstChild) = pChild;
+            m_pLastChild = pChild;
+        }
 
+        const CDasherNode* m_pNode;
         CDasherScreen::Label* m_pLabel;
         screenint m_ix, m_iy;
-        std::vector<CTextString*> m_children;
+        /// Children, in order, linked by m_pNext
+        CTextString* m_pFirstChild = nullptr;
+        CTextString* m_pLastChild = nullptr;
+        CTextString* m_pNext = nullptr;
         int m_iSize;
         const ColorPalette::Color& m_Color;
     };
@@ -157,8 +168,8 @@ class Dasher::CDasherViewSquare : public CDasherView {
     ///
     /// Draw text specified in Dasher co-ordinates
     ///
-    CTextString* DasherDrawText(myint iDasherMaxX, myint iDasherMidY, CDasherScreen::Label* pLabel,
-                                const ColorPalette::Color& Color) const;
+    CTextString* DasherDrawText(myint iDasherMaxX, myint iDasherMidY, const CDasherNode* pNode,
+                                CDasherScreen::Label* pLabel, const ColorPalette::Color& Color) const;
 
     ///
     /// (Recursively) render a node and all contained subnodes, in disjoint rects.
@@ -205,7 +216,7 @@ class Dasher::CDasherViewSquare : public CDasherView {
     // Divides by SCALE_FACTOR, rounding away from 0
     static inline myint CustomIDivScaleFactor(myint iNumerator);
 
-    void DasherLine2Screen(myint x1, myint y1, myint x2, myint y2, std::vector<point>& vPoints) const override;
+    void DasherLine2Screen(myint x1, myint y1, myint x2, myint y2, PointList& vPoints) const override;
 
     // Called on screen size or orientation changes
     void ComputeScaleFactor();
@@ -234,12 +245,23 @@ class Dasher::CDasherViewSquare : public CDasherView {
     void SetVisibleNodeCapture(bool enabled) override { m_captureVisibleNodes = enabled; }
     bool IsVisibleNodeCaptureEnabled() const override { return m_captureVisibleNodes; }
     std::vector<VisibleNode> GetVisibleNodes() const override { return m_visibleNodes; }
+    void SetVisibleNodeArraysCapture(bool enabled) override { m_captureNodeArrays = enabled; }
+    bool IsVisibleNodeArraysCaptureEnabled() const override { return m_captureNodeArrays; }
+    CVisibleNodeArrays* GetVisibleNodeArrays() override { return &m_nodeArrays; }
+    RenderStats GetRenderStats() const override { return m_renderStats; }
 
   private:
+    RenderStats m_renderStats;
     bool m_captureVisibleNodes = false;
     std::vector<VisibleNode> m_visibleNodes;
+    bool m_captureNodeArrays = false;
+    CVisibleNodeArrays m_nodeArrays;
+    // The arrays being filled during Render() (nullptr unless capturing them)
+    SVisibleNodeArrays* m_pNodeArraysFrame = nullptr;
     // Record one drawn node's geometry/colour (no-op when capture is off).
     void CaptureNode(CDasherNode* node, myint y1, myint y2, int depth);
+    // Publish the arrays filled during Render(), if any
+    void EndCapture();
 };
 
 /// @}
@@ -78,7 +78,7 @@ CDefaultFilter::~CDefaultFilter() {
 bool CDefaultFilter::DecorateView(CDasherView* pView, CDasherInput* pInput) {
     bool bDidSomething(false);
 
-    if (m_pSettingsStore->GetBoolParameter(BP_DRAW_MOUSE)) {
+    if (m_pSettingsStore->GetRenderSettings().bDrawMouse) {
         // Draw a small box at the current mouse position
         pView->DasherDrawCentredRectangle(m_iLastX, m_iLastY, 5, pView->GetNamedColor(NamedColor::inputPosition),
                                           ColorPalette::noColor, false);
@@ -86,7 +86,7 @@ bool CDefaultFilter::DecorateView(CDasherView* pView, CDasherInput* pInput) {
         bDidSomething = true;
     }
 
-    if (m_pSettingsStore->GetBoolParameter(BP_DRAW_MOUSE_LINE)) {
+    if (m_pSettingsStore->GetRenderSettings().bDrawMouseLine) {
         // Draw a line from the origin to the current mouse position
         myint x[2];
         myint y[2];
@@ -101,11 +101,11 @@ bool CDefaultFilter::DecorateView(CDasherView* pView, CDasherInput* pInput) {
         y[1] = m_iLastY;
 
         // Actually plot the line
-        if (m_pSettingsStore->GetBoolParameter(BP_CURVE_MOUSE_LINE))
-            pView->DasherSpaceLine(x[0], y[0], x[1], y[1], m_pSettingsStore->GetLongParameter(LP_LINE_WIDTH),
+        if (m_pSettingsStore->GetRenderSettings().bCurveMouseLine)
+            pView->DasherSpaceLine(x[0], y[0], x[1], y[1], m_pSettingsStore->GetRenderSettings().iLineWidth,
                                    pView->GetNamedColor(NamedColor::inputLine));
         else
-            pView->DasherPolyline(x, y, 2, m_pSettingsStore->GetLongParameter(LP_LINE_WIDTH),
+            pView->DasherPolyline(x, y, 2, m_pSettingsStore->GetRenderSettings().iLineWidth,
                                   pView->GetNamedColor(NamedColor::inputLine));
 
         /*  // Plot a brachistochrone
@@ -262,7 +262,7 @@ double xmax(double y) {
 
 void CDefaultFilter::ApplyTransform(myint& iDasherX, myint& iDasherY, CDasherView* pView) {
     ApplyOffset(iDasherX, iDasherY);
-    if (m_pSettingsStore->GetLongParameter(LP_GEOMETRY) == Options::ScreenGeometry::square_no_xhair) {
+    if (m_pSettingsStore->GetRenderSettings().iGeometry == Options::ScreenGeometry::square_no_xhair) {
         // crosshair may be offscreen; so do something to allow us to navigate
         //  up/down and reverse
         const CDasherView::DasherCoordScreenRegion visibleRegion = pView->VisibleRegion();
@@ -276,7 +276,7 @@ void CDefaultFilter::ApplyTransform(myint& iDasherX, myint& iDasherY, CDasherVie
         iDasherX += (2 * CDasherModel::ORIGIN_Y * CDasherModel::ORIGIN_Y) / (dist + 50);
         // and close to centerpoint = reverse
     }
-    if (m_pSettingsStore->GetBoolParameter(BP_REMAP_XTREME)) {
+    if (m_pSettingsStore->GetRenderSettings().bRemapXtreme) {
         // Y co-ordinate...
         myint dasherOY = CDasherModel::ORIGIN_Y;
         double double_y = ((iDasherY - dasherOY) / (double)(dasherOY)); // Fraction above the crosshair
@@ -294,9 +294,9 @@ void CDefaultFilter::ApplyOffset(myint& iDasherX, myint& iDasherY) {
     // factor of 10 to get the offset in Dasher coordinates, but it
     // would be a good idea at some point to sort this out properly.
 
-    iDasherY += 10 * m_pSettingsStore->GetLongParameter(LP_TARGET_OFFSET);
+    iDasherY += 10 * m_pSettingsStore->GetRenderSettings().iTargetOffset;
 
-    if (m_pSettingsStore->GetBoolParameter(BP_AUTOCALIBRATE) && !isPaused()) {
+    if (m_pSettingsStore->GetRenderSettings().bAutocalibrate && !isPaused()) {
         // Auto-update the offset
 
         m_iSum += CDasherModel::ORIGIN_Y - iDasherY; // Distance above crosshair
@@ -312,7 +312,7 @@ void CDefaultFilter::ApplyOffset(myint& iDasherX, myint& iDasherY) {
 
             if (((m_iSum > 0) ? m_iSum : -m_iSum) > CDasherModel::MAX_Y / 2)
                 m_pSettingsStore->SetLongParameter(
-                    LP_TARGET_OFFSET, m_pSettingsStore->GetLongParameter(LP_TARGET_OFFSET) + ((m_iSum > 0) ? -1 : 1));
+                    LP_TARGET_OFFSET, m_pSettingsStore->GetRenderSettings().iTargetOffset + ((m_iSum > 0) ? -1 : 1));
             // TODO, "else return" - check effectiveness with/without?
             //  old code exited now if neither above cases applied,
             //  but had TODO suggesting maybe we should _always_ reset m_iSum
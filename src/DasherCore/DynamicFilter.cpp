@@ -42,17 +42,17 @@ bool CDynamicFilter::OneStepTowards(CDasherModel* pModel, myint X, myint Y, unsi
     // Not rescaling Y in this case: at that X, all Y's are nearly equivalent!
     X = std::max(myint(1), std::min(X, myint(1 << 29) / iSteps));
 
-    pModel->ScheduleOneStep(Y - X, Y + X, iSteps, m_pSettingsStore->GetLongParameter(LP_X_LIMIT_SPEED),
-                            m_pSettingsStore->GetBoolParameter(BP_EXACT_DYNAMICS));
+    pModel->ScheduleOneStep(Y - X, Y + X, iSteps, m_pSettingsStore->GetRenderSettings().iXLimitSpeed,
+                            m_pSettingsStore->GetRenderSettings().bExactDynamics);
     return true;
 }
 
 double CDynamicFilter::FrameSpeedMul(CDasherModel* pModel, unsigned long iTime) {
     CDasherNode* n = pModel->Get_node_under_crosshair();
     double d = n ? n->SpeedMul() : 1.0;
-    if (m_pSettingsStore->GetBoolParameter(BP_SLOW_START)) {
+    if (m_pSettingsStore->GetRenderSettings().bSlowStart) {
         const unsigned long timeSinceStart = iTime - m_iStartTime;
-        const unsigned long slowStartTime = m_pSettingsStore->GetLongParameter(LP_SLOW_START_TIME);
+        const unsigned long slowStartTime = m_pSettingsStore->GetRenderSettings().iSlowStartTime;
         const double ratio = std::min(timeSinceStart / static_cast<double>(slowStartTime), 1.0);
         d *= 0.1 + 0.9 * ratio;
     }
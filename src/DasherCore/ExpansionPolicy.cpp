@@ -10,6 +10,7 @@
 #include "ExpansionPolicy.h"
 #include "DasherModel.h"
 #include <algorithm>
+#include <chrono>
 #include <limits>
 
 using namespace Dasher;
@@ -18,6 +19,13 @@ void CExpansionPolicy::ExpandNode(CDasherNode* pNode) {
     m_pModel->ExpandNode(pNode);
 }
 
+void CExpansionPolicy::CollapseNode(CDasherNode* pNode) {
+    if (m_pModel)
+        m_pModel->CollapseNode(pNode);
+    else
+        pNode->DeleteChildren();
+}
+
 bool Less(std::pair<double, CDasherNode*> x, std::pair<double, CDasherNode*> y) {
     return x.first < y.first;
 }
@@ -71,11 +79,11 @@ bool BudgettingPolicy::apply() {
     double collapseCost = -std::numeric_limits<double>::infinity();
 
     // first, make sure we are within our budget (probably only in case the budget's changed)
-    while (!sCollapse.empty() && static_cast<unsigned int>(currentNumNodeObjects()) > m_iNodeBudget) {
+    while (!sCollapse.empty() && countNodes() > m_iNodeBudget) {
         std::pair<double, CDasherNode*> node = sCollapse.back();
         DASHER_ASSERT(node.first >= collapseCost);
         collapseCost = node.first;
-        node.second->DeleteChildren();
+        CollapseNode(node.second);
         sCollapse.pop_back();
     }
 
@@ -83,9 +91,8 @@ bool BudgettingPolicy::apply() {
     //  against each other, in case there are any unimportant (low-cost) nodes we could collapse
     //  to make room to expand other more important (high-benefit) nodes.
     while (!sExpand.empty() && sExpand.back().first > collapseCost) {
-        if (static_cast<unsigned int>(currentNumNodeObjects() + sExpand.back().second->ExpectedNumChildren()) <
-            m_iNodeBudget) {
-            ExpandNode(sExpand.back().second);
+        if (countNodes() + sExpand.back().second->ExpectedNumChildren() < m_iNodeBudget) {
+            if (!expand(sExpand.back().second)) break; // (no time for it)
             sExpand.pop_back();
             bReturnValue = true;
             //...and loop.
@@ -94,7 +101,7 @@ bool BudgettingPolicy::apply() {
             std::pair<double, CDasherNode*> node = sCollapse.back();
             DASHER_ASSERT(node.first >= collapseCost);
             collapseCost = node.first;
-            node.second->DeleteChildren();
+            CollapseNode(node.second);
             sCollapse.pop_back();
             //...and see how much room that makes
         } else
@@ -105,6 +112,19 @@ bool BudgettingPolicy::apply() {
     return bReturnValue;
 }
 
+unsigned int BudgettingPolicy::countNodes() const {
+    // (counted per model, not process-wide, so another context's tree doesn't eat into this one's budget;
+    //  the few roots allocated from the heap go uncounted)
+    const std::size_t iLive = GetModel()->GetNodePool().GetLiveCount(),
+                      iParked = GetModel()->GetSubtreeCache().GetNodeCount();
+    return static_cast<unsigned int>(iLive > iParked ? iLive - iParked : 0);
+}
+
+bool BudgettingPolicy::expand(CDasherNode* pNode) {
+    ExpandNode(pNode);
+    return true;
+}
+
 int BudgettingPolicy::getRange(int y1, int y2, int iMin, int iMax) {
     if (y1 > iMax || y2 < iMin) return 0;
     return std::min(y2, iMax) - std::max(y1, iMin);
@@ -127,8 +147,36 @@ double AmortizedPolicy::pushNode(CDasherNode* node, int iMin, int iMax, bool bEx
 }
 
 bool AmortizedPolicy::apply() {
+    m_deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(m_iMicroseconds);
+    m_iExpanded = 0;
+    m_dExpandedMicroseconds = 0.0;
     trim();
-    return BudgettingPolicy::apply();
+    const bool bReturnValue = BudgettingPolicy::apply();
+    if (m_iMicroseconds && m_dExpandMicroseconds > 0.0) {
+        // Next time, consider (twice) as many nodes as fit in the time, at the average cost
+        const double dFit = 2.0 * m_iMicroseconds / m_dExpandMicroseconds;
+        m_iMaxExpands = static_cast<unsigned int>(std::clamp(dFit, 1.0, 4096.0));
+    }
+    return bReturnValue;
+}
+
+bool AmortizedPolicy::expand(CDasherNode* pNode) {
+    const auto tStart = std::chrono::steady_clock::now();
+    if (m_iMicroseconds && m_iExpanded > 0) {
+        const double dExpected = m_dChildMicroseconds * pNode->ExpectedNumChildren();
+        if (tStart + std::chrono::microseconds(static_cast<long long>(dExpected)) > m_deadline) return false;
+    }
+    ExpandNode(pNode);
+    const auto tEnd = std::chrono::steady_clock::now();
+    const double dMicroseconds = std::chrono::duration<double, std::micro>(tEnd - tStart).count();
+    m_iExpanded++;
+    m_dExpandedMicroseconds += dMicroseconds;
+    // (the first measurement is taken as it is, later ones are averaged in)
+    const double dChild = dMicroseconds / std::max(1u, pNode->ChildCount());
+    m_dChildMicroseconds = m_dChildMicroseconds > 0.0 ? 0.75 * m_dChildMicroseconds + 0.25 * dChild : dChild;
+    m_dExpandMicroseconds =
+        m_dExpandMicroseconds > 0.0 ? 0.75 * m_dExpandMicroseconds + 0.25 * dMicroseconds : dMicroseconds;
+    return true;
 }
 
 void AmortizedPolicy::trim() {
@@ -200,3 +248,56 @@ void AmortizedPolicy::trim() {
             cout << "trim not equal!\n";
 #endif
 }
+
+LookaheadPolicy::LookaheadPolicy(CDasherModel* pModel, unsigned int iNodeBudget, int iFrames, int iMicroseconds)
+    : AmortizedPolicy(pModel, iNodeBudget), m_iFrames(iFrames), m_iLookaheadMicroseconds(iMicroseconds) {}
+
+void LookaheadPolicy::predict() {
+    if (m_bPredicted) return;
+    m_bPredicted = true;
+    m_bAhead = GetModel()->PredictCrosshair(m_iFrames, m_iAheadY, m_dAheadZoom);
+}
+
+bool LookaheadPolicy::isAhead(myint y1, myint y2) const {
+    return m_bAhead && y1 <= m_iAheadY && m_iAheadY < y2 && (y2 - y1) * m_dAheadZoom > CDasherModel::ORIGIN_X;
+}
+
+double LookaheadPolicy::getCost(CDasherNode* pNode, int iDasherMinY, int iDasherMaxY) {
+    predict();
+    // (as pushNode makes no node cost more than its parent, this applies to the path from the root down)
+    if (isAhead(iDasherMinY, iDasherMaxY)) return std::numeric_limits<double>::infinity();
+    return AmortizedPolicy::getCost(pNode, iDasherMinY, iDasherMaxY);
+}
+
+bool LookaheadPolicy::apply() {
+    bool bReturnValue = AmortizedPolicy::apply();
+    predict();
+    m_bPredicted = false; // predict again next frame
+    m_iExpandedAhead = 0;
+    if (!m_bAhead) return bReturnValue;
+
+    // Walk down from the root, through the nodes ahead, expanding any without children
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(m_iLookaheadMicroseconds);
+    myint y1, y2;
+    CDasherNode* pNode = GetModel()->GetRoot(y1, y2);
+    while (pNode && isAhead(y1, y2)) {
+        if (pNode->ChildCount() == 0) {
+            if (std::chrono::steady_clock::now() >= deadline) break;
+            ExpandNode(pNode);
+            m_iExpandedAhead++;
+            bReturnValue = true;
+        }
+        // On to the child ahead, if any (children need not cover their parent, if it's being rebuilt)
+        const myint iRange = y2 - y1;
+        const CArrayView<unsigned int> vHbnds = pNode->GetChildHbnds();
+        const auto it = std::partition_point(vHbnds.begin(), vHbnds.end(), [&](unsigned int iHbnd) {
+            return y1 + (iRange * iHbnd) / CDasherModel::NORMALIZATION <= m_iAheadY;
+        });
+        if (it == vHbnds.end()) break;
+        CDasherNode* pChild = pNode->GetChildren()[it - vHbnds.begin()];
+        y2 = y1 + (iRange * pChild->Hbnd()) / CDasherModel::NORMALIZATION;
+        y1 = y1 + (iRange * pChild->Lbnd()) / CDasherModel::NORMALIZATION;
+        pNode = pChild;
+    }
+    return bReturnValue;
+}
@@ -9,6 +9,7 @@
 
 #pragma once
 
+#include <chrono>
 #include <vector>
 #include "DasherNode.h"
 
@@ -30,12 +31,17 @@ class CExpansionPolicy {
     ///  to implement their apply() methods, but public so the view can call directly for nodes
     ///  which must be expanded during rendering. (Delegates to CDasherModel.)
     void ExpandNode(CDasherNode* pNode);
+    /// Collapse node immediately, as the view does for nodes too small or offscreen: deleting
+    ///  its children, or parking them to give back if it is expanded again. (Delegates to
+    ///  CDasherModel, if any.)
+    void CollapseNode(CDasherNode* pNode);
 
   protected:
     CExpansionPolicy(CDasherModel* pModel) : m_pModel(pModel) {}
+    CDasherModel* GetModel() const { return m_pModel; }
 
   private:
-    CDasherModel* m_pModel;
+    CDasherModel* m_pModel = nullptr;
 };
 
 class NoExpansions : public CExpansionPolicy {
@@ -60,14 +66,23 @@ class BudgettingPolicy : public CExpansionPolicy {
 
   protected:
     virtual double getCost(CDasherNode* pNode, int iDasherMinY, int iDasherMaxY);
+    /// Expands a node for apply(), in order of benefit; a subclass may return false instead,
+    ///  leaving the node (and all less beneficial) unexpanded this time
+    virtual bool expand(CDasherNode* pNode);
     /// return the intersection of the ranges (y1-y2) and (iMin-iMax)
     int getRange(int y1, int y2, int iMin, int iMax);
+    /// Nodes in the model's tree, to keep within budget (not those parked in its CSubtreeCache)
+    unsigned int countNodes() const;
     std::vector<std::pair<double, CDasherNode*>> sExpand, sCollapse;
     unsigned int m_iNodeBudget;
 };
 
 /// limits expansion to a few nodes (per instance i.e. per frame)
 ///(collapsing is at present unlimited, have to test this...)
+/// Or, given a time budget, to as many as fit in it: expansion costs vary a lot (with the
+/// number of children, and between alphabets - a Mandarin conversion node costs far more
+/// than an English letter), so the cost of each is measured, and the next is expanded only
+/// if, at the cost per child measured so far, it will be done before the time is up.
 class AmortizedPolicy : public BudgettingPolicy {
   public:
     AmortizedPolicy() = delete;
@@ -76,9 +91,58 @@ class AmortizedPolicy : public BudgettingPolicy {
     ~AmortizedPolicy() = default;
     bool apply() override;
     double pushNode(CDasherNode* pNode, int iMin, int iMax, bool bExpand, double dParentCost) override;
+    /// Limit the expansions in each apply() to iMicroseconds from when it starts, rather than
+    ///  by count (0 = by count); the most beneficial node is expanded even so
+    void SetTimeBudget(int iMicroseconds) { m_iMicroseconds = iMicroseconds; }
+    /// Nodes expanded by the last apply(), and the microseconds it spent expanding them
+    int GetExpanded() const { return m_iExpanded; }
+    double GetExpandMicroseconds() const { return m_dExpandedMicroseconds; }
+
+  protected:
+    bool expand(CDasherNode* pNode) override;
 
   private:
     unsigned int m_iMaxExpands;
     void trim();
+    int m_iMicroseconds = 0;
+    std::chrono::steady_clock::time_point m_deadline;
+    /// Measured cost of expanding a node, per child created, in microseconds (averaged over recent expansions)
+    double m_dChildMicroseconds = 0.0;
+    /// ...and per node expanded
+    double m_dExpandMicroseconds = 0.0;
+    int m_iExpanded = 0;
+    /// Microseconds spent expanding by the last apply() (with their fractions, for the caller to sum)
+    double m_dExpandedMicroseconds = 0.0;
+};
+
+/// As AmortizedPolicy, but also looks ahead to where the crosshair is going (see
+/// CDasherModel::PredictCrosshair): nodes there, which will have grown big enough to
+/// cover the crosshair within a given number of frames, are expanded now - down through
+/// children and grandchildren, as far as a time budget per frame allows - rather than
+/// by the view, when they get there, in the middle of rendering.
+/// Such nodes onscreen also come first to expand, and last to collapse.
+class LookaheadPolicy : public AmortizedPolicy {
+  public:
+    /// \param iFrames how many frames ahead to look
+    /// \param iMicroseconds time to spend expanding nodes ahead, per frame
+    LookaheadPolicy(CDasherModel* pModel, unsigned int iNodeBudget, int iFrames, int iMicroseconds);
+    bool apply() override;
+    /// Number of nodes expanded ahead by the last apply()
+    int GetExpandedAhead() const { return m_iExpandedAhead; }
+
+  protected:
+    double getCost(CDasherNode* pNode, int iDasherMinY, int iDasherMaxY) override;
+
+  private:
+    /// Whether a node at the given coordinates will be big enough to cover the crosshair
+    ///  when the crosshair gets to m_iAheadY
+    bool isAhead(myint y1, myint y2) const;
+    /// Predicts where the crosshair is going, once per frame
+    void predict();
+    const int m_iFrames, m_iLookaheadMicroseconds;
+    bool m_bPredicted = false, m_bAhead = false;
+    myint m_iAheadY = 0;
+    double m_dAheadZoom = 1.0;
+    int m_iExpandedAhead = 0;
 };
 } // namespace Dasher
@@ -1,25 +1,14 @@
 #ifndef HAVE_OWN_FILEUTILS
 #include "FileUtils.h"
+#include "DasherCore/Common/TempFile.h"
 
-#include <regex>
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
-
-namespace Dasher {
-
-// Static member initialization
-std::string FileUtils::s_dataDirectory;
-std::string FileUtils::s_userDataDirectory;
-
-void FileUtils::SetDataDirectory(const std::string& dataDir) {
-    s_dataDirectory = dataDir;
-}
-
-void FileUtils::SetUserDataDirectory(const std::string& userDir) {
-    s_userDataDirectory = userDir;
-}
-
-} // namespace Dasher
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 static bool IsFileWriteable(const std::filesystem::path& file_path) {
     // Check writability via permission bits without opening the file.
@@ -38,7 +27,184 @@ int Dasher::FileUtils::GetFileSize(const std::string& strFileName) {
     return static_cast<int>(std::filesystem::file_size(strFileName));
 }
 
-void Dasher::FileUtils::ScanFiles(AbstractParser* parser, const std::string& strPattern) {
+namespace {
+
+// The names of the regular files in one directory, and of its subdirectories, as of its modification time
+struct SDirectory {
+    long long iModified = 0;
+    std::vector<std::string> vFiles, vSubdirs;
+};
+
+// Every regular file under one root directory (the data or the user directory), as of one scan
+struct SRootIndex {
+    std::map<std::string, SDirectory> dirs;                  // by path relative to the root ("" for the root)
+    std::vector<std::pair<std::string, std::string>> vFiles; // (file name, full path), sorted
+};
+
+// A root indexed. Its directories are scanned without the lock - from the index last published,
+//  which the scan then replaces - so lookups by other sessions need not wait for it; and as an
+//  index is never changed once published, those holding one may go on reading it meanwhile.
+struct SRoot {
+    std::filesystem::path root;
+    std::filesystem::path excluded;           // the other root, left out if within this one
+    std::shared_ptr<const SRootIndex> pIndex; // null until first scanned
+    bool bStale = false;                      // directories to be checked again before use
+    unsigned long iStaled = 0;                // times marked stale, so a scan begun before stays so
+};
+
+// Every root indexed, for any instance (sessions with different user directories share that of the data)
+std::mutex s_indexMutex;
+std::vector<SRoot> s_roots;
+
+void MarkStale(SRoot& root) {
+    root.bStale = true;
+    root.iStaled++;
+}
+
+const char* const INDEX_MAGIC = "DasherFileIndex 1";
+
+long long ModificationTime(const std::filesystem::path& path) {
+    std::error_code ec;
+    const auto time = std::filesystem::last_write_time(path, ec);
+    return ec ? -1 : static_cast<long long>(time.time_since_epoch().count());
+}
+
+// Lists the directory strRel under root into dirs, and (recursively) its subdirectories but the one
+//  at excluded, reusing what prior records of any directory whose modification time is unchanged.
+void IndexDirectory(const std::filesystem::path& root, const std::string& strRel,
+                    const std::filesystem::path& excluded, std::map<std::string, SDirectory>& prior,
+                    std::map<std::string, SDirectory>& dirs, bool& bChanged) {
+    const std::filesystem::path dir = strRel.empty() ? root : root / std::filesystem::u8path(strRel);
+    const long long iModified = ModificationTime(dir);
+    if (iModified == -1) return;
+
+    SDirectory& entry = dirs[strRel];
+    auto it = prior.find(strRel);
+    if (it != prior.end() && it->second.iModified == iModified) {
+        entry = std::move(it->second);
+    } else {
+        entry.iModified = iModified;
+        std::error_code ec;
+        const auto options = std::filesystem::directory_options::skip_permission_denied;
+        for (std::filesystem::directory_iterator iter(dir, options, ec), end; !ec && iter != end; iter.increment(ec)) {
+            // Symlinked directories are not followed (as by recursive_directory_iterator); symlinked files are
+            if (!iter->is_symlink(ec) && iter->is_directory(ec)) {
+                if (iter->path() != excluded) entry.vSubdirs.push_back(iter->path().filename().u8string());
+            } else if (iter->is_regular_file(ec)) {
+                entry.vFiles.push_back(iter->path().filename().u8string());
+            }
+        }
+        bChanged = true;
+    }
+    const std::vector<std::string> vSubdirs = entry.vSubdirs;
+    for (const std::string& strSub : vSubdirs)
+        IndexDirectory(root, strRel.empty() ? strSub : strRel + "/" + strSub, excluded, prior, dirs, bChanged);
+}
+
+std::map<std::string, SDirectory> ReadIndex(const std::string& strFile, const std::filesystem::path& root) {
+    std::map<std::string, SDirectory> dirs;
+    std::ifstream in(strFile.c_str(), std::ios::binary);
+    std::string strLine;
+    if (!std::getline(in, strLine) || strLine != INDEX_MAGIC || !std::getline(in, strLine) ||
+        strLine != root.u8string())
+        return dirs;
+    // A line "D<tab>modification time<tab>relative path" for each directory, then "F<tab>name" for each
+    //  of its files and "S<tab>name" for each of its subdirectories
+    SDirectory* pDir = nullptr;
+    while (std::getline(in, strLine)) {
+        if (strLine.size() < 2 || strLine[1] != '\t') return {};
+        if (strLine[0] == 'D') {
+            const size_t iTab = strLine.find('\t', 2);
+            if (iTab == std::string::npos) return {};
+            pDir = &dirs[strLine.substr(iTab + 1)];
+            pDir->iModified = std::strtoll(strLine.c_str() + 2, nullptr, 10);
+        } else if (pDir && (strLine[0] == 'F' || strLine[0] == 'S')) {
+            (strLine[0] == 'F' ? pDir->vFiles : pDir->vSubdirs).push_back(strLine.substr(2));
+        } else {
+            return {};
+        }
+    }
+    return dirs;
+}
+
+void WriteIndex(const std::string& strFile, const std::filesystem::path& root, const SRootIndex& index) {
+    const std::string strTemp = Dasher::UniqueTempName(strFile);
+    {
+        std::ofstream out(strTemp.c_str(), std::ios::binary | std::ios::trunc);
+        if (!out) return;
+        out << INDEX_MAGIC << '\n' << root.u8string() << '\n';
+        for (const auto& [strRel, dir] : index.dirs) {
+            out << "D\t" << dir.iModified << '\t' << strRel << '\n';
+            for (const std::string& strName : dir.vFiles)
+                out << "F\t" << strName << '\n';
+            for (const std::string& strName : dir.vSubdirs)
+                out << "S\t" << strName << '\n';
+        }
+        out.close();
+        if (!out) {
+            std::remove(strTemp.c_str());
+            return;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(strTemp, strFile, ec);
+    if (ec) std::remove(strTemp.c_str());
+}
+
+// An up to date index of root, re-listing only the directories changed since pPrior (if any, and not
+//  empty); strCache, if not empty, is where it is persisted, and read in place of a missing pPrior
+std::shared_ptr<const SRootIndex> UpdateIndex(const std::filesystem::path& root, const SRootIndex* pPrior,
+                                              const std::filesystem::path& excluded, const std::string& strCache) {
+    std::map<std::string, SDirectory> prior;
+    if (pPrior && !pPrior->dirs.empty()) prior = pPrior->dirs;
+    else if (!strCache.empty()) prior = ReadIndex(strCache, root);
+    bool bChanged = (prior.empty());
+    auto pIndex = std::make_shared<SRootIndex>();
+    IndexDirectory(root, "", excluded, prior, pIndex->dirs, bChanged);
+    bChanged |= (prior.size() != pIndex->dirs.size());
+
+    for (const auto& [strRel, dir] : pIndex->dirs) {
+        const std::filesystem::path path = strRel.empty() ? root : root / std::filesystem::u8path(strRel);
+        for (const std::string& strName : dir.vFiles)
+            pIndex->vFiles.emplace_back(strName, (path / std::filesystem::u8path(strName)).string());
+    }
+    std::sort(pIndex->vFiles.begin(), pIndex->vFiles.end());
+    if (bChanged && !strCache.empty()) WriteIndex(strCache, root, *pIndex);
+    return pIndex;
+}
+
+// Glob matching: '*' matches any run of characters, '?' any one
+bool GlobMatch(const std::string& strName, const std::string& strPattern) {
+    size_t n = 0, p = 0, iStar = std::string::npos, iStarName = 0;
+    while (n < strName.size()) {
+        if (p < strPattern.size() && (strPattern[p] == '?' || strPattern[p] == strName[n])) {
+            n++;
+            p++;
+        } else if (p < strPattern.size() && strPattern[p] == '*') {
+            iStar = p++;
+            iStarName = n;
+        } else if (iStar != std::string::npos) {
+            p = iStar + 1;
+            n = ++iStarName;
+        } else {
+            return false;
+        }
+    }
+    while (p < strPattern.size() && strPattern[p] == '*')
+        p++;
+    return p == strPattern.size();
+}
+
+std::filesystem::path NormalRoot(const std::filesystem::path& dir) {
+    std::error_code ec;
+    std::filesystem::path path = std::filesystem::absolute(dir, ec).lexically_normal();
+    if (!path.has_filename() && path.has_parent_path() && path != path.root_path()) path = path.parent_path();
+    return path;
+}
+
+} // namespace
+
+void Dasher::FileUtils::ScanFiles(AbstractParser* parser, const std::string& strPattern) const {
     // Absolute path to a real file -> parse only that file
     std::error_code error_code; // just used for not throwing errors
     std::filesystem::path p(strPattern);
@@ -47,57 +213,115 @@ void Dasher::FileUtils::ScanFiles(AbstractParser* parser, const std::string& str
         return;
     }
 
-    // Replace * with .* for actual regex matching
-    // Note: pattern is interpreted as regex, so "alphabet.*.xml" matches "alphabet.English.xml"
-    const std::regex pattern = std::regex(strPattern);
-
-    // Search in the specified data directory (or current directory if not set)
-    // Uses recursive_directory_iterator to find files in subdirectories
-    std::vector<std::filesystem::path> search_paths;
-    if (!s_dataDirectory.empty()) {
-        search_paths.push_back(std::filesystem::path(s_dataDirectory));
-    } else {
-        search_paths.push_back(std::filesystem::current_path());
+    // Search the data directory (or current directory if not set), then the user directory
+    std::vector<std::filesystem::path> search_paths{NormalRoot(
+        m_strDataDirectory.empty() ? std::filesystem::current_path() : std::filesystem::path(m_strDataDirectory))};
+    if (!m_strUserDataDirectory.empty()) {
+        const std::filesystem::path user = NormalRoot(m_strUserDataDirectory);
+        if (user != search_paths[0]) search_paths.push_back(user);
     }
 
-    for (const std::filesystem::path& current_path : search_paths) {
-        if (!std::filesystem::exists(current_path)) continue;
-        // Use recursive_directory_iterator to search subdirectories
-        for (const auto& entry : std::filesystem::recursive_directory_iterator(current_path)) {
-            if (entry.is_regular_file() && std::regex_search(entry.path().filename().string(), pattern)) {
-                parser->ParseFile(entry.path().string(), IsFileWriteable(entry.path()));
+    std::vector<std::string> vPaths;
+    for (size_t i = 0; i < search_paths.size(); i++) {
+        // Each root leaves out the other, if within it
+        const std::filesystem::path excluded = search_paths.size() > 1 ? search_paths[1 - i] : "";
+        // (found afresh each time the lock is taken, as other sessions may add roots meanwhile)
+        auto find = [&]() {
+            auto it = std::find_if(s_roots.begin(), s_roots.end(), [&](const SRoot& root) {
+                return root.root == search_paths[i] && root.excluded == excluded;
+            });
+            if (it == s_roots.end()) {
+                s_roots.emplace_back();
+                it = s_roots.end() - 1;
+                it->root = search_paths[i];
+                it->excluded = excluded;
             }
+            return it;
+        };
+        std::shared_ptr<const SRootIndex> pIndex;
+        bool bUpdate;
+        unsigned long iStaled;
+        {
+            std::lock_guard<std::mutex> lock(s_indexMutex);
+            auto it = find();
+            pIndex = it->pIndex;
+            bUpdate = !pIndex || pIndex->dirs.empty() || it->bStale;
+            iStaled = it->iStaled;
+        }
+        if (bUpdate) {
+            // Only the data directory's index is worth persisting; the user directory's is
+            //  small, and changes with every session.
+            const std::string strCache =
+                (i == 0 && search_paths.size() > 1) ? (search_paths[1] / "files.index").string() : std::string();
+            pIndex = UpdateIndex(search_paths[i], pIndex.get(), excluded, strCache);
+            std::lock_guard<std::mutex> lock(s_indexMutex);
+            auto it = find();
+            it->pIndex = pIndex;
+            it->bStale = (it->iStaled != iStaled); // if marked stale during the scan, it may have missed that
+        }
+
+        // Only files whose names start with the pattern's literal prefix need be compared
+        const std::string strPrefix = strPattern.substr(0, strPattern.find_first_of("*?"));
+        for (auto file = std::lower_bound(pIndex->vFiles.begin(), pIndex->vFiles.end(),
+                                          std::make_pair(strPrefix, std::string()));
+             file != pIndex->vFiles.end() && file->first.compare(0, strPrefix.size(), strPrefix) == 0; ++file) {
+            if (GlobMatch(file->first, strPattern)) vPaths.push_back(file->second);
         }
     }
+
+    for (const std::string& strPath : vPaths)
+        parser->ParseFile(strPath, IsFileWriteable(strPath));
+}
+
+void Dasher::FileUtils::InvalidateFileIndex() {
+    std::lock_guard<std::mutex> lock(s_indexMutex);
+    for (SRoot& root : s_roots)
+        MarkStale(root);
 }
 
-bool Dasher::FileUtils::WriteUserDataFile(const std::string& filename, const std::string& strNewText, bool append) {
+bool Dasher::FileUtils::WriteUserDataFile(const std::string& filename, const std::string& strNewText,
+                                          bool append) const {
     std::ofstream File(ResolveUserDataPath(filename), (append) ? std::ios_base::app : std::ios_base::out);
 
     if (File.is_open()) {
         File << strNewText;
         File.close();
+        // The file may be new to the index of the directory it is in
+        const std::filesystem::path path = NormalRoot(ResolveUserDataPath(filename));
+        std::lock_guard<std::mutex> lock(s_indexMutex);
+        for (SRoot& root : s_roots) {
+            if (std::mismatch(root.root.begin(), root.root.end(), path.begin(), path.end()).first == root.root.end())
+                MarkStale(root);
+        }
         return true;
     }
     return false;
 }
 
-std::string Dasher::FileUtils::ResolveUserDataPath(const std::string& filename) {
+std::string Dasher::FileUtils::ResolveUserDataPath(const std::string& filename) const {
     std::filesystem::path fullPath(filename);
     if (!fullPath.is_relative()) return filename;
     // Prefer the user-writable data directory for mutable files
     // (training deltas, dasher.log, settings). Fall back to the bundled
     // data directory if the client never configured a separate user dir
     // — this preserves the historical single-dir behaviour.
-    if (!s_userDataDirectory.empty()) {
-        return (std::filesystem::path(s_userDataDirectory) / filename).string();
+    if (!m_strUserDataDirectory.empty()) {
+        return (std::filesystem::path(m_strUserDataDirectory) / filename).string();
     }
-    if (!s_dataDirectory.empty()) {
-        return (std::filesystem::path(s_dataDirectory) / filename).string();
+    if (!m_strDataDirectory.empty()) {
+        return (std::filesystem::path(m_strDataDirectory) / filename).string();
     }
     return filename;
 }
 
+bool Dasher::FileUtils::IsInUserDataDirectory(const std::string& strPath) const {
+    if (m_strUserDataDirectory.empty()) return false;
+    const std::filesystem::path user = NormalRoot(m_strUserDataDirectory);
+    if (!m_strDataDirectory.empty() && NormalRoot(m_strDataDirectory) == user) return false;
+    const std::filesystem::path path = NormalRoot(strPath);
+    return std::mismatch(user.begin(), user.end(), path.begin(), path.end()).first == user.end();
+}
+
 std::string Dasher::FileUtils::GetFullFilenamePath(const std::string strFilename) {
     // We get a weak canonical path in case the path does not exist
     std::filesystem::path path = std::filesystem::weakly_canonical(strFilename);
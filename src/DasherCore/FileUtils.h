@@ -5,40 +5,61 @@
 
 namespace Dasher {
 
-// needed File utilities
+// needed File utilities. An instance looks files up in, and writes them to, the
+// directories it was given - each session (CDasherInterfaceBase) has its own, so
+// sessions with different directories can run side by side, on different threads.
+// What all share - the index of each directory listed - is guarded by a mutex.
 class FileUtils {
   public:
-    // Set the data directory for file operations (read-only bundled data:
-    // alphabets, training corpora, etc.). Used by ScanFiles().
-    static void SetDataDirectory(const std::string& dataDir);
+    // Files in the current directory
+    FileUtils() = default;
 
-    // Set the user data directory for writable per-user files (training
-    // text deltas, dasher.log, settings). Must point to a writable
-    // location. Falls back to the data directory if never set, preserving
-    // historical behaviour for clients that don't distinguish the two.
-    static void SetUserDataDirectory(const std::string& userDir);
+    // dataDir: read-only bundled data (alphabets, training corpora, etc.), searched
+    // by ScanFiles(). userDir: writable per-user files (training text deltas,
+    // dasher.log, settings) - must point to a writable location; if empty, the data
+    // directory is used instead, preserving historical behaviour for clients that
+    // don't distinguish the two.
+    FileUtils(const std::string& dataDir, const std::string& userDir)
+        : m_strDataDirectory(dataDir), m_strUserDataDirectory(userDir) {}
+
+    const std::string& GetDataDirectory() const { return m_strDataDirectory; }
+    const std::string& GetUserDataDirectory() const { return m_strUserDataDirectory; }
 
     // Return file size on disk
     static int GetFileSize(const std::string& strFileName);
 
-    // Open File with the filename strPattern in the project directory
-    static void ScanFiles(AbstractParser* parser, const std::string& strPattern);
+    // Parse every file under the data and user directories whose name matches the
+    // glob strPattern ('*' matching any run of characters, '?' any one), those in the
+    // data directory first; or, given the absolute path of a file, just that file.
+    // Lookups are answered from an index of both directories, listed on first use
+    // (and persisted in the user directory, along with the modification time of each
+    // directory, so that a later process need only re-list those which have changed).
+    void ScanFiles(AbstractParser* parser, const std::string& strPattern) const;
+
+    // Make the next ScanFiles check the index against the directories, re-listing
+    // any whose modification time has changed - e.g. after the frontend installs
+    // new data files. (Every directory indexed, whichever instance it was for.)
+    static void InvalidateFileIndex();
 
     // Writes into the user file
-    static bool WriteUserDataFile(const std::string& filename, const std::string& strNewText, bool append);
+    bool WriteUserDataFile(const std::string& filename, const std::string& strNewText, bool append) const;
 
     // Resolve a relative filename against the user data directory (or, if
     // unset, the data directory). Returns the input unchanged if absolute.
     // Used by code that needs the resolved path up front (e.g. FileLogger
     // captures its path at construction time).
-    static std::string ResolveUserDataPath(const std::string& filename);
+    std::string ResolveUserDataPath(const std::string& filename) const;
+
+    // Whether strPath lies within the user data directory, when that is set and is
+    // not the data directory: i.e. is the user's own, rather than bundled, data.
+    bool IsInUserDataDirectory(const std::string& strPath) const;
 
     // Convert relative to full paths
     static std::string GetFullFilenamePath(const std::string strFilename);
 
   private:
-    static std::string s_dataDirectory;
-    static std::string s_userDataDirectory;
+    std::string m_strDataDirectory;
+    std::string m_strUserDataDirectory;
 };
 
 // Just a function to Log XML errors
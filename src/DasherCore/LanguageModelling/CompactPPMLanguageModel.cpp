@@ -0,0 +1,234 @@
+// CompactPPMLanguageModel.cpp
+//
+// PPM language model keeping its trie in a contiguous, index-addressed arena.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "CompactPPMLanguageModel.h"
+
+#include "PPMLanguageModel.h"
+#include "DasherCore/Common/myassert.h"
+
+#include <algorithm>
+
+using namespace Dasher;
+
+namespace {
+// Up to this many children are searched linearly; beyond, by binary search
+const uint16_t MAX_LINEAR_CHILDREN = 8;
+
+// log2 of the size of the slab holding iNumChildren (>= 2) children
+int SlabLog2(unsigned int iNumChildren) {
+    int iLog2 = 1;
+    while ((1u << iLog2) < iNumChildren)
+        iLog2++;
+    return iLog2;
+}
+} // namespace
+
+CCompactPPMLanguageModel::CCompactPPMLanguageModel(CSettingsStore* pSettingsStore, int iNumSyms)
+    : CLanguageModel(iNumSyms), m_pSettingsStore(pSettingsStore),
+      m_iMaxOrder(m_pSettingsStore->GetLongParameter(LP_LM_MAX_ORDER)),
+      bUpdateExclusion(m_pSettingsStore->GetLongParameter(LP_LM_UPDATE_EXCLUSION) != 0),
+      m_vFreeSlabs(SlabLog2(std::max(iNumSyms, 2)) + 1), m_ContextAlloc(1024) {
+    DASHER_ASSERT(iNumSyms <= 0x10000); // symbols and child counts are stored in 16 bits
+    m_vNodes.push_back({NO_NODE, 0, 0, 1, 0, 0});
+}
+
+size_t CCompactPPMLanguageModel::GetMemoryUsage() const {
+    size_t iBytes = m_vNodes.capacity() * sizeof(SNode) + m_vChildren.capacity() * sizeof(SChild);
+    for (const std::vector<uint32_t>& vFree : m_vFreeSlabs)
+        iBytes += vFree.capacity() * sizeof(uint32_t);
+    return iBytes;
+}
+
+/////////////////////////////////////////////////////////////////////
+// Children
+
+CCompactPPMLanguageModel::NodeId CCompactPPMLanguageModel::FindChild(NodeId id, symbol sym) const {
+    const SNode& node = m_vNodes[id];
+    if (node.iNumChildren == 1) return (m_vNodes[node.iChildren].sym == sym) ? node.iChildren : NO_NODE;
+    const SChild* pFirst = m_vChildren.data() + node.iChildren;
+    const SChild* pLast = pFirst + node.iNumChildren;
+    if (node.iNumChildren <= MAX_LINEAR_CHILDREN) {
+        for (const SChild* pChild = pFirst; pChild != pLast; ++pChild)
+            if (pChild->sym == static_cast<uint32_t>(sym)) return pChild->id;
+        return NO_NODE;
+    }
+    const SChild* pFound = std::lower_bound(
+        pFirst, pLast, sym, [](const SChild& c, symbol s) { return c.sym < static_cast<uint32_t>(s); });
+    return (pFound != pLast && pFound->sym == static_cast<uint32_t>(sym)) ? pFound->id : NO_NODE;
+}
+
+uint32_t CCompactPPMLanguageModel::AllocSlab(int iLog2) {
+    std::vector<uint32_t>& vFree = m_vFreeSlabs[iLog2];
+    if (!vFree.empty()) {
+        const uint32_t iSlab = vFree.back();
+        vFree.pop_back();
+        return iSlab;
+    }
+    const size_t iSlab = m_vChildren.size();
+    m_vChildren.resize(iSlab + (size_t(1) << iLog2));
+    return static_cast<uint32_t>(iSlab);
+}
+
+void CCompactPPMLanguageModel::AddChild(NodeId id, NodeId child) {
+    const uint32_t sym = m_vNodes[child].sym;
+    const unsigned int iNum = m_vNodes[id].iNumChildren;
+    if (iNum == 0) {
+        m_vNodes[id].iChildren = child;
+    } else if (iNum == 1) {
+        // Moves out of the node into a slab of two
+        const NodeId only = m_vNodes[id].iChildren;
+        const uint32_t iSlab = AllocSlab(1);
+        SChild* pSlab = m_vChildren.data() + iSlab;
+        pSlab[0] = {m_vNodes[only].sym, only};
+        pSlab[1] = {sym, child};
+        if (pSlab[1].sym < pSlab[0].sym) std::swap(pSlab[0], pSlab[1]);
+        m_vNodes[id].iChildren = iSlab;
+    } else {
+        uint32_t iSlab = m_vNodes[id].iChildren;
+        const int iLog2 = SlabLog2(iNum);
+        if (iNum == (1u << iLog2)) {
+            // Full: move to a slab twice the size, freeing this one for reuse
+            const uint32_t iNewSlab = AllocSlab(iLog2 + 1);
+            std::copy(m_vChildren.begin() + iSlab, m_vChildren.begin() + iSlab + iNum, m_vChildren.begin() + iNewSlab);
+            m_vFreeSlabs[iLog2].push_back(iSlab);
+            m_vNodes[id].iChildren = iSlab = iNewSlab;
+        }
+        SChild* pFirst = m_vChildren.data() + iSlab;
+        SChild* pPos =
+            std::lower_bound(pFirst, pFirst + iNum, sym, [](const SChild& c, uint32_t s) { return c.sym < s; });
+        std::copy_backward(pPos, pFirst + iNum, pFirst + iNum + 1);
+        *pPos = {sym, child};
+    }
+    m_vNodes[id].iNumChildren = static_cast<uint16_t>(iNum + 1);
+}
+
+/////////////////////////////////////////////////////////////////////
+// Contexts
+
+CLanguageModel::Context CCompactPPMLanguageModel::CreateEmptyContext() {
+    CCompactContext* pCont = m_ContextAlloc.Alloc();
+    pCont->head = ROOT;
+    pCont->order = 0;
+    return reinterpret_cast<Context>(pCont);
+}
+
+CLanguageModel::Context CCompactPPMLanguageModel::CloneContext(Context Copy) {
+    CCompactContext* pCont = m_ContextAlloc.Alloc();
+    *pCont = *reinterpret_cast<CCompactContext*>(Copy);
+    return reinterpret_cast<Context>(pCont);
+}
+
+void CCompactPPMLanguageModel::ReleaseContext(Context release) {
+    m_ContextAlloc.Free(reinterpret_cast<CCompactContext*>(release));
+}
+
+bool CCompactPPMLanguageModel::GetContextKey(Context context, ContextKey& key) const {
+    const CCompactContext* pCont = reinterpret_cast<const CCompactContext*>(context);
+    key = {pCont->head, pCont->order};
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////
+// Entering and learning - as CAbstractPPM::EnterSymbol / LearnSymbol
+
+void CCompactPPMLanguageModel::EnterSymbol(Context c, int Symbol) {
+    if (Symbol == 0) return;
+
+    DASHER_ASSERT(Symbol >= 0 && Symbol < GetSize());
+
+    CCompactContext& context = *reinterpret_cast<CCompactContext*>(c);
+
+    while (context.head != NO_NODE) {
+        if (context.order < m_iMaxOrder) { // Only try to extend the context if it's not going to make it too long
+            const NodeId find = FindChild(context.head, Symbol);
+            if (find != NO_NODE) {
+                context.order++;
+                context.head = find;
+                return;
+            }
+        }
+
+        // If we can't extend the current context, follow vine pointer to shorten it and try again
+        context.order--;
+        context.head = Vine(context.head);
+    }
+
+    context.head = ROOT;
+    context.order = 0;
+}
+
+void CCompactPPMLanguageModel::LearnSymbol(Context c, int Symbol) {
+    if (Symbol == 0) return;
+
+    DASHER_ASSERT(Symbol >= 0 && Symbol < GetSize());
+    CCompactContext& context = *reinterpret_cast<CCompactContext*>(c);
+    m_iGeneration++;
+
+    context.head = AddSymbolToNode(context.head, Symbol);
+    context.order++;
+
+    while (context.order > m_iMaxOrder) {
+        context.head = Vine(context.head);
+        context.order--;
+    }
+}
+
+// As CAbstractPPM::AddSymbolToNode. Nodes are referred to by id throughout, as
+//  adding one may move the whole array.
+CCompactPPMLanguageModel::NodeId CCompactPPMLanguageModel::AddSymbolToNode(NodeId id, symbol sym) {
+    NodeId found = FindChild(id, sym);
+
+    if (found != NO_NODE) {
+        m_vNodes[found].count++;
+        if (!bUpdateExclusion) {
+            // update vine contexts too. Guaranteed to exist if child does!
+            for (NodeId v = Vine(found); v != NO_NODE; v = Vine(v)) {
+                DASHER_ASSERT(v == ROOT || Sym(v) == sym);
+                m_vNodes[v].count++;
+            }
+        }
+        return found;
+    }
+
+    // symbol does not exist at this level
+    DASHER_ASSERT(m_vNodes.size() < NO_NODE);
+    found = static_cast<NodeId>(m_vNodes.size());
+    m_vNodes.push_back({NO_NODE, 0, 0, 1, static_cast<uint16_t>(sym), 0}); // count 1 but no vine yet
+    AddChild(id, found);
+    const NodeId vine = (id == ROOT) ? ROOT : AddSymbolToNode(Vine(id), sym);
+    m_vNodes[found].vine = vine;
+    return found;
+}
+
+/////////////////////////////////////////////////////////////////////
+// Get the probability distribution at the context - as CAbstractPPM::mergePPMProbs
+
+void CCompactPPMLanguageModel::GetProbs(Context context, std::vector<unsigned int>& probs, int norm,
+                                        int iUniform) const {
+    const CCompactContext* ppmcontext = reinterpret_cast<const CCompactContext*>(context);
+    const int iNumSymbols = GetSize();
+    probs.resize(iNumSymbols);
+
+    const int alpha = m_pSettingsStore->GetLongParameter(LP_LM_ALPHA);
+    const int beta = m_pSettingsStore->GetLongParameter(LP_LM_BETA);
+
+    thread_local std::vector<CAbstractPPM::SymbolCount> childCounts;
+    thread_local std::vector<std::pair<symbol, unsigned int>> slices;
+    slices.clear();
+
+    unsigned int iToSpend = norm - iUniform;
+    for (NodeId n = ppmcontext->head; n != NO_NODE; n = Vine(n)) {
+        childCounts.clear();
+        ForEachChild(n, [&](symbol sym, NodeId c) { childCounts.push_back({sym, Count(c)}); });
+        iToSpend = CAbstractPPM::SliceLevel(childCounts, iToSpend, alpha, beta, slices);
+    }
+
+    probs[0] = 0;
+    CAbstractPPM::SpreadEvenly(probs.data(), iNumSymbols, iUniform, iToSpend);
+
+    for (const auto& [sym, p] : slices)
+        probs[sym] += p;
+}
@@ -0,0 +1,137 @@
+// CompactPPMLanguageModel.h
+//
+// PPM language model keeping its trie in a contiguous, index-addressed arena.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "DasherCore/Common/NoClones.h"
+#include "DasherCore/Common/Allocators/PooledAlloc.h"
+
+#include "DasherCore/DasherTypes.h"
+#include "LanguageModel.h"
+#include "DasherCore/SettingsStore.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace Dasher {
+
+///
+/// \ingroup LM
+/// @{
+///
+/// PPM language model storing the same trie as CPPMLanguageModel, but compactly:
+/// nodes are plain 16-byte records in one contiguous array, referring to each
+/// other by 32-bit index rather than by pointer, and the children of a node with
+/// more than one are kept, sorted by symbol, in a slab carved from a second
+/// array (slabs are powers of two in size, and reused once outgrown). There is
+/// no per-node heap allocation and no virtual dispatch below the CLanguageModel
+/// interface. GetMemoryUsage reports what this costs per node.
+///
+/// Predictions are identical to those of CPPMLanguageModel trained on the same
+/// text with the same LP_LM_* settings. Alphabets are limited to 65536 symbols
+/// (as for snapshots and mapped images).
+///
+class CCompactPPMLanguageModel : public CLanguageModel, private NoClones {
+  public:
+    CCompactPPMLanguageModel(CSettingsStore* pSettingsStore, int iNumSyms);
+
+    Context CreateEmptyContext() override;
+    Context CloneContext(Context context) override;
+    void ReleaseContext(Context context) override;
+
+    void EnterSymbol(Context context, int Symbol) override;
+    void LearnSymbol(Context context, int Symbol) override;
+
+    void GetProbs(Context context, std::vector<unsigned int>& Probs, int norm, int iUniform) const override;
+
+    /// The context's head node (by id), and order
+    bool GetContextKey(Context context, ContextKey& key) const override;
+
+    /// Number of nodes in the trie, including the root
+    size_t GetNodeCount() const { return m_vNodes.size(); }
+
+    /// Bytes allocated for the trie: the node and slab arrays (inc. spare capacity,
+    ///  and slabs awaiting reuse) and the lists of free slabs.
+    size_t GetMemoryUsage() const;
+
+    /// GetMemoryUsage() / GetNodeCount()
+    double GetBytesPerNode() const { return static_cast<double>(GetMemoryUsage()) / GetNodeCount(); }
+
+  protected:
+    /// Index of a node in the arena. Nodes are numbered densely, from the root (0),
+    ///  in order of creation, and keep their ids for good; so a subclass needing
+    ///  more per node (as CPPMPYLanguageModel's pinyin counts or CRoutingPPMLanguageModel's
+    ///  routes) keeps it in side arrays indexed by NodeId, grown to GetNodeCount().
+    typedef uint32_t NodeId;
+    static constexpr NodeId NO_NODE = UINT32_MAX;
+    static constexpr NodeId ROOT = 0;
+
+    /// The node a context is at
+    NodeId GetHead(Context context) const { return reinterpret_cast<const CCompactContext*>(context)->head; }
+
+    symbol Sym(NodeId id) const { return m_vNodes[id].sym; }
+    NodeId Vine(NodeId id) const { return m_vNodes[id].vine; }
+    unsigned short int Count(NodeId id) const { return m_vNodes[id].count; }
+    NodeId FindChild(NodeId id, symbol sym) const;
+    /// Calls f(sym, child) for every child of id, in order of symbol
+    template <typename F>
+    void ForEachChild(NodeId id, F f) const;
+
+  private:
+    struct SNode {
+        NodeId vine;
+        /// With one child, its id; with more, the offset of their slab in m_vChildren
+        uint32_t iChildren;
+        uint16_t iNumChildren;
+        unsigned short int count;
+        uint16_t sym;
+        uint16_t iPadding;
+    };
+    static_assert(sizeof(SNode) == 16, "nodes must be packed");
+    struct SChild {
+        uint32_t sym;
+        NodeId id;
+    };
+    class CCompactContext {
+      public:
+        NodeId head;
+        int order;
+    };
+
+    NodeId AddSymbolToNode(NodeId id, symbol sym);
+    void AddChild(NodeId id, NodeId child);
+    /// Offset of a free slab of 2^iLog2 children
+    uint32_t AllocSlab(int iLog2);
+
+    CSettingsStore* m_pSettingsStore;
+
+    /// Cache parameters that don't make sense to adjust during the life of a language model...
+    const int m_iMaxOrder;
+    const bool bUpdateExclusion;
+
+    std::vector<SNode> m_vNodes;
+    std::vector<SChild> m_vChildren;
+    /// Offsets of outgrown slabs, by log2 of their size
+    std::vector<std::vector<uint32_t>> m_vFreeSlabs;
+
+    CPooledAlloc<CCompactContext> m_ContextAlloc;
+};
+
+template <typename F>
+inline void CCompactPPMLanguageModel::ForEachChild(NodeId id, F f) const {
+    const SNode& node = m_vNodes[id];
+    if (node.iNumChildren == 1) {
+        f(static_cast<symbol>(m_vNodes[node.iChildren].sym), node.iChildren);
+        return;
+    }
+    for (const SChild *pChild = m_vChildren.data() + node.iChildren, *pEnd = pChild + node.iNumChildren;
+         pChild != pEnd; ++pChild)
+        f(static_cast<symbol>(pChild->sym), pChild->id);
+}
+
+/// @}
+
+} // namespace Dasher
@@ -6,6 +6,8 @@
 
 #include "LMRegistry.h"
 #include "PPMLanguageModel.h"
+#include "MappedPPMLanguageModel.h"
+#include "CompactPPMLanguageModel.h"
 #include "WordLanguageModel.h"
 #include "MixtureLanguageModel.h"
 #include "CTWLanguageModel.h"
@@ -72,7 +74,8 @@ struct StaticInit {
                         "Prediction by Partial Match",
                         false,
                         false,
-                        {LP_LM_ALPHA, LP_LM_BETA, LP_LM_MAX_ORDER, LP_LM_EXCLUSION, LP_LM_UPDATE_EXCLUSION},
+                        {LP_LM_ALPHA, LP_LM_BETA, LP_LM_MAX_ORDER, LP_LM_EXCLUSION, LP_LM_UPDATE_EXCLUSION,
+                         LP_LM_NODE_BUDGET},
                         [](CSettingsStore* s, const CAlphInfo*, const CAlphabetMap*, int n) -> CLanguageModel* {
                             return new CPPMLanguageModel(s, n);
                         }});
@@ -93,7 +96,7 @@ struct StaticInit {
                         true,
                         true,
                         {LP_LM_ALPHA, LP_LM_BETA, LP_LM_MAX_ORDER, LP_LM_MIXTURE, LP_LM_WORD_ALPHA, LP_LM_EXCLUSION,
-                         LP_LM_UPDATE_EXCLUSION},
+                         LP_LM_UPDATE_EXCLUSION, LP_LM_NODE_BUDGET},
                         [](CSettingsStore* s, const CAlphInfo* a, const CAlphabetMap* m, int) -> CLanguageModel* {
                             return new CMixtureLanguageModel(s, a, m);
                         }});
@@ -107,6 +110,26 @@ struct StaticInit {
                         [](CSettingsStore*, const CAlphInfo*, const CAlphabetMap*, int n) -> CLanguageModel* {
                             return new CCTWLanguageModel(n);
                         }});
+
+        reg.registerLM({5,
+                        "MappedPPM",
+                        "PPM served from a memory-mapped pre-trained image",
+                        false,
+                        false,
+                        {LP_LM_ALPHA, LP_LM_BETA, LP_LM_MAX_ORDER, LP_LM_UPDATE_EXCLUSION},
+                        [](CSettingsStore* s, const CAlphInfo*, const CAlphabetMap*, int n) -> CLanguageModel* {
+                            return new CMappedPPMLanguageModel(s, n);
+                        }});
+
+        reg.registerLM({6,
+                        "CompactPPM",
+                        "PPM with its trie in a compact, index-addressed arena",
+                        false,
+                        false,
+                        {LP_LM_ALPHA, LP_LM_BETA, LP_LM_MAX_ORDER, LP_LM_UPDATE_EXCLUSION},
+                        [](CSettingsStore* s, const CAlphInfo*, const CAlphabetMap*, int n) -> CLanguageModel* {
+                            return new CCompactPPMLanguageModel(s, n);
+                        }});
     }
 };
 
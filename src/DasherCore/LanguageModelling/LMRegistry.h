@@ -3,8 +3,10 @@
 // Language Model Registry for DasherCore.
 //
 // Provides a plugin-style factory for language models. Built-in LMs
-// (PPM, Word, Mixture, CTW) self-register at static init time.
+// (PPM, Word, Mixture, CTW, MappedPPM, CompactPPM) self-register at static init time.
 // External LMs (e.g. KenLM, ONNX) can register via Dasher::LMRegistry::registerLM().
+// Registration is not synchronised: do it before creating any context. After that the
+// registry is only read, so contexts on different threads can share it.
 //
 // See docs/LM_REGISTRY.md for full documentation.
 //
@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <vector>
 #include <string>
 
@@ -96,6 +97,39 @@ class Dasher::CLanguageModel {
 
     /// @}
 
+    /// @name Caching predictions
+    /// For callers keeping GetProbs results to reuse for other contexts in the same state
+    /// @{
+
+    ///
+    /// Identifies the state a context predicts from: the node it is at (pointer or
+    /// index, as the model likes) and its order
+    ///
+
+    struct ContextKey {
+        uintptr_t iNode;
+        int iOrder;
+        bool operator==(const ContextKey& other) const { return iNode == other.iNode && iOrder == other.iOrder; }
+    };
+
+    ///
+    /// Gets the key of a context: two contexts with the same key get the same GetProbs
+    /// (for the same norm, uniform and settings) as long as GetGeneration is unchanged.
+    /// Returns false if the model can't tell, so its predictions should not be kept.
+    ///
+
+    virtual bool GetContextKey(Context context, ContextKey& key) const { return false; }
+
+    ///
+    /// Count of changes to the model that may change its predictions. Models
+    /// implementing GetContextKey bump it on every LearnSymbol, or anything else
+    /// that changes the counts or nodes (such as reading from a file)
+    ///
+
+    uint64_t GetGeneration() const { return m_iGeneration; }
+
+    /// @}
+
     /// @name Persistant storage
     /// Binary representation of language model state
     /// @{
@@ -138,6 +172,9 @@ class Dasher::CLanguageModel {
     int GetSize() const { return m_iNumSyms + 1; }
 
     const int m_iNumSyms;
+
+    /// See GetGeneration
+    uint64_t m_iGeneration = 0;
 };
 
 /// @}
@@ -0,0 +1,472 @@
+// MappedPPMLanguageModel.cpp
+//
+// PPM language model served from a memory-mapped, pre-trained image.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MappedPPMLanguageModel.h"
+
+#include "DasherCore/Common/myassert.h"
+#include "DasherCore/Common/TempFile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace Dasher;
+
+/////////////////////////////////////////////////////////////////////
+// Image format
+//
+// An SImageHeader, the alphabet ID (UTF-8, not terminated), padding up to
+// iNodesOffset, then iNumNodes SImageNodes. Node 0 is the root; nodes are in
+// breadth-first order with each node's children contiguous and sorted by
+// symbol, so a child is found by binary search over [iFirstChild,
+// iFirstChild + iNumChildren). All links are indices into the node array
+// (NO_NODE for the root's vine), never pointers, so the array is used in
+// place straight from the mapping. Native-endian, checked via iByteOrder.
+
+struct CMappedPPMLanguageModel::SImageNode {
+    uint32_t iFirstChild;
+    uint32_t iVine;
+    uint32_t iNumChildren;
+    uint16_t iSymbol;
+    uint16_t iCount;
+};
+static_assert(sizeof(CMappedPPMLanguageModel::SImageNode) == 16, "image nodes must be packed");
+
+namespace {
+const char IMAGE_MAGIC[8] = {'%', 'D', 'P', 'P', 'M', 'M', 'A', 'P'};
+const uint32_t IMAGE_VERSION = 1;
+const uint32_t IMAGE_BYTE_ORDER = 0x01020304;
+
+struct SImageHeader {
+    char szMagic[8];
+    uint32_t iVersion;
+    uint32_t iByteOrder;
+    uint32_t iNumSyms;
+    int32_t iMaxOrder;
+    uint32_t iUpdateExclusion;
+    uint32_t iAlphabetIDLength;
+    uint64_t iTrainingHash;
+    uint64_t iNumNodes;
+    uint64_t iNodesOffset;
+};
+} // namespace
+
+CMappedPPMLanguageModel::CMappedPPMLanguageModel(CSettingsStore* pSettingsStore, int iNumSyms)
+    : CLanguageModel(iNumSyms), m_pSettingsStore(pSettingsStore),
+      m_iMaxOrder(m_pSettingsStore->GetLongParameter(LP_LM_MAX_ORDER)),
+      bUpdateExclusion(m_pSettingsStore->GetLongParameter(LP_LM_UPDATE_EXCLUSION) != 0), m_ContextAlloc(1024) {
+    // Without an image, the root is the first overlay node
+    m_vOverlay.push_back({-1, NO_NODE, 1, {}});
+}
+
+CMappedPPMLanguageModel::~CMappedPPMLanguageModel() {
+    Unmap();
+}
+
+/////////////////////////////////////////////////////////////////////
+// Node accessors, merging image and overlay
+
+symbol CMappedPPMLanguageModel::Sym(NodeId id) const {
+    if (IsImageNode(id)) return id == 0 ? -1 : m_pImageNodes[id].iSymbol;
+    return m_vOverlay[id - m_iNumImageNodes].sym;
+}
+
+CMappedPPMLanguageModel::NodeId CMappedPPMLanguageModel::Vine(NodeId id) const {
+    if (!IsImageNode(id)) return m_vOverlay[id - m_iNumImageNodes].vine;
+    // (checked by MapImage: earlier in the breadth-first order, but for the root's)
+    return m_pImageNodes[id].iVine;
+}
+
+unsigned short int CMappedPPMLanguageModel::Count(NodeId id) const {
+    if (!IsImageNode(id)) return m_vOverlay[id - m_iNumImageNodes].count;
+    unsigned short int count = m_pImageNodes[id].iCount;
+    if (!m_mapImageDeltas.empty()) {
+        auto it = m_mapImageDeltas.find(id);
+        // wraps exactly as CPPMnode::count would have
+        if (it != m_mapImageDeltas.end()) count = static_cast<unsigned short int>(count + it->second.count);
+    }
+    return count;
+}
+
+bool CMappedPPMLanguageModel::ImageSymbolValid(NodeId id) const {
+    const uint16_t iSymbol = m_pImageNodes[id].iSymbol;
+    return iSymbol != 0 && iSymbol < GetSize();
+}
+
+bool CMappedPPMLanguageModel::ImageChildren(NodeId id, NodeId& first, NodeId& num) const {
+    first = m_pImageNodes[id].iFirstChild;
+    num = m_pImageNodes[id].iNumChildren;
+    // Children always follow their parent in the breadth-first order, and must lie within the image
+    return num && first > id && num <= m_iNumImageNodes && first <= m_iNumImageNodes - num;
+}
+
+namespace {
+template <typename Vec>
+auto LowerBoundSym(Vec& v, symbol sym) {
+    return std::lower_bound(v.begin(), v.end(), sym, [](const auto& c, symbol s) { return c.sym < s; });
+}
+} // namespace
+
+CMappedPPMLanguageModel::NodeId CMappedPPMLanguageModel::FindChild(NodeId id, symbol sym) const {
+    const std::vector<SChild>* pExtra;
+    if (IsImageNode(id)) {
+        NodeId first, num;
+        if (ImageChildren(id, first, num)) {
+            const SImageNode* pFirst = m_pImageNodes + first;
+            const SImageNode* pLast = pFirst + num;
+            const SImageNode* pFound = std::lower_bound(
+                pFirst, pLast, sym, [](const SImageNode& n, symbol s) { return static_cast<symbol>(n.iSymbol) < s; });
+            // (sym is of the alphabet, so a node matching it has a valid symbol)
+            if (pFound != pLast && pFound->iSymbol == sym) return static_cast<NodeId>(pFound - m_pImageNodes);
+        }
+        if (m_mapImageDeltas.empty()) return NO_NODE;
+        auto it = m_mapImageDeltas.find(id);
+        if (it == m_mapImageDeltas.end()) return NO_NODE;
+        pExtra = &it->second.vChildren;
+    } else {
+        pExtra = &m_vOverlay[id - m_iNumImageNodes].vChildren;
+    }
+    auto it = LowerBoundSym(*pExtra, sym);
+    return (it != pExtra->end() && it->sym == sym) ? it->id : NO_NODE;
+}
+
+template <typename F>
+void CMappedPPMLanguageModel::ForEachChild(NodeId id, F f) const {
+    const std::vector<SChild>* pExtra = nullptr;
+    if (IsImageNode(id)) {
+        NodeId first, num;
+        if (ImageChildren(id, first, num)) {
+            for (NodeId c = first; c < first + num; c++)
+                if (ImageSymbolValid(c)) f(c);
+        }
+        if (!m_mapImageDeltas.empty()) {
+            auto it = m_mapImageDeltas.find(id);
+            if (it != m_mapImageDeltas.end()) pExtra = &it->second.vChildren;
+        }
+    } else {
+        pExtra = &m_vOverlay[id - m_iNumImageNodes].vChildren;
+    }
+    if (pExtra)
+        for (const SChild& c : *pExtra)
+            f(c.id);
+}
+
+/////////////////////////////////////////////////////////////////////
+// Contexts
+
+CLanguageModel::Context CMappedPPMLanguageModel::CreateEmptyContext() {
+    CMappedContext* pCont = m_ContextAlloc.Alloc();
+    pCont->head = 0;
+    pCont->order = 0;
+    m_iLiveContexts++;
+    return reinterpret_cast<Context>(pCont);
+}
+
+CLanguageModel::Context CMappedPPMLanguageModel::CloneContext(Context Copy) {
+    CMappedContext* pCont = m_ContextAlloc.Alloc();
+    *pCont = *reinterpret_cast<CMappedContext*>(Copy);
+    m_iLiveContexts++;
+    return reinterpret_cast<Context>(pCont);
+}
+
+void CMappedPPMLanguageModel::ReleaseContext(Context release) {
+    m_ContextAlloc.Free(reinterpret_cast<CMappedContext*>(release));
+    m_iLiveContexts--;
+}
+
+/////////////////////////////////////////////////////////////////////
+// Entering and learning - as CAbstractPPM::EnterSymbol / LearnSymbol
+
+void CMappedPPMLanguageModel::EnterSymbol(Context c, int Symbol) {
+    if (Symbol == 0) return;
+
+    DASHER_ASSERT(Symbol >= 0 && Symbol < GetSize());
+
+    CMappedContext& context = *reinterpret_cast<CMappedContext*>(c);
+
+    while (context.head != NO_NODE) {
+        if (context.order < m_iMaxOrder) { // Only try to extend the context if it's not going to make it too long
+            NodeId find = FindChild(context.head, Symbol);
+            if (find != NO_NODE) {
+                context.order++;
+                context.head = find;
+                return;
+            }
+        }
+        // If we can't extend the current context, follow vine pointer to shorten it and try again
+        context.order--;
+        context.head = Vine(context.head);
+    }
+
+    context.head = 0;
+    context.order = 0;
+}
+
+void CMappedPPMLanguageModel::LearnSymbol(Context c, int Symbol) {
+    if (Symbol == 0) return;
+
+    DASHER_ASSERT(Symbol >= 0 && Symbol < GetSize());
+    CMappedContext& context = *reinterpret_cast<CMappedContext*>(c);
+
+    context.head = AddSymbolToNode(context.head, Symbol);
+    context.order++;
+
+    while (context.order > m_iMaxOrder) {
+        context.head = Vine(context.head);
+        context.order--;
+    }
+}
+
+void CMappedPPMLanguageModel::IncrementCount(NodeId id) {
+    if (IsImageNode(id))
+        m_mapImageDeltas[id].count++;
+    else
+        m_vOverlay[id - m_iNumImageNodes].count++;
+}
+
+CMappedPPMLanguageModel::NodeId CMappedPPMLanguageModel::AddSymbolToNode(NodeId id, symbol sym) {
+    NodeId ret = FindChild(id, sym);
+
+    if (ret != NO_NODE) {
+        IncrementCount(ret);
+        if (!bUpdateExclusion) {
+            // update vine contexts too. Guaranteed to exist if child does!
+            for (NodeId v = Vine(ret); v != NO_NODE; v = Vine(v))
+                IncrementCount(v);
+        }
+        return ret;
+    }
+
+    // symbol does not exist at this level: create it in the overlay (indices, not
+    //  references, throughout - the recursive call below may grow m_vOverlay)
+    ret = static_cast<NodeId>(m_iNumImageNodes + m_vOverlay.size());
+    m_vOverlay.push_back({sym, NO_NODE, 1, {}});
+    std::vector<SChild>& vChildren =
+        IsImageNode(id) ? m_mapImageDeltas[id].vChildren : m_vOverlay[id - m_iNumImageNodes].vChildren;
+    vChildren.insert(LowerBoundSym(vChildren, sym), {sym, ret});
+    // Only the root has no vine; should any other node lack one, the new node's falls back to the root
+    const NodeId parentVine = Vine(id);
+    const NodeId vine = (id == 0 || parentVine == NO_NODE) ? 0 : AddSymbolToNode(parentVine, sym);
+    m_vOverlay[ret - m_iNumImageNodes].vine = vine;
+    return ret;
+}
+
+/////////////////////////////////////////////////////////////////////
+// Probabilities
+//
+// The same four phases as CAbstractPPM::mergePPMProbs (see there for the
+// full description). The arithmetic must stay identical, so that an image
+// gives exactly the same predictions as the CPPMLanguageModel it was
+// trained as.
+
+void CMappedPPMLanguageModel::GetProbs(Context context, std::vector<unsigned int>& probs, int norm,
+                                       int iUniform) const {
+    const CMappedContext* ppmcontext = reinterpret_cast<const CMappedContext*>(context);
+    const int alpha = m_pSettingsStore->GetLongParameter(LP_LM_ALPHA);
+    const int beta = m_pSettingsStore->GetLongParameter(LP_LM_BETA);
+    const int iNumSymbols = GetSize();
+
+    probs.resize(iNumSymbols);
+
+    thread_local std::vector<CAbstractPPM::SymbolCount> childCounts;
+    thread_local std::vector<std::pair<symbol, unsigned int>> slices;
+    slices.clear();
+
+    unsigned int iToSpend = norm - iUniform;
+    for (NodeId n = ppmcontext->head; n != NO_NODE; n = Vine(n)) {
+        childCounts.clear();
+        ForEachChild(n, [&](NodeId c) { childCounts.push_back({Sym(c), Count(c)}); });
+        iToSpend = CAbstractPPM::SliceLevel(childCounts, iToSpend, alpha, beta, slices);
+    }
+
+    probs[0] = 0;
+    CAbstractPPM::SpreadEvenly(probs.data(), iNumSymbols, iUniform, iToSpend);
+    for (const auto& [sym, p] : slices)
+        probs[sym] += p;
+}
+
+/////////////////////////////////////////////////////////////////////
+// Mapping and writing images
+
+bool CMappedPPMLanguageModel::ImageVinesValid(const SImageNode* pNodes, NodeId iNumNodes) {
+    if (pNodes[0].iVine != NO_NODE) return false;
+    // Vines always point one level shallower, hence earlier in the breadth-first order
+    for (NodeId id = 1; id < iNumNodes; id++)
+        if (pNodes[id].iVine >= id) return false;
+    return true;
+}
+
+void CMappedPPMLanguageModel::Unmap() {
+    if (!m_pImage) return;
+#ifdef _WIN32
+    UnmapViewOfFile(m_pImage);
+    CloseHandle(static_cast<HANDLE>(m_hMapping));
+    m_hMapping = nullptr;
+#else
+    munmap(const_cast<char*>(m_pImage), m_iImageSize);
+#endif
+    m_pImage = nullptr;
+    m_iImageSize = 0;
+    m_pImageNodes = nullptr;
+    m_iNumImageNodes = 0;
+}
+
+bool CMappedPPMLanguageModel::MapImage(const std::string& strFilename, const CPPMLanguageModel::SnapshotKey& key) {
+    if (m_iLiveContexts) return false; // contexts may point into the overlay we are about to discard
+
+    std::error_code ec;
+    const uintmax_t iFileSize = std::filesystem::file_size(strFilename, ec);
+    if (ec || iFileSize < sizeof(SImageHeader)) return false;
+
+    const char* pImage = nullptr;
+#ifdef _WIN32
+    HANDLE hFile = CreateFileA(strFilename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                               OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (hFile == INVALID_HANDLE_VALUE) return false;
+    HANDLE hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(hFile); // the mapping keeps the file open
+    if (!hMapping) return false;
+    pImage = static_cast<const char*>(MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0));
+    if (!pImage) {
+        CloseHandle(hMapping);
+        return false;
+    }
+    auto unmap = [&]() {
+        UnmapViewOfFile(pImage);
+        CloseHandle(hMapping);
+    };
+#else
+    int fd = open(strFilename.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    void* pMap = mmap(nullptr, static_cast<size_t>(iFileSize), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // the mapping keeps the file open
+    if (pMap == MAP_FAILED) return false;
+    pImage = static_cast<const char*>(pMap);
+    auto unmap = [&]() { munmap(pMap, static_cast<size_t>(iFileSize)); };
+#endif
+
+    // The header is checked, and every node's vine, as following a vine out of range would index past
+    //  the overlay; children and symbols are bounds-checked as they are followed instead.
+    SImageHeader sHeader;
+    memcpy(&sHeader, pImage, sizeof(sHeader));
+    const bool bValid =
+        memcmp(sHeader.szMagic, IMAGE_MAGIC, sizeof(sHeader.szMagic)) == 0 && sHeader.iVersion == IMAGE_VERSION &&
+        sHeader.iByteOrder == IMAGE_BYTE_ORDER && sHeader.iNumSyms == static_cast<uint32_t>(GetSize()) &&
+        sHeader.iMaxOrder == m_iMaxOrder && sHeader.iUpdateExclusion == (bUpdateExclusion ? 1u : 0u) &&
+        (key.iTrainingHash == CPPMLanguageModel::SnapshotKey::ANY_TRAINING ||
+         sHeader.iTrainingHash == key.iTrainingHash) &&
+        sHeader.iAlphabetIDLength == key.strAlphabetID.size() &&
+        sizeof(SImageHeader) + sHeader.iAlphabetIDLength <= sHeader.iNodesOffset &&
+        sHeader.iNodesOffset % alignof(SImageNode) == 0 && sHeader.iNumNodes > 0 && sHeader.iNumNodes < NO_NODE &&
+        iFileSize == sHeader.iNodesOffset + sHeader.iNumNodes * sizeof(SImageNode) &&
+        key.strAlphabetID.compare(0, std::string::npos, pImage + sizeof(SImageHeader), sHeader.iAlphabetIDLength) ==
+            0;
+    if (!bValid || !ImageVinesValid(reinterpret_cast<const SImageNode*>(pImage + sHeader.iNodesOffset),
+                                    static_cast<NodeId>(sHeader.iNumNodes))) {
+        unmap();
+        return false;
+    }
+
+    Unmap();
+    m_pImage = pImage;
+    m_iImageSize = static_cast<size_t>(iFileSize);
+#ifdef _WIN32
+    m_hMapping = hMapping;
+#endif
+    m_pImageNodes = reinterpret_cast<const SImageNode*>(pImage + sHeader.iNodesOffset);
+    m_iNumImageNodes = static_cast<NodeId>(sHeader.iNumNodes);
+    m_vOverlay.clear();
+    m_mapImageDeltas.clear();
+    return true;
+}
+
+bool CMappedPPMLanguageModel::WriteImage(const std::string& strFilename,
+                                         const CPPMLanguageModel::SnapshotKey& key) const {
+    if (GetSize() > 0xFFFF) return false; // symbols are stored in 16 bits
+
+    // Breadth-first renumbering of image + overlay. Ids are dense, so a vector maps old ids to new.
+    const size_t iTotal = m_iNumImageNodes + m_vOverlay.size();
+    std::vector<NodeId> vOrder, vNewId(iTotal, NO_NODE);
+    std::vector<SImageNode> vNodes;
+    vOrder.reserve(iTotal);
+    vNodes.reserve(iTotal);
+    std::vector<NodeId> vChildren;
+
+    vOrder.push_back(0);
+    vNewId[0] = 0;
+    for (size_t i = 0; i < vOrder.size(); i++) {
+        const NodeId id = vOrder[i];
+        vChildren.clear();
+        ForEachChild(id, [&](NodeId c) { vChildren.push_back(c); });
+        // image children and overlay children are each sorted; the merge must be too
+        std::sort(vChildren.begin(), vChildren.end(),
+                  [this](NodeId a, NodeId b) { return Sym(a) < Sym(b); });
+
+        SImageNode node;
+        node.iFirstChild = static_cast<uint32_t>(vOrder.size());
+        node.iNumChildren = static_cast<uint32_t>(vChildren.size());
+        node.iSymbol = static_cast<uint16_t>(i == 0 ? 0 : Sym(id));
+        node.iCount = Count(id);
+        const NodeId vine = Vine(id);
+        node.iVine = (vine == NO_NODE) ? NO_NODE : vNewId[vine];
+        if (vine != NO_NODE && node.iVine == NO_NODE) return false; // vine not yet numbered: not a PPM trie
+        for (NodeId c : vChildren) {
+            vNewId[c] = static_cast<NodeId>(vOrder.size());
+            vOrder.push_back(c);
+        }
+        vNodes.push_back(node);
+    }
+
+    SImageHeader sHeader;
+    memcpy(sHeader.szMagic, IMAGE_MAGIC, sizeof(sHeader.szMagic));
+    sHeader.iVersion = IMAGE_VERSION;
+    sHeader.iByteOrder = IMAGE_BYTE_ORDER;
+    sHeader.iNumSyms = GetSize();
+    sHeader.iMaxOrder = m_iMaxOrder;
+    sHeader.iUpdateExclusion = bUpdateExclusion ? 1 : 0;
+    sHeader.iAlphabetIDLength = static_cast<uint32_t>(key.strAlphabetID.size());
+    sHeader.iTrainingHash = key.iTrainingHash;
+    sHeader.iNumNodes = vNodes.size();
+    // Page-align the node array, so nodes never straddle the header's page
+    sHeader.iNodesOffset = (sizeof(SImageHeader) + key.strAlphabetID.size() + 4095) & ~uint64_t(4095);
+
+    const std::string strTemp = UniqueTempName(strFilename);
+    {
+        std::ofstream oOutputFile(strTemp.c_str(), std::ios::binary | std::ios::trunc);
+        if (!oOutputFile) return false;
+        oOutputFile.write(reinterpret_cast<const char*>(&sHeader), sizeof(sHeader));
+        oOutputFile.write(key.strAlphabetID.data(), key.strAlphabetID.size());
+        const std::string strPad(sHeader.iNodesOffset - sizeof(sHeader) - key.strAlphabetID.size(), '\0');
+        oOutputFile.write(strPad.data(), strPad.size());
+        oOutputFile.write(reinterpret_cast<const char*>(vNodes.data()), vNodes.size() * sizeof(SImageNode));
+        oOutputFile.close();
+        if (!oOutputFile) {
+            std::remove(strTemp.c_str());
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(strTemp, strFilename, ec);
+    if (ec) {
+        std::remove(strTemp.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,153 @@
+// MappedPPMLanguageModel.h
+//
+// PPM language model served from a memory-mapped, pre-trained image.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "DasherCore/Common/NoClones.h"
+#include "DasherCore/Common/Allocators/PooledAlloc.h"
+
+#include "LanguageModel.h"
+#include "PPMLanguageModel.h"
+#include "DasherCore/SettingsStore.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Dasher {
+
+///
+/// \ingroup LM
+/// @{
+///
+/// PPM language model whose trained trie is a read-only image mapped straight
+/// from disk. Nodes in the image refer to each other by index (relative to the
+/// start of the node array) rather than by pointer, so the file is usable as
+/// soon as it is mapped: opening a language costs page faults rather than
+/// allocations, and every context on the host that maps the same image shares
+/// its physical pages.
+///
+/// Symbols learnt during the session (LearnSymbol) go into a private heap
+/// overlay: count increments for image nodes, and whole new nodes, which are
+/// merged with the image on every lookup. Without an image the model simply
+/// starts empty and everything lives in the overlay; WriteImage then flattens
+/// image + overlay into a new image (which is how images are produced).
+///
+/// Predictions are identical to those of CPPMLanguageModel trained on the same
+/// text with the same LP_LM_* settings.
+///
+class CMappedPPMLanguageModel : public CLanguageModel, private NoClones {
+  public:
+    CMappedPPMLanguageModel(CSettingsStore* pSettingsStore, int iNumSyms);
+    ~CMappedPPMLanguageModel() override;
+
+    Context CreateEmptyContext() override;
+    Context CloneContext(Context context) override;
+    void ReleaseContext(Context context) override;
+
+    void EnterSymbol(Context context, int Symbol) override;
+    void LearnSymbol(Context context, int Symbol) override;
+
+    void GetProbs(Context context, std::vector<unsigned int>& Probs, int norm, int iUniform) const override;
+
+    /// Maps the image at strFilename as the base model, discarding anything
+    ///  learnt so far. Returns false, leaving the model untouched, if the file
+    ///  is missing, is not an image of this format version, does not match key
+    ///  (its training hash unless that is SnapshotKey::ANY_TRAINING)
+    ///  or this model's alphabet size / LP_LM_MAX_ORDER / LP_LM_UPDATE_EXCLUSION,
+    ///  has a node whose vine is out of range, or if any context is still live.
+    bool MapImage(const std::string& strFilename, const CPPMLanguageModel::SnapshotKey& key);
+
+    /// Writes the current model (image plus overlay) as a new image. The file
+    ///  is written alongside, under a name no other writer uses, and renamed into
+    ///  place, so processes that have the old image mapped are unaffected.
+    bool WriteImage(const std::string& strFilename, const CPPMLanguageModel::SnapshotKey& key) const;
+
+    /// True if the base model is a mapped image (rather than empty)
+    bool IsMapped() const { return m_pImage != nullptr; }
+
+    /// Number of nodes in the mapped image, and created in the overlay
+    size_t GetImageNodeCount() const { return m_iNumImageNodes; }
+    size_t GetOverlayNodeCount() const { return m_vOverlay.size(); }
+
+    /// One node of a mapped image (see MappedPPMLanguageModel.cpp for the file format)
+    struct SImageNode;
+
+  private:
+
+    /// Node ids: [0, m_iNumImageNodes) index the image, the rest index m_vOverlay
+    ///  (offset by m_iNumImageNodes). The root is always id 0.
+    typedef uint32_t NodeId;
+    static constexpr NodeId NO_NODE = UINT32_MAX;
+
+    struct SChild {
+        symbol sym;
+        NodeId id;
+    };
+    /// A node created by LearnSymbol. Children are kept sorted by symbol.
+    struct SOverlayNode {
+        symbol sym;
+        NodeId vine;
+        unsigned short int count;
+        std::vector<SChild> vChildren;
+    };
+    /// What LearnSymbol has added to a node of the image. Children are kept sorted by symbol.
+    struct SImageDelta {
+        unsigned short int count = 0;
+        std::vector<SChild> vChildren;
+    };
+    class CMappedContext {
+      public:
+        NodeId head;
+        int order;
+    };
+
+    bool IsImageNode(NodeId id) const { return id < m_iNumImageNodes; }
+    symbol Sym(NodeId id) const;
+    NodeId Vine(NodeId id) const;
+    unsigned short int Count(NodeId id) const;
+    /// Whether every node of an image has a vine to an earlier node (and the root none)
+    static bool ImageVinesValid(const SImageNode* pNodes, NodeId iNumNodes);
+    /// Whether image node id has a symbol of the alphabet: if not (the image is corrupt), the link
+    ///  to it is broken, as is one to a node out of range
+    bool ImageSymbolValid(NodeId id) const;
+    /// Range of id's children within the image; false if it has none (or the image is corrupt)
+    bool ImageChildren(NodeId id, NodeId& first, NodeId& num) const;
+    NodeId FindChild(NodeId id, symbol sym) const;
+    /// Calls f(sym, count) for every child of id, image children first
+    template <typename F>
+    void ForEachChild(NodeId id, F f) const;
+
+    void IncrementCount(NodeId id);
+    NodeId AddSymbolToNode(NodeId id, symbol sym);
+    void Unmap();
+
+    CSettingsStore* m_pSettingsStore;
+
+    /// Cache parameters that don't make sense to adjust during the life of a language model...
+    const int m_iMaxOrder;
+    const bool bUpdateExclusion;
+
+    /// The mapping (whole file), and the node array within it
+    const char* m_pImage = nullptr;
+    size_t m_iImageSize = 0;
+    const SImageNode* m_pImageNodes = nullptr;
+    NodeId m_iNumImageNodes = 0;
+#ifdef _WIN32
+    void* m_hMapping = nullptr;
+#endif
+
+    std::vector<SOverlayNode> m_vOverlay;
+    std::unordered_map<NodeId, SImageDelta> m_mapImageDeltas;
+
+    CPooledAlloc<CMappedContext> m_ContextAlloc;
+    int m_iLiveContexts = 0;
+};
+
+/// @}
+
+} // namespace Dasher
@@ -8,17 +8,27 @@
 
 #include "PPMLanguageModel.h"
 
+#include <algorithm>
+#include <cstdio>
 #include <cstring>
+#include <filesystem>
+#include <unordered_map>
 #include "DasherCore/Common/myassert.h"
+#include "DasherCore/Common/TempFile.h"
 
 using namespace Dasher;
 
 /////////////////////////////////////////////////////////////////////
 
-CAbstractPPM::CAbstractPPM(CSettingsStore* pSettingsStore, int iNumSyms, CPPMnode* pRoot, int iMaxOrder)
+CAbstractPPM::CAbstractPPM(CSettingsStore* pSettingsStore, int iNumSyms, CPPMnode* pRoot, int iMaxOrder,
+                           int iUpdateExclusion, long iNodeBudget)
     : CLanguageModel(iNumSyms), m_pRoot(pRoot), m_pSettingsStore(pSettingsStore),
       m_iMaxOrder(iMaxOrder < 0 ? m_pSettingsStore->GetLongParameter(LP_LM_MAX_ORDER) : iMaxOrder),
-      bUpdateExclusion(m_pSettingsStore->GetLongParameter(LP_LM_UPDATE_EXCLUSION) != 0), m_ContextAlloc(1024) {
+      bUpdateExclusion(iUpdateExclusion < 0 ? m_pSettingsStore->GetLongParameter(LP_LM_UPDATE_EXCLUSION) != 0
+                                            : iUpdateExclusion != 0),
+      m_iNodeBudget(std::max(iNodeBudget < 0 ? m_pSettingsStore->GetLongParameter(LP_LM_NODE_BUDGET) : iNodeBudget,
+                             0l)),
+      m_ContextAlloc(1024) {
     m_pRootContext = m_ContextAlloc.Alloc();
     m_pRootContext->head = m_pRoot;
     m_pRootContext->order = 0;
@@ -28,6 +38,12 @@ bool CAbstractPPM::isValidContext(const Context context) const {
     return m_setContexts.count(reinterpret_cast<const CPPMContext*>(context)) > 0;
 }
 
+bool CAbstractPPM::GetContextKey(Context context, ContextKey& key) const {
+    const CPPMContext* ppmcontext = reinterpret_cast<const CPPMContext*>(context);
+    key = {reinterpret_cast<uintptr_t>(ppmcontext->head), ppmcontext->order};
+    return true;
+}
+
 /////////////////////////////////////////////////////////////////////
 // Get the probability distribution at the context
 
@@ -62,18 +78,27 @@ void CPPMLanguageModel::GetProbs(Context context, std::vector<unsigned int>& pro
 //
 //        p = remaining_mass * (100 * count - beta) / (100 * total + alpha)
 //
-//      Symbols seen at shorter contexts are "excluded" from longer
-//      contexts (when doExclusion is enabled — currently disabled,
-//      see FIXME below). The remaining_mass shrinks at each level.
+//      The remaining_mass shrinks at each level.
 //
 //   3. LEFTOVER: Any probability mass still unspent after the vine
-//      traversal is distributed evenly among symbols that were never
-//      seen in any context.
+//      traversal is distributed evenly among all symbols.
 //
 //   4. ROUNDING CORRECTION: Integer arithmetic loses a few units to
-//      truncation. The final loop distributes the residual so that
+//      truncation. The final pass distributes the residual so that
 //      sum(probs) == norm exactly.
 //
+// Phases 1, 3 and 4 each hand out a sum in turn, every symbol getting
+// an equal share (rounded down) of what is left, which comes to the
+// same share for all but the last (sum % n) symbols, which get one
+// more. So they are computed in closed form, in one pass filling three
+// runs of symbols with constants (see SpreadEvenly); phase 2's
+// contributions, collected first to know what phase 3 has left to
+// spend, are then added to the few symbols that get them.
+//
+// (An exclusion mechanism, keeping symbols seen in longer contexts
+// from receiving mass again at shorter ones, was long disabled here
+// and has been dropped.)
+//
 // The result is a cumulative probability vector where:
 //   probs[0] == 0  (sentinel — required by AlphabetManager)
 //   sum(probs) == norm  (typically 65536 = 2^16)
@@ -92,47 +117,71 @@ void CAbstractPPM::collectChildCounts(const CPPMnode* node, std::vector<SymbolCo
     }
 }
 
+unsigned int CAbstractPPM::SliceLevel(const std::vector<SymbolCount>& childCounts, unsigned int iToSpend, int alpha,
+                                      int beta, std::vector<std::pair<symbol, unsigned int>>& slices) {
+    // Sum counts of children at this context level
+    int iTotal = 0;
+    for (const auto& sc : childCounts)
+        iTotal += sc.count;
+    if (!iTotal) return iToSpend;
+
+    // size_of_slice = all remaining mass. Each child gets a
+    // fraction proportional to its count, discounted by alpha
+    // (smoothing) and beta (count threshold). That depends only on
+    // the count, so (as most children of the shorter contexts have
+    // small counts) the fraction for each small count is kept once
+    // worked out, saving a 64-bit divide per child.
+    const unsigned int size_of_slice = iToSpend;
+    const myint iDivisor = 100 * iTotal + alpha;
+    constexpr unsigned short MEMO_COUNTS = 256;
+    thread_local unsigned int memo[MEMO_COUNTS], memoLevel[MEMO_COUNTS], iLevel = 0;
+    if (++iLevel == 0) {
+        std::fill(memoLevel, memoLevel + MEMO_COUNTS, 0);
+        iLevel = 1;
+    }
+    for (const auto& sc : childCounts) {
+        unsigned int p;
+        if (sc.count < MEMO_COUNTS && memoLevel[sc.count] == iLevel) {
+            p = memo[sc.count];
+        } else {
+            p = static_cast<myint>(size_of_slice) * (100 * sc.count - beta) / iDivisor;
+            if (sc.count < MEMO_COUNTS) {
+                memo[sc.count] = p;
+                memoLevel[sc.count] = iLevel;
+            }
+        }
+        slices.emplace_back(sc.sym, p);
+        iToSpend -= p;
+    }
+    return iToSpend;
+}
+
+void CAbstractPPM::SpreadEvenly(unsigned int* probs, int iNumSymbols, unsigned int iFirst, unsigned int iSecond) {
+    const int n = iNumSymbols - 1;
+    if (n <= 0) return;
+    // Symbols from iCutFirst on get one more of iFirst, from iCutSecond on one more of iSecond
+    int iCutFirst = iNumSymbols - static_cast<int>(iFirst % n);
+    int iCutSecond = iNumSymbols - static_cast<int>(iSecond % n);
+    if (iCutSecond < iCutFirst) std::swap(iCutFirst, iCutSecond);
+    const unsigned int iShare = iFirst / n + iSecond / n;
+    std::fill(probs + 1, probs + iCutFirst, iShare);
+    std::fill(probs + iCutFirst, probs + iCutSecond, iShare + 1);
+    std::fill(probs + iCutSecond, probs + iNumSymbols, iShare + 2);
+}
+
 void CAbstractPPM::mergePPMProbs(const CPPMContext* ppmcontext, std::vector<unsigned int>& probs, int iNumSymbols,
                                  int norm, int iUniform, int alpha, int beta) const {
     probs.resize(iNumSymbols);
 
-    // exclusions[sym] = true once sym has received probability from
-    // a context level. When doExclusion is enabled, excluded symbols
-    // are skipped at deeper context levels to avoid double-counting.
-    // (doExclusion is currently disabled — see FIXME below.)
-    std::vector<bool> exclusions(iNumSymbols);
+    // Scratch space, kept between calls (per thread, as a model may be asked for
+    // probabilities from more than one): the children of one context level, and
+    // the (symbol, mass) each child of every level receives in phase 2.
+    thread_local std::vector<SymbolCount> childCounts;
+    thread_local std::vector<std::pair<symbol, unsigned int>> slices;
+    slices.clear();
 
-    unsigned int iToSpend = norm; // remaining probability mass to distribute
-    unsigned int iUniformLeft = iUniform;
-
-    // Symbol 0 is the sentinel (root/end marker). It must carry zero
-    // probability so that cumulative-difference arithmetic in
-    // AlphabetManager::IterateChildGroups remains valid.
-    probs[0] = 0;
-    exclusions[0] = false;
-
-    // --- Step 1: Uniform backoff distribution ---
-    // Distribute iUniform units evenly across symbols 1..N-1.
-    // This ensures every symbol gets at least some baseline probability,
-    // even if it was never observed in any context.
-    for (int i = 1; i < iNumSymbols; i++) {
-        probs[i] = iUniformLeft / (iNumSymbols - i);
-        iUniformLeft -= probs[i];
-        iToSpend -= probs[i];
-        exclusions[i] = false;
-    }
-    DASHER_ASSERT(iUniformLeft == 0);
-
-    // FIXME: doExclusion is always 0. The exclusion mechanism was
-    // intended to prevent symbols seen at shorter contexts from
-    // receiving probability at longer contexts (a standard PPM
-    // technique). It's disabled because enabling it requires careful
-    // tuning to avoid degrading prediction quality. The infrastructure
-    // is preserved here so it can be enabled experimentally.
-    bool doExclusion = 0;
-
-    // Reusable buffer for child counts (avoids per-level allocation)
-    std::vector<SymbolCount> childCounts;
+    // --- Step 1: Uniform backoff distribution (see SpreadEvenly below) ---
+    unsigned int iToSpend = norm - iUniform; // remaining probability mass to distribute
 
     // --- Step 2: Vine-chain traversal ---
     // Walk from the deepest context node toward the root. At each
@@ -146,62 +195,18 @@ void CAbstractPPM::mergePPMProbs(const CPPMContext* ppmcontext, std::vector<unsi
     for (CPPMnode* pTemp = ppmcontext->head; pTemp; pTemp = pTemp->vine) {
         childCounts.clear();
         collectChildCounts(pTemp, childCounts);
-
-        // Sum counts of non-excluded children at this context level
-        int iTotal = 0;
-        for (const auto& sc : childCounts) {
-            if (!(exclusions[sc.sym] && doExclusion)) iTotal += sc.count;
-        }
-
-        if (iTotal) {
-            // size_of_slice = all remaining mass. Each child gets a
-            // fraction proportional to its count, discounted by alpha
-            // (smoothing) and beta (count threshold).
-            unsigned int size_of_slice = iToSpend;
-            for (const auto& sc : childCounts) {
-                if (!(exclusions[sc.sym] && doExclusion)) {
-                    exclusions[sc.sym] = 1;
-
-                    unsigned int p =
-                        static_cast<myint>(size_of_slice) * (100 * sc.count - beta) / (100 * iTotal + alpha);
-
-                    probs[sc.sym] += p;
-                    iToSpend -= p;
-                }
-            }
-        }
-    }
-
-    // --- Step 3: Leftover distribution ---
-    // Any mass not consumed by the vine traversal is distributed
-    // evenly among symbols that were never observed (not excluded).
-    unsigned int size_of_slice = iToSpend;
-    int symbolsleft = 0;
-
-    for (int i = 1; i < iNumSymbols; i++)
-        if (!(exclusions[i] && doExclusion)) symbolsleft++;
-
-    for (int i = 1; i < iNumSymbols; i++) {
-        if (!(exclusions[i] && doExclusion)) {
-            unsigned int p = size_of_slice / symbolsleft;
-            probs[i] += p;
-            iToSpend -= p;
-        }
+        iToSpend = SliceLevel(childCounts, iToSpend, alpha, beta, slices);
     }
 
-    // --- Step 4: Rounding correction ---
-    // Integer division loses a few units to truncation. Distribute
-    // the residual sequentially so that sum(probs) == norm exactly.
-    int iLeft = iNumSymbols - 1;
-
-    for (int i = 1; i < iNumSymbols; i++) {
-        unsigned int p = iToSpend / iLeft;
-        probs[i] += p;
-        --iLeft;
-        iToSpend -= p;
-    }
+    // --- Steps 1, 3 and 4: uniform backoff, leftover and rounding correction ---
+    // Symbol 0 is the sentinel (root/end marker). It must carry zero
+    // probability so that cumulative-difference arithmetic in
+    // AlphabetManager::IterateChildGroups remains valid.
+    probs[0] = 0;
+    SpreadEvenly(probs.data(), iNumSymbols, iUniform, iToSpend);
 
-    DASHER_ASSERT(iToSpend == 0);
+    for (const auto& [sym, p] : slices)
+        probs[sym] += p;
 }
 
 /////////////////////////////////////////////////////////////////////
@@ -249,6 +254,7 @@ void CAbstractPPM::LearnSymbol(Context c, int Symbol) {
 
     DASHER_ASSERT(Symbol >= 0 && Symbol < GetSize());
     CPPMContext& context = *reinterpret_cast<CPPMContext*>(c);
+    m_iGeneration++;
 
     CPPMnode* n = AddSymbolToNode(context.head, Symbol);
     DASHER_ASSERT(n == context.head->find_symbol(Symbol));
@@ -259,6 +265,110 @@ void CAbstractPPM::LearnSymbol(Context c, int Symbol) {
         context.head = context.head->vine;
         context.order--;
     }
+
+    if (m_iNodeBudget && GetNodeCount() > m_iNodeBudget) Prune();
+}
+
+/////////////////////////////////////////////////////////////////////
+// move context on by 'Symbol' as LearnSymbol does, but learning nothing
+
+void CAbstractPPM::PrimeSymbol(Context c, int Symbol) {
+
+    if (Symbol == 0) return;
+
+    DASHER_ASSERT(Symbol >= 0 && Symbol < GetSize());
+    CPPMContext& context = *reinterpret_cast<CPPMContext*>(c);
+    m_iGeneration++; // may add nodes, if not counts
+
+    context.head = PrimeSymbolToNode(context.head, Symbol);
+    context.order++;
+
+    while (context.order > m_iMaxOrder) {
+        context.head = context.head->vine;
+        context.order--;
+    }
+}
+
+/////////////////////////////////////////////////////////////////////
+// Pruning to the node budget
+//
+// Nodes seen fewer than some number of times are dropped - mostly deep
+// contexts, as those are the rarest - with the least number that brings the
+// trie down to its target, which is below the budget (see Prune) so it is
+// not pruned again straight away. Order 1 (the root's children) is always
+// kept. A node must go with its parent, and with its vine: a node for a
+// context implies nodes for every suffix of it, which EnterSymbol and
+// AddSymbolToNode rely on. Both are one symbol shorter, so visiting nodes
+// breadth first, each can be decided once its parent and vine have been.
+//
+// Which nodes are kept is tracked apart from the nodes themselves: a count
+// can't mark them, as nodes kept may have a count of 0 (those PrimeSymbol
+// made, or whose count has wrapped) and the counts are left unchanged.
+
+CAbstractPPM::NodeList CAbstractPPM::PruneNodes(size_t iTarget) {
+    NodeList vNodes;
+    vNodes.reserve(GetNodeCount());
+    for (ChildIterator it = m_pRoot->children(); it != m_pRoot->end(); it++)
+        vNodes.emplace_back(*it, m_pRoot);
+    for (size_t i = 0; i < vNodes.size(); i++) {
+        CPPMnode* pNode = vNodes[i].first;
+        for (ChildIterator it = pNode->children(); it != pNode->end(); it++)
+            vNodes.emplace_back(*it, pNode);
+    }
+
+    // Indices of each node's parent and vine in vNodes, or NONE for the root (always kept)
+    const size_t NONE = static_cast<size_t>(-1);
+    std::unordered_map<const CPPMnode*, size_t> mapIndex;
+    mapIndex.reserve(vNodes.size());
+    for (size_t i = 0; i < vNodes.size(); i++)
+        mapIndex[vNodes[i].first] = i;
+    auto indexOf = [&](const CPPMnode* pNode) { return pNode == m_pRoot ? NONE : mapIndex.at(pNode); };
+    std::vector<size_t> vParents(vNodes.size()), vVines(vNodes.size());
+    for (size_t i = 0; i < vNodes.size(); i++) {
+        vParents[i] = indexOf(vNodes[i].second);
+        vVines[i] = indexOf(vNodes[i].first->vine);
+    }
+    mapIndex.clear();
+
+    // Marks which nodes are kept with a minimum count of iMin; returns how many (inc. the root)
+    std::vector<bool> vKept(vNodes.size());
+    auto mark = [&](unsigned int iMin) {
+        size_t iKept = 1;
+        for (size_t i = 0; i < vNodes.size(); i++) {
+            vKept[i] = vParents[i] == NONE || (vNodes[i].first->count >= iMin && vKept[vParents[i]] &&
+                                               (vVines[i] == NONE || vKept[vVines[i]]));
+            if (vKept[i]) iKept++;
+        }
+        return iKept;
+    };
+
+    // Fewer are kept the greater the minimum: find the least that keeps few enough
+    unsigned int iLow = 1, iHigh = 0x10000;
+    while (iLow < iHigh) {
+        const unsigned int iMid = (iLow + iHigh) / 2;
+        if (mark(iMid) <= iTarget) iHigh = iMid;
+        else iLow = iMid + 1;
+    }
+    mark(iLow);
+
+    NodeList vKeep;
+    vKeep.reserve(vNodes.size());
+    for (size_t i = 0; i < vNodes.size(); i++)
+        if (vKept[i]) vKeep.push_back(vNodes[i]);
+    return vKeep;
+}
+
+void CAbstractPPM::RemapContexts(const std::unordered_map<const CPPMnode*, CPPMnode*>& mapNew) {
+    for (const CPPMContext* pContext : m_setContexts) {
+        CPPMContext& context = *const_cast<CPPMContext*>(pContext);
+        auto it = mapNew.find(context.head);
+        while (it == mapNew.end()) {
+            context.head = context.head->vine;
+            context.order--;
+            it = mapNew.find(context.head);
+        }
+        context.head = it->second;
+    }
 }
 
 void CAbstractPPM::dumpSymbol(symbol sym) {
@@ -495,9 +605,110 @@ CAbstractPPM::CPPMnode* CAbstractPPM::AddSymbolToNode(CPPMnode* pNode, symbol sy
     return pReturn;
 }
 
+// As AddSymbolToNode, but the node for sym gets no count of its own. With update exclusion, each
+//  node's count is the number of times it was learnt directly, plus the number of nodes whose vine
+//  points to it - so a new node's vine is still counted (as AddSymbolToNode does) for the new node.
+//  Without, every count is just the number of times the node was learnt, so nothing is counted.
+CAbstractPPM::CPPMnode* CAbstractPPM::PrimeSymbolToNode(CPPMnode* pNode, symbol sym) {
+
+    CPPMnode* pReturn = pNode->find_symbol(sym);
+    if (pReturn != NULL) return pReturn;
+
+    pReturn = makeNode(sym);
+    pReturn->count = 0;
+    pNode->AddChild(pReturn, GetSize());
+    if (pNode == m_pRoot)
+        pReturn->vine = m_pRoot;
+    else
+        pReturn->vine = bUpdateExclusion ? AddSymbolToNode(pNode->vine, sym) : PrimeSymbolToNode(pNode->vine, sym);
+
+    return pReturn;
+}
+
 CPPMLanguageModel::CPPMLanguageModel(CSettingsStore* pSettingsStore, int iNumSyms)
     : CAbstractPPM(pSettingsStore, iNumSyms, new CPPMnode(-1)), NodesAllocated(0), m_NodeAlloc(8192) {}
 
+CPPMLanguageModel::CPPMLanguageModel(CSettingsStore* pSettingsStore, int iNumSyms, int iMaxOrder,
+                                     bool bExclusion)
+    : CAbstractPPM(pSettingsStore, iNumSyms, new CPPMnode(-1), iMaxOrder, bExclusion ? 1 : 0, 0),
+      NodesAllocated(0), m_NodeAlloc(8192) {}
+
+CPPMLanguageModel* CPPMLanguageModel::CreateShard() const {
+    return new CPPMLanguageModel(m_pSettingsStore, m_iNumSyms, m_iMaxOrder, bUpdateExclusion);
+}
+
+/////////////////////////////////////////////////////////////////////
+// Merging shards
+//
+// Without update exclusion, learning a symbol adds one to the count of the
+// node for every suffix of the new context (found or created), so counts
+// just add up - except the root's, which is incremented only when the
+// order-1 node for the symbol already existed: it is 1 + (symbols learnt)
+// - (order-1 nodes), and the symbols learnt are the sum of the order-1
+// counts.
+//
+// With update exclusion, a node's count is the number of times it was the
+// new context itself, plus the number of nodes whose vine points to it
+// (each of which counted it once, when created). The first part adds up;
+// the second is recounted for the merged trie. The root is never counted.
+//
+// Both hold for a shard's primed nodes (see PrimeSymbolToNode), whose text
+// the model merged into has already learnt.
+
+void CPPMLanguageModel::MergeShard(const CPPMLanguageModel& shard) {
+    DASHER_ASSERT(shard.GetSize() == GetSize() && shard.m_iMaxOrder == m_iMaxOrder &&
+                  shard.bUpdateExclusion == bUpdateExclusion);
+
+    // (shard node, node here for the same context), breadth first: every vine, being one
+    //  symbol shorter, is merged before the nodes that point to it.
+    std::vector<std::pair<const CPPMnode*, CPPMnode*>> vQueue;
+    vQueue.reserve(shard.NodesAllocated + 1);
+    vQueue.emplace_back(shard.m_pRoot, m_pRoot);
+    m_iGeneration++;
+    unsigned short int iLearnt = 0, iNewOrder1 = 0;
+    for (size_t i = 0; i < vQueue.size(); i++) {
+        const CPPMnode* pFrom = vQueue[i].first;
+        CPPMnode* pTo = vQueue[i].second;
+        for (ChildIterator it = pFrom->children(); it != pFrom->end(); it++) {
+            const CPPMnode* pChild = *it;
+            CPPMnode* pNode = pTo->find_symbol(pChild->sym);
+            if (pNode == NULL) {
+                pNode = makeNode(pChild->sym);
+                pNode->count = 0;
+                pTo->AddChild(pNode, GetSize());
+                pNode->vine = (pTo == m_pRoot) ? m_pRoot : pTo->vine->find_symbol(pChild->sym);
+                DASHER_ASSERT(pNode->vine);
+                if (pTo == m_pRoot) iNewOrder1++;
+            } else if (bUpdateExclusion && pTo != m_pRoot) {
+                // pChild counted its vine, but pNode has been counted by its vine already. That
+                //  vine's count here includes both (even after pruning, which never lowers a
+                //  count), so one comes off - wrapping, as the sum it is taken from may have.
+                pNode->vine->count--;
+            }
+            pNode->count += pChild->count;
+            if (pTo == m_pRoot) iLearnt += pChild->count;
+            vQueue.emplace_back(pChild, pNode);
+        }
+    }
+    if (!bUpdateExclusion) m_pRoot->count += static_cast<unsigned short int>(iLearnt - iNewOrder1);
+
+    if (m_iNodeBudget && GetNodeCount() > m_iNodeBudget) Prune();
+}
+
+size_t CPPMLanguageModel::GetMemoryUsage() const {
+    size_t iBytes = GetNodeCount() * sizeof(CPPMnode);
+    std::vector<const CPPMnode*> vStack(1, m_pRoot);
+    while (!vStack.empty()) {
+        const CPPMnode* pNode = vStack.back();
+        vStack.pop_back();
+        if (pNode->m_iNumChildSlots < 0 || pNode->m_iNumChildSlots > 1)
+            iBytes += std::abs(pNode->m_iNumChildSlots) * sizeof(CPPMnode*) + 16;
+        for (ChildIterator it = pNode->children(); it != pNode->end(); it++)
+            vStack.push_back(*it);
+    }
+    return iBytes;
+}
+
 CAbstractPPM::CPPMnode* CPPMLanguageModel::makeNode(int sym) {
     CPPMnode* res = m_NodeAlloc.Alloc();
     res->sym = sym;
@@ -580,6 +791,7 @@ int CPPMLanguageModel::GetIndex(CPPMnode* pAddr, std::map<CPPMnode*, int>* pmapI
 bool CPPMLanguageModel::ReadFromFile(std::string strFilename) {
 
     std::ifstream oInputFile(strFilename.c_str());
+    m_iGeneration++;
     // map from file index, to address of node object with that index
     std::map<int, CPPMnode*> oMap;
     // map from file index, to address of *parent* for that node
@@ -637,3 +849,187 @@ CPPMLanguageModel::CPPMnode* CPPMLanguageModel::GetAddress(int iIndex, std::map<
         return it->second;
     }
 }
+
+/////////////////////////////////////////////////////////////////////
+// Binary snapshot
+//
+// A SnapshotHeader, the alphabet ID (UTF-8, not terminated), then one
+// SnapshotRecord per node. Records are in breadth-first order from the
+// root (record 0), so the children of each node form a contiguous run
+// directly after those of the preceding node, and every vine - which
+// always points one level shallower - refers to an earlier record. Vines
+// are stored as index+1, with 0 meaning NULL (only the root has no vine).
+// Fields are native-endian; iByteOrder makes a file written on a machine
+// of the other endianness fail validation rather than load garbage.
+
+namespace {
+const char SNAPSHOT_MAGIC[8] = {'%', 'D', 'P', 'P', 'M', 'S', 'N', 'P'};
+const uint32_t SNAPSHOT_VERSION = 1;
+const uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+
+struct SnapshotHeader {
+    char szMagic[8];
+    uint32_t iVersion;
+    uint32_t iByteOrder;
+    uint32_t iNumSyms;
+    int32_t iMaxOrder;
+    uint32_t iUpdateExclusion;
+    uint32_t iAlphabetIDLength;
+    uint64_t iTrainingHash;
+    uint64_t iNumNodes;
+};
+
+struct SnapshotRecord {
+    uint32_t iVine;
+    uint32_t iNumChildren;
+    uint16_t iSymbol;
+    uint16_t iCount;
+};
+static_assert(sizeof(SnapshotRecord) == 12, "snapshot records must be packed");
+
+// The training hash as stored: a node budget prunes the trie learnt from the same text differently
+uint64_t StoredHash(const CPPMLanguageModel::SnapshotKey& key, size_t iNodeBudget) {
+    return key.iTrainingHash ^ (static_cast<uint64_t>(iNodeBudget) * 0x9E3779B97F4A7C15ull);
+}
+} // namespace
+
+bool CPPMLanguageModel::WriteSnapshot(const std::string& strFilename, const SnapshotKey& key) const {
+    if (GetSize() > 0xFFFF) return false; // symbols are stored in 16 bits
+
+    std::vector<const CPPMnode*> vOrder;
+    std::vector<SnapshotRecord> vRecords;
+    std::unordered_map<const CPPMnode*, uint32_t> mapIdx;
+    vOrder.reserve(NodesAllocated + 1);
+    vRecords.reserve(NodesAllocated + 1);
+    mapIdx.reserve(NodesAllocated + 1);
+
+    vOrder.push_back(m_pRoot);
+    mapIdx.emplace(m_pRoot, 0);
+    for (size_t i = 0; i < vOrder.size(); i++) {
+        const CPPMnode* pNode = vOrder[i];
+        SnapshotRecord sRec;
+        sRec.iVine = 0;
+        if (pNode->vine) {
+            auto it = mapIdx.find(pNode->vine);
+            if (it == mapIdx.end()) return false; // vine not one level shallower: not a PPM trie we can flatten
+            sRec.iVine = it->second + 1;
+        }
+        sRec.iSymbol = static_cast<uint16_t>(i == 0 ? 0 : pNode->sym);
+        sRec.iCount = pNode->count;
+        sRec.iNumChildren = 0;
+        for (ChildIterator it = pNode->children(); it != pNode->end(); it++) {
+            mapIdx.emplace(*it, static_cast<uint32_t>(vOrder.size()));
+            vOrder.push_back(*it);
+            sRec.iNumChildren++;
+        }
+        vRecords.push_back(sRec);
+    }
+
+    SnapshotHeader sHeader;
+    memcpy(sHeader.szMagic, SNAPSHOT_MAGIC, sizeof(sHeader.szMagic));
+    sHeader.iVersion = SNAPSHOT_VERSION;
+    sHeader.iByteOrder = SNAPSHOT_BYTE_ORDER;
+    sHeader.iNumSyms = GetSize();
+    sHeader.iMaxOrder = m_iMaxOrder;
+    sHeader.iUpdateExclusion = bUpdateExclusion ? 1 : 0;
+    sHeader.iAlphabetIDLength = static_cast<uint32_t>(key.strAlphabetID.size());
+    sHeader.iTrainingHash = StoredHash(key, m_iNodeBudget);
+    sHeader.iNumNodes = vRecords.size();
+
+    // Written alongside and renamed into place, so a crash or full disk mid-write leaves the old snapshot whole
+    const std::string strTemp = UniqueTempName(strFilename);
+    {
+        std::ofstream oOutputFile(strTemp.c_str(), std::ios::binary | std::ios::trunc);
+        if (!oOutputFile) return false;
+        oOutputFile.write(reinterpret_cast<const char*>(&sHeader), sizeof(sHeader));
+        oOutputFile.write(key.strAlphabetID.data(), key.strAlphabetID.size());
+        oOutputFile.write(reinterpret_cast<const char*>(vRecords.data()), vRecords.size() * sizeof(SnapshotRecord));
+        oOutputFile.close();
+        if (!oOutputFile) {
+            std::remove(strTemp.c_str());
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(strTemp, strFilename, ec);
+    if (ec) {
+        std::remove(strTemp.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool CPPMLanguageModel::ReadSnapshot(const std::string& strFilename, const SnapshotKey& key) {
+    if (m_pRoot->m_iNumChildSlots != 0) return false; // only an untrained model can be replaced
+
+    std::error_code ec;
+    const uintmax_t iFileSize = std::filesystem::file_size(strFilename, ec);
+    if (ec || iFileSize < sizeof(SnapshotHeader)) return false;
+
+    std::ifstream oInputFile(strFilename.c_str(), std::ios::binary);
+    SnapshotHeader sHeader;
+    if (!oInputFile.read(reinterpret_cast<char*>(&sHeader), sizeof(sHeader))) return false;
+    if (memcmp(sHeader.szMagic, SNAPSHOT_MAGIC, sizeof(sHeader.szMagic)) != 0 || sHeader.iVersion != SNAPSHOT_VERSION ||
+        sHeader.iByteOrder != SNAPSHOT_BYTE_ORDER)
+        return false;
+    if (sHeader.iNumSyms != static_cast<uint32_t>(GetSize()) || sHeader.iMaxOrder != m_iMaxOrder ||
+        sHeader.iUpdateExclusion != (bUpdateExclusion ? 1u : 0u) ||
+        sHeader.iTrainingHash != StoredHash(key, m_iNodeBudget) ||
+        sHeader.iAlphabetIDLength != key.strAlphabetID.size())
+        return false;
+    if (sHeader.iNumNodes == 0 ||
+        iFileSize != sizeof(SnapshotHeader) + sHeader.iAlphabetIDLength + sHeader.iNumNodes * sizeof(SnapshotRecord))
+        return false;
+
+    std::string strAlphabetID(sHeader.iAlphabetIDLength, '\0');
+    if (!oInputFile.read(&strAlphabetID[0], strAlphabetID.size()) || strAlphabetID != key.strAlphabetID) return false;
+
+    const size_t iNumNodes = static_cast<size_t>(sHeader.iNumNodes);
+    std::vector<SnapshotRecord> vRecords(iNumNodes);
+    if (!oInputFile.read(reinterpret_cast<char*>(vRecords.data()), iNumNodes * sizeof(SnapshotRecord))) return false;
+
+    // Validate everything before touching the trie, so a corrupt file leaves the model as it was.
+    // Walks the same parent cursor as the build loop below, checking each node's parent and vine
+    // precede it, vines carry the same symbol, and no parent has two children with one symbol.
+    if (vRecords[0].iVine != 0) return false;
+    std::vector<uint32_t> vLastParent(GetSize(), UINT32_MAX);
+    size_t iParent = 0;
+    uint32_t iRemaining = vRecords[0].iNumChildren;
+    for (size_t i = 1; i < iNumNodes; i++) {
+        const SnapshotRecord& sRec = vRecords[i];
+        while (iRemaining == 0) {
+            if (++iParent >= i) return false;
+            iRemaining = vRecords[iParent].iNumChildren;
+        }
+        --iRemaining;
+        if (sRec.iSymbol == 0 || sRec.iSymbol >= GetSize()) return false;
+        if (sRec.iVine == 0 || sRec.iVine > i) return false;
+        if (sRec.iVine != 1 && vRecords[sRec.iVine - 1].iSymbol != sRec.iSymbol) return false;
+        if (vLastParent[sRec.iSymbol] == iParent) return false;
+        vLastParent[sRec.iSymbol] = static_cast<uint32_t>(iParent);
+    }
+    if (iRemaining != 0) return false;
+    for (size_t i = iParent + 1; i < iNumNodes; i++)
+        if (vRecords[i].iNumChildren) return false;
+
+    std::vector<CPPMnode*> vNodes(iNumNodes);
+    vNodes[0] = m_pRoot;
+    m_iGeneration++;
+    m_pRoot->count = vRecords[0].iCount;
+    iParent = 0;
+    iRemaining = vRecords[0].iNumChildren;
+    for (size_t i = 1; i < iNumNodes; i++) {
+        const SnapshotRecord& sRec = vRecords[i];
+        while (iRemaining == 0)
+            iRemaining = vRecords[++iParent].iNumChildren;
+        --iRemaining;
+        CPPMnode* pNode = m_NodeAlloc.Alloc();
+        pNode->sym = sRec.iSymbol;
+        pNode->count = sRec.iCount;
+        pNode->vine = vNodes[sRec.iVine - 1];
+        vNodes[iParent]->AddChild(pNode, GetSize());
+        vNodes[i] = pNode;
+    }
+    NodesAllocated += static_cast<int>(iNumNodes - 1);
+    return true;
+}
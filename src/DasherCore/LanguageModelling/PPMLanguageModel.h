@@ -15,10 +15,14 @@
 #include "LanguageModel.h"
 #include "DasherCore/SettingsStore.h"
 #include "stdlib.h"
+#include <cstdint>
+#include <string>
 #include <vector>
 #include <fstream>
 #include <set>
 #include <map>
+#include <unordered_map>
+#include <utility>
 
 namespace Dasher {
 
@@ -32,7 +36,8 @@ namespace Dasher {
 /// to LP_LM_UPDATE_EXCLUSION
 ///
 /// Subclasses must implement CLanguageModel::GetProbs and a makeNode() method (perhaps
-/// using a pooled allocator).
+/// using a pooled allocator); also GetNodeCount(), and Prune() to keep the trie within
+/// LP_LM_NODE_BUDGET (which PruneNodes and CompactNodes do most of).
 ///
 class CAbstractPPM : public CLanguageModel, private NoClones {
   protected:
@@ -50,11 +55,14 @@ class CAbstractPPM : public CLanguageModel, private NoClones {
         ///  (d) >MAX_RUN ->  m_ppChildren is an inline hash (overflow to next elem) with that many slots
         int m_iNumChildSlots;
         friend class CPPMLanguageModel;
+        friend class CAbstractPPM;
 
       public:
         ChildIterator children() const;
         const ChildIterator end() const;
         void AddChild(CPPMnode* pNewChild, int numSymbols);
+        /// Removes all children (the nodes themselves are not deleted)
+        void ClearChildren();
         CPPMnode* find_symbol(symbol sym) const;
         CPPMnode* vine;
         unsigned short int count;
@@ -115,7 +123,40 @@ class CAbstractPPM : public CLanguageModel, private NoClones {
     ///  is required by the subclass, for the specified symbol. (Initial count will be 1.)
     virtual CPPMnode* makeNode(int sym) = 0;
     /// \param iMaxOrder max order of model; anything <0 means to use LP_LM_MAX_ORDER.
-    CAbstractPPM(CSettingsStore* pSettingsStore, int iNumSyms, CPPMnode* pRoot, int iMaxOrder = -1);
+    /// \param iUpdateExclusion likewise, whether to use update exclusion; <0 means use LP_LM_UPDATE_EXCLUSION.
+    /// \param iNodeBudget likewise, most nodes before pruning (0 = unlimited); <0 means use LP_LM_NODE_BUDGET.
+    CAbstractPPM(CSettingsStore* pSettingsStore, int iNumSyms, CPPMnode* pRoot, int iMaxOrder = -1,
+                 int iUpdateExclusion = -1, long iNodeBudget = -1);
+
+    /// Called by LearnSymbol once the trie has grown beyond m_iNodeBudget nodes. Should cut
+    ///  it back with PruneNodes, then rebuild what is left in new storage with CompactNodes
+    ///  (so that memory is returned, as the pooled allocators never free single nodes);
+    ///  PruneAlloc does all of that for a subclass whose nodes come from one allocator.
+    virtual void Prune() = 0;
+
+    /// The nodes (other than the root) that remain, each with its parent, breadth first.
+    typedef std::vector<std::pair<CPPMnode*, CPPMnode*>> NodeList;
+
+    /// Cuts the trie back to at most iTarget nodes (inc. the root), or as near as keeping
+    ///  all of order 1 allows, by dropping every node seen fewer than the least number
+    ///  of times that does so - along with the nodes below it and those whose vine it
+    ///  is, which would otherwise refer to it. Counts of the nodes kept are unchanged.
+    ///  Dropped nodes are not yet freed (nor unlinked): returns those kept, for CompactNodes.
+    NodeList PruneNodes(size_t iTarget);
+
+    /// Rebuilds the trie from vKeep (as returned by PruneNodes) as copies of those nodes in
+    ///  a new allocator, which then replaces alloc; so all the old nodes, and their child
+    ///  arrays, are freed. Live contexts are moved to the copies, those at a dropped node
+    ///  to the longest suffix of it that remains. Node must be the type alloc allocates,
+    ///  and of every node but the root.
+    template <typename Node>
+    void CompactNodes(const NodeList& vKeep, CSimplePooledAlloc<Node>& alloc);
+
+    /// All of Prune, for a subclass whose nodes all come from alloc and which counts them
+    ///  (not inc. the root) in iNodesAllocated: cuts the trie down to 3/4 of the budget, so
+    ///  that learning can go on for a while before the next, and compacts what is left.
+    template <typename Node>
+    void PruneAlloc(CSimplePooledAlloc<Node>& alloc, int& iNodesAllocated);
 
     void dumpSymbol(symbol sym);
     void dumpString(char* str, int pos, int len);
@@ -128,6 +169,7 @@ class CAbstractPPM : public CLanguageModel, private NoClones {
     /// Cache parameters that don't make sense to adjust during the life of a language model...
     const int m_iMaxOrder;
     const bool bUpdateExclusion;
+    const size_t m_iNodeBudget;
 
   public:
     virtual bool eq(CAbstractPPM* other);
@@ -140,10 +182,21 @@ class CAbstractPPM : public CLanguageModel, private NoClones {
     virtual void EnterSymbol(Context context, int Symbol);
     virtual void LearnSymbol(Context context, int Symbol);
 
-    void dump();
-    bool isValidContext(const Context c) const;
+    /// Moves context on by Symbol exactly as LearnSymbol would, creating whatever nodes that
+    ///  needs, but without counting anything: new nodes start with a count of 0, and their
+    ///  creation affects other counts only as far as LearnSymbol's would when they are later
+    ///  learnt. Used to start a model trained on part of a text (see CPPMLanguageModel::MergeShard)
+    ///  in the context where the preceding text leaves off.
+    void PrimeSymbol(Context context, int Symbol);
+
+    int GetMaxOrder() const { return m_iMaxOrder; }
+
+    /// The context's head node, and order
+    bool GetContextKey(Context context, ContextKey& key) const override;
+
+    /// Number of nodes in the trie, including the root
+    virtual size_t GetNodeCount() const = 0;
 
-  protected:
     /// A (symbol, count) pair representing one child of a PPM trie node.
     /// Used by collectChildCounts() to abstract away the different child
     /// storage mechanisms (inline hash vs pychild map).
@@ -152,6 +205,22 @@ class CAbstractPPM : public CLanguageModel, private NoClones {
         unsigned short count;
     };
 
+    /// Phase 2 of mergePPMProbs for one context level, whose children are childCounts: appends
+    ///  the (symbol, mass) each receives to slices, and returns what is left of iToSpend.
+    ///  (Also used by CMappedPPMLanguageModel.)
+    static unsigned int SliceLevel(const std::vector<SymbolCount>& childCounts, unsigned int iToSpend, int alpha,
+                                   int beta, std::vector<std::pair<symbol, unsigned int>>& slices);
+
+    /// Phases 1, 3 and 4 of mergePPMProbs in closed form: sets probs[1..iNumSymbols-1] to what
+    ///  handing out iFirst, then iSecond, to those symbols in turn - each getting an equal share,
+    ///  rounded down, of what is left - would give them. (Also used by CMappedPPMLanguageModel.)
+    static void SpreadEvenly(unsigned int* probs, int iNumSymbols, unsigned int iFirst, unsigned int iSecond);
+
+    void dump();
+    bool isValidContext(const Context c) const;
+
+  protected:
+
     /// Collect children of a PPM node as (symbol, count) pairs.
     ///
     /// Base implementation iterates the CPPMnode inline hash table
@@ -191,6 +260,9 @@ class CAbstractPPM : public CLanguageModel, private NoClones {
 
   private:
     CPPMnode* AddSymbolToNode(CPPMnode* pNode, symbol sym);
+    CPPMnode* PrimeSymbolToNode(CPPMnode* pNode, symbol sym);
+    /// Moves every live context onto the copy of its node in mapNew (see CompactNodes)
+    void RemapContexts(const std::unordered_map<const CPPMnode*, CPPMnode*>& mapNew);
 
     CPooledAlloc<CPPMContext> m_ContextAlloc;
 
@@ -205,14 +277,63 @@ class CPPMLanguageModel : public CAbstractPPM {
     CPPMLanguageModel(CSettingsStore* pSettingsStore, int iNumSyms);
     virtual void GetProbs(Context context, std::vector<unsigned int>& Probs, int norm, int iUniform) const;
 
+    /// Identifies the training run a snapshot was taken from. Together with the
+    ///  alphabet size, max order, update-exclusion setting and node budget of the
+    ///  model itself, this must match exactly for ReadSnapshot to accept a file.
+    struct SnapshotKey {
+        std::string strAlphabetID;
+        /// Fingerprint of the system training files learnt (by name, size and modification
+        ///  time - not the user's own text, which is learnt on top of a snapshot once loaded)
+        uint64_t iTrainingHash;
+        /// As iTrainingHash, to accept an image trained on any text (one shipped with the alphabet)
+        static constexpr uint64_t ANY_TRAINING = 0;
+    };
+
+    /// Writes the trie as a versioned binary snapshot: a fixed header, then one
+    ///  fixed-size record per node in breadth-first order, with vines stored as
+    ///  node indices. The file is written alongside and renamed into place, so
+    ///  an old snapshot is never left half-overwritten. Returns false if the
+    ///  file could not be written.
+    bool WriteSnapshot(const std::string& strFilename, const SnapshotKey& key) const;
+
+    /// Replaces the (untrained) trie with one read from a snapshot written by
+    ///  WriteSnapshot. Breadth-first order guarantees every vine and parent
+    ///  precedes its node, so the trie is rebuilt in a single pass without
+    ///  fixups. Returns false, leaving the model untouched, if the file is
+    ///  missing, corrupt, from another format version or does not match key;
+    ///  also if the model has already learnt anything.
+    bool ReadSnapshot(const std::string& strFilename, const SnapshotKey& key);
+
+    /// Makes an empty model with the same alphabet size, max order and update exclusion
+    ///  as this one, to learn a shard of text that will be merged back with MergeShard.
+    CPPMLanguageModel* CreateShard() const;
+
+    /// Adds everything shard has learnt into this model. shard must come from CreateShard,
+    ///  and have learnt text directly following everything this model has learnt, starting
+    ///  from the context where that left off (see PrimeSymbol); the result is then exactly
+    ///  the model this one would have become by learning shard's text itself. Counts are
+    ///  16-bit, and wrap on overflow as LearnSymbol's do, so that holds for them too.
+    ///  Merging several shards must be done in the order of their text.
+    void MergeShard(const CPPMLanguageModel& shard);
+
+    size_t GetNodeCount() const override { return NodesAllocated + 1; }
+
+    /// Bytes allocated for the trie: every node, and every child array (each a separate
+    ///  new[], so also counting the 16 bytes a typical malloc adds to each).
+    size_t GetMemoryUsage() const;
+
   protected:
     /// Makes a standard CPPMnode, but using a pooled allocator (m_NodeAlloc) - faster!
     virtual CPPMnode* makeNode(int sym);
+    void Prune() override { PruneAlloc(m_NodeAlloc, NodesAllocated); }
 
     virtual bool WriteToFile(std::string strFilename);
     virtual bool ReadFromFile(std::string strFilename);
 
   private:
+    /// For shards: as given, and with no node budget (which MergeShard applies instead)
+    CPPMLanguageModel(CSettingsStore* pSettingsStore, int iNumSyms, int iMaxOrder, bool bExclusion);
+
     int NodesAllocated;
 
     bool RecursiveWrite(CPPMnode* pNode, CPPMnode* pNextSibling, std::map<CPPMnode*, int>* pmapIdx, int* pNextIdx,
@@ -255,6 +376,40 @@ inline CAbstractPPM::CPPMnode::~CPPMnode() {
     if (m_iNumChildSlots != 1) delete[] m_ppChildren;
 }
 
+inline void CAbstractPPM::CPPMnode::ClearChildren() {
+    if (m_iNumChildSlots != 1) delete[] m_ppChildren;
+    m_iNumChildSlots = 0;
+    m_ppChildren = NULL;
+}
+
+template <typename Node>
+void CAbstractPPM::CompactNodes(const NodeList& vKeep, CSimplePooledAlloc<Node>& alloc) {
+    CSimplePooledAlloc<Node> newAlloc(alloc.GetBlockSize());
+    std::unordered_map<const CPPMnode*, CPPMnode*> mapNew;
+    mapNew.reserve(vKeep.size() + 1);
+    mapNew.emplace(m_pRoot, m_pRoot);
+    m_pRoot->ClearChildren();
+    // Breadth first, so each node's parent and vine have been copied already
+    for (const auto& [pOld, pParent] : vKeep) {
+        Node* pNew = newAlloc.Alloc();
+        *pNew = *static_cast<const Node*>(pOld); // inc. anything a subclass of CPPMnode adds
+        pNew->m_iNumChildSlots = 0;               // the children are the old node's
+        pNew->m_ppChildren = NULL;
+        pNew->vine = mapNew.at(pOld->vine);
+        mapNew.at(pParent)->AddChild(pNew, GetSize());
+        mapNew.emplace(pOld, pNew);
+    }
+    RemapContexts(mapNew);
+    alloc.swap(newAlloc); // and the old nodes are deleted with newAlloc
+}
+
+template <typename Node>
+void CAbstractPPM::PruneAlloc(CSimplePooledAlloc<Node>& alloc, int& iNodesAllocated) {
+    const NodeList vKeep = PruneNodes(m_iNodeBudget / 4 * 3);
+    CompactNodes(vKeep, alloc);
+    iNodesAllocated = static_cast<int>(vKeep.size());
+}
+
 inline CLanguageModel::Context CAbstractPPM::CreateEmptyContext() {
     CPPMContext* pCont = m_ContextAlloc.Alloc();
     *pCont = *m_pRootContext;
@@ -289,6 +289,7 @@ void CPPMPYLanguageModel::LearnPYSymbol(Context c, int pysym) {
 
     DASHER_ASSERT(pysym > 0 && pysym <= m_iNumPYsyms);
     CPPMPYLanguageModel::CPPMContext& context = *reinterpret_cast<CPPMContext*>(c);
+    m_iGeneration++;
 
     /*   CPPMPYnode * pNode = m_pRoot->child;
 
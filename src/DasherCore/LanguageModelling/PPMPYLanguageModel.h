@@ -64,6 +64,8 @@ class CPPMPYLanguageModel : public CAbstractPPM {
     virtual bool WriteToFile(std::string strFilename);
     virtual bool ReadFromFile(std::string strFilename);
 
+    size_t GetNodeCount() const override { return NodesAllocated + 1; }
+
   protected:
     class CPPMPYnode : public CPPMnode {
       public:
@@ -73,6 +75,7 @@ class CPPMPYLanguageModel : public CAbstractPPM {
         inline CPPMPYnode() : CPPMnode() {}
     };
     CPPMPYnode* makeNode(int sym);
+    void Prune() override { PruneAlloc(m_NodeAlloc, NodesAllocated); }
 
     /// Override to iterate the pychild map instead of CPPMnode children.
     void collectChildCounts(const CPPMnode* node, std::vector<SymbolCount>& out) const override;
@@ -0,0 +1,57 @@
+// ProbCache.cpp
+//
+// LRU cache of the probabilities computed for language model contexts.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ProbCache.h"
+
+#include "DasherCore/Common/myassert.h"
+
+#include <functional>
+#include <iterator>
+
+using namespace Dasher;
+
+size_t CProbCache::KeyHash::operator()(const Key& key) const {
+    // boost::hash_combine, over each field
+    size_t h = 0;
+    auto combine = [&h](uint64_t v) { h ^= std::hash<uint64_t>()(v) + 0x9e3779b9 + (h << 6) + (h >> 2); };
+    combine(key.context.iNode);
+    combine(static_cast<uint64_t>(key.context.iOrder));
+    combine(key.iGeneration);
+    combine(key.iNorm);
+    combine(key.iUniform);
+    return h;
+}
+
+const std::vector<unsigned int>* CProbCache::Find(const Key& key) {
+    auto it = m_mIndex.find(key);
+    if (it == m_mIndex.end()) {
+        m_iMisses++;
+        return NULL;
+    }
+    m_iHits++;
+    m_lEntries.splice(m_lEntries.begin(), m_lEntries, it->second);
+    return &it->second->second;
+}
+
+void CProbCache::Insert(const Key& key, const std::vector<unsigned int>& vProbs) {
+    DASHER_ASSERT(m_mIndex.find(key) == m_mIndex.end());
+    if (m_iCapacity == 0) return;
+    if (m_lEntries.size() == m_iCapacity) {
+        // Reuse the least recently used entry (and its vector's storage)
+        m_mIndex.erase(m_lEntries.back().first);
+        m_lEntries.splice(m_lEntries.begin(), m_lEntries, std::prev(m_lEntries.end()));
+        m_lEntries.front().first = key;
+        m_lEntries.front().second.assign(vProbs.begin(), vProbs.end());
+    } else {
+        m_lEntries.emplace_front(key, vProbs);
+    }
+    m_mIndex.emplace(key, m_lEntries.begin());
+}
+
+void CProbCache::Clear() {
+    m_lEntries.clear();
+    m_mIndex.clear();
+}
@@ -0,0 +1,81 @@
+// ProbCache.h
+//
+// LRU cache of the probabilities computed for language model contexts.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "LanguageModel.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Dasher {
+
+///
+/// \ingroup LM
+/// @{
+///
+/// Keeps the (cumulative) probabilities last computed for up to a fixed number
+/// of contexts, keyed by everything they depend on: the context's key in the
+/// model (see CLanguageModel::GetContextKey), the model's generation, and the
+/// normalisation asked for. So nodes re-created for a context seen recently -
+/// as when zooming back out and in again - need not ask the model again; and
+/// once the model learns anything, its generation moves on and every entry
+/// from before is a miss, aging out as new ones are added.
+///
+/// Anything else the probabilities depend on (such as LP_LM_ALPHA) is not in
+/// the key: the owner must Clear the cache when that changes.
+///
+class CProbCache {
+  public:
+    struct Key {
+        CLanguageModel::ContextKey context;
+        uint64_t iGeneration;
+        unsigned long iNorm;
+        unsigned int iUniform;
+        bool operator==(const Key& other) const {
+            return context == other.context && iGeneration == other.iGeneration && iNorm == other.iNorm &&
+                   iUniform == other.iUniform;
+        }
+    };
+
+    explicit CProbCache(size_t iCapacity) : m_iCapacity(iCapacity) {}
+
+    /// The probabilities stored for key, which become the most recently used;
+    ///  or NULL if there are none. Counts a hit or a miss.
+    const std::vector<unsigned int>* Find(const Key& key);
+
+    /// Stores probabilities for key (not already stored), evicting the least
+    ///  recently used entry if full.
+    void Insert(const Key& key, const std::vector<unsigned int>& vProbs);
+
+    /// Forgets every entry (but not the hit and miss counts)
+    void Clear();
+
+    size_t GetSize() const { return m_lEntries.size(); }
+    uint64_t GetHits() const { return m_iHits; }
+    uint64_t GetMisses() const { return m_iMisses; }
+
+  private:
+    struct KeyHash {
+        size_t operator()(const Key& key) const;
+    };
+    typedef std::list<std::pair<Key, std::vector<unsigned int>>> EntryList;
+
+    const size_t m_iCapacity;
+    /// Most recently used first
+    EntryList m_lEntries;
+    std::unordered_map<Key, EntryList::iterator, KeyHash> m_mIndex;
+    uint64_t m_iHits = 0;
+    uint64_t m_iMisses = 0;
+};
+
+/// @}
+
+} // namespace Dasher
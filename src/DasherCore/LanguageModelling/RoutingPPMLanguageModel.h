@@ -64,6 +64,8 @@ class CRoutingPPMLanguageModel : public CAbstractPPM {
     virtual bool WriteToFile(std::string strFilename);
     virtual bool ReadFromFile(std::string strFilename);
 
+    size_t GetNodeCount() const override { return NodesAllocated + 1; }
+
   protected:
     /// Subclass to additionally store counts of route by which this context (i.e.
     ///  the last base symbol within) was entered, when we know that.
@@ -78,6 +80,7 @@ class CRoutingPPMLanguageModel : public CAbstractPPM {
     /// Always returns a CRoutingPPMnode. TODO, work through class and use standard
     ///  map-less PPMnodes for unambiguous base syms (which have only one route) ?
     CRoutingPPMnode* makeNode(int sym);
+    void Prune() override { PruneAlloc(m_NodeAlloc, NodesAllocated); }
 
   private:
     int NodesAllocated;
@@ -58,10 +58,12 @@ void CMandarinAlphMgr::InitMap() {
     for (const char i : additonalChars) {
         // add a PY mapping to a single CH-character (already rehashed), i.e. the space/para
         int hashed = m_map.GetSingleChar(i);
-        DASHER_ASSERT(hashed);
+        // ...if the alphabet has one (e.g. a paragraph node may only be labelled, not print a newline)
+        if (!hashed) continue;
         m_vGroupsByConversion[hashed].insert(
             static_cast<int>(m_vConversionsByGroup.size())); // identifies the new PY sound
         m_vConversionsByGroup.push_back(std::vector<symbol>(1, hashed));
+        m_vGroupNames.push_back(m_pPYgroups->strName); // named like any sound, by its group
         m_pPYgroups->iEnd++;
         m_pPYgroups->iNumChildNodes++;
     }
@@ -145,13 +147,14 @@ CMandarinAlphMgr::~CMandarinAlphMgr() {
     delete m_pPYgroups;
 }
 
-void CMandarinAlphMgr::CreateLanguageModel() {
-    m_pLanguageModel = new CPPMPYLanguageModel(m_pSettingsStore, static_cast<int>(m_vGroupsByConversion.size()) - 1,
-                                               static_cast<int>(m_vConversionsByGroup.size()) - 1);
+CLanguageModel* CMandarinAlphMgr::CreateLanguageModel() {
+    return new CPPMPYLanguageModel(m_pSettingsStore, static_cast<int>(m_vGroupsByConversion.size()) - 1,
+                                   static_cast<int>(m_vConversionsByGroup.size()) - 1);
 }
 
-CMandarinAlphMgr::CMandarinTrainer::CMandarinTrainer(CMessageDisplay* pMsgs, CMandarinAlphMgr* pMgr)
-    : CTrainer(pMsgs, pMgr->m_pLanguageModel, pMgr->m_pAlphabet, &pMgr->m_map), m_pMgr(pMgr) {
+CMandarinAlphMgr::CMandarinTrainer::CMandarinTrainer(CMessageDisplay* pMsgs, CMandarinAlphMgr* pMgr,
+                                                    CLanguageModel* pLanguageModel)
+    : CTrainer(pMsgs, pLanguageModel, pMgr->m_pAlphabet, &pMgr->m_map), m_pMgr(pMgr) {
     // We pass in the alphabet to define the context-switch escape character, and the default context.
 
     m_iStartSym = 0;
@@ -265,8 +268,8 @@ void CMandarinAlphMgr::CMandarinTrainer::Train(CAlphabetMap::SymbolStream& syms)
     m_pLanguageModel->ReleaseContext(trainContext);
 }
 
-CTrainer* CMandarinAlphMgr::GetTrainer() {
-    return new CMandarinTrainer(m_pInterface, this);
+CTrainer* CMandarinAlphMgr::GetTrainer(CLanguageModel* pLanguageModel, CMessageDisplay* pMsgs) {
+    return new CMandarinTrainer(pMsgs, this, pLanguageModel);
 }
 
 CAlphNode* CMandarinAlphMgr::CreateSymbolRoot(int iOffset, CLanguageModel::Context ctx, symbol chSym) {
@@ -72,7 +72,8 @@ class CMandarinAlphMgr : public CAlphabetManager {
     class CMandarinTrainer : public CTrainer {
       public:
         /// Construct a new MandarinTrainer. Reads alphabet etc. directly from pMgr.
-        CMandarinTrainer(CMessageDisplay* pMsgs, CMandarinAlphMgr* pMgr);
+        ///  pLanguageModel must be a PPMPYLanguageModel created by pMgr.
+        CMandarinTrainer(CMessageDisplay* pMsgs, CMandarinAlphMgr* pMgr, CLanguageModel* pLanguageModel);
 
       protected:
         // override...
@@ -94,7 +95,10 @@ class CMandarinAlphMgr : public CAlphabetManager {
     ~CMandarinAlphMgr();
 
     /// ACL: returns a MandarinTrainer too.
-    CTrainer* GetTrainer() override;
+    CTrainer* GetTrainer(CLanguageModel* pLanguageModel, CMessageDisplay* pMsgs) override;
+
+    /// WZ: Mandarin Dasher Change. Sets language model to PPMPY.
+    CLanguageModel* CreateLanguageModel() override;
 
     /// Disable game mode. The target sentence might appear in several places...!!
     CWordGeneratorBase* GetGameWords() { return NULL; }
@@ -109,8 +113,6 @@ class CMandarinAlphMgr : public CAlphabetManager {
     /// also MakeMap) return information on the target(chinese)-alphabet symbols, which
     /// are rehashed from the original/input alphabet to remove duplicates;
     void InitMap() override;
-    /// WZ: Mandarin Dasher Change. Sets language model to PPMPY.
-    void CreateLanguageModel() override;
 
     /// Process SGroupInfo's from the alphabet into form suitable for m_pPYgroups
     ///  \param pBase group from alphabet (i.e. containing unhashed CH symbol numbers)
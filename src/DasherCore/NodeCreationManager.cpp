@@ -6,8 +6,20 @@
 #include "FileUtils.h"
 #include "MandarinAlphMgr.h"
 #include "RoutingAlphMgr.h"
+#include "LanguageModelling/MappedPPMLanguageModel.h"
+#include "LanguageModelling/PPMLanguageModel.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 using namespace Dasher;
 
@@ -16,57 +28,296 @@ using namespace Dasher;
 class ProgressNotifier : public AbstractParser, private CTrainer::ProgressIndicator {
   public:
     ProgressNotifier(CDasherInterfaceBase* pInterface, CTrainer* pTrainer)
-        : AbstractParser(pInterface), m_bSystem(false), m_bUser(false), m_pInterface(pInterface), m_pTrainer(pTrainer) {
-    }
+        : ProgressNotifier(pInterface, pInterface, pTrainer) {}
 
     // update lock status with percent
-    void bytesRead(off_t n) {
-        const int iNewPercent = n / m_file_length * 100;
+    void bytesRead(off_t n) override {
+        // With a total, percent is of all the files, not just this one
+        const off_t iLength = m_iTotalLength ? m_iTotalLength : m_file_length;
+        const int iNewPercent = static_cast<int>((m_iPreviousFilesLength + n) * 100 / iLength);
         if (iNewPercent != m_iPercent) {
             m_iPercent = iNewPercent;
-            m_pInterface->SetLockStatus(m_strDisplay, m_iPercent);
+            SetStatus(m_strDisplay, m_iPercent);
         }
     }
 
-    bool ParseFile(const std::string& strFilename, bool bUser) {
+    bool ParseFile(const std::string& strFilename, bool bUser) override {
         m_file_length = Dasher::FileUtils::GetFileSize(strFilename);
         if (m_file_length == 0) return false;
-        return AbstractParser::ParseFile(strFilename, bUser);
+        const bool bResult = AbstractParser::ParseFile(strFilename, bUser);
+        if (m_iTotalLength) m_iPreviousFilesLength += m_file_length;
+        return bResult;
     }
 
-    bool Parse(const std::string& strUrl, std::istream& in, bool bUser) {
+    bool Parse(const std::string& strUrl, std::istream& in, bool bUser) override {
         m_strDisplay = bUser ? "Training on User Text" : "Training on System Text";
-        m_iPercent = 0;
-        m_bUser = m_bSystem = false; // Indication for 'file was neither parsed from user nor from system dir'
-        m_pInterface->SetLockStatus(m_strDisplay, m_iPercent);
+        m_pIn = &in;
+        m_iPercent = static_cast<int>(m_iTotalLength ? m_iPreviousFilesLength * 100 / m_iTotalLength : 0);
+        SetStatus(m_strDisplay, m_iPercent);
         m_pTrainer->SetProgressIndicator(this);
 
         if (m_pTrainer->Parse(strUrl, in, bUser)) {
             m_bUser |= bUser;
             m_bSystem |= !bUser;
 
-            m_pInterface->SetLockStatus("", -1); // Done, so unlock
+            SetStatus("", -1); // Done, so unlock
             return true;
         }
 
-        m_pInterface->SetLockStatus("", -1); // Unlock
+        SetStatus("", -1); // Unlock
         return false;
     }
 
+    /// Report progress as a percentage of iLength bytes over all the files to be parsed
+    void SetTotalLength(off_t iLength) { m_iTotalLength = iLength; }
+
     bool has_parsed_from_user_dir() { return m_bUser; }
     bool has_parsed_from_system_dir() { return m_bSystem; }
 
+    /// Whether training was abandoned part way through (and so must not be saved)
+    virtual bool cancelled() const { return false; }
+
+  protected:
+    ProgressNotifier(CMessageDisplay* pMsgs, CDasherInterfaceBase* pInterface, CTrainer* pTrainer)
+        : AbstractParser(pMsgs), m_bSystem(false), m_bUser(false), m_pInterface(pInterface), m_pTrainer(pTrainer) {}
+
+    /// Reports progress, as for CDasherInterfaceBase::SetLockStatus (which the default calls)
+    virtual void SetStatus(const std::string& strText, int iPercent) { m_pInterface->SetLockStatus(strText, iPercent); }
+
+    /// Stream the trainer is currently reading
+    std::istream* m_pIn = nullptr;
+
   private:
     bool m_bSystem, m_bUser;
     CDasherInterfaceBase* m_pInterface;
     CTrainer* m_pTrainer;
     off_t m_file_length = 0;
+    off_t m_iTotalLength = 0, m_iPreviousFilesLength = 0;
     int m_iPercent = 0;
     std::string m_strDisplay;
 };
 
+// 64-bit FNV-1a of str, continuing from iHash; also used to name snapshot files after the alphabet ID.
+static uint64_t HashString(const std::string& str, uint64_t iHash = 0xcbf29ce484222325ULL) {
+    for (char c : str) {
+        iHash ^= static_cast<unsigned char>(c);
+        iHash *= 0x100000001b3ULL;
+    }
+    return iHash;
+}
+
+// Passed to ScanFiles in place of a ProgressNotifier, to list the (non-empty) training files
+//  training would read, in order, without reading them; and fingerprint the system ones by name,
+//  size and modification time. Trained copies of the model are of the system text only (the
+//  user's own text changes with every session that writes it), so are keyed on that fingerprint.
+class TrainingFiles : public AbstractParser {
+  public:
+    struct SFile {
+        std::string strPath;
+        bool bUserText; // in the user's own directory, so learnt on top of any trained copy
+    };
+
+    explicit TrainingFiles(const FileUtils& fileUtils) : AbstractParser(nullptr), m_fileUtils(fileUtils) {}
+
+    bool ParseFile(const std::string& strPath, bool) override {
+        // Same condition as ProgressNotifier: empty files don't count as training text.
+        const int iSize = FileUtils::GetFileSize(strPath);
+        if (iSize <= 0) return false;
+        const bool bUserText = m_fileUtils.IsInUserDataDirectory(strPath);
+        m_vFiles.push_back({strPath, bUserText});
+        if (!bUserText) {
+            std::error_code ec;
+            const auto time = std::filesystem::last_write_time(strPath, ec);
+            m_iHash = HashString(std::filesystem::path(strPath).filename().string() + '\0' + std::to_string(iSize) +
+                                     ':' + std::to_string(ec ? 0 : time.time_since_epoch().count()) + '\0',
+                                 m_iHash);
+        }
+        return true;
+    }
+    bool Parse(const std::string&, std::istream&, bool) override { return false; }
+
+    const std::vector<SFile>& files() const { return m_vFiles; }
+    uint64_t systemHash() const { return m_iHash; }
+    bool hasSystemText() const {
+        return std::any_of(m_vFiles.begin(), m_vFiles.end(), [](const SFile& f) { return !f.bUserText; });
+    }
+
+  private:
+    const FileUtils& m_fileUtils;
+    std::vector<SFile> m_vFiles;
+    uint64_t m_iHash = HashString("");
+};
+
+// Collects the paths of the files ScanFiles finds, without reading them
+class FileCollector : public AbstractParser {
+  public:
+    FileCollector() : AbstractParser(nullptr) {}
+    bool ParseFile(const std::string& strPath, bool) override {
+        m_vPaths.push_back(strPath);
+        return true;
+    }
+    bool Parse(const std::string&, std::istream&, bool) override { return false; }
+    const std::vector<std::string>& paths() const { return m_vPaths; }
+
+  private:
+    std::vector<std::string> m_vPaths;
+};
+
+// A language model being trained on a worker thread (BP_BACKGROUND_TRAINING). The worker
+//  touches nothing but the LM and trainer here (and read-only alphabet data), so the only
+//  shared state is the progress below, and messages, which are queued until the model
+//  is adopted on the main thread.
+class CNodeCreationManager::CBackgroundTraining : public CMessageDisplay {
+  public:
+    ~CBackgroundTraining() {
+        // Abandoning the LM (e.g. the alphabet changed); make the worker stop reading
+        bCancel = true;
+        if (m_thread.joinable()) m_thread.join();
+        delete pTrainer;
+        delete pLM;
+    }
+
+    void Start(std::function<void()> fnTrain) {
+        m_thread = std::thread([this, fnTrain]() {
+            fnTrain();
+            bFinished = true;
+        });
+    }
+    void Wait() {
+        if (m_thread.joinable()) m_thread.join();
+    }
+
+    void Message(const std::string& strText, bool bInterrupt) override {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_vMessages.emplace_back(strText, bInterrupt);
+    }
+    void SetStatus(const std::string& strText, int iPercent) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_strStatus = strText;
+        iProgress = iPercent;
+    }
+    std::string GetStatus() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_strStatus;
+    }
+    /// Passes on (and forgets) the messages queued by the worker
+    void FlushMessages(CMessageDisplay* pMsgs) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const auto& msg : m_vMessages)
+            pMsgs->Message(msg.first, msg.second);
+        m_vMessages.clear();
+    }
+
+    /// The LM being trained, and its trainer; owned until adopted
+    CLanguageModel* pLM = nullptr;
+    CTrainer* pTrainer = nullptr;
+
+    std::atomic<int> iProgress{0};
+    std::atomic<bool> bFinished{false}, bCancel{false};
+
+  private:
+    std::thread m_thread;
+    mutable std::mutex m_mutex;
+    std::string m_strStatus;
+    std::vector<std::pair<std::string, bool>> m_vMessages;
+};
+
+// Reports progress over all the training files to a CBackgroundTraining, rather than to the
+//  interface, and stops the trainer if the training is abandoned.
+class BackgroundProgressNotifier : public ProgressNotifier {
+  public:
+    BackgroundProgressNotifier(CMessageDisplay* pMsgs, CTrainer* pTrainer, std::atomic<bool>& bCancel,
+                               std::function<void(const std::string&, int)> fnStatus)
+        : ProgressNotifier(pMsgs, nullptr, pTrainer), m_bCancel(bCancel), m_fnStatus(std::move(fnStatus)) {}
+
+    void bytesRead(off_t n) override {
+        // Makes the trainer's next read hit EOF
+        if (m_bCancel && m_pIn) m_pIn->setstate(std::ios::failbit);
+        ProgressNotifier::bytesRead(n);
+    }
+    bool ParseFile(const std::string& strFilename, bool bUser) override {
+        return !m_bCancel && ProgressNotifier::ParseFile(strFilename, bUser);
+    }
+    bool cancelled() const override { return m_bCancel; }
+
+  protected:
+    void SetStatus(const std::string& strText, int iPercent) override {
+        if (iPercent != -1) m_fnStatus(strText, iPercent); // the lock lasts until the model is adopted
+    }
+
+  private:
+    std::atomic<bool>& m_bCancel;
+    std::function<void(const std::string&, int)> m_fnStatus;
+};
+
+// Trains pLM (with pn's trainer) on the alphabet's training files (found through fileUtils). For
+//  standard PPM models, the system text is instead loaded from a trained copy of it if there is one:
+//  a snapshot in the user dir for CPPMLanguageModel, or for CMappedPPMLanguageModel an image in the
+//  user dir, else one shipped in the data dir (which is taken as trained on the alphabet's corpus,
+//  whatever the files there now). The user's own text is learnt on top, every time. Warns via pMsgs
+//  if there was little or no training text.
+static void TrainLanguageModel(const FileUtils& fileUtils, const CAlphInfo* pAlphInfo, CLanguageModel* pLM,
+                               ProgressNotifier& pn, CMessageDisplay* pMsgs) {
+    TrainingFiles files(fileUtils);
+    fileUtils.ScanFiles(&files, pAlphInfo->GetTrainingFile());
+    bool bLoaded = false;
+    CPPMLanguageModel* pPPM = dynamic_cast<CPPMLanguageModel*>(pLM);
+    CMappedPPMLanguageModel* pMapped = dynamic_cast<CMappedPPMLanguageModel*>(pLM);
+    const CPPMLanguageModel::SnapshotKey key{pAlphInfo->GetID(), files.systemHash()};
+    std::string strCache; // user dir file to save to, after training
+    if ((pPPM || pMapped) && files.hasSystemText()) {
+        char szAlphHash[17];
+        snprintf(szAlphHash, sizeof(szAlphHash), "%016" PRIx64, HashString(pAlphInfo->GetID()));
+        const std::string strBase = std::string("ppm_") + szAlphHash;
+        strCache = fileUtils.ResolveUserDataPath(strBase + (pPPM ? ".snapshot" : ".ppmimage"));
+        if (pPPM) {
+            bLoaded = pPPM->ReadSnapshot(strCache, key);
+        } else if (!(bLoaded = pMapped->MapImage(strCache, key))) {
+            FileCollector images;
+            fileUtils.ScanFiles(&images, strBase + ".ppmimage");
+            const CPPMLanguageModel::SnapshotKey shipped{pAlphInfo->GetID(),
+                                                         CPPMLanguageModel::SnapshotKey::ANY_TRAINING};
+            for (const std::string& strImage : images.paths())
+                if (!fileUtils.IsInUserDataDirectory(strImage) && (bLoaded = pMapped->MapImage(strImage, shipped)))
+                    break;
+        }
+    }
+    // (in the order ScanFiles found them, as it would have parsed them; as user text if in the user's dir)
+    const auto train = [&](bool bUserText) {
+        for (const TrainingFiles::SFile& file : files.files())
+            if (file.bUserText == bUserText && !pn.cancelled()) pn.ParseFile(file.strPath, file.bUserText);
+    };
+    if (!bLoaded) {
+        train(false);
+        if (!strCache.empty() && !pn.cancelled()) {
+            if (pPPM) pPPM->WriteSnapshot(strCache, key);
+            // Serve the rest of the session from the new image too, rather than from the heap overlay
+            if (pMapped && pMapped->WriteImage(strCache, key)) pMapped->MapImage(strCache, key);
+        }
+    }
+    train(true);
+
+    if (pn.cancelled()) return; // (the model is abandoned)
+    if (!pn.has_parsed_from_user_dir()) {
+        /// TRANSLATORS: These 3 messages will be displayed when the user has just chosen a new alphabet. The %s
+        /// parameter (or quoted name) will be the name of the alphabet.
+        if (bLoaded || pn.has_parsed_from_system_dir()) {
+            // (Not modal: entry works as well as ever, and when training in the background this
+            //  comes whenever training ends, which may be mid-zoom)
+            pMsgs->Message("No user training text found - if you have written in \"" + pAlphInfo->GetID() +
+                               "\" before, this means Dasher may not be learning from previous sessions",
+                           false);
+        } else {
+            pMsgs->FormatMessage("No training text (user or system) found for \"%s\". Dasher will still work "
+                                 "but entry will be slower. We suggest downloading a training text file from "
+                                 "the Dasher website, or constructing your own.",
+                                 pAlphInfo->GetID().c_str());
+        }
+    }
+}
+
 CNodeCreationManager::CNodeCreationManager(CSettingsStore* pSettingsStore, CDasherInterfaceBase* pInterface,
-                                           const CAlphIO* pAlphIO)
+                                           CAlphIO* pAlphIO)
     : m_pInterface(pInterface), m_pScreen(nullptr), m_pSettingsStore(pSettingsStore) {
     m_pSettingsStore->OnParameterChanged.Subscribe(this, [this](const Parameter p) { HandleParameterChange(p); });
 
@@ -94,24 +345,15 @@ CNodeCreationManager::CNodeCreationManager(CSettingsStore* pSettingsStore, CDash
     // all other configuration changes, etc., that might be necessary for a particular conversion mode,
     //  are implemented by AlphabetManager subclasses overriding the following two methods:
     m_pAlphabetManager->Setup();
-    m_pTrainer = m_pAlphabetManager->GetTrainer();
+    m_pTrainer = m_pAlphabetManager->GetTrainer(m_pAlphabetManager->GetLanguageModel(), pInterface);
 
     if (!pAlphInfo->GetTrainingFile().empty()) {
-        ProgressNotifier pn(pInterface, m_pTrainer);
-        Dasher::FileUtils::ScanFiles(&pn, pAlphInfo->GetTrainingFile());
-        if (!pn.has_parsed_from_user_dir()) {
-            /// TRANSLATORS: These 3 messages will be displayed when the user has just chosen a new alphabet. The %s
-            /// parameter will be the name of the alphabet.
-            if (pn.has_parsed_from_system_dir()) {
-                pInterface->FormatMessage("No user training text found - if you have written in \"%s\" before, this "
-                                          "means Dasher may not be learning from previous sessions",
-                                          pAlphInfo->GetID().c_str());
-            } else {
-                pInterface->FormatMessage("No training text (user or system) found for \"%s\". Dasher will still work "
-                                          "but entry will be slower. We suggest downloading a training text file from "
-                                          "the Dasher website, or constructing your own.",
-                                          pAlphInfo->GetID().c_str());
-            }
+        if (m_pSettingsStore->GetBoolParameter(BP_BACKGROUND_TRAINING)) {
+            StartBackgroundTraining(pAlphInfo);
+        } else {
+            ProgressNotifier pn(pInterface, m_pTrainer);
+            TrainLanguageModel(pInterface->GetFileUtils(), pAlphInfo, m_pAlphabetManager->GetLanguageModel(), pn,
+                               pInterface);
         }
     } else {
         pInterface->FormatMessage("\"%s\" does not specify training file. Dasher will work but entry will be slower. "
@@ -125,6 +367,7 @@ CNodeCreationManager::CNodeCreationManager(CSettingsStore* pSettingsStore, CDash
 }
 
 CNodeCreationManager::~CNodeCreationManager() {
+    m_pTraining.reset(); // stop training before deleting the alphabet it reads
     delete m_pAlphabetManager;
     delete m_pTrainer;
     delete m_pControlManager;
@@ -139,6 +382,52 @@ void CNodeCreationManager::ChangeScreen(CDasherScreen* pScreen) {
     if (m_pControlManager) m_pControlManager->ChangeScreen(pScreen);
 }
 
+void CNodeCreationManager::StartBackgroundTraining(const CAlphInfo* pAlphInfo) {
+    m_pTraining.reset(new CBackgroundTraining());
+    CBackgroundTraining* pTraining = m_pTraining.get();
+    pTraining->pLM = m_pAlphabetManager->CreateLanguageModel();
+    pTraining->pTrainer = m_pAlphabetManager->GetTrainer(pTraining->pLM, pTraining);
+    pTraining->SetStatus("", 0);
+    // (the worker reads files through a copy of where to find them, which never changes)
+    pTraining->Start([pTraining, pAlphInfo, fileUtils = m_pInterface->GetFileUtils()]() {
+        BackgroundProgressNotifier pn(pTraining, pTraining->pTrainer, pTraining->bCancel,
+                                      [pTraining](const std::string& strText, int iPercent) {
+                                          pTraining->SetStatus(strText, iPercent);
+                                      });
+        FileCollector files;
+        fileUtils.ScanFiles(&files, pAlphInfo->GetTrainingFile());
+        off_t iTotalLength = 0;
+        for (const std::string& strFile : files.paths())
+            iTotalLength += Dasher::FileUtils::GetFileSize(strFile);
+        pn.SetTotalLength(iTotalLength);
+        TrainLanguageModel(fileUtils, pAlphInfo, pTraining->pLM, pn, pTraining);
+        pTraining->SetStatus("", 100);
+    });
+}
+
+bool CNodeCreationManager::IsTrainingFinished() const {
+    return m_pTraining && m_pTraining->bFinished;
+}
+
+int CNodeCreationManager::GetTrainingProgress() const {
+    return m_pTraining ? m_pTraining->iProgress.load() : -1;
+}
+
+std::string CNodeCreationManager::GetTrainingMessage() const {
+    return m_pTraining ? m_pTraining->GetStatus() : std::string();
+}
+
+void CNodeCreationManager::AdoptTrainedModel() {
+    if (!m_pTraining) return;
+    m_pTraining->Wait();
+    m_pAlphabetManager->SetLanguageModel(m_pTraining->pLM);
+    m_pTraining->pLM = nullptr;
+    delete m_pTrainer;
+    m_pTrainer = m_pAlphabetManager->GetTrainer(m_pAlphabetManager->GetLanguageModel(), m_pInterface);
+    m_pTraining->FlushMessages(m_pInterface);
+    m_pTraining.reset();
+}
+
 void CNodeCreationManager::ImportTrainingText(const std::string& strPath) {
     ProgressNotifier pn(m_pInterface, m_pTrainer);
     pn.ParseFile(strPath, true);
@@ -161,7 +450,7 @@ void CNodeCreationManager::CreateControlBox() {
         // Register frontend-provided custom actions before parsing control.xml
         for (auto& [name, callback] : m_pInterface->GetPendingCustomActions())
             m_pControlManager->GetActionRegistry()->registerCustomAction(name, std::move(callback));
-        Dasher::FileUtils::ScanFiles(m_pControlManager, "control.xml");
+        m_pInterface->GetFileUtils().ScanFiles(m_pControlManager, "control.xml");
         if (m_pScreen) m_pControlManager->ChangeScreen(m_pScreen);
         iControlSpace = Dasher::CDasherModel::NORMALIZATION / 20;
     } else {
@@ -6,6 +6,7 @@
 #include "Trainer.h"
 #include "SettingsStore.h"
 
+#include <memory>
 #include <string>
 
 namespace Dasher {
@@ -22,7 +23,7 @@ class CControlBoxIO;
 class CNodeCreationManager {
   public:
     CNodeCreationManager(Dasher::CSettingsStore* pSettingsStore, Dasher::CDasherInterfaceBase* pInterface,
-                         const Dasher::CAlphIO* pAlphIO);
+                         Dasher::CAlphIO* pAlphIO);
     ~CNodeCreationManager();
 
     /// Tells us the screen on which all created node labels must be rendered
@@ -45,6 +46,27 @@ class CNodeCreationManager {
 
     void ImportTrainingText(const std::string& strPath);
 
+    /// @name Background training
+    /// With BP_BACKGROUND_TRAINING, the LM is trained (or loaded from a snapshot/image)
+    ///  on a worker thread, and until AdoptTrainedModel() the alphabet manager predicts
+    ///  from an untrained one. The worker only touches the LM it is training, so these
+    ///  must all be called from the thread that owns this manager.
+    /// @{
+
+    /// Whether the LM is being trained in the background (i.e. not yet adopted)
+    bool IsTraining() const { return m_pTraining != nullptr; }
+    /// Whether background training has finished, i.e. AdoptTrainedModel() won't block
+    bool IsTrainingFinished() const;
+    /// Percentage of the training text read so far, or -1 if not training
+    int GetTrainingProgress() const;
+    /// Describes what is being trained on, for the lock screen
+    std::string GetTrainingMessage() const;
+    /// Waits for background training to finish, then replaces the alphabet manager's
+    ///  LM with the trained one, and passes on any messages from training. Every node
+    ///  from the alphabet manager must have been deleted first.
+    void AdoptTrainedModel();
+    /// @}
+
     /// Amount of probability space assigned to alphabet nodes
     /// (NORMALIZATION minus control node space, if control mode is on).
     unsigned long GetAlphNodeNormalization() { return m_iAlphNorm; }
@@ -57,6 +79,12 @@ class CNodeCreationManager {
     void CreateControlBox();
 
   private:
+    class CBackgroundTraining;
+    /// Starts training a new LM (from the alphabet manager) on a worker thread
+    void StartBackgroundTraining(const Dasher::CAlphInfo* pAlphInfo);
+    /// Non-null while the LM is being trained in the background
+    std::unique_ptr<CBackgroundTraining> m_pTraining;
+
     Dasher::CTrainer* m_pTrainer;
     Dasher::CDasherInterfaceBase* m_pInterface;
     Dasher::CAlphabetManager* m_pAlphabetManager;
@@ -0,0 +1,170 @@
+#include "ParallelTrainer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace Dasher;
+
+namespace {
+
+// Keeps a worker's messages (e.g. about invalid UTF-8), to be passed on in order by the calling thread
+class CQueuedMessages : public CMessageDisplay {
+  public:
+    void Message(const std::string& strText, bool bInterrupt) override {
+        m_vMessages.emplace_back(strText, bInterrupt);
+    }
+    void FlushTo(CMessageDisplay* pMsgs) {
+        for (const auto& msg : m_vMessages)
+            pMsgs->Message(msg.first, msg.second);
+        m_vMessages.clear();
+    }
+
+  private:
+    std::vector<std::pair<std::string, bool>> m_vMessages;
+};
+
+struct SShard {
+    /// Byte range of the file
+    size_t iStart, iEnd;
+    std::vector<symbol> vSymbols;
+    CQueuedMessages msgs;
+    /// Model learning the shard; null for the first, which learns straight into the trainer's
+    std::unique_ptr<CPPMLanguageModel> pModel;
+    /// Set (under the trainer's mutex) once the shard has been learnt
+    bool bDone = false;
+};
+
+// How often, in symbols, workers report their progress (and check for cancellation)
+const size_t PROGRESS_INTERVAL = 4096;
+
+} // namespace
+
+CParallelTrainer::CParallelTrainer(CMessageDisplay* pMsgs, CPPMLanguageModel* pLanguageModel, const CAlphInfo* pInfo,
+                                   const CAlphabetMap* pAlphabet, int iThreads)
+    : CTrainer(pMsgs, pLanguageModel, pInfo, pAlphabet), m_pPPM(pLanguageModel), m_iThreads(iThreads) {}
+
+bool CParallelTrainer::Parse(const std::string& strDesc, std::istream& in, bool bUser) {
+    if (m_iThreads < 2 || in.fail()) return CTrainer::Parse(strDesc, in, bUser);
+
+    // Only files that can be rewound (should they turn out to need CTrainer) are split
+    size_t iLength = 0;
+    const std::streampos iStart = in.tellg();
+    if (iStart != std::streampos(-1) && in.seekg(0, std::ios::end)) {
+        iLength = static_cast<size_t>(in.tellg() - iStart);
+        in.seekg(iStart);
+    }
+    in.clear();
+    const size_t iMaxShards = std::min(static_cast<size_t>(m_iThreads), iLength / MIN_SHARD_LENGTH);
+    if (iMaxShards < 2) return CTrainer::Parse(strDesc, in, bUser);
+
+    std::string strText(iLength, '\0');
+    in.read(&strText[0], iLength);
+    strText.resize(static_cast<size_t>(in.gcount()));
+    in.clear();
+
+    // Shards end just after a line break - never within a character - as near equal in length as that allows
+    std::vector<SShard> vShards;
+    vShards.reserve(iMaxShards);
+    for (size_t iPos = 0; iPos < strText.size();) {
+        size_t iEnd = strText.size();
+        if (vShards.size() + 1 < iMaxShards) {
+            const size_t iBreak =
+                strText.find('\n', std::max(iPos, strText.size() * (vShards.size() + 1) / iMaxShards));
+            if (iBreak != std::string::npos) iEnd = iBreak + 1;
+        }
+        vShards.emplace_back();
+        vShards.back().iStart = iPos;
+        vShards.back().iEnd = iPos = iEnd;
+    }
+    if (vShards.size() < 2 ||
+        (m_iCtxEsc != -1 && strText.find(m_pInfo->GetContextEscapeChar()) != std::string::npos)) {
+        in.seekg(iStart);
+        return CTrainer::Parse(strDesc, in, bUser);
+    }
+
+    // Read each shard's symbols...
+    std::vector<std::thread> vThreads;
+    auto read = [this, &strText](SShard& shard) {
+        std::istringstream ss(strText.substr(shard.iStart, shard.iEnd - shard.iStart));
+        CAlphabetMap::SymbolStream syms(ss, &shard.msgs);
+        for (symbol sym; (sym = syms.next(m_pAlphabet)) != -1;)
+            if (sym != 0) shard.vSymbols.push_back(sym); // LearnSymbol ignores unknown symbols anyway
+    };
+    for (size_t i = 1; i < vShards.size(); i++)
+        vThreads.emplace_back(read, std::ref(vShards[i]));
+    read(vShards[0]);
+    for (std::thread& thread : vThreads)
+        thread.join();
+    vThreads.clear();
+
+    // ...then learn them all at once
+    size_t iTotal = 0;
+    for (size_t i = 0; i < vShards.size(); i++) {
+        iTotal += vShards[i].vSymbols.size();
+        if (i) vShards[i].pModel.reset(m_pPPM->CreateShard());
+    }
+    std::atomic<size_t> iLearnt{0};
+    std::atomic<bool> bCancel{false};
+    std::mutex mutex;
+    std::condition_variable cvDone;
+    auto learn = [&](size_t i) {
+        SShard& shard = vShards[i];
+        CPPMLanguageModel* pModel = i ? shard.pModel.get() : m_pPPM;
+        CLanguageModel::Context ctx = pModel->CreateEmptyContext();
+        if (i) {
+            // Where the preceding text leaves off: its last (up to) max order symbols
+            std::vector<symbol> vContext;
+            const size_t iOrder = static_cast<size_t>(pModel->GetMaxOrder());
+            for (size_t j = i; j-- > 0 && vContext.size() < iOrder;) {
+                const std::vector<symbol>& vPrev = vShards[j].vSymbols;
+                for (auto it = vPrev.rbegin(); it != vPrev.rend() && vContext.size() < iOrder; ++it)
+                    vContext.push_back(*it);
+            }
+            for (auto it = vContext.rbegin(); it != vContext.rend(); ++it)
+                pModel->PrimeSymbol(ctx, *it);
+        }
+        size_t n = 0;
+        for (symbol sym : shard.vSymbols) {
+            pModel->LearnSymbol(ctx, sym);
+            if (++n % PROGRESS_INTERVAL == 0) {
+                iLearnt += PROGRESS_INTERVAL;
+                if (bCancel) break;
+            }
+        }
+        pModel->ReleaseContext(ctx);
+        std::lock_guard<std::mutex> lock(mutex);
+        shard.bDone = true;
+        cvDone.notify_all();
+    };
+    for (size_t i = 0; i < vShards.size(); i++)
+        vThreads.emplace_back(learn, i);
+
+    // Merge the shards in order as they finish, reporting progress meanwhile
+    for (size_t i = 0; i < vShards.size(); i++) {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!cvDone.wait_for(lock, std::chrono::milliseconds(50), [&]() { return vShards[i].bDone; })) {
+            lock.unlock();
+            if (m_pProg && iTotal) m_pProg->bytesRead(static_cast<off_t>(strText.size() * iLearnt / iTotal));
+            if (in.fail()) bCancel = true; // abandoned (see BackgroundProgressNotifier)
+            lock.lock();
+        }
+        lock.unlock();
+        if (i && !bCancel) m_pPPM->MergeShard(*vShards[i].pModel);
+        vShards[i].pModel.reset();
+    }
+    for (std::thread& thread : vThreads)
+        thread.join();
+    if (m_pProg) m_pProg->bytesRead(static_cast<off_t>(strText.size()));
+
+    for (SShard& shard : vShards)
+        shard.msgs.FlushTo(m_pMsgs);
+    return true;
+}
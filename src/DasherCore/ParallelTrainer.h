@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Trainer.h"
+#include "LanguageModelling/PPMLanguageModel.h"
+
+namespace Dasher {
+
+/// Trains a CPPMLanguageModel on several threads. Each training file is split, at line
+/// breaks, into up to one shard per thread; every shard but the first is learnt by a model
+/// of its own (CPPMLanguageModel::CreateShard), primed with the context the preceding text
+/// leaves off in, while the first is learnt directly. The shards are then merged back in
+/// order (CPPMLanguageModel::MergeShard), giving exactly the model CTrainer would have built.
+///
+/// Files too short to be worth splitting are trained as by CTrainer, as are files with
+/// context-switch commands: the context a command enters depends on everything learnt
+/// before it, which a shard does not have.
+class CParallelTrainer : public CTrainer {
+  public:
+    /// \param iThreads most threads (and so shards) to train each file with
+    CParallelTrainer(CMessageDisplay* pMsgs, CPPMLanguageModel* pLanguageModel, const CAlphInfo* pInfo,
+                     const CAlphabetMap* pAlphabet, int iThreads);
+
+    bool Parse(const std::string& strDesc, std::istream& in, bool bUser) override;
+
+    /// Files are only split into shards of at least this many bytes
+    static constexpr size_t MIN_SHARD_LENGTH = 64 * 1024;
+
+  private:
+    CPPMLanguageModel* const m_pPPM;
+    const int m_iThreads;
+};
+
+} // namespace Dasher
@@ -127,6 +127,12 @@ const std::unordered_map<Parameter, const Parameter_Value> parameter_defaults =
          "SlowControlBox", PARAM_BOOL, Persistence::PERSISTENT, true,
          "Reduces speed by half when navigating inside control nodes, making it harder to trigger actions by mistake.",
          "Slow in Control Nodes", Settings::UIControlType::Switch, true, "BP_SLOW_CONTROL_BOX", "Control", "Input"}},
+    {BP_BACKGROUND_TRAINING,
+     Parameter_Value{
+         "BackgroundTraining", PARAM_BOOL, Persistence::PERSISTENT, false,
+         "Train the language model on a background thread, showing its progress instead of blocking startup.",
+         "Train in Background", Settings::UIControlType::Switch, true, "BP_BACKGROUND_TRAINING", "Learning",
+         "Language"}},
     {BP_COPY_ALL_ON_STOP,
      Parameter_Value{"CopyOnStop", PARAM_BOOL, Persistence::PERSISTENT, false,
                      "Copy all text to clipboard whenever we stop.", "Copy on Stop", Settings::UIControlType::None,
@@ -178,7 +184,8 @@ const std::unordered_map<Parameter, const Parameter_Value> parameter_defaults =
                                            "LanguageModelID.",
                                            "Language Model",
                                            Settings::UIControlType::Enum,
-                                           {{"PPM", 0}, {"Word", 2}, {"Mixture", 3}, {"CTW", 4}},
+                                           {{"PPM", 0}, {"Word", 2}, {"Mixture", 3}, {"CTW", 4}, {"Mapped PPM", 5},
+                                            {"Compact PPM", 6}},
                                            true,
                                            "LP_LANGUAGE_MODEL_ID",
                                            "Learning",
@@ -250,6 +257,17 @@ const std::unordered_map<Parameter, const Parameter_Value> parameter_defaults =
     {LP_LM_UPDATE_EXCLUSION, Parameter_Value{"LMUpdateExclusion", PARAM_LONG, Persistence::PERSISTENT, 1l,
                                              "LMUpdateExclusion.", "LM Update Exclusion", Settings::UIControlType::Step,
                                              0, 100, 1, 1, true, "LP_LM_UPDATE_EXCLUSION", "Advanced", "Language"}},
+    {LP_TRAINING_THREADS,
+     Parameter_Value{"TrainingThreads", PARAM_LONG, Persistence::PERSISTENT, 1l,
+                     "Threads to train the language model with when a language is loaded (0 = one per core).",
+                     "Training Threads", Settings::UIControlType::Step, 0, 64, 1, 1, true, "LP_TRAINING_THREADS",
+                     "Learning", "Language"}},
+    {LP_LM_NODE_BUDGET,
+     Parameter_Value{"LMNodeBudget", PARAM_LONG, Persistence::PERSISTENT, 0l,
+                     "Most nodes the PPM language model may grow to before pruning rarely seen contexts (0 = "
+                     "unlimited).",
+                     "LM Node Budget", Settings::UIControlType::Step, 0, 100000000, 1, 100000, true,
+                     "LP_LM_NODE_BUDGET", "Learning", "Language"}},
     {LP_LM_ALPHA,
      Parameter_Value{"LMAlpha", PARAM_LONG, Persistence::PERSISTENT, 49l, "Language model alpha blending parameter.",
                      "LM Alpha", Settings::UIControlType::Slider, 0, 100, 1, 1, true, "LP_LM_ALPHA", "Advanced",
@@ -327,6 +345,30 @@ const std::unordered_map<Parameter, const Parameter_Value> parameter_defaults =
                      "Target (min) number of node objects to maintain.", "Node Budget", Settings::UIControlType::Step,
                      100, 10000, 1, 100, true, "LP_NODE_BUDGET", "Advanced", "Input"}},
 #endif
+    {LP_LOOKAHEAD_FRAMES,
+     Parameter_Value{"LookaheadFrames", PARAM_LONG, Persistence::PERSISTENT, 0l,
+                     "Expand the nodes the crosshair is heading for this many frames ahead, judging by recent "
+                     "movement (0 = off).",
+                     "Look-ahead Frames", Settings::UIControlType::Step, 0, 60, 1, 1, true, "LP_LOOKAHEAD_FRAMES",
+                     "Advanced", "Input"}},
+    {LP_LOOKAHEAD_TIME,
+     Parameter_Value{"LookaheadTime", PARAM_LONG, Persistence::PERSISTENT, 2000l,
+                     "Microseconds per frame to spend expanding nodes ahead of the crosshair (see "
+                     "LP_LOOKAHEAD_FRAMES).",
+                     "Look-ahead Time", Settings::UIControlType::Step, 0, 100000, 1, 100, true, "LP_LOOKAHEAD_TIME",
+                     "Advanced", "Input"}},
+    {LP_EXPANSION_TIME,
+     Parameter_Value{"ExpansionTime", PARAM_LONG, Persistence::PERSISTENT, 0l,
+                     "Microseconds per frame to spend expanding nodes, as measured, rather than a number of nodes "
+                     "(0 = a number of nodes, by the node budget).",
+                     "Expansion Time", Settings::UIControlType::Step, 0, 100000, 1, 100, true, "LP_EXPANSION_TIME",
+                     "Advanced", "Input"}},
+    {LP_SUBTREE_CACHE,
+     Parameter_Value{"SubtreeCache", PARAM_LONG, Persistence::PERSISTENT, 0l,
+                     "Kilobytes of collapsed nodes to keep, to give back if their parents are expanded again, rather "
+                     "than creating them anew (0 = off).",
+                     "Subtree Cache", Settings::UIControlType::Step, 0, 65536, 1, 256, true, "LP_SUBTREE_CACHE",
+                     "Advanced", "Input"}},
     {LP_OUTLINE_WIDTH, Parameter_Value{"OutlineWidth", PARAM_LONG, Persistence::PERSISTENT, 0l,
                                        "Absolute value is line width to draw boxes (fill iff >=0).", "Outline Width",
                                        Settings::UIControlType::Step, -10, 100, 1, 1, true, "LP_OUTLINE_WIDTH",
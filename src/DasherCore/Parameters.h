@@ -39,6 +39,7 @@ enum Parameter {
     BP_SIMULATE_TRANSPARENCY,
     BP_CONTROL_MODE,
     BP_SLOW_CONTROL_BOX,
+    BP_BACKGROUND_TRAINING,
     END_OF_BPS,
 
     LP_ORIENTATION,
@@ -106,6 +107,12 @@ enum Parameter {
     LP_X_LIMIT_SPEED,
     LP_GAME_HELP_DIST,
     LP_GAME_HELP_TIME,
+    LP_TRAINING_THREADS,
+    LP_LM_NODE_BUDGET,
+    LP_LOOKAHEAD_FRAMES,
+    LP_LOOKAHEAD_TIME,
+    LP_EXPANSION_TIME,
+    LP_SUBTREE_CACHE,
     END_OF_LPS,
 
     SP_ALPHABET_ID,
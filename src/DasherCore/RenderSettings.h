@@ -0,0 +1,85 @@
+// RenderSettings.h
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+
+#include "Parameters.h"
+
+namespace Dasher {
+/// \ingroup Core
+/// @{
+
+/// \brief Settings read for every node drawn or every frame moved.
+///
+/// The view reads the node shape, outline width etc. for each node it draws,
+/// and the filters read the dynamics settings every frame; looking each of
+/// them up in the settings store's map every time soon adds up. Instead the
+/// store keeps this snapshot of them, typed and packed into one cache line,
+/// refreshed only when one of them changes (before OnParameterChanged is
+/// broadcast, so listeners see the new value here too).
+///
+/// Long settings are narrowed to 32 bits: all of these have small ranges.
+struct alignas(64) SRenderSettings {
+    // View
+    int32_t iShapeType;   // LP_SHAPE_TYPE
+    int32_t iOutlineWidth; // LP_OUTLINE_WIDTH
+    int32_t iTextPadding;  // LP_TEXT_PADDING
+    int32_t iFontSize;     // LP_DASHER_FONTSIZE
+    int32_t iMinNodeSize;  // LP_MIN_NODE_SIZE
+    int32_t iNonlinearX;   // LP_NONLINEAR_X
+    int32_t iGeometry;     // LP_GEOMETRY
+    // Model
+    int32_t iUniform; // LP_UNIFORM
+    // Filters
+    int32_t iXLimitSpeed;   // LP_X_LIMIT_SPEED
+    int32_t iSlowStartTime; // LP_SLOW_START_TIME
+    int32_t iLineWidth;     // LP_LINE_WIDTH
+    int32_t iTargetOffset;  // LP_TARGET_OFFSET
+
+    bool bNonlinearY;           // BP_NONLINEAR_Y
+    bool bSimulateTransparency; // BP_SIMULATE_TRANSPARENCY
+    bool bExactDynamics;        // BP_EXACT_DYNAMICS
+    bool bSlowStart;            // BP_SLOW_START
+    bool bAutocalibrate;        // BP_AUTOCALIBRATE
+    bool bDrawMouse;            // BP_DRAW_MOUSE
+    bool bDrawMouseLine;        // BP_DRAW_MOUSE_LINE
+    bool bCurveMouseLine;       // BP_CURVE_MOUSE_LINE
+    bool bRemapXtreme;          // BP_REMAP_XTREME
+
+    /// Whether parameter is one of those above
+    static bool Contains(Parameter parameter) {
+        switch (parameter) {
+        case LP_SHAPE_TYPE:
+        case LP_OUTLINE_WIDTH:
+        case LP_TEXT_PADDING:
+        case LP_DASHER_FONTSIZE:
+        case LP_MIN_NODE_SIZE:
+        case LP_NONLINEAR_X:
+        case LP_GEOMETRY:
+        case LP_UNIFORM:
+        case LP_X_LIMIT_SPEED:
+        case LP_SLOW_START_TIME:
+        case LP_LINE_WIDTH:
+        case LP_TARGET_OFFSET:
+        case BP_NONLINEAR_Y:
+        case BP_SIMULATE_TRANSPARENCY:
+        case BP_EXACT_DYNAMICS:
+        case BP_SLOW_START:
+        case BP_AUTOCALIBRATE:
+        case BP_DRAW_MOUSE:
+        case BP_DRAW_MOUSE_LINE:
+        case BP_CURVE_MOUSE_LINE:
+        case BP_REMAP_XTREME:
+            return true;
+        default:
+            return false;
+        }
+    }
+};
+static_assert(sizeof(SRenderSettings) == 64, "render settings should fill one cache line");
+
+/// @}
+} // namespace Dasher
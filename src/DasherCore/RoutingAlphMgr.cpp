@@ -48,9 +48,9 @@ void CRoutingAlphMgr::InitMap() {
     }
 }
 
-void CRoutingAlphMgr::CreateLanguageModel() {
-    m_pLanguageModel = new CRoutingPPMLanguageModel(m_pSettingsStore, &m_vBaseSyms, &m_vRoutes,
-                                                    m_pAlphabet->m_iConversionID == CAlphInfo::RoutingContextSensitive);
+CLanguageModel* CRoutingAlphMgr::CreateLanguageModel() {
+    return new CRoutingPPMLanguageModel(m_pSettingsStore, &m_vBaseSyms, &m_vRoutes,
+                                        m_pAlphabet->m_iConversionID == CAlphInfo::RoutingContextSensitive);
 }
 
 std::string CRoutingAlphMgr::CRoutedSym::trainText() {
@@ -92,8 +92,9 @@ CDasherNode* CRoutingAlphMgr::CreateSymbolNode(CAlphNode* pParent, symbol iSymbo
     return pAlphNode;
 }
 
-CRoutingAlphMgr::CRoutingTrainer::CRoutingTrainer(CMessageDisplay* pMsgs, CRoutingAlphMgr* pMgr)
-    : CTrainer(pMsgs, pMgr->m_pLanguageModel, pMgr->m_pAlphabet, &pMgr->m_map), m_pMgr(pMgr) {
+CRoutingAlphMgr::CRoutingTrainer::CRoutingTrainer(CMessageDisplay* pMsgs, CRoutingAlphMgr* pMgr,
+                                                  CLanguageModel* pLanguageModel)
+    : CTrainer(pMsgs, pLanguageModel, pMgr->m_pAlphabet, &pMgr->m_map), m_pMgr(pMgr) {
 
     m_iStartSym = 0;
     std::vector<symbol> trainStartSyms;
@@ -167,9 +168,9 @@ void CRoutingAlphMgr::CRoutingTrainer::Train(CAlphabetMap::SymbolStream& syms) {
     m_pLanguageModel->ReleaseContext(trainContext);
 }
 
-CTrainer* CRoutingAlphMgr::GetTrainer() {
+CTrainer* CRoutingAlphMgr::GetTrainer(CLanguageModel* pLanguageModel, CMessageDisplay* pMsgs) {
     // We pass in the pinyin alphabet to define the context-switch escape character, and the default context.
     //  Although the default context will be symbolified via the _chinese_ alphabet, this seems reasonable
     //  as it is the Pinyin alphabet which defines the conversion mapping (i.e. m_strConversionTarget!)
-    return new CRoutingTrainer(m_pInterface, this);
+    return new CRoutingTrainer(pMsgs, this, pLanguageModel);
 }
@@ -43,7 +43,10 @@ class CRoutingAlphMgr : public CAlphabetManager {
                     const CAlphInfo* pAlphabet);
 
     /// Override to return a CRoutingTrainer
-    CTrainer* GetTrainer() override;
+    CTrainer* GetTrainer(CLanguageModel* pLanguageModel, CMessageDisplay* pMsgs) override;
+
+    /// Override to create a RoutingPPMLanguageModel
+    CLanguageModel* CreateLanguageModel() override;
 
     /// Disable game mode. The target sentence might appear in several places...!!
     CWordGeneratorBase* GetGameWords() { return NULL; }
@@ -52,8 +55,6 @@ class CRoutingAlphMgr : public CAlphabetManager {
     /// Fills map w/ rehashed base symbols, filling m_vBaseSyms, m_vRoutes,
     ///  and m_vGroupsByRoute to record which symbols were identified together.
     void InitMap() override;
-    /// Override to create a RoutingPPMLanguageModel
-    void CreateLanguageModel() override;
 
     /// Creates a symbol, i.e. including route.
     ///  Both ctx and sym were reconstructed from m_map (filled by InitMap), so
@@ -98,7 +99,8 @@ class CRoutingAlphMgr : public CAlphabetManager {
     /// is specified, somewhat better than PPMPY).
     class CRoutingTrainer : public CTrainer {
       public:
-        CRoutingTrainer(CMessageDisplay* pMsgs, CRoutingAlphMgr* pMgr);
+        /// pLanguageModel must be a RoutingPPMLanguageModel created by pMgr
+        CRoutingTrainer(CMessageDisplay* pMsgs, CRoutingAlphMgr* pMgr, CLanguageModel* pLanguageModel);
 
       protected:
         // override...
@@ -46,6 +46,7 @@ void CSettingsStore::AddParameters(const std::unordered_map<Parameter, const Set
             }
         }
     }
+    RefreshRenderSettings();
 }
 
 // Return 0 on success, an error string on failure.
@@ -95,6 +96,7 @@ void CSettingsStore::SetParameter(Parameter parameter, T value) {
     OnPreParameterChange.Broadcast(parameter, value);
 
     parameter_value->second.value = value;
+    if (SRenderSettings::Contains(parameter)) RefreshRenderSettings();
 
     // Initiate events for changed parameter
     OnParameterChanged.Broadcast(parameter);
@@ -118,6 +120,9 @@ void CSettingsStore::SetStringParameter(Parameter parameter, const std::string s
 
 template <typename T>
 const T& CSettingsStore::GetParameter(Parameter parameter) const {
+#ifndef NDEBUG
+    m_iLookups.fetch_add(1, std::memory_order_relaxed);
+#endif
     auto p = parameters_.find(parameter);
     // Parameter must exist in the table. A type mismatch (e.g. caller asks
     // for a string on a bool parameter) is a recoverable condition —
@@ -127,6 +132,14 @@ const T& CSettingsStore::GetParameter(Parameter parameter) const {
     return std::get<T>(p->second.value);
 }
 
+long long CSettingsStore::GetLookupCount() const {
+#ifndef NDEBUG
+    return static_cast<long long>(m_iLookups.load(std::memory_order_relaxed));
+#else
+    return -1;
+#endif
+}
+
 bool CSettingsStore::GetBoolParameter(Parameter parameter) const {
     return GetParameter<bool>(parameter);
 }
@@ -145,6 +158,37 @@ void CSettingsStore::ResetParameter(Parameter parameter) {
     DASHER_ASSERT(current_parameter != parameters_.end() && default_parameter != Settings::parameter_defaults.end());
 
     current_parameter->second.value = default_parameter->second.value;
+    if (SRenderSettings::Contains(parameter)) RefreshRenderSettings();
+}
+
+void CSettingsStore::RefreshRenderSettings() {
+    // Read the map directly: these are not lookups made while drawing
+    auto get = [this](Parameter parameter, auto fallback) {
+        auto p = parameters_.find(parameter);
+        return p == parameters_.end() ? fallback : std::get<decltype(fallback)>(p->second.value);
+    };
+    SRenderSettings& s = m_renderSettings;
+    s.iShapeType = static_cast<int32_t>(get(LP_SHAPE_TYPE, 0L));
+    s.iOutlineWidth = static_cast<int32_t>(get(LP_OUTLINE_WIDTH, 0L));
+    s.iTextPadding = static_cast<int32_t>(get(LP_TEXT_PADDING, 0L));
+    s.iFontSize = static_cast<int32_t>(get(LP_DASHER_FONTSIZE, 0L));
+    s.iMinNodeSize = static_cast<int32_t>(get(LP_MIN_NODE_SIZE, 0L));
+    s.iNonlinearX = static_cast<int32_t>(get(LP_NONLINEAR_X, 0L));
+    s.iGeometry = static_cast<int32_t>(get(LP_GEOMETRY, 0L));
+    s.iUniform = static_cast<int32_t>(get(LP_UNIFORM, 0L));
+    s.iXLimitSpeed = static_cast<int32_t>(get(LP_X_LIMIT_SPEED, 0L));
+    s.iSlowStartTime = static_cast<int32_t>(get(LP_SLOW_START_TIME, 0L));
+    s.iLineWidth = static_cast<int32_t>(get(LP_LINE_WIDTH, 0L));
+    s.iTargetOffset = static_cast<int32_t>(get(LP_TARGET_OFFSET, 0L));
+    s.bNonlinearY = get(BP_NONLINEAR_Y, false);
+    s.bSimulateTransparency = get(BP_SIMULATE_TRANSPARENCY, false);
+    s.bExactDynamics = get(BP_EXACT_DYNAMICS, false);
+    s.bSlowStart = get(BP_SLOW_START, false);
+    s.bAutocalibrate = get(BP_AUTOCALIBRATE, false);
+    s.bDrawMouse = get(BP_DRAW_MOUSE, false);
+    s.bDrawMouseLine = get(BP_DRAW_MOUSE_LINE, false);
+    s.bCurveMouseLine = get(BP_CURVE_MOUSE_LINE, false);
+    s.bRemapXtreme = get(BP_REMAP_XTREME, false);
 }
 
 /* Private functions -- Settings are not saved between sessions unless these
@@ -8,12 +8,14 @@
 
 #pragma once
 
+#include <atomic>
 #include <string>
 #include <unordered_map>
 #include <variant>
 
 #include "Event.h"
 #include "Parameters.h"
+#include "RenderSettings.h"
 
 namespace Dasher {
 /// \ingroup Core
@@ -68,6 +70,15 @@ class CSettingsStore {
 
     virtual bool IsParameterSaved(const std::string& Key) { return false; }; // avoid undef sub-classes error
 
+    /// Current values of the settings read while drawing and moving (see
+    ///  SRenderSettings); reading these is not counted as a lookup.
+    const SRenderSettings& GetRenderSettings() const { return m_renderSettings; }
+
+    /// Number of parameter values looked up (by Get*Parameter) so far; for profiling, so
+    ///  only counted in debug builds of the core (-1 otherwise), keeping the lookup itself
+    ///  free of atomics. Defined out of line so callers need not be built the same way.
+    long long GetLookupCount() const;
+
   protected:
     /// Loads all (persistent) prefs from disk, using+storing default values when no
     ///  existing value stored; non-persistent prefs are reinitialized from defaults.
@@ -117,6 +128,12 @@ class CSettingsStore {
     //! \param Value Value of the setting, UTF8 encoded
     virtual void SaveSetting(const std::string& Key, const std::string& Value);
 
+    /// Copy the current values of the render settings into m_renderSettings
+    void RefreshRenderSettings();
+
     std::unordered_map<Parameter, Settings::Parameter_Value> parameters_;
+    SRenderSettings m_renderSettings{};
+    // Always present, so the class layout does not depend on NDEBUG; only incremented in debug builds.
+    mutable std::atomic<unsigned long long> m_iLookups{0};
 };
 } // namespace Dasher
@@ -0,0 +1,118 @@
+// SubtreeCache.cpp
+//
+// Keeps the children of collapsed nodes, to give back if they are expanded again.
+
+#include "SubtreeCache.h"
+
+#include "DasherNode.h"
+#include "DasherCore/Common/myassert.h"
+
+#include <algorithm>
+
+using namespace Dasher;
+
+CSubtreeCache::~CSubtreeCache() {
+    Clear();
+    while (SParkedChildren* pSet = m_pFree) {
+        m_pFree = pSet->pOlder;
+        delete pSet;
+    }
+}
+
+void CSubtreeCache::SetCapacity(std::size_t iBytes) {
+    m_iCapacity = iBytes;
+    Evict();
+}
+
+void CSubtreeCache::Collapse(CDasherNode* pNode) {
+    if (!m_iCapacity || !pNode->ChildCount() || pNode->GetFlag(CDasherNode::NF_SEEN)) {
+        if (pNode->ChildCount()) pNode->SetFlag(CDasherNode::NF_COLLAPSED, true);
+        pNode->DeleteChildren();
+        return;
+    }
+    Park(pNode);
+    Evict();
+}
+
+void CSubtreeCache::Park(CDasherNode* pNode) {
+    std::size_t iBytes =
+        sizeof(SParkedChildren) + pNode->m_iChildCapacity * (sizeof(CDasherNode*) + sizeof(unsigned int));
+    for (CDasherNode* pChild : pNode->GetChildren()) {
+        if (pChild->ChildCount()) Park(pChild);
+        // (nodes from the heap, such as roots, record no size)
+        iBytes += std::max(CNodePool::SizeOf(dynamic_cast<const void*>(pChild)), sizeof(CDasherNode));
+    }
+    SParkedChildren* pSet = NewSet();
+    *pSet = {this, pNode, pNode->m_ppChildren, pNode->m_iChildCount, pNode->m_iChildCapacity, iBytes, nullptr,
+             m_pNewest};
+    (m_pNewest ? m_pNewest->pNewer : m_pOldest) = pSet;
+    m_pNewest = pSet;
+    m_iNodes += pSet->iCount;
+    m_iBytes += iBytes;
+
+    pNode->m_ppChildren = nullptr;
+    pNode->m_iChildCount = pNode->m_iChildCapacity = 0;
+    pNode->m_pParked = pSet;
+    pNode->onlyChildRendered = nullptr;
+    pNode->SetFlag(CDasherNode::NF_ALLCHILDREN, false);
+    pNode->SetFlag(CDasherNode::NF_COLLAPSED, true);
+}
+
+bool CSubtreeCache::Revive(CDasherNode* pNode) {
+    SParkedChildren* pSet = pNode->m_pParked;
+    if (!pSet) {
+        if (m_iCapacity && pNode->GetFlag(CDasherNode::NF_COLLAPSED)) m_iMisses++;
+        return false;
+    }
+    DASHER_ASSERT(!pNode->m_ppChildren);
+    Unlink(pSet);
+    pNode->m_ppChildren = pSet->ppChildren;
+    pNode->m_iChildCount = pSet->iCount;
+    pNode->m_iChildCapacity = pSet->iCapacity;
+    pNode->m_pParked = nullptr;
+    FreeSet(pSet);
+    pNode->SetFlag(CDasherNode::NF_ALLCHILDREN, true);
+    m_iHits++;
+    return true;
+}
+
+void CSubtreeCache::Clear() {
+    while (m_pOldest)
+        Delete(m_pOldest);
+}
+
+void CSubtreeCache::Unlink(SParkedChildren* pSet) {
+    (pSet->pNewer ? pSet->pNewer->pOlder : m_pNewest) = pSet->pOlder;
+    (pSet->pOlder ? pSet->pOlder->pNewer : m_pOldest) = pSet->pNewer;
+    m_iNodes -= pSet->iCount;
+    m_iBytes -= pSet->iBytes;
+}
+
+void CSubtreeCache::Delete(SParkedChildren* pSet) {
+    Unlink(pSet);
+    pSet->pParent->m_pParked = nullptr;
+    // (each deletes any set parked for it in turn)
+    for (unsigned int i = 0; i < pSet->iCount; i++)
+        delete pSet->ppChildren[i];
+    ::operator delete(pSet->ppChildren);
+    FreeSet(pSet);
+}
+
+void CSubtreeCache::Evict() {
+    while (m_iBytes > m_iCapacity && m_pOldest) {
+        Delete(m_pOldest);
+        m_iEvicted++;
+    }
+}
+
+SParkedChildren* CSubtreeCache::NewSet() {
+    SParkedChildren* pSet = m_pFree;
+    if (!pSet) return new SParkedChildren;
+    m_pFree = pSet->pOlder;
+    return pSet;
+}
+
+void CSubtreeCache::FreeSet(SParkedChildren* pSet) {
+    pSet->pOlder = m_pFree;
+    m_pFree = pSet;
+}
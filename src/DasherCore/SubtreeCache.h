@@ -0,0 +1,107 @@
+// SubtreeCache.h
+//
+// Keeps the children of collapsed nodes, to give back if they are expanded again.
+
+#pragma once
+
+#include "Common/NoClones.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Dasher {
+class CDasherNode;
+class CSubtreeCache;
+
+/// The children of a collapsed node, parked in a CSubtreeCache
+struct SParkedChildren {
+    CSubtreeCache* pCache;
+    CDasherNode* pParent;
+    /// The parent's array of children (and their Hbnds), as it was when collapsed
+    CDasherNode** ppChildren;
+    unsigned int iCount, iCapacity;
+    /// What the children and their array take (not counting their own parked children)
+    std::size_t iBytes;
+    /// Neighbours in the cache's list, most recently parked first (or, once
+    ///  recycled, the next in its free list: pOlder)
+    SParkedChildren *pNewer, *pOlder;
+};
+
+/// \ingroup Model
+/// @{
+
+/// Keeps what collapsing a node would delete - its children, with their language model
+/// contexts and probabilities, and theirs, and so on down (each node's children parked
+/// as a set of their own) - so that expanding it again, as when the user reverses back
+/// over what they just zoomed away from, gives them back rather than creating them anew.
+/// Sets are evicted, least recently parked first, to keep under a number of bytes (as
+/// judged by the node pool's size classes, and the arrays of children: not counting
+/// what the node managers or language model hold for them).
+///
+/// A set is keyed by the node it was collapsed from, so is only given back to that very
+/// node: it is deleted with it, and the node keeps all the state its children were created
+/// from (its context and probabilities), so they are the same children expanding it would
+/// create - apart from anything that has changed meanwhile without the tree being rebuilt,
+/// which the children of a node never collapsed would not see either.
+///
+/// Only nodes not yet output are parked (so neither are their descendants); others are
+/// collapsed by deleting their children, as is everything if the capacity is 0.
+class CSubtreeCache : private NoClones {
+  public:
+    CSubtreeCache() = default;
+    /// Deletes everything parked, and the sets kept for reuse
+    ~CSubtreeCache();
+
+    /// Sets how many bytes of nodes to keep parked, evicting sets to fit (0 parks nothing)
+    void SetCapacity(std::size_t iBytes);
+    std::size_t GetCapacity() const { return m_iCapacity; }
+
+    /// Collapses pNode: deletes its children, or parks them and their descendants
+    void Collapse(CDasherNode* pNode);
+
+    /// Gives pNode back the children parked for it, if any, returning true (a hit); else
+    ///  returns false, counting a miss if it has been collapsed since it was last expanded.
+    ///  Does not broadcast anything: the caller finishes expanding it.
+    bool Revive(CDasherNode* pNode);
+
+    /// Deletes every set parked
+    void Clear();
+
+    /// Deletes a set, when the node it was parked for is deleted (by ~CDasherNode)
+    static void Discard(SParkedChildren* pSet) { pSet->pCache->Delete(pSet); }
+
+    /// Nodes re-expanded with the children parked for them, and re-expanded anew
+    uint64_t GetHits() const { return m_iHits; }
+    uint64_t GetMisses() const { return m_iMisses; }
+    /// Sets deleted to keep within capacity
+    uint64_t GetEvicted() const { return m_iEvicted; }
+    /// Nodes parked now, and the bytes they take
+    std::size_t GetNodeCount() const { return m_iNodes; }
+    std::size_t GetBytes() const { return m_iBytes; }
+
+  private:
+    /// Parks the children of pNode, after their own children
+    void Park(CDasherNode* pNode);
+    /// Takes a set out of the list and the counts
+    void Unlink(SParkedChildren* pSet);
+    /// Deletes a set, and its children
+    void Delete(SParkedChildren* pSet);
+    /// Deletes the least recently parked sets until within capacity
+    void Evict();
+    /// A set from the free list, or the heap if it is empty
+    SParkedChildren* NewSet();
+    /// Puts a set on the free list
+    void FreeSet(SParkedChildren* pSet);
+
+    std::size_t m_iCapacity = 0;
+    /// Ends of the list of sets, most recently parked first
+    SParkedChildren *m_pNewest = nullptr, *m_pOldest = nullptr;
+    /// Sets no longer parked, kept for the next collapse (as many as were ever parked at once)
+    SParkedChildren* m_pFree = nullptr;
+    std::size_t m_iNodes = 0, m_iBytes = 0;
+    uint64_t m_iHits = 0, m_iMisses = 0, m_iEvicted = 0;
+};
+
+/// @}
+
+} // namespace Dasher
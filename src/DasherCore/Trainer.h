@@ -48,9 +48,9 @@ class CTrainer : public AbstractParser {
     const CAlphInfo* const m_pInfo;
     // symbol number in alphabet of the context-switch character (maybe 0 if not in alphabet!)
     int m_iCtxEsc;
+    ProgressIndicator* m_pProg;
 
   private:
-    ProgressIndicator* m_pProg;
     std::string m_strDesc;
 };
 
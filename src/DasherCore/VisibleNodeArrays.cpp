@@ -0,0 +1,71 @@
+// VisibleNodeArrays.cpp
+//
+// The nodes drawn in each frame, as parallel arrays, double-buffered for another thread to read.
+
+#include "VisibleNodeArrays.h"
+
+using namespace Dasher;
+
+void SVisibleNodeArrays::clear() {
+    vY1.clear();
+    vY2.clear();
+    vDepth.clear();
+    vScreenX1.clear();
+    vScreenY1.clear();
+    vScreenX2.clear();
+    vScreenY2.clear();
+    vFill.clear();
+    vOutline.clear();
+    vSymbol.clear();
+    vFlags.clear();
+    vLabelId.clear();
+}
+
+SVisibleNodeArrays& CVisibleNodeArrays::BeginFrame() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_bPending) {
+        // (the frame finished while the reader held the last is overwritten unseen)
+        m_bPending = false;
+        m_iDropped++;
+    }
+    SVisibleNodeArrays& arrays = m_arrays[1 - m_iFront];
+    arrays.clear();
+    return arrays;
+}
+
+void CVisibleNodeArrays::EndFrame() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_arrays[1 - m_iFront].iFrame = ++m_iFrames;
+    if (m_bHeld)
+        m_bPending = true;
+    else
+        m_iFront = 1 - m_iFront;
+}
+
+const SVisibleNodeArrays* CVisibleNodeArrays::Acquire() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_bHeld || !m_arrays[m_iFront].iFrame) return nullptr;
+    m_bHeld = true;
+    return &m_arrays[m_iFront];
+}
+
+bool CVisibleNodeArrays::Release() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_bHeld) return false;
+    m_bHeld = false;
+    if (m_bPending) {
+        m_bPending = false;
+        m_iFront = 1 - m_iFront;
+    }
+    return true;
+}
+
+uint64_t CVisibleNodeArrays::GetFrameCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_iFrames;
+}
+
+uint64_t CVisibleNodeArrays::GetDroppedCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_iDropped;
+}
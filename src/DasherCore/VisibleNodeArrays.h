@@ -0,0 +1,86 @@
+// VisibleNodeArrays.h
+//
+// The nodes drawn in each frame, as parallel arrays, double-buffered for another thread to read.
+
+#pragma once
+
+#include "Common/NoClones.h"
+#include "DasherTypes.h"
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace Dasher {
+
+/// \ingroup View
+/// @{
+
+/// The nodes drawn in one frame, in the order drawn (parents before their children), as
+/// parallel arrays: element i of each is about the i'th node. Everything is resolved when
+/// the node is drawn - colours to ARGB, labels to the screen's ids for them - so nothing
+/// here refers to the node itself, which may be deleted before the arrays are read.
+struct SVisibleNodeArrays {
+    enum : int { HAS_CHILDREN = 1, GAME = 2 };
+
+    /// Which frame this was: the number of frames captured before it, plus one
+    uint64_t iFrame = 0;
+    /// Each node's Dasher-Y range
+    std::vector<myint> vY1, vY2;
+    /// Depth from the root rendered (the extrusion level, in cube mode)
+    std::vector<int> vDepth;
+    /// Clipped screen bounds, as the Strand 1 filled rectangle
+    std::vector<int> vScreenX1, vScreenY1, vScreenX2, vScreenY2;
+    std::vector<int32_t> vFill, vOutline;
+    /// Alphabet symbol (-1 for groups and control nodes)
+    std::vector<int> vSymbol;
+    /// HAS_CHILDREN and GAME
+    std::vector<int> vFlags;
+    /// The screen's id for the node's label (-1 if none; see CDasherScreen::GetLabelId)
+    std::vector<int> vLabelId;
+
+    std::size_t size() const { return vY1.size(); }
+    /// Empties every array, keeping what they have allocated
+    void clear();
+};
+
+/// Two SVisibleNodeArrays, one filled by the view as it renders a frame while the other,
+/// with the last frame published, may be held by another thread, between Acquire() and
+/// Release(), to read. A frame finished while the other is held is published on its
+/// release, unless the view has started on the next by then: so a reader holding the
+/// arrays for longer than a frame misses frames, but never sees one half written, and
+/// the view never waits for it.
+class CVisibleNodeArrays : private NoClones {
+  public:
+    CVisibleNodeArrays() = default;
+
+    /// The arrays to fill, emptied (on the view's thread, at the start of Render)
+    SVisibleNodeArrays& BeginFrame();
+    /// Publishes the arrays filled, or has Release() publish them if held
+    void EndFrame();
+
+    /// Holds the arrays last published, until Release(); nullptr if there are none yet, or
+    ///  they are held already (one reader at a time). Any thread.
+    const SVisibleNodeArrays* Acquire();
+    /// Lets the view reuse the arrays held, publishing any finished meanwhile; false if
+    ///  none were held. Any thread.
+    bool Release();
+
+    /// Frames captured, and those never published (overwritten while the other was held)
+    uint64_t GetFrameCount() const;
+    uint64_t GetDroppedCount() const;
+
+  private:
+    SVisibleNodeArrays m_arrays[2];
+    mutable std::mutex m_mutex;
+    /// The arrays published (the other is the view's); all below under m_mutex
+    int m_iFront = 0;
+    bool m_bHeld = false;
+    /// The view's arrays are finished, but not published as the front ones are held
+    bool m_bPending = false;
+    uint64_t m_iFrames = 0, m_iDropped = 0;
+};
+
+/// @}
+
+} // namespace Dasher
@@ -18,7 +18,8 @@ XmlSettingsStore::XmlSettingsStore(const std::string& filename, CMessageDisplay*
     : AbstractXMLParser(pDisplay), last_mutable_filepath(filename) {}
 
 void XmlSettingsStore::Load() {
-    Dasher::FileUtils::ScanFiles(this, last_mutable_filepath);
+    // (a path, so looked up in no session's directories)
+    FileUtils().ScanFiles(this, last_mutable_filepath);
     // Load all the settings or create defaults for the ones that don't exist.
     // The superclass 'ParseFile' saves default settings if not found.
     mode_ = EXPLICIT_SAVE;
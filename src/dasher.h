@@ -19,7 +19,16 @@
 //   }
 //   dasher_destroy(ctx);
 //
-// Thread safety: a dasher_ctx is NOT thread-safe. One thread per context.
+// Thread safety: a dasher_ctx is NOT thread-safe: call its functions from one
+// thread at a time (except as documented, e.g. the visible node arrays). But
+// contexts share no state on the frame path, so each may be created, driven
+// and destroyed on a thread of its own, any number at once. What they do share
+// is safe to use from any thread: the file index (dasher_invalidate_file_index),
+// the locale dasher_get_parameter_info localizes with (that of whichever
+// context last set its own), and the parameter schema and language model
+// list. Language models must be registered (LMRegistry::registerLM) before any
+// context is created. Strings returned by functions taking no context are
+// valid until the next call of the same function on the same thread.
 
 #include <stdint.h>
 
@@ -41,7 +50,8 @@ typedef struct dasher_ctx dasher_ctx;
 //   Must be readable. On mobile platforms this is the app bundle's read-only data.
 // user_dir: writable directory for settings and user data. If NULL, data_dir is used.
 // out_error: if not NULL, set to a human-readable error string on failure.
-//   Caller must NOT free the string. Valid until next API call.
+//   Caller must NOT free the string. Valid until the next failed dasher_create on
+//   the same thread.
 // Returns NULL on failure.
 DASHER_API dasher_ctx* dasher_create(const char* data_dir, const char* user_dir, char** out_error);
 
@@ -88,7 +98,8 @@ DASHER_API void dasher_key_event(dasher_ctx* ctx, int key, int pressed);
 //   5: Text                  — a=x, b=y, c=fontSize, d=stringIndex, argb
 //   6: Set line width        — a=lineWidth (applies to subsequent opcode 2 lines)
 //
-// For opcode 5, d is an index into the strings array.
+// For opcode 5, d is an index into the strings array (or a label id, with
+// dasher_set_label_ids_enabled).
 //
 // LP_SHAPE_TYPE == CUBE (6) renders through the same opcode-3/4/5 commands:
 // each cube face is an opcode-4 filled rectangle (with an opcode-3 outline when
@@ -100,6 +111,70 @@ DASHER_API void dasher_key_event(dasher_ctx* ctx, int key, int pressed);
 DASHER_API void dasher_frame(dasher_ctx* ctx, int64_t time_ms, int** out_commands, int* out_command_count,
                              char*** out_strings, int* out_string_count);
 
+// Opt-in delta frames, e.g. for a frontend that ships each frame elsewhere:
+// once enabled, dasher_frame gives only the changes to the commands of the
+// previous frame, as ops of varying length, each starting with its op number:
+//
+//   0: Reset   [0, n, then n commands of 6 ints]
+//              — forget all commands; these n, with ids 0 to n - 1, are the frame
+//   1: Insert  [1, id, prev, opcode, a, b, c, d, argb]
+//              — add command id, drawn just after command prev (-1: first)
+//   2: Update  [2, id, opcode, a, b, c, d, argb]
+//              — command id becomes this command; it stays in place
+//   3: Remove  [3, id] — command id is no longer drawn
+//
+// Commands are as above (for text, d indexes the strings returned with the
+// ops, which are only those the ops use). Draw the commands kept in order. A
+// command's id stays the same while the node it was drawn for stays on screen,
+// until the next reset (the same id may be used again after a remove or a
+// reset). Frames in which nothing changed give no ops at all - and when
+// nothing moved, the nodes are not even redrawn. The first frame, the first
+// after a resize, and any frame for which the other ops would be longer (e.g.
+// zooming) are a reset alone.
+// out_command_count counts ints, as for full frames.
+// Returns 0 on success, -1 if ctx is NULL or not realised.
+DASHER_API int dasher_set_delta_frames_enabled(dasher_ctx* ctx, int enabled);
+
+// Get the whole of the last frame, as dasher_frame gives it without delta
+// frames - e.g. for a remote display that joins part way through. Valid until
+// the next dasher_frame() call. Returns 0 on success, -1 if not realised.
+DASHER_API int dasher_get_full_frame(dasher_ctx* ctx, int** out_commands, int* out_command_count,
+                                     char*** out_strings, int* out_string_count);
+
+// Get the whole of the last frame in another encoding, e.g. to send it over a
+// network. Encoding 1 is compact (version 1), with the same commands and
+// strings as dasher_get_full_frame, in a third to a quarter of the bytes. All
+// values are little-endian; a varint is LEB128, a signed one zigzag-encoded:
+//
+//   u8      version (1)
+//   varint  colour count, then that many u32 argb colours
+//   varint  command count, then the commands, in runs of each:
+//     u8      tag: bits 0-2 opcode; bit 3 set if a colour follows (else the
+//             previous run's colour); bits 4-7 the run's length - 1
+//     varint  colour, an index into the colours (if bit 3 set)
+//     then for each command of the run (all with that opcode and colour):
+//     signed varints a, b, c, d - for opcodes 2, 3 and 4, c - a and d - b
+//
+// Valid until the next dasher_frame() call. Returns 0 on success, -1 if ctx
+// is NULL or not realised, or the encoding is unknown.
+DASHER_API int dasher_get_encoded_frame(dasher_ctx* ctx, int encoding, const uint8_t** out_bytes,
+                                        int* out_byte_count);
+
+// Label ids: once enabled, d in each text command (opcode 5) is a label id, an
+// index into the label table, instead of an index into the strings array -
+// and the strings array stays empty, so no text is copied per frame. Works
+// with or without delta frames. Returns 0 on success, -1 if not realised.
+DASHER_API int dasher_set_label_ids_enabled(dasher_ctx* ctx, int enabled);
+
+// Get the label table: the UTF-8 text of every label, by id (NULL for labels
+// since deleted; a deleted label's id is given to a new label from the second
+// frame after at the earliest). The table only changes when labels are made or
+// deleted - e.g. on changing alphabet, or for a new message - so fetch it again
+// only when the returned version differs from the last seen. Valid until the
+// next dasher_frame() or dasher_get_label_table() call.
+// Returns the table's version (>= 0), or -1 if ctx is NULL or not realised.
+DASHER_API long long dasher_get_label_table(dasher_ctx* ctx, char*** out_labels, int* out_label_count);
+
 // Engine fault flag. Returns 1 if a C++ exception was caught at the boundary
 // of dasher_frame / dasher_mouse_* / dasher_key_event, leaving the engine in
 // an indeterminate state; 0 otherwise. When true, those per-frame entry points
@@ -203,13 +278,16 @@ DASHER_API int dasher_get_parameter_count(void);
 
 // Fill out info for the parameter at the given index (0..count-1).
 // Returns 0 on success, -1 if index out of range.
+// Taking no context, name and desc are localized with the process default:
+// the locale and string overrides of whichever context last changed its own
+// (see dasher_set_locale), or the built-in English before any has.
 DASHER_API int dasher_get_parameter_info(int index, dasher_parameter_info* out);
 
 // Get the number of enum values for a parameter (only valid for enum-type).
 DASHER_API int dasher_get_parameter_enum_count(int key);
 
 // Get the display name and integer value for an enum entry.
-// name pointer is valid until the next API call.
+// name pointer is valid for the life of the process.
 DASHER_API const char* dasher_get_parameter_enum_name(int key, int index);
 DASHER_API int dasher_get_parameter_enum_value(int key, int index);
 
@@ -332,6 +410,14 @@ DASHER_API void dasher_save_settings(dasher_ctx* ctx);
 // appearance_settings.xml separately before calling.
 DASHER_API void dasher_reset_settings(dasher_ctx* ctx);
 
+// Tell Dasher that files under data_dir or user_dir may have changed (e.g. the
+// frontend has installed new alphabets or training text). Dasher finds its files
+// through an index of both directories, kept for the whole process (and persisted
+// in user_dir); after this call, the next lookup re-lists every directory that
+// has been modified. Affects lookups made after the call, e.g. by contexts
+// created or alphabets selected later.
+DASHER_API void dasher_invalidate_file_index(void);
+
 // ── Output callbacks ───────────────────────────────────────────────────────
 //
 // Register a callback to receive output/delete events in real time.
@@ -401,6 +487,47 @@ typedef void (*dasher_speak_callback)(const char* text, int interrupt, void* use
 
 DASHER_API void dasher_set_speak_callback(dasher_ctx* ctx, dasher_speak_callback callback, void* user_data);
 
+// ── Text measuring callback ──────────────────────────────────────────────────
+//
+// Register a callback that measures text as the frontend will draw it, so
+// labels are laid out (e.g. pushed clear of their parents' labels) by their
+// real size. Without one, text is estimated at half the font size per
+// character.
+//
+// Set out_width / out_height to the size of text drawn at font_size. If
+// wrap_width > 0 the text is a message, wrapped to fit that width: give the
+// size of the wrapped block.
+//
+// Each label is measured once per font size bucket (sizes below 16 exactly,
+// above that at eight steps per octave, scaled in between) and the result
+// cached, so steady-state frames do not call back at all. Changing
+// SP_DASHER_FONT or the screen size clears the cache; call
+// dasher_invalidate_text_metrics when the frontend's fonts change in any
+// other way. The callback fires on the thread that calls dasher_frame().
+
+typedef void (*dasher_text_measure_callback)(const char* text, int font_size, int wrap_width, int* out_width,
+                                             int* out_height, void* user_data);
+
+DASHER_API void dasher_set_text_measure_callback(dasher_ctx* ctx, dasher_text_measure_callback callback,
+                                                 void* user_data);
+
+// Forget all text measured (the fonts changed); the next frame measures again.
+DASHER_API void dasher_invalidate_text_metrics(dasher_ctx* ctx);
+
+// Text measuring cache statistics: sizes served from the cache, and sizes
+// measured by calling back. Returns 0 on success, -1 if there is no screen yet.
+DASHER_API int dasher_get_text_metrics_stats(dasher_ctx* ctx, long long* out_hits, long long* out_misses);
+
+// ── Render statistics ───────────────────────────────────────────────────────
+//
+// Counts from the last frame drawn: nodes visited (whose extent on screen was
+// worked out), nodes drawn, and children skipped. Each node keeps its
+// children's bounds in one sorted array, so children wholly above the screen
+// are found by binary search and skipped without being visited; with large
+// alphabets (Mandarin, Japanese) most children are offscreen. Any pointer may
+// be NULL. Returns 0 on success, -1 if ctx is null / not realised.
+DASHER_API int dasher_get_render_stats(dasher_ctx* ctx, int* out_visited, int* out_drawn, int* out_skipped);
+
 // ── Clipboard callback ───────────────────────────────────────────────────────
 //
 // Register a callback for DasherCore's clipboard features.
@@ -438,6 +565,8 @@ DASHER_API void dasher_set_parameter_callback(dasher_ctx* ctx, dasher_parameter_
 // ── Localization ──────────────────────────────────────────────────────────
 
 // Set the active locale for parameter names, descriptions, and enum labels.
+// Each context has its own locale and string overrides; the context-less
+// dasher_get_parameter_info uses those of the context that last changed them.
 // Looks for strings_{locale}.json in the data_dir/Strings/ directory.
 // Pass NULL or "en" to reset to English (built-in defaults).
 // Returns 0 on success, -1 if locale file not found.
@@ -535,6 +664,54 @@ DASHER_API int dasher_get_alphabet_symbol_image(dasher_ctx* ctx, int index, char
 // Returns 0 on success, -1 on failure.
 DASHER_API int dasher_import_training_text(dasher_ctx* ctx, const char* text);
 
+// Get the progress of language model training running in the background
+// (BP_BACKGROUND_TRAINING), as a percentage (0-100) of the training text read.
+// Returns -1 if the model is not being trained. While training, dasher_frame
+// draws a progress message instead of the nodes; the first dasher_frame after
+// training finishes swaps in the trained model, after which this returns -1.
+DASHER_API int dasher_get_training_progress(dasher_ctx* ctx);
+
+// Get how often the probabilities for a node's children were found already
+// computed for a context in the same state (hits) or had to be asked of the
+// language model (misses) - e.g. when zooming back and forth - for profiling.
+// Counts run from when the alphabet was loaded. Returns 0 on success, -1 if not realized.
+DASHER_API int dasher_get_prob_cache_stats(dasher_ctx* ctx, long long* out_hits, long long* out_misses);
+
+// Get the counts of the node pool, from which the nodes created as others are
+// expanded take their memory: nodes alive, nodes freed and waiting to be reused,
+// and nodes allocated and freed since the model was created, for profiling.
+// Returns 0 on success, -1 if not realized.
+DASHER_API int dasher_get_node_pool_stats(dasher_ctx* ctx, long long* out_live, long long* out_free,
+                                          long long* out_allocated, long long* out_freed);
+
+// Get the counts of the subtree cache (LP_SUBTREE_CACHE, in KB; default 0 = off),
+// which keeps the children of collapsed nodes to give back if those nodes are
+// expanded again: nodes re-expanded with their parked children (hits), and
+// re-expanded anew (misses), sets of children evicted to keep within the cache's
+// size, and the bytes parked now, for profiling.
+// Returns 0 on success, -1 if not realized.
+DASHER_API int dasher_get_subtree_cache_stats(dasher_ctx* ctx, long long* out_hits, long long* out_misses,
+                                              long long* out_evicted, long long* out_bytes);
+
+// Get how many nodes the expansion policy has expanded after drawing each frame,
+// and the microseconds it spent doing so - at most LP_EXPANSION_TIME a frame, if
+// set, as near as it can tell beforehand - since the context was created, for
+// profiling. Returns 0 on success, -1 if not realized.
+DASHER_API int dasher_get_expansion_time_stats(dasher_ctx* ctx, long long* out_expanded,
+                                               long long* out_microseconds);
+
+// Get how many nodes have been expanded as they came to cover the crosshair,
+// mid-render (forced), and how many were expanded ahead of the crosshair, on
+// its predicted path (LP_LOOKAHEAD_FRAMES), since the context was created, for
+// profiling. Returns 0 on success, -1 if not realized.
+DASHER_API int dasher_get_lookahead_stats(dasher_ctx* ctx, long long* out_forced, long long* out_ahead);
+
+// Get how many times a setting's value has been looked up in the settings
+// store since the context was created - per frame, a measure of the settings
+// traffic in the render and movement loops - for profiling. Only counted in debug
+// builds (without NDEBUG): returns -1 in others, and if ctx is NULL.
+DASHER_API long long dasher_get_settings_lookup_count(dasher_ctx* ctx);
+
 // Get the current Dasher offset (character position in the output).
 // Returns -1 if the engine is not realized.
 DASHER_API int dasher_get_offset(dasher_ctx* ctx);
@@ -622,6 +799,58 @@ DASHER_API int dasher_get_visible_nodes(dasher_ctx* ctx, dasher_node_info* out_n
 // Query viewport state. Returns 0 on success, -1 on error.
 DASHER_API int dasher_get_viewport(dasher_ctx* ctx, dasher_viewport* out);
 
+// The same nodes as parallel arrays, read in place: each frame writes them once,
+// as it draws, into one of two buffers, while a renderer thread may hold the
+// other (the last frame finished) for as long as it takes to draw it - nothing
+// is converted or copied per query, and the engine never waits for the reader.
+// Element i of each array is about the i'th node, in the order drawn (parent
+// before children), as dasher_get_visible_nodes().
+typedef struct dasher_node_arrays {
+    int struct_size;             // caller sets to sizeof(dasher_node_arrays)
+    int count;                   // nodes (the length of each array)
+    long long frame;             // frames recorded up to and including this one (1, 2, ...)
+    const int64_t* dasher_y1;    // nodes' Dasher-Y ranges
+    const int64_t* dasher_y2;
+    const int* depth;            // tree depth from the rendered root (0 = root)
+    const int* screen_x1;        // nodes' clipped screen bounds
+    const int* screen_y1;
+    const int* screen_x2;
+    const int* screen_y2;
+    const int32_t* fill_argb;    // fill colours (from active palette)
+    const int32_t* outline_argb; // outline colours
+    const int* symbol;           // alphabet symbol index (-1 for group/control nodes)
+    const int* flags;            // 1 = has children, 2 = on the game-mode path
+    const int* label_id;         // label id, as in dasher_get_label_table() (-1 if no label)
+} dasher_node_arrays;
+
+// Enable/disable recording the arrays each frame. Default off; independent of
+// dasher_set_visible_nodes_enabled(). Returns 0, or -1 if ctx is null / not
+// realised.
+DASHER_API int dasher_set_visible_node_arrays_enabled(dasher_ctx* ctx, int enabled);
+
+// Hold the arrays of the last frame finished, filling *out with pointers into
+// them, valid until dasher_release_visible_node_arrays() - frames finished
+// meanwhile are recorded into the other buffer (and all but the last dropped).
+// Returns the node count, or -1 if no frame has been recorded yet, the arrays
+// are already held, out->struct_size is too small, or ctx is null / not
+// realised.
+//
+// Unlike the rest of the API, acquire and release may be called from a thread
+// other than the one calling dasher_frame() (one reader at a time), once the
+// context is realised and until it is destroyed. A label id is not reused until
+// the second frame after its label is deleted, so the reader can keep the text
+// of each, looked up with dasher_get_label_table() on the dasher_frame() thread
+// (again when its version changes), while it holds the last frame finished.
+DASHER_API int dasher_acquire_visible_node_arrays(dasher_ctx* ctx, dasher_node_arrays* out);
+
+// Let the engine reuse the arrays held. Returns 0, or -1 if none were held.
+DASHER_API int dasher_release_visible_node_arrays(dasher_ctx* ctx);
+
+// Frames recorded, and frames dropped (finished while the reader held the
+// last, and overwritten before it was released). 0 on success, -1 on error.
+DASHER_API int dasher_get_visible_node_arrays_stats(dasher_ctx* ctx, long long* out_frames,
+                                                    long long* out_dropped);
+
 #ifdef __cplusplus
 }
 #endif
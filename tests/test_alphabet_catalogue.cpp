@@ -0,0 +1,147 @@
+// Alphabet catalogue tests: at startup CAlphIO only catalogues the alphabet
+// files - reading the ID from each one's start tag, or from the cache it keeps
+// in the user dir - and parses an alphabet the first time it is asked for.
+// The catalogue must list exactly the alphabets parsing every file does, and
+// each must parse to the same alphabet. Also prints startup times for parsing
+// everything, cataloguing from cold, and cataloguing from the cache.
+//
+// Built via dasher_add_test_internal (drives CAlphIO and FileUtils directly).
+
+#include "test_common.h"
+
+#include "DasherCore/Alphabet/AlphIO.h"
+#include "DasherCore/FileUtils.h"
+
+#include <chrono>
+#include <vector>
+
+using namespace Dasher;
+
+namespace {
+
+CommandlineErrorDisplay g_msgs;
+
+std::vector<std::string> alphabets(CAlphIO& alphIO) {
+    std::vector<std::string> out;
+    alphIO.GetAlphabets(&out);
+    return out;
+}
+
+void write_alphabet(const std::filesystem::path& file, const std::string& id, bool bV5 = false) {
+    std::ofstream out(file);
+    out << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        << "<!-- <alphabet name=\"not this one\"> -->\n";
+    if (bV5) out << "<alphabets>\n";
+    out << "<alphabet name=\"" << id << "\" orientation=\"LR\">\n"
+        << "  <group name=\"letters\"><node text=\"a\"/><node text=\"b\"/></group>\n"
+        << "</alphabet>\n";
+    if (bV5) out << "</alphabets>\n";
+}
+
+} // namespace
+
+TEST_CASE("catalogue lists exactly the alphabets parsing every file does") {
+    ScopedTempDir userDir;
+    const FileUtils files(TEST_DATA_DIR, userDir.path);
+    const std::string cache = files.ResolveUserDataPath("alphabets.cache");
+
+    CAlphIO parsed(&g_msgs);
+    files.ScanFiles(&parsed, "alphabet.*.xml");
+    const std::vector<std::string> expected = alphabets(parsed);
+    REQUIRE(expected.size() > 100);
+
+    CAlphIO cold(&g_msgs);
+    cold.LoadCatalogue(files, cache);
+    CHECK(std::filesystem::exists(cache));
+    CHECK_EQ(alphabets(cold), expected);
+    CHECK_EQ(cold.GetDefault(), parsed.GetDefault());
+
+    CAlphIO warm(&g_msgs);
+    warm.LoadCatalogue(files, cache);
+    CHECK_EQ(alphabets(warm), expected);
+
+    // Every alphabet is parsed on demand from the file that parsing them all would keep
+    for (const std::string& id : expected) {
+        CAPTURE(id);
+        const CAlphInfo* pWant = parsed.GetInfo(id);
+        const CAlphInfo* pGot = warm.GetInfo(id);
+        REQUIRE(pGot);
+        CHECK_EQ(pGot->GetID(), pWant->GetID());
+        CHECK_EQ(pGot->GetTrainingFile(), pWant->GetTrainingFile());
+        CHECK_EQ(pGot->iEnd, pWant->iEnd);
+    }
+    CHECK_EQ(alphabets(warm), expected); // listing parsed alphabets once each, as before
+    CHECK_EQ(warm.GetInfo("no such alphabet"), warm.GetInfo(warm.GetDefault()));
+}
+
+TEST_CASE("catalogue follows changes to the alphabet files") {
+    ScopedTempDir dataDir, userDir;
+    const FileUtils files(dataDir.path, userDir.path);
+    const std::string cache = files.ResolveUserDataPath("alphabets.cache");
+    const std::filesystem::path data(dataDir.path);
+    write_alphabet(data / "alphabet.one.xml", "One");
+    write_alphabet(data / "alphabet.two.xml", "Two");
+    write_alphabet(data / "alphabet.legacy.xml", "Legacy", true);
+
+    auto catalogue = [&]() {
+        FileUtils::InvalidateFileIndex(); // as a frontend must, having installed files
+        CAlphIO alphIO(&g_msgs);
+        alphIO.LoadCatalogue(files, cache);
+        return alphabets(alphIO);
+    };
+    using List = std::vector<std::string>;
+    CHECK_EQ(catalogue(), List{"Default", "Legacy", "One", "Two"});
+
+    SUBCASE("renamed") {
+        write_alphabet(data / "alphabet.two.xml", "Second alphabet");
+        CHECK_EQ(catalogue(), List{"Default", "Legacy", "One", "Second alphabet"});
+    }
+    SUBCASE("added and removed") {
+        std::filesystem::remove(data / "alphabet.one.xml");
+        write_alphabet(data / "alphabet.three.xml", "Three");
+        CHECK_EQ(catalogue(), List{"Default", "Legacy", "Three", "Two"});
+    }
+    SUBCASE("v5 never overrides") {
+        write_alphabet(data / "alphabet.old.xml", "One", true);
+        CHECK_EQ(catalogue(), List{"Default", "Legacy", "One", "Two"});
+        CAlphIO alphIO(&g_msgs);
+        alphIO.LoadCatalogue(files, cache);
+        CHECK_EQ(alphIO.GetInfo("One")->iEnd, 3); // the v6 "One"
+    }
+    SUBCASE("corrupt cache") {
+        std::ofstream(cache) << "DasherAlphabetCatalogue 1\nrubbish\n1\t2\t6\t";
+        CHECK_EQ(catalogue(), List{"Default", "Legacy", "One", "Two"});
+    }
+    SUBCASE("not an alphabet") {
+        std::ofstream(data / "alphabet.broken.xml") << "<colours name=\"Broken\"/>";
+        CHECK_EQ(catalogue(), List{"Default", "Legacy", "One", "Two"});
+    }
+    CHECK_EQ(catalogue(), catalogue()); // and again from the cache just written
+}
+
+TEST_CASE("bench/alphabet startup: parse everything vs catalogue") {
+    ScopedTempDir userDir;
+    const FileUtils files(TEST_DATA_DIR, userDir.path);
+    const std::string cache = files.ResolveUserDataPath("alphabets.cache");
+
+    auto start = std::chrono::steady_clock::now();
+    CAlphIO parsed(&g_msgs);
+    files.ScanFiles(&parsed, "alphabet.*.xml");
+    const double parse = seconds_since(start);
+
+    start = std::chrono::steady_clock::now();
+    CAlphIO cold(&g_msgs);
+    cold.LoadCatalogue(files, cache);
+    const double coldSeconds = seconds_since(start);
+
+    start = std::chrono::steady_clock::now();
+    CAlphIO warm(&g_msgs);
+    warm.LoadCatalogue(files, cache);
+    const double warmSeconds = seconds_since(start);
+
+    printf("  %zu alphabets\n", alphabets(warm).size());
+    printf("  parse all files:    %.3fs\n", parse);
+    printf("  catalogue (cold):   %.3fs\n", coldSeconds);
+    printf("  catalogue (cached): %.3fs (x%.1f)\n", warmSeconds, parse / warmSeconds);
+    CHECK(warmSeconds < parse);
+}
@@ -0,0 +1,129 @@
+// Background training tests: with BP_BACKGROUND_TRAINING, the language model
+// trains on a worker thread. Frames keep coming (drawing the lock screen with
+// the training progress) instead of the host's render thread blocking, and the
+// trained model is swapped in between frames once training has finished.
+// Also checks how long those frames take against a 60Hz budget (bench/ case).
+#include "test_common.h"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace {
+
+dasher_ctx* create(const ScopedTempDir& dir, bool bBackground) {
+    dasher_ctx* ctx = dasher_create(TEST_DATA_DIR, dir.c_str(), nullptr);
+    REQUIRE(ctx);
+    dasher_set_bool_parameter(ctx, dasher_find_parameter_key("BP_BACKGROUND_TRAINING"), bBackground);
+    dasher_set_screen_size(ctx, 800, 600);
+    return ctx;
+}
+
+bool frame_shows(dasher_ctx* ctx, int64_t time_ms, const std::string& text) {
+    int* cmds = nullptr;
+    int cmd_count = 0;
+    char** strs = nullptr;
+    int str_count = 0;
+    dasher_frame(ctx, time_ms, &cmds, &cmd_count, &strs, &str_count);
+    for (int i = 0; i < str_count; i++)
+        if (std::string(strs[i]).find(text) != std::string::npos) return true;
+    return false;
+}
+
+struct TrainingFrames {
+    int frames = 0, lockFrames = 0, lastProgress = 0;
+    double slowest = 0; // ms, of the frames drawn while training
+    int64_t time_ms = 1000;
+};
+
+// Draws frames at 60Hz until background training has finished
+TrainingFrames frames_while_training(dasher_ctx* ctx) {
+    TrainingFrames result;
+    const auto frame = std::chrono::milliseconds(16);
+    auto next = std::chrono::steady_clock::now();
+    while (dasher_get_training_progress(ctx) != -1) {
+        const int percent = dasher_get_training_progress(ctx);
+        CHECK(percent >= result.lastProgress);
+        result.lastProgress = percent;
+
+        const auto start = std::chrono::steady_clock::now();
+        if (frame_shows(ctx, result.time_ms += 16, "Training")) result.lockFrames++;
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        // The frame that swaps in the trained model rebuilds the tree, like an alphabet change
+        if (dasher_get_training_progress(ctx) != -1 && ms > result.slowest) result.slowest = ms;
+        result.frames++;
+
+        next += frame;
+        std::this_thread::sleep_until(next);
+    }
+    return result;
+}
+
+} // namespace
+
+TEST_CASE("background training keeps frames coming") {
+    ScopedTempDir dir, foregroundDir;
+
+    dasher_ctx* ctx = create(dir, true);
+    REQUIRE(dasher_get_training_progress(ctx) >= 0); // returned before training finished
+
+    TrainingFrames result = frames_while_training(ctx);
+    CHECK(result.frames >= 3);
+    CHECK_EQ(result.lockFrames, result.frames - 1); // all but the last drew the lock screen
+    CHECK(result.lastProgress > 0);
+    CHECK_FALSE(frame_shows(ctx, result.time_ms += 16, "Training"));
+
+    // The swapped-in model is exactly the one foreground training builds.
+    dasher_ctx* foreground = create(foregroundDir, false);
+    CHECK_EQ(dasher_get_training_progress(foreground), -1);
+    auto expected = probabilities(foreground);
+    REQUIRE(!expected.empty());
+    CHECK_EQ(probabilities(ctx), expected);
+
+    dasher_destroy(foreground);
+    dasher_destroy(ctx);
+}
+
+TEST_CASE("importing text waits for background training") {
+    ScopedTempDir dir, foregroundDir;
+    dasher_ctx* ctx = create(dir, true);
+    dasher_ctx* foreground = create(foregroundDir, false);
+
+    const char* text = "the quick brown fox jumps over the lazy dog. ";
+    REQUIRE_EQ(dasher_import_training_text(ctx, text), 0);
+    CHECK_EQ(dasher_get_training_progress(ctx), -1);
+    REQUIRE_EQ(dasher_import_training_text(foreground, text), 0);
+    run_frames(ctx, 2);
+    run_frames(foreground, 2);
+    CHECK_EQ(probabilities(ctx), probabilities(foreground));
+
+    dasher_destroy(foreground);
+    dasher_destroy(ctx);
+}
+
+TEST_CASE("background training is abandoned with its context") {
+    ScopedTempDir dir;
+    dasher_ctx* ctx = create(dir, true);
+    REQUIRE(dasher_get_training_progress(ctx) >= 0);
+    run_frames(ctx, 3);
+    // Switching model abandons the first training for a second...
+    dasher_set_language_model_id(ctx, 5);
+    CHECK(dasher_get_training_progress(ctx) >= 0);
+    run_frames(ctx, 3);
+    // ...which is abandoned in turn: destroying the context joins the worker, which would
+    //  go on to save the model had it not seen it was cancelled.
+    dasher_destroy(ctx);
+
+    // Neither saved a (partly) trained model.
+    for (auto& entry : std::filesystem::directory_iterator(dir.path))
+        CHECK(entry.path().filename().string().rfind("ppm_", 0) != 0);
+}
+
+TEST_CASE("bench/frame times while training in the background") {
+    ScopedTempDir dir;
+    dasher_ctx* ctx = create(dir, true);
+    const TrainingFrames result = frames_while_training(ctx);
+    printf("  %d frames while training, slowest %.2fms (60Hz budget 16ms)\n", result.frames, result.slowest);
+    CHECK(result.slowest < 16.0);
+    dasher_destroy(ctx);
+}
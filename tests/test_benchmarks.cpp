@@ -163,3 +163,125 @@ TEST_CASE("bench/dasher_frame at rest is faster than active") {
     // not be more expensive than active.
     CHECK(idle_p50 <= active_p50 + 1.0); // 1ms tolerance for noise
 }
+
+TEST_CASE("bench/delta frames: bytes and time per frame against full frames") {
+    // CHARACTERIZATION: with delta frames enabled, dasher_frame gives only
+    // what changed since the last frame - nothing at all when nothing
+    // moved, and NewFrame then skips redrawing the nodes. Zooming changes
+    // most commands every frame, so there most frames are a reset: the full
+    // frame and two ints more. Only the idle saving is asserted.
+    // Bytes are 4 per int plus the strings sent (with their terminators).
+    constexpr int N = 1000;
+    struct Result {
+        double idle_bytes, active_bytes, idle_p50, active_p50;
+    };
+    auto measure = [](bool bDelta) {
+        ScopedContext ctx(800, 600);
+        dasher_set_speed_percent(ctx, 200);
+        REQUIRE_EQ(dasher_set_delta_frames_enabled(ctx, bDelta ? 1 : 0), 0);
+        run_frames(ctx, 20);
+
+        std::vector<double> samples;
+        samples.reserve(N);
+        double bytes = 0;
+        auto frame = [&](int64_t time_ms) {
+            int* cmds = nullptr;
+            int cc = 0;
+            char** strs = nullptr;
+            int sc = 0;
+            auto t0 = clk::now();
+            dasher_frame(ctx, time_ms, &cmds, &cc, &strs, &sc);
+            auto t1 = clk::now();
+            samples.push_back(std::chrono::duration<double, std::milli>(t1 - t0).count());
+            bytes += cc * 4.0;
+            for (int i = 0; i < sc; ++i)
+                bytes += std::strlen(strs[i]) + 1;
+        };
+
+        Result result;
+        dasher_mouse_move(ctx, 400.0f, 300.0f);
+        for (int i = 0; i < N; ++i)
+            frame(200000 + i * 16);
+        result.idle_bytes = bytes / N;
+        result.idle_p50 = percentile_ms(samples, 0.50);
+
+        samples.clear();
+        bytes = 0;
+        dasher_mouse_move(ctx, 700.0f, 300.0f);
+        dasher_mouse_down(ctx);
+        dasher_mouse_up(ctx);
+        for (int i = 0; i < N; ++i) {
+            dasher_mouse_move(ctx, 700.0f, 300.0f + (i % 50));
+            frame(300000 + i * 16);
+        }
+        dasher_mouse_down(ctx);
+        dasher_mouse_up(ctx);
+        result.active_bytes = bytes / N;
+        result.active_p50 = percentile_ms(samples, 0.50);
+        return result;
+    };
+    const Result full = measure(false);
+    const Result delta = measure(true);
+
+    printf("\n[dasher_frame full vs delta] N=%d frames each\n", N);
+    printf("  idle   full: %8.0f bytes/frame p50 %.3f ms   delta: %8.0f bytes/frame p50 %.3f ms\n",
+           full.idle_bytes, full.idle_p50, delta.idle_bytes, delta.idle_p50);
+    printf("  active full: %8.0f bytes/frame p50 %.3f ms   delta: %8.0f bytes/frame p50 %.3f ms\n",
+           full.active_bytes, full.active_p50, delta.active_bytes, delta.active_p50);
+    fflush(stdout);
+
+    CHECK(delta.idle_bytes * 10 < full.idle_bytes);
+    CHECK(delta.idle_p50 <= full.idle_p50 + 1.0); // 1ms tolerance for noise
+}
+
+TEST_CASE("bench/compact frame encoding: size and encode cost") {
+    // CHARACTERIZATION: the compact encoding (dasher_get_encoded_frame,
+    // encoding 1) against the 6-int commands, for a busy 4K frame with
+    // outlines while zooming. Reports the compression ratio and the encode
+    // time beside the frame's own; asserts only that it does compress.
+    constexpr int N = 500;
+    ScopedContext ctx(3840, 2160);
+    dasher_set_speed_percent(ctx, 200);
+    const int widthKey = dasher_find_parameter_key("LP_OUTLINE_WIDTH");
+    REQUIRE(widthKey >= 0);
+    dasher_set_long_parameter(ctx, widthKey, 2);
+    run_frames(ctx, 20);
+
+    std::vector<double> frame_samples, encode_samples;
+    frame_samples.reserve(N);
+    encode_samples.reserve(N);
+    double int_bytes = 0, compact_bytes = 0;
+    dasher_mouse_move(ctx, 3300.0f, 1000.0f);
+    dasher_mouse_down(ctx);
+    dasher_mouse_up(ctx);
+    for (int i = 0; i < N; ++i) {
+        dasher_mouse_move(ctx, 3300.0f, 1000.0f + (i % 100));
+        int* cmds = nullptr;
+        int cc = 0;
+        char** strs = nullptr;
+        int sc = 0;
+        const uint8_t* bytes = nullptr;
+        int size = 0;
+        auto t0 = clk::now();
+        dasher_frame(ctx, 300000 + i * 16, &cmds, &cc, &strs, &sc);
+        auto t1 = clk::now();
+        dasher_get_encoded_frame(ctx, 1, &bytes, &size);
+        auto t2 = clk::now();
+        frame_samples.push_back(std::chrono::duration<double, std::milli>(t1 - t0).count());
+        encode_samples.push_back(std::chrono::duration<double, std::milli>(t2 - t1).count());
+        int_bytes += cc * 4.0;
+        compact_bytes += size;
+    }
+    dasher_mouse_down(ctx);
+    dasher_mouse_up(ctx);
+
+    printf("\n[compact encoding] 3840x2160, outlines, N=%d frames\n", N);
+    printf("  ints:    %8.0f bytes/frame\n", int_bytes / N);
+    printf("  compact: %8.0f bytes/frame (%.2fx smaller)\n", compact_bytes / N,
+           int_bytes / std::max(1.0, compact_bytes));
+    printf("  encode p50: %.3f ms (frame p50 %.3f ms)\n", percentile_ms(encode_samples, 0.50),
+           percentile_ms(frame_samples, 0.50));
+    fflush(stdout);
+
+    CHECK(compact_bytes * 2 < int_bytes);
+}
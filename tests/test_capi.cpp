@@ -244,3 +244,35 @@ TEST(locale_multiple_languages) {
 
     CHECK(loaded > 0); // at least one locale file must load when Strings/ is present
 }
+
+TEST(locale_per_context) {
+    // Each context has its own locale and overrides; only dasher_get_parameter_info,
+    // taking no context, follows whichever context last changed its own
+    ScopedContext a, b;
+    REQUIRE(a.ctx != nullptr);
+    REQUIRE(b.ctx != nullptr);
+
+    REQUIRE(dasher_set_locale(a, "de") == 0);
+    ASSERT_STR_EQ(dasher_get_locale(a), "de");
+    ASSERT_STR_EQ(dasher_get_locale(b), "en");
+
+    dasher_set_string_override(a, "BP_DRAW_MOUSE_LINE.label", "Only in a");
+    ASSERT_STR_EQ(dasher_get_localized_string(a, "BP_DRAW_MOUSE_LINE.label"), "Only in a");
+    const char* inB = dasher_get_localized_string(b, "BP_DRAW_MOUSE_LINE.label");
+    CHECK((inB == nullptr || std::string(inB) != "Only in a"));
+
+    const int key = dasher_find_parameter_key("BP_DRAW_MOUSE_LINE");
+    auto paramName = [key]() {
+        dasher_parameter_info info{};
+        for (int i = 0; i < dasher_get_parameter_count(); i++)
+            if (dasher_get_parameter_info(i, &info) == 0 && info.key == key) return std::string(info.name);
+        return std::string();
+    };
+    CHECK_EQ(paramName(), "Only in a");
+    dasher_set_string_override(b, "BP_DRAW_MOUSE_LINE.label", "Only in b");
+    CHECK_EQ(paramName(), "Only in b");
+
+    // (the process default is left as English for the tests that follow)
+    dasher_set_locale(a, nullptr);
+    dasher_set_string_override(a, "BP_DRAW_MOUSE_LINE.label", nullptr);
+}
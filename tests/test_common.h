@@ -15,6 +15,16 @@
 //   - ScopedTempDir: RAII wrapper that removes the directory on destruction
 //   - run_frames(): canonical frame-stepping helper (single source of truth
 //     for the time-step convention so tests stop drifting between *16 and *20)
+//   - settle(): frames until training is done and its messages have gone
+//   - probabilities(): the children's bounds under the crosshair, to compare models
+//   - percentile(): p50/p99 etc. of a benchmark's timings
+//   - seconds_since(): wall time elapsed since a steady_clock time point
+//   - LMSettings: a settings store for constructing language models directly
+//     (internal tests only, see DASHER_TEST_INTERNAL)
+//   - g_iAllocations / g_iBytes / g_iLiveBytes: heap use, counted by replacing
+//     global operator new (see DASHER_TEST_COUNT_ALLOCATIONS)
+//   - set_long(): set a long parameter by its key name
+//   - start_zooming() / steer_frame(): zoom at 400%, steering up and down
 
 #pragma once
 
@@ -27,11 +37,15 @@
 
 #include "dasher.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstdio>
 #include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <string>
+#include <vector>
 
 #ifdef _WIN32
 #include <direct.h>
@@ -108,7 +122,8 @@ struct ScopedTempDir {
     std::string path;
 
     ScopedTempDir() {
-        static int counter = 0;
+        // (atomic, as contexts may be created on several threads at once)
+        static std::atomic<int> counter{0};
         char buf[256];
         snprintf(buf, sizeof(buf), "%s/dasher_test_%d_%d", dasher_temp_dir(), dasher_getpid(), counter++);
         path = buf;
@@ -192,6 +207,163 @@ inline void run_frames(dasher_ctx* ctx, int count, int64_t start_ms = 1000, int6
     }
 }
 
+// Runs frames (from start_ms, every 16ms) until the language model is trained and the
+//  messages that gave (e.g. for want of user training text) have been shown and gone,
+//  after LP_MESSAGE_TIME; returns the time for the next frame. For tests of frames in
+//  which nothing else changes.
+inline int64_t settle(dasher_ctx* ctx, int64_t start_ms = 1000) {
+    int64_t time_ms = start_ms;
+    do {
+        run_frames(ctx, 1, time_ms);
+        time_ms += 16;
+    } while (dasher_get_training_progress(ctx) != -1);
+    run_frames(ctx, 1, time_ms); // (shows the messages the trained model was adopted with)
+    run_frames(ctx, 1, time_ms + 2516);
+    return time_ms + 2532;
+}
+
+// The upper bounds (cumulative) of the children of the node under the crosshair, as
+// dasher_get_probabilities gives them: to compare what two contexts' models predict.
+inline std::vector<int> probabilities(dasher_ctx* ctx) {
+    int lbnds[256], hbnds[256];
+    int n = dasher_get_probabilities(ctx, lbnds, hbnds, 256);
+    std::vector<int> out;
+    for (int i = 0; i < n; i++)
+        out.push_back(hbnds[i]);
+    return out;
+}
+
+// The pct'th (0..1) of some timings, or 0 if there are none
+inline double percentile(std::vector<double> samples, double pct) {
+    if (samples.empty()) return 0.0;
+    std::sort(samples.begin(), samples.end());
+    return samples[std::min(samples.size() - 1, static_cast<size_t>(samples.size() * pct))];
+}
+
+inline double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Set a long parameter by its key name (e.g. "LP_NODE_BUDGET"), which must exist.
+inline void set_long(dasher_ctx* ctx, const char* name, long value) {
+    const int key = dasher_find_parameter_key(name);
+    REQUIRE(key >= 0);
+    dasher_set_long_parameter(ctx, key, value);
+}
+
+// ---------------------------------------------------------------------------
+// Steering at speed
+//
+// The expansion benchmarks all drive Dasher the same way: start zooming at
+// 400% speed, then steer up and down the screen, switching every `period`
+// frames, so that nodes keep coming onscreen and going off again.
+// ---------------------------------------------------------------------------
+
+inline void start_zooming(dasher_ctx* ctx, float x = 700.0f) {
+    dasher_set_speed_percent(ctx, 400);
+    run_frames(ctx, 5);
+    dasher_mouse_move(ctx, x, 300.0f);
+    dasher_mouse_down(ctx);
+    dasher_mouse_up(ctx);
+}
+
+// Frame i of the steering (at start_ms + i * 16), with the pointer at x, amplitude above
+//  and below the middle of the screen; returns the number of draw commands
+inline int steer_frame(dasher_ctx* ctx, int i, int64_t start_ms = 2000, float x = 700.0f, int period = 45,
+                       float amplitude = 220.0f) {
+    dasher_mouse_move(ctx, x, 300.0f + amplitude * ((i / period) % 2 ? 1 : -1));
+    int* cmds = nullptr;
+    int cmd_count = 0;
+    char** strs = nullptr;
+    int str_count = 0;
+    dasher_frame(ctx, start_ms + i * 16, &cmds, &cmd_count, &strs, &str_count);
+    return cmd_count;
+}
+
+// ---------------------------------------------------------------------------
+// Language model settings
+//
+// Tests linked against DasherCore itself (dasher_add_test_internal, which
+// defines DASHER_TEST_INTERNAL) construct language models directly, each
+// needing a settings store with the default parameters plus the few the
+// model reads.
+// ---------------------------------------------------------------------------
+
+#ifdef DASHER_TEST_INTERNAL
+#include "DasherCore/Parameters.h"
+#include "DasherCore/SettingsStore.h"
+
+struct LMSettings {
+    Dasher::CSettingsStore store;
+    // A node budget of 0 leaves the model unbounded
+    LMSettings(int iOrder, bool bUpdateExclusion, long iNodeBudget = 0) {
+        store.AddParameters(Dasher::Settings::parameter_defaults);
+        store.SetLongParameter(Dasher::LP_LM_MAX_ORDER, iOrder);
+        store.SetLongParameter(Dasher::LP_LM_UPDATE_EXCLUSION, bUpdateExclusion ? 1 : 0);
+        store.SetLongParameter(Dasher::LP_LM_NODE_BUDGET, iNodeBudget);
+    }
+};
+#endif
+
+// ---------------------------------------------------------------------------
+// Heap allocation counting
+//
+// Tests built with dasher_add_test_counting (which defines
+// DASHER_TEST_COUNT_ALLOCATIONS) replace the global operator new and delete
+// here, counting every allocation and the bytes allocated and still live.
+// Replacements can't be inline, so this relies on each test executable
+// having a single .cpp, as DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN above does.
+// ---------------------------------------------------------------------------
+
+#ifdef DASHER_TEST_COUNT_ALLOCATIONS
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+inline std::atomic<long long> g_iAllocations{0}, g_iBytes{0}, g_iLiveBytes{0};
+
+namespace dasher_test {
+// Each allocation is preceded by its size, to count the bytes live
+constexpr std::size_t kHeader = alignof(std::max_align_t);
+
+inline void* counted_alloc(std::size_t iBytes) {
+    char* p = static_cast<char*>(std::malloc(kHeader + iBytes));
+    if (!p) throw std::bad_alloc();
+    *reinterpret_cast<std::size_t*>(p) = iBytes;
+    g_iAllocations++;
+    g_iBytes += static_cast<long long>(iBytes);
+    g_iLiveBytes += static_cast<long long>(iBytes);
+    return p + kHeader;
+}
+
+inline void counted_free(void* p) {
+    if (!p) return;
+    char* pBlock = static_cast<char*>(p) - kHeader;
+    g_iLiveBytes -= static_cast<long long>(*reinterpret_cast<std::size_t*>(pBlock));
+    std::free(pBlock);
+}
+} // namespace dasher_test
+
+void* operator new(std::size_t iBytes) {
+    return dasher_test::counted_alloc(iBytes);
+}
+void* operator new[](std::size_t iBytes) {
+    return dasher_test::counted_alloc(iBytes);
+}
+void operator delete(void* p) noexcept {
+    dasher_test::counted_free(p);
+}
+void operator delete[](void* p) noexcept {
+    dasher_test::counted_free(p);
+}
+void operator delete(void* p, std::size_t) noexcept {
+    dasher_test::counted_free(p);
+}
+void operator delete[](void* p, std::size_t) noexcept {
+    dasher_test::counted_free(p);
+}
+#endif
+
 // ---------------------------------------------------------------------------
 // build_data_dir: create a temp Data/ directory populated with symlinks to
 // the real bundled data files. Used by tests that need to inject malformed
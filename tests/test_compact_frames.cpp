@@ -0,0 +1,188 @@
+// Compact frame encoding tests: dasher_get_encoded_frame(ctx, 1, ...) gives
+// the last frame as opcode tags, zigzag varints and a per-frame colour
+// table, in runs of same-opcode, same-colour commands. The reference decoder
+// below follows the format documented in dasher.h; decoding must give back
+// exactly the commands dasher_frame gave, whatever the engine draws - so a
+// seeded random session (pointer moves, starts and stops, shapes, outlines,
+// sizes, delta frames and label ids switched on and off) is checked frame
+// by frame.
+#include "test_common.h"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace {
+
+// Reference decoder: the commands as dasher_frame gives them, false if malformed
+struct Reader {
+    const uint8_t* p;
+    const uint8_t* end;
+    bool ok = true;
+
+    uint32_t varint() {
+        uint32_t v = 0;
+        for (int iShift = 0; iShift < 35; iShift += 7) {
+            if (p == end) break;
+            const uint8_t b = *p++;
+            v |= static_cast<uint32_t>(b & 0x7F) << iShift;
+            if (!(b & 0x80)) return v;
+        }
+        ok = false;
+        return 0;
+    }
+    int32_t signed_varint() {
+        const uint32_t v = varint();
+        return static_cast<int32_t>((v >> 1) ^ (0u - (v & 1)));
+    }
+    uint8_t byte() {
+        if (p == end) {
+            ok = false;
+            return 0;
+        }
+        return *p++;
+    }
+};
+
+bool decode(const uint8_t* bytes, int size, std::vector<int>& out) {
+    out.clear();
+    Reader in{bytes, bytes + size};
+    if (in.byte() != 1) return false;
+    std::vector<int32_t> colours(in.varint());
+    for (int32_t& argb : colours) {
+        uint32_t v = 0;
+        for (int iShift = 0; iShift < 32; iShift += 8)
+            v |= static_cast<uint32_t>(in.byte()) << iShift;
+        argb = static_cast<int32_t>(v);
+    }
+    const uint32_t count = in.varint();
+    int32_t argb = 0;
+    bool bColour = false;
+    while (in.ok && out.size() < count * 6u) {
+        const uint8_t tag = in.byte();
+        const int opcode = tag & 0x07;
+        if (tag & 0x08) {
+            const uint32_t index = in.varint();
+            if (index >= colours.size()) return false;
+            argb = colours[index];
+            bColour = true;
+        }
+        if (!bColour) return false;
+        const bool bRelative = opcode >= 2 && opcode <= 4;
+        for (int j = 0; j <= tag >> 4; j++) {
+            const int a = in.signed_varint();
+            const int b = in.signed_varint();
+            const int c = in.signed_varint();
+            const int d = in.signed_varint();
+            out.insert(out.end(), {opcode, a, b, bRelative ? c + a : c, bRelative ? d + b : d, argb});
+        }
+    }
+    return in.ok && in.p == in.end && out.size() == count * 6u;
+}
+
+struct Sizes {
+    long full_bytes = 0;
+    long compact_bytes = 0;
+};
+
+// Checks the encoding of the last frame against the full frame
+void check_last_frame(dasher_ctx* ctx, Sizes& sizes) {
+    int* cmds = nullptr;
+    int cmd_count = 0;
+    REQUIRE_EQ(dasher_get_full_frame(ctx, &cmds, &cmd_count, nullptr, nullptr), 0);
+    const uint8_t* bytes = nullptr;
+    int size = 0;
+    REQUIRE_EQ(dasher_get_encoded_frame(ctx, 1, &bytes, &size), 0);
+    std::vector<int> decoded;
+    CHECK(decode(bytes, size, decoded));
+    CHECK(decoded == std::vector<int>(cmds, cmds + cmd_count));
+    sizes.full_bytes += cmd_count * 4L;
+    sizes.compact_bytes += size;
+}
+
+} // namespace
+
+TEST_CASE("decoding the compact encoding gives the frame drawn") {
+    const int shapeKey = dasher_find_parameter_key("LP_SHAPE_TYPE");
+    const int widthKey = dasher_find_parameter_key("LP_OUTLINE_WIDTH");
+    REQUIRE(shapeKey >= 0);
+    REQUIRE(widthKey >= 0);
+
+    for (unsigned seed : {1u, 2u, 3u, 4u}) {
+        CAPTURE(seed);
+        std::mt19937 rng(seed);
+        auto uniform = [&rng](int lo, int hi) { return std::uniform_int_distribution<int>(lo, hi)(rng); };
+        int width = 800, height = 600;
+        ScopedContext ctx(width, height);
+        Sizes sizes;
+        bool bRunning = false;
+        int64_t time_ms = 1000;
+        for (int i = 0; i < 600; i++) {
+            switch (uniform(0, 40)) {
+            case 0:
+                dasher_set_long_parameter(ctx, shapeKey, uniform(0, 6));
+                break;
+            case 1:
+                dasher_set_long_parameter(ctx, widthKey, uniform(0, 4));
+                break;
+            case 2:
+                width = uniform(200, 3840);
+                height = uniform(200, 2160);
+                dasher_set_screen_size(ctx, width, height);
+                break;
+            case 3:
+                dasher_set_delta_frames_enabled(ctx, uniform(0, 1));
+                break;
+            case 4:
+                dasher_set_label_ids_enabled(ctx, uniform(0, 1));
+                break;
+            case 5:
+            case 6:
+                dasher_mouse_down(ctx);
+                dasher_mouse_up(ctx);
+                bRunning = !bRunning;
+                break;
+            default:
+                // Mostly towards the right, to zoom in; sometimes off the canvas
+                dasher_mouse_move(ctx, static_cast<float>(uniform(-width / 4, width * 5 / 4)),
+                                  static_cast<float>(uniform(-height / 4, height * 5 / 4)));
+                break;
+            }
+            int* cmds = nullptr;
+            int cmd_count = 0;
+            char** strs = nullptr;
+            int str_count = 0;
+            dasher_frame(ctx, time_ms += 16, &cmds, &cmd_count, &strs, &str_count);
+            check_last_frame(ctx, sizes);
+        }
+        if (bRunning) {
+            dasher_mouse_down(ctx);
+            dasher_mouse_up(ctx);
+        }
+        printf("  seed %u: %ld bytes as ints, %ld compact (%.1fx)\n", seed, sizes.full_bytes, sizes.compact_bytes,
+               static_cast<double>(sizes.full_bytes) / sizes.compact_bytes);
+        CHECK(sizes.compact_bytes * 2 < sizes.full_bytes);
+    }
+}
+
+TEST_CASE("the encoding is the same however often it is asked for") {
+    ScopedContext ctx(800, 600);
+    run_frames(ctx, 10);
+    const uint8_t* bytes = nullptr;
+    int size = 0;
+    REQUIRE_EQ(dasher_get_encoded_frame(ctx, 1, &bytes, &size), 0);
+    const std::vector<uint8_t> first(bytes, bytes + size);
+    REQUIRE_EQ(dasher_get_encoded_frame(ctx, 1, &bytes, &size), 0);
+    CHECK(std::vector<uint8_t>(bytes, bytes + size) == first);
+    CHECK_EQ(first[0], 1);
+}
+
+TEST_CASE("encoded frames need a realized context and a known encoding") {
+    const uint8_t* bytes = nullptr;
+    int size = 0;
+    CHECK_EQ(dasher_get_encoded_frame(nullptr, 1, &bytes, &size), -1);
+    ScopedContext ctx(800, 600);
+    run_frames(ctx, 1);
+    CHECK_EQ(dasher_get_encoded_frame(ctx, 0, &bytes, &size), -1);
+    CHECK_EQ(dasher_get_encoded_frame(ctx, 2, &bytes, &size), -1);
+}
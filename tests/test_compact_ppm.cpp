@@ -0,0 +1,195 @@
+// Compact PPM tests: the CompactPPM language model (id 6) keeps the PPM trie
+// in an arena of 16-byte nodes addressed by 32-bit index, with children in
+// pooled slabs. It must predict exactly as the standard PPM model does for
+// the same training, at any order and with or without update exclusion; and
+// its node ids must be dense, so subclasses can keep per-node data in side
+// arrays. Also prints bytes per node, training time and GetProbs calls/sec
+// of both on the English corpus.
+//
+// Built via dasher_add_test_internal (drives the language models directly).
+
+#include "test_common.h"
+
+#include "DasherCore/LanguageModelling/CompactPPMLanguageModel.h"
+#include "DasherCore/LanguageModelling/PPMLanguageModel.h"
+
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace Dasher;
+
+namespace {
+
+const int NORM = 1 << 16;
+const int UNIFORM = NORM * 50 / 1000;
+
+// Text over iNumSyms symbols (1..iNumSyms-1), Zipf-distributed, with each symbol
+//  also likely to repeat a short while later, so that contexts of every order recur
+std::vector<symbol> zipf_text(int iNumSyms, size_t iLength, unsigned int iSeed) {
+    std::mt19937 rng(iSeed);
+    std::vector<double> weights(iNumSyms - 1);
+    for (size_t i = 0; i < weights.size(); i++)
+        weights[i] = 1.0 / std::pow(static_cast<double>(i + 1), 1.1);
+    std::discrete_distribution<int> zipf(weights.begin(), weights.end());
+    std::vector<symbol> out;
+    for (size_t i = 0; i < iLength; i++) {
+        if (out.size() > 8 && rng() % 2) out.push_back(out[out.size() - 1 - rng() % 8]);
+        else out.push_back(zipf(rng) + 1);
+    }
+    return out;
+}
+
+// The English corpus, a symbol (1..256) per byte
+std::vector<symbol> corpus_text() {
+    std::ifstream in(std::string(TEST_DATA_DIR) + "/Data/training/training_wa_en_Latn.txt", std::ios::binary);
+    REQUIRE(in);
+    std::vector<symbol> out;
+    for (char c; in.get(c);)
+        out.push_back(static_cast<unsigned char>(c) + 1);
+    return out;
+}
+const int CORPUS_SYMS = 257;
+
+void learn(CLanguageModel& lm, const std::vector<symbol>& text) {
+    CLanguageModel::Context ctx = lm.CreateEmptyContext();
+    for (symbol sym : text)
+        lm.LearnSymbol(ctx, sym);
+    lm.ReleaseContext(ctx);
+}
+
+// A context after each symbol of text, entered (not learnt)
+std::vector<CLanguageModel::Context> contexts(CLanguageModel& lm, const std::vector<symbol>& text) {
+    std::vector<CLanguageModel::Context> out;
+    CLanguageModel::Context ctx = lm.CreateEmptyContext();
+    for (symbol sym : text) {
+        lm.EnterSymbol(ctx, sym);
+        out.push_back(lm.CloneContext(ctx));
+    }
+    lm.ReleaseContext(ctx);
+    return out;
+}
+
+void release(CLanguageModel& lm, const std::vector<CLanguageModel::Context>& ctxs) {
+    for (CLanguageModel::Context ctx : ctxs)
+        lm.ReleaseContext(ctx);
+}
+
+// GetProbs calls per second, over all of ctxs
+double calls_per_second(const CLanguageModel& lm, const std::vector<CLanguageModel::Context>& ctxs) {
+    std::vector<unsigned int> probs;
+    size_t iCalls = 0;
+    const auto start = std::chrono::steady_clock::now();
+    double seconds = 0;
+    while (seconds < 0.2) {
+        for (CLanguageModel::Context ctx : ctxs)
+            lm.GetProbs(ctx, probs, NORM, UNIFORM);
+        iCalls += ctxs.size();
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    return iCalls / seconds;
+}
+
+// Records, in a side array, how many times each node has been the context learnt into
+class CCountingPPM : public CCompactPPMLanguageModel {
+  public:
+    using CCompactPPMLanguageModel::CCompactPPMLanguageModel;
+    void LearnSymbol(Context context, int Symbol) override {
+        CCompactPPMLanguageModel::LearnSymbol(context, Symbol);
+        m_vLearnt.resize(GetNodeCount());
+        m_vLearnt[GetHead(context)]++;
+    }
+    int Learnt(Context context) const { return m_vLearnt[GetHead(context)]; }
+    symbol HeadSymbol(Context context) const { return Sym(GetHead(context)); }
+
+  private:
+    std::vector<int> m_vLearnt;
+};
+
+} // namespace
+
+TEST_CASE("compact ppm predicts exactly as ppm") {
+    for (int iNumSyms : {3, 30, 7000}) {
+        for (int iOrder : {1, 3, 5, 8}) {
+            for (bool bUpdateExclusion : {true, false}) {
+                CAPTURE(iNumSyms);
+                CAPTURE(iOrder);
+                CAPTURE(bUpdateExclusion);
+                LMSettings settings(iOrder, bUpdateExclusion);
+                CPPMLanguageModel ppm(&settings.store, iNumSyms);
+                CCompactPPMLanguageModel compact(&settings.store, iNumSyms);
+                const std::vector<symbol> training = zipf_text(iNumSyms, 20000, 1);
+                learn(ppm, training);
+                learn(compact, training);
+                REQUIRE_EQ(compact.GetNodeCount(), ppm.GetNodeCount());
+
+                const std::vector<symbol> text = zipf_text(iNumSyms, 300, 2);
+                const auto ppmContexts = contexts(ppm, text), compactContexts = contexts(compact, text);
+                std::vector<unsigned int> got, want;
+                for (size_t i = 0; i < text.size(); i++) {
+                    ppm.GetProbs(ppmContexts[i], want, NORM, UNIFORM);
+                    compact.GetProbs(compactContexts[i], got, NORM, UNIFORM);
+                    REQUIRE_EQ(got, want);
+                }
+                release(ppm, ppmContexts);
+                release(compact, compactContexts);
+            }
+        }
+    }
+}
+
+TEST_CASE("compact ppm node ids index side arrays") {
+    LMSettings settings(4, true);
+    CCountingPPM compact(&settings.store, 30);
+    const std::vector<symbol> text = zipf_text(30, 5000, 3);
+    CLanguageModel::Context ctx = compact.CreateEmptyContext();
+    for (symbol sym : text) {
+        const size_t iNodes = compact.GetNodeCount();
+        compact.LearnSymbol(ctx, sym);
+        CHECK_EQ(compact.HeadSymbol(ctx), sym);
+        CHECK(compact.GetNodeCount() >= iNodes); // ids are handed out densely, never reused
+    }
+    compact.ReleaseContext(ctx);
+
+    // Learning the same text again finds every context it was learnt into before
+    CLanguageModel::Context again = compact.CreateEmptyContext();
+    for (symbol sym : text) {
+        const size_t iNodes = compact.GetNodeCount();
+        compact.LearnSymbol(again, sym);
+        CHECK_EQ(compact.GetNodeCount(), iNodes);
+        CHECK(compact.Learnt(again) >= 2);
+    }
+    compact.ReleaseContext(again);
+}
+
+TEST_CASE("bench/ppm vs compact ppm on the English corpus: bytes per node, training, GetProbs") {
+    const std::vector<symbol> training = corpus_text();
+    const std::vector<symbol> text(training.begin(), training.begin() + 2000);
+    printf("  %zu symbols\n", training.size());
+    printf("  order engine     nodes  bytes/node       MB  train/s  GetProbs/s\n");
+    for (int iOrder : {4, 5, 6}) {
+        LMSettings settings(iOrder, true);
+        CPPMLanguageModel ppm(&settings.store, CORPUS_SYMS);
+        CCompactPPMLanguageModel compact(&settings.store, CORPUS_SYMS);
+
+        auto start = std::chrono::steady_clock::now();
+        learn(ppm, training);
+        const double ppmSeconds = seconds_since(start);
+        start = std::chrono::steady_clock::now();
+        learn(compact, training);
+        const double compactSeconds = seconds_since(start);
+
+        const auto ppmContexts = contexts(ppm, text), compactContexts = contexts(compact, text);
+        const double ppmBytes = static_cast<double>(ppm.GetMemoryUsage()) / ppm.GetNodeCount();
+        printf("  %5d PPM     %9zu %11.1f %8.1f %8.3f %11.0f\n", iOrder, ppm.GetNodeCount(), ppmBytes,
+               ppm.GetMemoryUsage() / 1e6, ppmSeconds, calls_per_second(ppm, ppmContexts));
+        printf("  %5d Compact %9zu %11.1f %8.1f %8.3f %11.0f\n", iOrder, compact.GetNodeCount(),
+               compact.GetBytesPerNode(), compact.GetMemoryUsage() / 1e6, compactSeconds,
+               calls_per_second(compact, compactContexts));
+        CHECK(compact.GetBytesPerNode() < ppmBytes);
+        release(ppm, ppmContexts);
+        release(compact, compactContexts);
+    }
+}
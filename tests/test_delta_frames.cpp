@@ -0,0 +1,271 @@
+// Delta frame tests: with delta frames enabled, dasher_frame gives only the
+// ops (reset / insert / update / remove, by stable command id) turning the
+// previous frame's commands into this frame's. Applying them must rebuild
+// the whole frame (dasher_get_full_frame) every frame - zooming, stopped, in
+// any shape; while stopped, the frames kept must be just those a context
+// drawing full frames gives; and a frame in which nothing moved gives no ops.
+#include "test_common.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace {
+
+// A command with its text (if any) in place of the string index
+struct Command {
+    std::array<int, 6> ints;
+    std::string text;
+    bool operator==(const Command& other) const { return ints == other.ints && text == other.text; }
+};
+
+Command make_command(const int* p, char** strs) {
+    Command cmd;
+    std::copy(p, p + 6, cmd.ints.begin());
+    if (cmd.ints[0] == 5) {
+        cmd.text = strs[cmd.ints[4]];
+        cmd.ints[4] = 0;
+    }
+    return cmd;
+}
+
+std::vector<Command> to_commands(const int* cmds, int cmd_count, char** strs) {
+    std::vector<Command> out;
+    for (int i = 0; i + 6 <= cmd_count; i += 6)
+        out.push_back(make_command(cmds + i, strs));
+    return out;
+}
+
+std::vector<Command> full_frame(dasher_ctx* ctx, int64_t time_ms) {
+    int* cmds = nullptr;
+    int cmd_count = 0;
+    char** strs = nullptr;
+    int str_count = 0;
+    dasher_frame(ctx, time_ms, &cmds, &cmd_count, &strs, &str_count);
+    return to_commands(cmds, cmd_count, strs);
+}
+
+// The whole of the last frame drawn
+std::vector<Command> last_frame(dasher_ctx* ctx) {
+    int* cmds = nullptr;
+    int cmd_count = 0;
+    char** strs = nullptr;
+    int str_count = 0;
+    REQUIRE_EQ(dasher_get_full_frame(ctx, &cmds, &cmd_count, &strs, &str_count), 0);
+    return to_commands(cmds, cmd_count, strs);
+}
+
+// What a delta frontend keeps: the commands drawn, in order, by id
+struct DisplayList {
+    std::vector<std::pair<int, Command>> entries;
+    int last_ints = 0; // in the last frame's ops
+
+    std::vector<std::pair<int, Command>>::iterator find(int id) {
+        return std::find_if(entries.begin(), entries.end(), [id](const auto& e) { return e.first == id; });
+    }
+
+    // Applies one delta frame; returns the number of ops
+    int apply(dasher_ctx* ctx, int64_t time_ms) {
+        int* ops = nullptr;
+        int op_count = 0;
+        char** strs = nullptr;
+        int str_count = 0;
+        dasher_frame(ctx, time_ms, &ops, &op_count, &strs, &str_count);
+        last_ints = op_count;
+        int iOps = 0;
+        for (int i = 0; i < op_count; iOps++) {
+            const int* op = ops + i;
+            switch (op[0]) {
+            case 0: {
+                REQUIRE(i + 2 <= op_count);
+                REQUIRE(i + 2 + 6 * op[1] <= op_count);
+                entries.clear();
+                for (int id = 0; id < op[1]; id++)
+                    entries.push_back({id, make_command(op + 2 + 6 * id, strs)});
+                i += 2 + 6 * op[1];
+                break;
+            }
+            case 1: {
+                REQUIRE(i + 9 <= op_count);
+                REQUIRE(find(op[1]) == entries.end());
+                auto at = entries.begin();
+                if (op[2] >= 0) {
+                    at = find(op[2]);
+                    REQUIRE(at != entries.end());
+                    ++at;
+                }
+                entries.insert(at, {op[1], make_command(op + 3, strs)});
+                i += 9;
+                break;
+            }
+            case 2: {
+                REQUIRE(i + 8 <= op_count);
+                auto it = find(op[1]);
+                REQUIRE(it != entries.end());
+                it->second = make_command(op + 2, strs);
+                i += 8;
+                break;
+            }
+            case 3: {
+                REQUIRE(i + 2 <= op_count);
+                auto it = find(op[1]);
+                REQUIRE(it != entries.end());
+                entries.erase(it);
+                i += 2;
+                break;
+            }
+            default:
+                FAIL("unknown op " << op[0]);
+            }
+        }
+        return iOps;
+    }
+
+    std::vector<Command> commands() const {
+        std::vector<Command> out;
+        for (const auto& e : entries)
+            out.push_back(e.second);
+        return out;
+    }
+};
+
+// A delta context, checking each frame against the whole frame
+struct DeltaContext {
+    ScopedContext ctx{800, 600};
+    DisplayList list;
+    int64_t time_ms = 1000;
+
+    DeltaContext() { REQUIRE_EQ(dasher_set_delta_frames_enabled(ctx, 1), 0); }
+
+    // Runs a frame; returns the ops
+    int frame() {
+        const int iOps = list.apply(ctx, time_ms += 16);
+        CHECK(list.commands() == last_frame(ctx));
+        return iOps;
+    }
+    void click() {
+        dasher_mouse_down(ctx);
+        dasher_mouse_up(ctx);
+    }
+};
+
+} // namespace
+
+TEST_CASE("applying the ops rebuilds each frame") {
+    const int shapeKey = dasher_find_parameter_key("LP_SHAPE_TYPE");
+    REQUIRE(shapeKey >= 0);
+    for (int iShape : {0, 1, 5}) {
+        CAPTURE(iShape);
+        DeltaContext delta;
+        dasher_set_long_parameter(delta.ctx, shapeKey, iShape);
+        for (int i = 0; i < 20; i++)
+            delta.frame();
+
+        // Zoom in, steering up and down, then stop
+        dasher_mouse_move(delta.ctx, 680.0f, 300.0f);
+        delta.click();
+        for (int i = 0; i < 200; i++) {
+            dasher_mouse_move(delta.ctx, 680.0f, 300.0f + 120.0f * std::sin(i * 0.05f));
+            delta.frame();
+        }
+        delta.click();
+        for (int i = 0; i < 30; i++)
+            delta.frame();
+    }
+}
+
+TEST_CASE("a frame in which nothing moved gives no ops") {
+    DeltaContext delta;
+    // The first frame is a reset, sending everything
+    const int iFirst = delta.frame();
+    CHECK(delta.list.commands().size() > 5);
+    CHECK_EQ(iFirst, 1);
+    dasher_mouse_move(delta.ctx, 680.0f, 300.0f);
+    delta.click();
+    for (int i = 0; i < 60; i++)
+        delta.frame();
+    delta.click();
+    for (int i = 0; i < 30; i++)
+        delta.frame();
+
+    // Once stopped and settled, nothing
+    int iOps = 0;
+    for (int i = 0; i < 50; i++)
+        iOps += delta.frame();
+    CHECK_EQ(iOps, 0);
+
+    // Moving the pointer while stopped moves the decorations only
+    dasher_mouse_move(delta.ctx, 500.0f, 200.0f);
+    iOps = delta.frame();
+    CHECK(iOps > 0);
+    CHECK(iOps < 10);
+    CHECK_EQ(delta.frame(), 0);
+}
+
+TEST_CASE("while stopped, delta frames keep what full frames draw") {
+    // (Only while stopped: starting takes the wall-clock time, so two contexts
+    //  zooming from the same input do not stay in step)
+    ScopedContext full(800, 600);
+    DeltaContext delta;
+    auto frame = [&]() {
+        delta.frame();
+        CHECK(delta.list.commands() == full_frame(full, delta.time_ms));
+    };
+    for (int i = 0; i < 30; i++)
+        frame();
+
+    // Pointer moves
+    for (int i = 0; i < 10; i++) {
+        dasher_mouse_move(full, 400.0f + 30.0f * i, 300.0f - 20.0f * i);
+        dasher_mouse_move(delta.ctx, 400.0f + 30.0f * i, 300.0f - 20.0f * i);
+        frame();
+        frame();
+    }
+
+    // A setting that changes the nodes
+    const int key = dasher_find_parameter_key("LP_OUTLINE_WIDTH");
+    REQUIRE(key >= 0);
+    const long width = dasher_get_long_parameter(full, key) + 2;
+    dasher_set_long_parameter(full, key, width);
+    dasher_set_long_parameter(delta.ctx, key, width);
+    frame();
+    CHECK(delta.list.commands() != std::vector<Command>());
+    for (int i = 0; i < 10; i++)
+        frame();
+
+    // A new screen size starts again with a reset
+    dasher_set_screen_size(full, 640, 480);
+    dasher_set_screen_size(delta.ctx, 640, 480);
+    int* ops = nullptr;
+    int op_count = 0;
+    char** strs = nullptr;
+    int str_count = 0;
+    dasher_frame(delta.ctx, delta.time_ms += 16, &ops, &op_count, &strs, &str_count);
+    REQUIRE(op_count >= 2);
+    CHECK_EQ(ops[0], 0);
+    const int iCommands = static_cast<int>(full_frame(full, delta.time_ms).size());
+    CHECK_EQ(ops[1], iCommands);
+    CHECK_EQ(op_count, 2 + 6 * iCommands);
+}
+
+TEST_CASE("zooming, each frame's ops are no longer than the full frame and a reset op") {
+    DeltaContext delta;
+    dasher_set_speed_percent(delta.ctx, 400);
+    for (int i = 0; i < 20; i++)
+        delta.frame();
+    dasher_mouse_move(delta.ctx, 700.0f, 300.0f);
+    delta.click();
+    for (int i = 0; i < 200; i++) {
+        dasher_mouse_move(delta.ctx, 700.0f, 300.0f + (i % 50));
+        delta.frame();
+        CHECK(delta.list.last_ints <= 2 + 6 * static_cast<int>(delta.list.entries.size()));
+    }
+    delta.click();
+}
+
+TEST_CASE("delta frames need a realized context") {
+    CHECK_EQ(dasher_set_delta_frames_enabled(nullptr, 1), -1);
+    CHECK_EQ(dasher_get_full_frame(nullptr, nullptr, nullptr, nullptr, nullptr), -1);
+}
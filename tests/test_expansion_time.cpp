@@ -0,0 +1,144 @@
+// Expansion time budget tests: with LP_EXPANSION_TIME set, the expansion policy
+// expands nodes after each frame, most useful first, until the next would
+// overrun that many microseconds (judging by the cost per child it has
+// measured), rather than a fixed number of them. The time it spends must stay
+// within the budget; it must always expand the most useful node, so Dasher
+// still writes with a budget too small for anything; and, given plenty of
+// time, it must expand more than the fixed number. The benchmark steers at
+// 400% speed on the Mandarin alphabet, whose nodes are the costliest to
+// expand, timing each frame and the expansions in it.
+#include "test_common.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char* const kMandarin = "Mandarin (simp) by Pinyin, tone last";
+
+long long expanded(dasher_ctx* ctx) {
+    long long count = 0;
+    REQUIRE_EQ(dasher_get_expansion_time_stats(ctx, &count, nullptr), 0);
+    return count;
+}
+
+struct Run {
+    std::vector<double> frame_us;  // each frame, all in
+    std::vector<double> expand_us; // ...of which expanding nodes after rendering
+    std::vector<long long> frame_expanded;
+    long long expanded = 0;
+    std::string text;
+};
+
+// Steers up and down the screen at 400% speed, timing each frame
+Run steer(const char* alphabet, long budget_us, int frames) {
+    ScopedContext ctx(800, 600);
+    if (alphabet) {
+        dasher_set_alphabet_id(ctx, alphabet);
+        REQUIRE(std::string(dasher_get_alphabet_id(ctx)) == alphabet);
+    }
+    set_long(ctx, "LP_EXPANSION_TIME", budget_us);
+    start_zooming(ctx);
+    Run run;
+    long long expanded0 = 0, us0 = 0;
+    REQUIRE_EQ(dasher_get_expansion_time_stats(ctx, &expanded0, &us0), 0);
+    for (int i = 0; i < frames; i++) {
+        const auto t0 = std::chrono::steady_clock::now();
+        steer_frame(ctx, i);
+        run.frame_us.push_back(
+            std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count());
+        long long count = 0, us = 0;
+        REQUIRE_EQ(dasher_get_expansion_time_stats(ctx, &count, &us), 0);
+        run.expand_us.push_back(static_cast<double>(us - us0));
+        run.frame_expanded.push_back(count - expanded0);
+        run.expanded += count - expanded0;
+        expanded0 = count;
+        us0 = us;
+    }
+    dasher_mouse_down(ctx);
+    dasher_mouse_up(ctx);
+    run.text = dasher_get_output_text(ctx);
+    return run;
+}
+
+// What rendering takes, in all but 1 frame in 100, measured with the budget off (expanding by
+//  count): the wall-clock frame time less the time spent expanding after rendering
+double render_allowance(const Run& byCount) {
+    std::vector<double> render_us;
+    for (size_t i = 0; i < byCount.frame_us.size(); i++)
+        render_us.push_back(byCount.frame_us[i] - byCount.expand_us[i]);
+    return percentile(render_us, 0.99);
+}
+
+// Frames whose wall-clock time exceeded the budget plus the render allowance - other than those
+//  expanding just the one node that is expanded whatever the budget (which alone may take
+//  longer, e.g. in a debug build)
+int over_budget(const Run& run, long budget_us, double render_us) {
+    int over = 0;
+    for (size_t i = 0; i < run.frame_us.size(); i++)
+        if (run.frame_expanded[i] > 1 && run.frame_us[i] > budget_us + render_us) over++;
+    return over;
+}
+
+} // namespace
+
+TEST_CASE("a time budget bounds each frame's expansions") {
+    // By the policy's own timing of them, in a typical frame: wall-clock frame times, which
+    //  a loaded or instrumented build may stretch, are left to the bench/ case
+    const long budget_us = 200;
+    const Run run = steer(kMandarin, budget_us, 500);
+    CHECK(run.expanded > 0);
+    CHECK(percentile(run.expand_us, 0.50) <= budget_us);
+}
+
+TEST_CASE("the most useful node is expanded, however small the budget") {
+    const Run run = steer(nullptr, 1, 300);
+    CHECK(run.expanded > 0);
+    CHECK(!run.text.empty());
+    // ...and no other, as expanding it takes longer than that
+    CHECK(*std::max_element(run.frame_expanded.begin(), run.frame_expanded.end()) <= 1);
+}
+
+TEST_CASE("plenty of time expands more than a fixed number") {
+    // Straight after starting, there is much to expand
+    long long byCount = 0, byTime = 0;
+    {
+        ScopedContext ctx(800, 600);
+        run_frames(ctx, 5);
+        byCount = expanded(ctx);
+    }
+    {
+        ScopedContext ctx(800, 600);
+        set_long(ctx, "LP_EXPANSION_TIME", 100000);
+        run_frames(ctx, 5);
+        byTime = expanded(ctx);
+    }
+    CHECK(byCount > 0);
+    CHECK(byTime > byCount);
+}
+
+TEST_CASE("bench/frame time under the expansion time budget, Mandarin at 400%") {
+    const Run byCount = steer(kMandarin, 0, 1500);
+    const double render_us = render_allowance(byCount);
+    printf("  by count: frame p50 %.0f us, p99 %.0f us; expanding p99 %.0f us; %lld expanded; "
+           "render p99 %.0f us\n",
+           percentile(byCount.frame_us, 0.50), percentile(byCount.frame_us, 0.99),
+           percentile(byCount.expand_us, 0.99), byCount.expanded, render_us);
+    for (long budget_us : {100L, 500L, 2000L}) {
+        const Run run = steer(kMandarin, budget_us, 1500);
+        const int over = over_budget(run, budget_us, render_us);
+        printf("  %4ld us:  frame p50 %.0f us, p99 %.0f us; expanding p99 %.0f us; %lld expanded; "
+               "%d frames over budget + render\n",
+               budget_us, percentile(run.frame_us, 0.50), percentile(run.frame_us, 0.99),
+               percentile(run.expand_us, 0.99), run.expanded, over);
+        CAPTURE(budget_us);
+        CHECK(over <= static_cast<int>(run.frame_us.size()) / 50);
+    }
+}
+
+TEST_CASE("expansion time stats need a realized context") {
+    long long count = 0;
+    CHECK_EQ(dasher_get_expansion_time_stats(nullptr, &count, nullptr), -1);
+}
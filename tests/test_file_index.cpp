@@ -0,0 +1,177 @@
+// File index tests: FileUtils::ScanFiles answers every lookup (alphabets,
+// colours, control.xml, training text...) from one index of the data and user
+// directories, matching names by glob, instead of walking the data directory
+// for each. Files installed later are found once dasher_invalidate_file_index()
+// is called. Also prints the filesystem calls (directory reads and stats)
+// a dasher_create + dasher_set_screen_size makes with the index cold, persisted
+// in the user dir from a previous run, and already built - against those of the
+// full walk of the data directory which ScanFiles made, before the index, for
+// every lookup.
+#include "test_common.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <dlfcn.h>
+#include <sys/stat.h>
+
+// Counts calls (from anywhere in the process, e.g. std::filesystem inside
+//  libdasher, on any thread) to the libc functions that read directories or stat files.
+static std::atomic<int> g_iFileSystemCalls{0};
+
+#define COUNTED(ret, name, params, args)                                                                               \
+    extern "C" ret name params {                                                                                       \
+        static auto real = reinterpret_cast<ret(*) params>(dlsym(RTLD_NEXT, #name));                                   \
+        g_iFileSystemCalls++;                                                                                          \
+        return real args;                                                                                              \
+    }
+COUNTED(DIR*, opendir, (const char* p), (p))
+COUNTED(DIR*, fdopendir, (int fd), (fd))
+COUNTED(struct dirent*, readdir, (DIR * d), (d))
+COUNTED(struct dirent64*, readdir64, (DIR * d), (d))
+COUNTED(int, stat, (const char* p, struct stat* b), (p, b))
+COUNTED(int, lstat, (const char* p, struct stat* b), (p, b))
+COUNTED(int, stat64, (const char* p, struct stat64* b), (p, b))
+COUNTED(int, lstat64, (const char* p, struct stat64* b), (p, b))
+#undef COUNTED
+#else
+static std::atomic<int> g_iFileSystemCalls{0};
+#endif
+
+namespace {
+
+std::vector<std::string> alphabets(dasher_ctx* ctx) {
+    std::vector<std::string> out;
+    for (int i = 0; i < dasher_get_alphabet_count(ctx); i++)
+        out.push_back(dasher_get_alphabet_name(ctx, i));
+    return out;
+}
+
+bool lists(dasher_ctx* ctx, const std::string& id) {
+    const std::vector<std::string> ids = alphabets(ctx);
+    return std::find(ids.begin(), ids.end(), id) != ids.end();
+}
+
+std::string alphabet_xml(const std::string& id) {
+    return "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<alphabet name=\"" + id +
+           "\">\n  <group name=\"letters\"><node text=\"a\"/><node text=\"b\"/></group>\n</alphabet>\n";
+}
+
+dasher_ctx* create(const std::string& dataDir, const std::string& userDir) {
+    dasher_ctx* ctx = dasher_create(dataDir.c_str(), userDir.c_str(), nullptr);
+    REQUIRE(ctx);
+    dasher_set_screen_size(ctx, 800, 600);
+    return ctx;
+}
+
+struct Startup {
+    int iCalls;
+    double ms;
+};
+
+Startup startup(const std::string& dataDir, const std::string& userDir) {
+    const int iCalls = g_iFileSystemCalls;
+    const auto start = std::chrono::steady_clock::now();
+    dasher_ctx* ctx = create(dataDir, userDir);
+    Startup result{g_iFileSystemCalls - iCalls,
+                   std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()};
+    dasher_destroy(ctx);
+    return result;
+}
+
+// Filesystem calls for one full walk of dataDir, as ScanFiles made for every lookup before the index
+int full_walk(const std::string& dataDir) {
+    const int iCalls = g_iFileSystemCalls;
+    int iFiles = 0;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(dataDir))
+        if (entry.is_regular_file()) iFiles++;
+    REQUIRE(iFiles > 0);
+    return g_iFileSystemCalls - iCalls;
+}
+
+} // namespace
+
+TEST_CASE("files installed later are found after invalidating the index") {
+    ScopedTempDir tmp, userDir;
+    const std::string dataDir = build_data_dir(tmp);
+    dasher_ctx* first = create(dataDir, userDir.path);
+    const size_t iCount = alphabets(first).size();
+    REQUIRE(iCount > 1);
+    dasher_destroy(first);
+
+    REQUIRE(write_data_file(dataDir, "alphabets", "alphabet.installed.xml", alphabet_xml("Installed")));
+    std::ofstream(std::filesystem::path(userDir.path) / "alphabet.mine.xml") << alphabet_xml("Mine");
+    dasher_invalidate_file_index();
+
+    dasher_ctx* ctx = create(dataDir, userDir.path);
+    CHECK(lists(ctx, "Installed"));
+    CHECK(lists(ctx, "Mine")); // the user dir is searched too
+    CHECK_EQ(alphabets(ctx).size(), iCount + 2);
+    dasher_set_alphabet_id(ctx, "Installed");
+    CHECK_EQ(std::string(dasher_get_alphabet_id(ctx)), "Installed");
+    dasher_destroy(ctx);
+}
+
+TEST_CASE("file names are matched by glob, in full") {
+    ScopedTempDir tmp;
+    const std::string dataDir = build_data_dir(tmp);
+    // Under the old regex search, "alphabet.*.xml" matched anywhere within these
+    REQUIRE(write_data_file(dataDir, "alphabets", "alphabet.backup.xml.bak", alphabet_xml("Backup")));
+    REQUIRE(write_data_file(dataDir, "alphabets", "myalphabet.other.xml", alphabet_xml("Other")));
+    REQUIRE(write_data_file(dataDir, "alphabets", "alphabet.glob.xml", alphabet_xml("Glob")));
+    dasher_invalidate_file_index();
+
+    dasher_ctx* ctx = create(dataDir, tmp.path);
+    CHECK(lists(ctx, "Glob"));
+    CHECK_FALSE(lists(ctx, "Backup"));
+    CHECK_FALSE(lists(ctx, "Other"));
+    dasher_destroy(ctx);
+}
+
+TEST_CASE("the index persisted in the user dir is reused, and kept up to date") {
+    ScopedTempDir tmp, userDir;
+    const std::string dataDir = build_data_dir(tmp);
+    dasher_destroy(create(dataDir, userDir.path));
+    const std::filesystem::path index = std::filesystem::path(userDir.path) / "files.index";
+    REQUIRE(std::filesystem::exists(index));
+
+    // A new directory of data files, found in the persisted index's stead
+    std::filesystem::create_directories(std::filesystem::path(dataDir) / "Data" / "extra");
+    REQUIRE(write_data_file(dataDir, "extra", "alphabet.extra.xml", alphabet_xml("Extra")));
+    dasher_invalidate_file_index();
+    dasher_ctx* ctx = create(dataDir, userDir.path);
+    CHECK(lists(ctx, "Extra"));
+    dasher_destroy(ctx);
+    std::ifstream in(index);
+    const std::string strIndex((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    CHECK(strIndex.find("alphabet.extra.xml") != std::string::npos);
+}
+
+TEST_CASE("bench/startup filesystem calls: cold, persisted and built index") {
+    ScopedTempDir userDir, nextUserDir;
+    const std::string dataDir = get_test_data_dir();
+
+    // The data dir is indexed anew for each user dir (which it leaves out), so a second finds it
+    //  unindexed - but for the index persisted in the first, as from a previous run
+    const Startup cold = startup(dataDir, userDir.path);
+    std::filesystem::copy_file(std::filesystem::path(userDir.path) / "files.index",
+                               std::filesystem::path(nextUserDir.path) / "files.index");
+    const Startup persisted = startup(dataDir, nextUserDir.path);
+    const Startup built = startup(dataDir, nextUserDir.path);
+    const int iWalk = full_walk(dataDir);
+
+    printf("  one full walk:   %6d filesystem calls (made for each lookup before the index)\n", iWalk);
+    printf("  cold index:      %6d filesystem calls, %7.1fms\n", cold.iCalls, cold.ms);
+    printf("  persisted index: %6d filesystem calls, %7.1fms\n", persisted.iCalls, persisted.ms);
+    printf("  built index:     %6d filesystem calls, %7.1fms\n", built.iCalls, built.ms);
+#if defined(__linux__)
+    CHECK(persisted.iCalls < cold.iCalls);
+    CHECK(built.iCalls < persisted.iCalls);
+    // A whole startup from the index takes fewer than one lookup used to (and it makes several)
+    CHECK(persisted.iCalls < iWalk);
+#endif
+}
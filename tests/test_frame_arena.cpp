@@ -0,0 +1,71 @@
+// Frame arena tests: everything the view needs only while drawing a frame
+// (label requests and their children, polygon and polyline points) comes from
+// a per-view bump allocator reset at the start of each frame. Once warmed up,
+// a frame that changes nothing in the tree must not touch the heap at all -
+// at 800x600 and at 4K, in every node shape, with node capture on or off -
+// nor must a run of frames with delta frames on, which draw the decorations
+// but not the nodes. Moving frames still allocate, for the nodes expanded;
+// their count is printed.
+//
+// Counts every global operator new, so is built with CAPI.cpp and the static
+// DasherCore (see dasher_add_test_counting).
+
+#include "test_common.h"
+
+namespace {
+
+// Heap allocations made by count frames
+long long allocations(dasher_ctx* ctx, int count, int64_t start_ms) {
+    const long long iBefore = g_iAllocations;
+    run_frames(ctx, count, start_ms);
+    return g_iAllocations - iBefore;
+}
+
+const char* const SHAPES[] = {"disjoint rectangles", "overlapping rectangles", "triangles",
+                              "truncated triangles", "quadrics",               "circles"};
+
+} // namespace
+
+TEST_CASE("bench/a steady frame makes no heap allocations") {
+    const int shapeKey = dasher_find_parameter_key("LP_SHAPE_TYPE");
+    REQUIRE(shapeKey > 0);
+    for (auto size : {std::make_pair(800, 600), std::make_pair(3840, 2160)}) {
+        for (int iShape = 0; iShape < 6; iShape++) {
+            for (int iCapture = 0; iCapture < 2; iCapture++) {
+                CAPTURE(size.first);
+                CAPTURE(SHAPES[iShape]);
+                CAPTURE(iCapture);
+                ScopedContext ctx(size.first, size.second);
+                dasher_set_long_parameter(ctx, shapeKey, iShape);
+                dasher_set_visible_nodes_enabled(ctx, iCapture);
+
+                // Warm up, then zoom in a way and click again to stop
+                run_frames(ctx, 20);
+                dasher_mouse_move(ctx, size.first * 0.85f, size.second * 0.45f);
+                dasher_mouse_down(ctx);
+                dasher_mouse_up(ctx);
+                const long long iMoving = allocations(ctx, 60, 2000);
+                dasher_mouse_down(ctx);
+                dasher_mouse_up(ctx);
+                run_frames(ctx, 60, 4000);
+
+                const long long iSteady = allocations(ctx, 100, 6000);
+                if (!iCapture)
+                    printf("  %4dx%-4d %-22s  moving %6.1f allocs/frame, steady %4.1f\n", size.first, size.second,
+                           SHAPES[iShape], iMoving / 60.0, iSteady / 100.0);
+                CHECK_EQ(iSteady, 0);
+            }
+        }
+    }
+}
+
+TEST_CASE("frames drawing only the decorations make no heap allocations") {
+    // (with delta frames, frames in which nothing moved skip drawing the nodes,
+    //  but still draw the mouse line, from the arena)
+    ScopedContext ctx(800, 600);
+    REQUIRE_EQ(dasher_set_delta_frames_enabled(ctx, 1), 0);
+    const int64_t time_ms = settle(ctx);
+    dasher_mouse_move(ctx, 500.0f, 200.0f);
+    run_frames(ctx, 20, time_ms);
+    CHECK_EQ(allocations(ctx, 5000, time_ms + 1000), 0);
+}
@@ -0,0 +1,195 @@
+// Label table tests: every label the engine makes gets a stable id, and with
+// label ids enabled a text command gives the id (resolved through the label
+// table) instead of a copy of its text in the strings array. The text drawn
+// must be just what the strings array gives; the strings array stays empty;
+// the table changes only when labels do (not while zooming), and reuses the
+// ids of deleted labels rather than growing; and label ids work with delta
+// frames too.
+#include "test_common.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace {
+
+// A frame's commands, with each text command's text in place of its index or id
+struct Frame {
+    std::vector<int> ints;
+    std::vector<std::string> texts;
+    int string_count = 0;
+    bool operator==(const Frame& other) const { return ints == other.ints && texts == other.texts; }
+};
+
+// The label table, as a frontend would keep it: fetched again when the version changes
+struct LabelTable {
+    long long version = -1;
+    std::vector<std::string> labels;
+    int fetches = 0;
+
+    void update(dasher_ctx* ctx) {
+        char** labs = nullptr;
+        int count = 0;
+        const long long now = dasher_get_label_table(ctx, &labs, &count);
+        REQUIRE(now >= 0);
+        if (now == version) return;
+        version = now;
+        fetches++;
+        labels.assign(count, std::string());
+        for (int i = 0; i < count; i++)
+            if (labs[i]) labels[i] = labs[i];
+    }
+};
+
+Frame frame(dasher_ctx* ctx, int64_t time_ms, LabelTable* table) {
+    int* cmds = nullptr;
+    int cmd_count = 0;
+    char** strs = nullptr;
+    int str_count = 0;
+    dasher_frame(ctx, time_ms, &cmds, &cmd_count, &strs, &str_count);
+    if (table) table->update(ctx);
+    Frame out;
+    out.ints.assign(cmds, cmds + cmd_count);
+    out.string_count = str_count;
+    for (int i = 0; i + 6 <= cmd_count; i += 6) {
+        if (cmds[i] != 5) continue;
+        const int d = cmds[i + 4];
+        if (table) {
+            REQUIRE(d >= 0);
+            REQUIRE(d < static_cast<int>(table->labels.size()));
+            out.texts.push_back(table->labels[d]);
+        } else {
+            out.texts.push_back(strs[d]);
+        }
+        out.ints[i + 4] = 0;
+    }
+    return out;
+}
+
+} // namespace
+
+TEST_CASE("text commands by label id draw the same text") {
+    ScopedContext strings(800, 600);
+    ScopedContext ids(800, 600);
+    REQUIRE_EQ(dasher_set_label_ids_enabled(ids, 1), 0);
+    LabelTable table;
+
+    // (Stopped only: starting takes the wall-clock time, so two zooming contexts drift apart)
+    int64_t time_ms = 1000;
+    for (int i = 0; i < 30; i++) {
+        if (i >= 10) {
+            dasher_mouse_move(strings, 300.0f + 15.0f * i, 500.0f - 10.0f * i);
+            dasher_mouse_move(ids, 300.0f + 15.0f * i, 500.0f - 10.0f * i);
+        }
+        time_ms += 16;
+        const Frame expected = frame(strings, time_ms, nullptr);
+        const Frame actual = frame(ids, time_ms, &table);
+        if (i > 0) CHECK(expected.texts.size() > 5);
+        CHECK(expected == actual);
+        CHECK_EQ(actual.string_count, 0);
+    }
+
+    // And back to strings
+    REQUIRE_EQ(dasher_set_label_ids_enabled(ids, 0), 0);
+    const Frame expected = frame(strings, time_ms + 16, nullptr);
+    const Frame actual = frame(ids, time_ms + 16, nullptr);
+    CHECK(expected == actual);
+    CHECK(actual.string_count > 5);
+}
+
+TEST_CASE("bench/the label table changes only when labels do") {
+    ScopedContext ctx(800, 600);
+    REQUIRE_EQ(dasher_set_label_ids_enabled(ctx, 1), 0);
+    LabelTable table;
+    const int64_t time_ms = settle(ctx);
+    frame(ctx, time_ms, &table);
+    const long long version = table.version;
+    const size_t iLabels = table.labels.size();
+    CHECK(iLabels > 20);
+
+    // Zooming draws many labels, from the same table
+    dasher_mouse_move(ctx, 680.0f, 280.0f);
+    dasher_mouse_down(ctx);
+    dasher_mouse_up(ctx);
+    size_t iTexts = 0;
+    for (int i = 0; i < 300; i++)
+        iTexts += frame(ctx, time_ms + 16 + i * 16, &table).texts.size();
+    dasher_mouse_down(ctx);
+    dasher_mouse_up(ctx);
+    printf("  %zu labels; 300 zooming frames drew %zu texts with %d table fetches\n", iLabels, iTexts,
+           table.fetches);
+    CHECK_EQ(table.version, version);
+    CHECK_EQ(table.fetches, 1);
+
+    // A new alphabet makes new labels (with new ids); the old ones go
+    dasher_set_alphabet_id(ctx, "English without punctuation");
+    frame(ctx, time_ms + 20000, &table);
+    CHECK(table.version != version);
+    CHECK(table.labels.size() > iLabels);
+    for (int i = 0; i < 20; i++) {
+        const Frame f = frame(ctx, time_ms + 20016 + i * 16, &table);
+        for (const std::string& text : f.texts)
+            CHECK(!text.empty());
+    }
+}
+
+TEST_CASE("deleted labels' ids are reused, so the table doesn't grow") {
+    ScopedContext ctx(800, 600);
+    REQUIRE_EQ(dasher_set_label_ids_enabled(ctx, 1), 0);
+    LabelTable table;
+    const std::string alphabets[] = {"English without punctuation", dasher_get_alphabet_id(ctx)};
+    // Each switch deletes one alphabet's labels and makes the other's: slots left empty don't
+    //  mount up, switch after switch (though the messages shown, each a label, do until they go)
+    std::vector<size_t> empty;
+    for (int i = 0; i < 10; i++) {
+        dasher_set_alphabet_id(ctx, alphabets[i % 2].c_str());
+        for (int j = 0; j < 3; j++) {
+            const Frame f = frame(ctx, 1000 + (i * 3 + j) * 16, &table);
+            CHECK(!f.texts.empty());
+            for (const std::string& text : f.texts)
+                CHECK(!text.empty());
+        }
+        empty.push_back(std::count(table.labels.begin(), table.labels.end(), std::string()));
+        CAPTURE(i);
+        if (i >= 2) CHECK(empty[i] <= empty[i - 2]);
+    }
+}
+
+TEST_CASE("label ids with delta frames") {
+    ScopedContext ctx(800, 600);
+    REQUIRE_EQ(dasher_set_delta_frames_enabled(ctx, 1), 0);
+    run_frames(ctx, 5);
+    REQUIRE_EQ(dasher_set_label_ids_enabled(ctx, 1), 0);
+
+    // Switching starts the ops again from a reset, with text by label id
+    int* ops = nullptr;
+    int op_count = 0;
+    char** strs = nullptr;
+    int str_count = 0;
+    dasher_frame(ctx, 2000, &ops, &op_count, &strs, &str_count);
+    REQUIRE(op_count >= 2);
+    CHECK_EQ(ops[0], 0);
+    REQUIRE_EQ(op_count, 2 + 6 * ops[1]);
+    CHECK_EQ(str_count, 0);
+    char** labs = nullptr;
+    int label_count = 0;
+    REQUIRE(dasher_get_label_table(ctx, &labs, &label_count) >= 0);
+    int iTexts = 0;
+    for (int i = 2; i < op_count; i += 6) {
+        if (ops[i] != 5) continue;
+        iTexts++;
+        REQUIRE(ops[i + 4] < label_count);
+        CHECK(labs[ops[i + 4]] != nullptr);
+    }
+    CHECK(iTexts > 5);
+
+    // Nothing moved: still no ops
+    dasher_frame(ctx, 2016, &ops, &op_count, &strs, &str_count);
+    dasher_frame(ctx, 2032, &ops, &op_count, &strs, &str_count);
+    CHECK_EQ(op_count, 0);
+}
+
+TEST_CASE("label table needs a realized context") {
+    CHECK_EQ(dasher_set_label_ids_enabled(nullptr, 1), -1);
+    CHECK_EQ(dasher_get_label_table(nullptr, nullptr, nullptr), -1);
+}
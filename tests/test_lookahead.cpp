@@ -0,0 +1,111 @@
+// Look-ahead expansion tests: with LP_LOOKAHEAD_FRAMES set, the model's recent
+// steps are extrapolated to where the crosshair is heading, and the nodes on
+// the way which will be big enough to cover it are expanded at the end of the
+// frame, rather than forcibly, mid-render, when the crosshair gets there. So
+// steering fast must force fewer expansions (the counts per 1000 frames are
+// printed, also for the large Mandarin alphabet), while writing exactly the
+// same text; and a paused model must expand nothing ahead. With the default
+// node budget the policy nearly always gets there first anyway, so the runs
+// use a small one, as a slow device would.
+#include "test_common.h"
+
+#include <chrono>
+#include <string>
+
+namespace {
+
+struct Run {
+    long long forced = 0;
+    long long ahead = 0;
+    int frames = 0;
+    double ms = 0;
+    std::string text;
+};
+
+// Steers up and down the screen at 400% speed, counting expansions
+Run steer(dasher_ctx* ctx, int frames) {
+    Run run;
+    start_zooming(ctx);
+    long long forced0 = 0, ahead0 = 0;
+    REQUIRE_EQ(dasher_get_lookahead_stats(ctx, &forced0, &ahead0), 0);
+    const auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; i++) {
+        steer_frame(ctx, i);
+        run.frames++;
+    }
+    run.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    dasher_mouse_down(ctx);
+    dasher_mouse_up(ctx);
+    REQUIRE_EQ(dasher_get_lookahead_stats(ctx, &run.forced, &run.ahead), 0);
+    run.forced -= forced0;
+    run.ahead -= ahead0;
+    run.text = dasher_get_output_text(ctx);
+    return run;
+}
+
+// (small enough that the crosshair often reaches nodes not yet expanded)
+const long kNodeBudget = 300;
+
+Run steer_with(const char* alphabet, long lookahead, int frames) {
+    ScopedContext ctx(800, 600);
+    set_long(ctx, "LP_NODE_BUDGET", kNodeBudget);
+    if (alphabet) {
+        dasher_set_alphabet_id(ctx, alphabet);
+        REQUIRE(std::string(dasher_get_alphabet_id(ctx)) == alphabet);
+    }
+    set_long(ctx, "LP_LOOKAHEAD_FRAMES", lookahead);
+    return steer(ctx, frames);
+}
+
+} // namespace
+
+TEST_CASE("looking ahead forces fewer expansions, and writes the same") {
+    const Run off = steer_with(nullptr, 0, 1000);
+    const Run on = steer_with(nullptr, 10, 1000);
+    CHECK(off.forced > 0);
+    CHECK_EQ(off.ahead, 0);
+    CHECK(on.ahead > 0);
+    CHECK(on.forced < off.forced);
+    CHECK(!off.text.empty());
+    CHECK(on.text == off.text);
+}
+
+TEST_CASE("nothing is expanded ahead while paused") {
+    ScopedContext ctx(800, 600);
+    set_long(ctx, "LP_LOOKAHEAD_FRAMES", 10);
+    run_frames(ctx, 50);
+    long long forced = 0, ahead = -1;
+    REQUIRE_EQ(dasher_get_lookahead_stats(ctx, &forced, &ahead), 0);
+    CHECK_EQ(ahead, 0);
+}
+
+TEST_CASE("a zero time budget expands nothing ahead") {
+    ScopedContext ctx(800, 600);
+    set_long(ctx, "LP_NODE_BUDGET", kNodeBudget);
+    set_long(ctx, "LP_LOOKAHEAD_FRAMES", 10);
+    set_long(ctx, "LP_LOOKAHEAD_TIME", 0);
+    const Run run = steer(ctx, 300);
+    CHECK_EQ(run.ahead, 0);
+}
+
+TEST_CASE("bench/forced expansions per 1000 frames at 400%") {
+    const char* alphabets[] = {nullptr, "Mandarin (simp) by Pinyin, tone last"};
+    for (const char* alphabet : alphabets) {
+        const std::string name = alphabet ? alphabet : "default";
+        CAPTURE(name);
+        const Run off = steer_with(alphabet, 0, 2000);
+        printf("  %s, no look-ahead: %.0f forced per 1000 frames (%.3f ms/frame)\n", name.c_str(),
+               1000.0 * off.forced / off.frames, off.ms / off.frames);
+        for (long frames : {5L, 10L, 20L}) {
+            const Run on = steer_with(alphabet, frames, 2000);
+            printf("  %s, %ld frames ahead: %.0f forced, %.0f ahead per 1000 frames (%.3f ms/frame)\n", name.c_str(),
+                   frames, 1000.0 * on.forced / on.frames, 1000.0 * on.ahead / on.frames, on.ms / on.frames);
+            CHECK(on.forced <= off.forced);
+        }
+    }
+}
+
+TEST_CASE("lookahead stats need a realized context") {
+    long long forced = 0;
+    CHECK_EQ(dasher_get_lookahead_stats(nullptr, &forced, nullptr), -1);
+}
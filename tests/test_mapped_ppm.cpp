@@ -0,0 +1,212 @@
+// Mapped PPM tests: the MappedPPM language model (id 5) serves predictions
+// from a memory-mapped trie image, with a heap overlay for whatever is
+// learnt during the session. It must predict exactly as the standard PPM
+// model (id 0) does for the same training, whether the image was just
+// written, mapped from a previous session, or shared with another context.
+// An image shipped in the data dir is used whatever the user's own text (which
+// is learnt into the overlay), and a corrupt one must never be read out of range.
+// Contexts writing the same image at once each write a temporary file of their own.
+#include "test_common.h"
+
+#include <thread>
+#include <vector>
+
+namespace {
+
+const int MAPPED_PPM = 5;
+
+std::vector<std::filesystem::path> image_files(const std::string& dir) {
+    std::vector<std::filesystem::path> out;
+    for (auto& entry : std::filesystem::directory_iterator(dir))
+        if (entry.path().extension() == ".ppmimage") out.push_back(entry.path());
+    return out;
+}
+
+dasher_ctx* create_with_lm(const ScopedTempDir& dir, int lm) {
+    dasher_ctx* ctx = dasher_create(TEST_DATA_DIR, dir.c_str(), nullptr);
+    REQUIRE(ctx);
+    dasher_set_screen_size(ctx, 800, 600);
+    dasher_set_language_model_id(ctx, lm);
+    REQUIRE_EQ(dasher_get_language_model_id(ctx), lm);
+    return ctx;
+}
+
+const char* const LEARNT_TEXT = "the quick brown fox jumps over the lazy dog. zyxxy qqq jjj "
+                                "the quick brown fox jumps over the lazy dog.";
+
+} // namespace
+
+TEST_CASE("mapped ppm is registered") {
+    CHECK_EQ(std::string(dasher_get_language_model_name(MAPPED_PPM)), "MappedPPM");
+}
+
+TEST_CASE("mapped ppm writes an image and matches ppm") {
+    ScopedTempDir ppmDir, mappedDir;
+    dasher_ctx* ppm = create_with_lm(ppmDir, 0);
+    dasher_ctx* mapped = create_with_lm(mappedDir, MAPPED_PPM);
+
+    CHECK_EQ(image_files(mappedDir.path).size(), 1u);
+    auto expected = probabilities(ppm);
+    REQUIRE(!expected.empty());
+    CHECK_EQ(probabilities(mapped), expected);
+
+    dasher_destroy(mapped);
+    dasher_destroy(ppm);
+}
+
+TEST_CASE("mapped ppm reuses the image from a previous session") {
+    ScopedTempDir dir;
+    dasher_ctx* first = create_with_lm(dir, MAPPED_PPM);
+    auto expected = probabilities(first);
+    dasher_destroy(first);
+
+    auto images = image_files(dir.path);
+    REQUIRE(images.size() == 1u);
+    const auto written = std::filesystem::last_write_time(images[0]);
+
+    // Two live contexts mapping the same image at once
+    dasher_ctx* a = create_with_lm(dir, MAPPED_PPM);
+    dasher_ctx* b = create_with_lm(dir, MAPPED_PPM);
+    CHECK_EQ(std::filesystem::last_write_time(images[0]), written); // mapped, not retrained and rewritten
+    CHECK_EQ(probabilities(a), expected);
+    CHECK_EQ(probabilities(b), expected);
+    dasher_destroy(b);
+    dasher_destroy(a);
+}
+
+TEST_CASE("mapped ppm learns into its overlay exactly as ppm learns") {
+    ScopedTempDir ppmDir, mappedDir;
+    dasher_ctx* ppm = create_with_lm(ppmDir, 0);
+    dasher_ctx* mapped = create_with_lm(mappedDir, MAPPED_PPM);
+
+    for (int round = 0; round < 3; round++) {
+        REQUIRE_EQ(dasher_import_training_text(ppm, LEARNT_TEXT), 0);
+        REQUIRE_EQ(dasher_import_training_text(mapped, LEARNT_TEXT), 0);
+        run_frames(ppm, 2);
+        run_frames(mapped, 2);
+        auto expected = probabilities(ppm);
+        REQUIRE(!expected.empty());
+        CHECK_EQ(expected.back(), 65536);
+        CHECK_EQ(probabilities(mapped), expected);
+    }
+
+    dasher_destroy(mapped);
+    dasher_destroy(ppm);
+}
+
+TEST_CASE("corrupt ppm image is retrained and replaced") {
+    ScopedTempDir dir;
+    dasher_ctx* first = create_with_lm(dir, MAPPED_PPM);
+    auto expected = probabilities(first);
+    dasher_destroy(first);
+
+    auto images = image_files(dir.path);
+    REQUIRE(images.size() == 1u);
+    const auto size = std::filesystem::file_size(images[0]);
+    std::filesystem::resize_file(images[0], size - 16); // lose the last node
+
+    dasher_ctx* again = create_with_lm(dir, MAPPED_PPM);
+    CHECK_EQ(probabilities(again), expected);
+    CHECK_EQ(std::filesystem::file_size(images[0]), size);
+    dasher_destroy(again);
+}
+
+TEST_CASE("an image shipped in the data dir is used, whatever the user has written") {
+    ScopedTempDir trainDir, tmp, userDir, ppmDir;
+    dasher_destroy(create_with_lm(trainDir, MAPPED_PPM));
+    auto images = image_files(trainDir.path);
+    REQUIRE(images.size() == 1u);
+
+    // Shipped alongside a corpus installed later than the image was trained (so a different fingerprint)
+    const std::string dataDir = build_data_dir(tmp);
+    const std::filesystem::path training = std::filesystem::path(dataDir) / "Data" / "training";
+    const std::filesystem::path corpus = training / "training_english_GB.txt";
+    const std::filesystem::path real = std::filesystem::canonical(corpus);
+    std::filesystem::remove(corpus);
+    std::filesystem::copy_file(real, corpus);
+    std::filesystem::copy_file(images[0], training / images[0].filename());
+
+    std::string text;
+    for (int i = 0; i < 50; i++)
+        text += LEARNT_TEXT;
+    for (const ScopedTempDir* dir : {&userDir, &ppmDir})
+        std::ofstream(std::filesystem::path(dir->path) / "training_english_GB.txt") << text;
+    dasher_invalidate_file_index();
+
+    dasher_ctx* mapped = dasher_create(dataDir.c_str(), userDir.c_str(), nullptr);
+    REQUIRE(mapped);
+    dasher_set_screen_size(mapped, 800, 600);
+    dasher_set_language_model_id(mapped, MAPPED_PPM);
+    REQUIRE_EQ(dasher_get_language_model_id(mapped), MAPPED_PPM);
+    CHECK(image_files(userDir.path).empty()); // mapped as shipped, not retrained
+    // with the user's text learnt into the overlay
+    dasher_ctx* ppm = create_with_lm(ppmDir, 0);
+    CHECK_EQ(probabilities(mapped), probabilities(ppm));
+    dasher_destroy(ppm);
+    dasher_destroy(mapped);
+}
+
+TEST_CASE("an image with symbols out of range is used without reading past the alphabet") {
+    ScopedTempDir dir;
+    dasher_destroy(create_with_lm(dir, MAPPED_PPM));
+    auto images = image_files(dir.path);
+    REQUIRE(images.size() == 1u);
+    {
+        // The root's first children: their symbols (the header and alphabet ID pad the nodes to 4096 bytes;
+        //  each node is 16 bytes, with its symbol at 12)
+        std::fstream f(images[0], std::ios::in | std::ios::out | std::ios::binary);
+        for (int node = 1; node <= 3; node++) {
+            f.seekp(4096 + 16 * node + 12);
+            const uint16_t symbol = node == 1 ? 0 : 0xFFFF;
+            f.write(reinterpret_cast<const char*>(&symbol), sizeof(symbol));
+        }
+    }
+    dasher_ctx* ctx = create_with_lm(dir, MAPPED_PPM);
+    const auto probs = probabilities(ctx);
+    REQUIRE(!probs.empty());
+    CHECK_EQ(probs.back(), 65536);
+    dasher_destroy(ctx);
+}
+
+TEST_CASE("an image with a vine out of range is retrained and replaced") {
+    ScopedTempDir dir;
+    dasher_ctx* first = create_with_lm(dir, MAPPED_PPM);
+    auto expected = probabilities(first);
+    dasher_destroy(first);
+
+    auto images = image_files(dir.path);
+    REQUIRE(images.size() == 1u);
+    {
+        // Node 2's vine (at 4 in each 16-byte node) to no node, as if the root
+        std::fstream f(images[0], std::ios::in | std::ios::out | std::ios::binary);
+        f.seekp(4096 + 16 * 2 + 4);
+        const uint32_t vine = 0xFFFFFFFF;
+        f.write(reinterpret_cast<const char*>(&vine), sizeof(vine));
+    }
+    dasher_ctx* again = create_with_lm(dir, MAPPED_PPM);
+    CHECK_EQ(probabilities(again), expected);
+    // Learning into the overlay follows vines, which must all be in range now
+    REQUIRE_EQ(dasher_import_training_text(again, LEARNT_TEXT), 0);
+    run_frames(again, 2);
+    CHECK_EQ(probabilities(again).back(), 65536);
+    dasher_destroy(again);
+}
+
+TEST_CASE("contexts writing the same image at once leave one whole image") {
+    ScopedTempDir dir;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++)
+        threads.emplace_back([&dir]() { dasher_destroy(create_with_lm(dir, MAPPED_PPM)); });
+    for (std::thread& t : threads)
+        t.join();
+
+    REQUIRE(image_files(dir.path).size() == 1u);
+    for (auto& entry : std::filesystem::directory_iterator(dir.path))
+        CHECK(entry.path().filename().string().find(".tmp") == std::string::npos);
+    dasher_ctx* mapped = create_with_lm(dir, MAPPED_PPM);
+    ScopedTempDir ppmDir;
+    dasher_ctx* ppm = create_with_lm(ppmDir, 0);
+    CHECK_EQ(probabilities(mapped), probabilities(ppm));
+    dasher_destroy(ppm);
+    dasher_destroy(mapped);
+}
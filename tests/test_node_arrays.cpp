@@ -0,0 +1,232 @@
+// Node arrays tests: with dasher_set_visible_node_arrays_enabled, each frame
+// records the nodes it draws as parallel arrays, read in place between
+// dasher_acquire_visible_node_arrays and dasher_release_visible_node_arrays.
+// They must give just the nodes dasher_get_visible_nodes does, value for
+// value (labels by id, through the label table); the frame held must not
+// change while the next are rendered, and is replaced by the latest on its
+// release; and a reader on another thread, while frames keep coming, must
+// only ever see whole frames, in order. The benchmark prints the time to read
+// a frame's nodes both ways, and frame times with each on, at 400% speed.
+#include "test_common.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::vector<dasher_node_info> visible_nodes(dasher_ctx* ctx, std::vector<std::string>& labels) {
+    std::vector<dasher_node_info> nodes(64);
+    int n = 0;
+    char** strs = nullptr;
+    int str_count = 0;
+    for (;;) {
+        for (dasher_node_info& node : nodes)
+            node.struct_size = sizeof(dasher_node_info);
+        n = dasher_get_visible_nodes(ctx, nodes.data(), static_cast<int>(nodes.size()), &strs, &str_count);
+        REQUIRE(n >= 0);
+        if (n <= static_cast<int>(nodes.size())) break;
+        nodes.resize(n);
+    }
+    nodes.resize(n);
+    labels.assign(strs, strs + str_count);
+    return nodes;
+}
+
+// Whether the arrays hold a frame drawn whole: each node at most a level deeper than the one
+//  before, and every range and rectangle the right way round. (Not that the root comes first:
+//  nodes drawn transparent, as the root may be, are not recorded.)
+bool whole(const dasher_node_arrays& arrays) {
+    if (arrays.count <= 0) return false;
+    for (int i = 0; i < arrays.count; i++) {
+        if (i && arrays.depth[i] > arrays.depth[i - 1] + 1) return false;
+        if (arrays.dasher_y1[i] >= arrays.dasher_y2[i]) return false;
+        if (arrays.screen_x1[i] > arrays.screen_x2[i] || arrays.screen_y1[i] > arrays.screen_y2[i]) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+TEST_CASE("node arrays are off by default") {
+    ScopedContext ctx(800, 600);
+    run_frames(ctx, 3);
+    dasher_node_arrays arrays = {};
+    arrays.struct_size = sizeof(arrays);
+    CHECK_EQ(dasher_acquire_visible_node_arrays(ctx, &arrays), -1);
+    CHECK_EQ(dasher_release_visible_node_arrays(ctx), -1);
+    REQUIRE_EQ(dasher_set_visible_node_arrays_enabled(ctx, 1), 0);
+    // (nothing recorded until the next frame)
+    CHECK_EQ(dasher_acquire_visible_node_arrays(ctx, &arrays), -1);
+    run_frames(ctx, 1, 2000);
+    CHECK(dasher_acquire_visible_node_arrays(ctx, &arrays) > 0);
+    CHECK_EQ(arrays.frame, 1);
+    // One reader at a time
+    dasher_node_arrays again = {};
+    again.struct_size = sizeof(again);
+    CHECK_EQ(dasher_acquire_visible_node_arrays(ctx, &again), -1);
+    CHECK_EQ(dasher_release_visible_node_arrays(ctx), 0);
+    CHECK_EQ(dasher_release_visible_node_arrays(ctx), -1);
+    // A caller built against a smaller struct is refused
+    dasher_node_arrays small = {};
+    small.struct_size = static_cast<int>(sizeof(small)) - 8;
+    CHECK_EQ(dasher_acquire_visible_node_arrays(ctx, &small), -1);
+}
+
+TEST_CASE("node arrays give the same nodes as dasher_get_visible_nodes") {
+    ScopedContext ctx(800, 600);
+    REQUIRE_EQ(dasher_set_visible_nodes_enabled(ctx, 1), 0);
+    REQUIRE_EQ(dasher_set_visible_node_arrays_enabled(ctx, 1), 0);
+    start_zooming(ctx, 780.0f);
+    int compared = 0;
+    for (int i = 0; i < 200; i++) {
+        steer_frame(ctx, i, 2000, 780.0f, 20, 250.0f);
+        if (i % 20) continue;
+        std::vector<std::string> strings;
+        const std::vector<dasher_node_info> nodes = visible_nodes(ctx, strings);
+        char** labels = nullptr;
+        int label_count = 0;
+        REQUIRE(dasher_get_label_table(ctx, &labels, &label_count) >= 0);
+        dasher_node_arrays arrays = {};
+        arrays.struct_size = sizeof(arrays);
+        REQUIRE_EQ(dasher_acquire_visible_node_arrays(ctx, &arrays), static_cast<int>(nodes.size()));
+        for (int j = 0; j < arrays.count; j++) {
+            const dasher_node_info& node = nodes[j];
+            CHECK_EQ(arrays.dasher_y1[j], node.dasher_y1);
+            CHECK_EQ(arrays.dasher_y2[j], node.dasher_y2);
+            CHECK_EQ(arrays.depth[j], node.depth);
+            CHECK_EQ(arrays.screen_x1[j], node.screen_x1);
+            CHECK_EQ(arrays.screen_y1[j], node.screen_y1);
+            CHECK_EQ(arrays.screen_x2[j], node.screen_x2);
+            CHECK_EQ(arrays.screen_y2[j], node.screen_y2);
+            CHECK_EQ(arrays.fill_argb[j], node.fill_argb);
+            CHECK_EQ(arrays.outline_argb[j], node.outline_argb);
+            CHECK_EQ(arrays.symbol[j], node.symbol);
+            CHECK_EQ((arrays.flags[j] & 1) != 0, node.has_children != 0);
+            CHECK_EQ((arrays.flags[j] & 2) != 0, node.is_game_node != 0);
+            // (a label with no text has an id, but no string)
+            const int id = arrays.label_id[j];
+            REQUIRE(id < label_count);
+            const std::string text = id >= 0 && labels[id] ? labels[id] : "";
+            CHECK(text == (node.label_index >= 0 ? strings[node.label_index] : ""));
+        }
+        REQUIRE_EQ(dasher_release_visible_node_arrays(ctx), 0);
+        compared++;
+    }
+    CHECK_EQ(compared, 10);
+}
+
+TEST_CASE("the frame held is not written while the next are rendered") {
+    ScopedContext ctx(800, 600);
+    REQUIRE_EQ(dasher_set_visible_node_arrays_enabled(ctx, 1), 0);
+    start_zooming(ctx, 780.0f);
+    for (int i = 0; i < 20; i++)
+        steer_frame(ctx, i, 2000, 780.0f, 20, 250.0f);
+    dasher_node_arrays held = {};
+    held.struct_size = sizeof(held);
+    REQUIRE(dasher_acquire_visible_node_arrays(ctx, &held) > 0);
+    const std::vector<int64_t> y1(held.dasher_y1, held.dasher_y1 + held.count);
+    const std::vector<int> x1(held.screen_x1, held.screen_x1 + held.count);
+    const long long frame_held = held.frame;
+    for (int i = 20; i < 40; i++)
+        steer_frame(ctx, i, 2000, 780.0f, 20, 250.0f);
+    CHECK(std::vector<int64_t>(held.dasher_y1, held.dasher_y1 + held.count) == y1);
+    CHECK(std::vector<int>(held.screen_x1, held.screen_x1 + held.count) == x1);
+    REQUIRE_EQ(dasher_release_visible_node_arrays(ctx), 0);
+    // The release hands over the last frame finished; those before it were dropped
+    dasher_node_arrays latest = {};
+    latest.struct_size = sizeof(latest);
+    REQUIRE(dasher_acquire_visible_node_arrays(ctx, &latest) > 0);
+    CHECK_EQ(latest.frame, frame_held + 20);
+    REQUIRE_EQ(dasher_release_visible_node_arrays(ctx), 0);
+    long long frames = 0, dropped = 0;
+    REQUIRE_EQ(dasher_get_visible_node_arrays_stats(ctx, &frames, &dropped), 0);
+    CHECK_EQ(frames, frame_held + 20);
+    CHECK_EQ(dropped, 19);
+}
+
+TEST_CASE("a reader on another thread sees whole frames, in order") {
+    ScopedContext ctx(800, 600);
+    REQUIRE_EQ(dasher_set_visible_node_arrays_enabled(ctx, 1), 0);
+    start_zooming(ctx, 780.0f);
+    std::atomic<bool> done{false};
+    std::atomic<int> reads{0}, torn{0}, backwards{0};
+    std::thread reader([&] {
+        long long last = 0;
+        while (!done) {
+            dasher_node_arrays arrays = {};
+            arrays.struct_size = sizeof(arrays);
+            if (dasher_acquire_visible_node_arrays(ctx, &arrays) < 0) {
+                std::this_thread::yield();
+                continue;
+            }
+            if (arrays.frame < last) backwards++;
+            if (!whole(arrays)) torn++;
+            last = arrays.frame;
+            reads++;
+            dasher_release_visible_node_arrays(ctx);
+            std::this_thread::yield();
+        }
+    });
+    for (int i = 0; i < 400; i++)
+        steer_frame(ctx, i, 2000, 780.0f, 20, 250.0f);
+    done = true;
+    reader.join();
+    CHECK(reads > 0);
+    CHECK_EQ(torn.load(), 0);
+    CHECK_EQ(backwards.load(), 0);
+}
+
+TEST_CASE("bench/reading the visible nodes, copied and as arrays") {
+    for (int arrays_on = 0; arrays_on < 2; arrays_on++) {
+        ScopedContext ctx(800, 600);
+        REQUIRE_EQ((arrays_on ? dasher_set_visible_node_arrays_enabled : dasher_set_visible_nodes_enabled)(ctx, 1), 0);
+        start_zooming(ctx, 780.0f);
+        std::vector<double> frame_us, read_us;
+        std::vector<dasher_node_info> nodes(4096);
+        long long total = 0;
+        for (int i = 0; i < 1200; i++) {
+            const auto t0 = std::chrono::steady_clock::now();
+            steer_frame(ctx, i, 2000, 780.0f, 20, 250.0f);
+            const auto t1 = std::chrono::steady_clock::now();
+            if (arrays_on) {
+                dasher_node_arrays arrays = {};
+                arrays.struct_size = sizeof(arrays);
+                const int n = dasher_acquire_visible_node_arrays(ctx, &arrays);
+                for (int j = 0; j < n; j++)
+                    total += arrays.screen_x2[j] - arrays.screen_x1[j];
+                dasher_release_visible_node_arrays(ctx);
+            } else {
+                for (dasher_node_info& node : nodes)
+                    node.struct_size = sizeof(dasher_node_info);
+                char** strs = nullptr;
+                int str_count = 0;
+                const int n = dasher_get_visible_nodes(ctx, nodes.data(), static_cast<int>(nodes.size()), &strs,
+                                                       &str_count);
+                for (int j = 0; j < std::min(n, static_cast<int>(nodes.size())); j++)
+                    total += nodes[j].screen_x2 - nodes[j].screen_x1;
+            }
+            const auto t2 = std::chrono::steady_clock::now();
+            frame_us.push_back(std::chrono::duration<double, std::micro>(t1 - t0).count());
+            read_us.push_back(std::chrono::duration<double, std::micro>(t2 - t1).count());
+        }
+        std::sort(frame_us.begin(), frame_us.end());
+        std::sort(read_us.begin(), read_us.end());
+        printf("  %s: read p50 %.1f us, p99 %.1f us; frame p50 %.0f us, p99 %.0f us (%lld)\n",
+               arrays_on ? "arrays, in place" : "dasher_get_visible_nodes", read_us[read_us.size() / 2],
+               read_us[read_us.size() * 99 / 100], frame_us[frame_us.size() / 2],
+               frame_us[frame_us.size() * 99 / 100], total);
+    }
+}
+
+TEST_CASE("node arrays need a realized context") {
+    dasher_node_arrays arrays = {};
+    arrays.struct_size = sizeof(arrays);
+    CHECK_EQ(dasher_set_visible_node_arrays_enabled(nullptr, 1), -1);
+    CHECK_EQ(dasher_acquire_visible_node_arrays(nullptr, &arrays), -1);
+    CHECK_EQ(dasher_release_visible_node_arrays(nullptr), -1);
+    CHECK_EQ(dasher_get_visible_node_arrays_stats(nullptr, nullptr, nullptr), -1);
+}
@@ -0,0 +1,89 @@
+// Node memory tests: a node's children (and their Hbnds) are kept in one
+// array, allocated when it is expanded for as many children as expected, and
+// freed when it is collapsed - a node without children needs no heap memory
+// at all (a std::deque allocated a map and a 512-byte block for every node).
+// So zooming in must take well under the two heap allocations per node created
+// that the deque did on its own (the nodes themselves come from the model's
+// node pool; what is left is mostly the language model's contexts), and what
+// collapsing frees per node must be about the size of its children's pointers.
+// The benchmark prints the heap allocations and bytes per node created, the
+// heap bytes freed per node collapsed, and sizeof(CDasherNode).
+//
+// Counts every global operator new, so is built with CAPI.cpp and the static
+// DasherCore (see dasher_add_test_counting).
+
+#include "test_common.h"
+
+#include "DasherCore/DasherNode.h"
+
+namespace {
+
+long long nodes_allocated(dasher_ctx* ctx) {
+    long long count = 0;
+    REQUIRE_EQ(dasher_get_node_pool_stats(ctx, nullptr, nullptr, &count, nullptr), 0);
+    return count;
+}
+
+long long nodes_live(dasher_ctx* ctx) {
+    long long count = 0;
+    REQUIRE_EQ(dasher_get_node_pool_stats(ctx, &count, nullptr, nullptr, nullptr), 0);
+    return count;
+}
+
+// Zooms in, steering up and down
+void zoom(dasher_ctx* ctx, int frames, int64_t start_ms) {
+    for (int i = 0; i < frames; i++)
+        steer_frame(ctx, i, start_ms, 780.0f, 20, 250.0f);
+}
+
+struct PerNode {
+    double allocations = 0, bytes = 0;
+};
+
+// Heap allocations and bytes per node created, zooming in
+PerNode per_node_created() {
+    ScopedContext ctx(800, 600);
+    start_zooming(ctx, 780.0f);
+    zoom(ctx, 240, 2000); // warm up
+    const long long iNodes = nodes_allocated(ctx), iAllocations = g_iAllocations, iBytes = g_iBytes;
+    zoom(ctx, 1200, 2000 + 240 * 16);
+    const double nodes = static_cast<double>(nodes_allocated(ctx) - iNodes);
+    REQUIRE(nodes > 0);
+    return {(g_iAllocations - iAllocations) / nodes, (g_iBytes - iBytes) / nodes};
+}
+
+// Heap bytes freed per node, collapsing the tree down to a small budget
+double bytes_per_node_collapsed() {
+    ScopedContext ctx(800, 600);
+    run_frames(ctx, 50);
+    const long long iLive = nodes_live(ctx), iBytes = g_iLiveBytes;
+    const int budgetKey = dasher_find_parameter_key("LP_NODE_BUDGET");
+    REQUIRE(budgetKey >= 0);
+    dasher_set_long_parameter(ctx, budgetKey, 100);
+    run_frames(ctx, 50, 2000);
+    const long long iCollapsed = iLive - nodes_live(ctx);
+    REQUIRE(iCollapsed > 0);
+    return static_cast<double>(iBytes - g_iLiveBytes) / static_cast<double>(iCollapsed);
+}
+
+} // namespace
+
+TEST_CASE("expanding nodes takes little from the heap per node created") {
+    // (over 5 allocations and 770 bytes with a deque per node)
+    const PerNode created = per_node_created();
+    CHECK(created.allocations < 4.0);
+    CHECK(created.bytes < 400.0);
+}
+
+TEST_CASE("collapsing frees about the children's pointers per node") {
+    // (a pointer and an Hbnd per child, less whatever the language model held)
+    CHECK(bytes_per_node_collapsed() < 64.0);
+}
+
+TEST_CASE("bench/heap memory per node") {
+    const PerNode created = per_node_created();
+    printf("  zooming at 400%%: %.2f heap allocations, %.0f bytes per node created\n", created.allocations,
+           created.bytes);
+    printf("  collapsing: %.0f heap bytes freed per node; sizeof(CDasherNode) %zu\n", bytes_per_node_collapsed(),
+           sizeof(Dasher::CDasherNode));
+}
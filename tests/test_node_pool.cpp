@@ -0,0 +1,102 @@
+// Node pool tests: the nodes the model creates, as it expands others, take
+// their memory from a per-model pool of slabs, in a size class per kind of
+// node, and give it back there when collapsed, for the next node of that size.
+// Zooming in and out, over and over, must then reuse the same nodes: after a
+// first round, another allocates thousands of nodes but no more memory. The
+// counts must balance, and each context must have a pool of its own. The
+// benchmark prints the nodes allocated and freed per second, and frame times,
+// while zooming in and out at 400% speed.
+#include "test_common.h"
+
+#include <chrono>
+#include <vector>
+
+namespace {
+
+struct PoolStats {
+    long long live = 0, free = 0, allocated = 0, freed = 0;
+};
+
+PoolStats pool_stats(dasher_ctx* ctx) {
+    PoolStats stats;
+    REQUIRE_EQ(dasher_get_node_pool_stats(ctx, &stats.live, &stats.free, &stats.allocated, &stats.freed), 0);
+    return stats;
+}
+
+// Zooms in, then out, each for 60 frames, steering up and down meanwhile; times each frame
+void zoom(dasher_ctx* ctx, int frames, int64_t start_ms, std::vector<double>* frame_us = nullptr) {
+    for (int i = 0; i < frames; i++) {
+        const bool in = (i / 60) % 2 == 0;
+        const auto t0 = std::chrono::steady_clock::now();
+        steer_frame(ctx, i, start_ms, in ? 780.0f : 20.0f, 20, 250.0f);
+        if (frame_us)
+            frame_us->push_back(
+                std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count());
+    }
+}
+
+} // namespace
+
+TEST_CASE("zooming in and out reuses the nodes collapsed") {
+    ScopedContext ctx(800, 600);
+    start_zooming(ctx, 780.0f);
+    zoom(ctx, 600, 2000);
+    const PoolStats first = pool_stats(ctx);
+    CHECK(first.allocated > 1000);
+    CHECK(first.free > 0);
+    zoom(ctx, 600, 2000 + 600 * 16);
+    const PoolStats second = pool_stats(ctx);
+    // Thousands more nodes, from the same memory
+    CHECK(second.allocated - first.allocated > 1000);
+    CHECK(second.live + second.free <= first.live + first.free);
+}
+
+TEST_CASE("node pool counts balance") {
+    ScopedContext ctx(800, 600);
+    start_zooming(ctx, 780.0f);
+    zoom(ctx, 300, 2000);
+    const PoolStats stats = pool_stats(ctx);
+    CHECK(stats.live > 0);
+    CHECK_EQ(stats.allocated - stats.freed, stats.live);
+    // Changing alphabet rebuilds the tree, in the same model
+    dasher_set_alphabet_id(ctx, "Hiragana ひらがな 83");
+    run_frames(ctx, 20, 20000);
+    const PoolStats after = pool_stats(ctx);
+    CHECK(after.freed > stats.freed);
+    CHECK_EQ(after.allocated - after.freed, after.live);
+}
+
+TEST_CASE("each context has its own node pool") {
+    ScopedContext a(800, 600);
+    ScopedContext b(800, 600);
+    const PoolStats before = pool_stats(b);
+    start_zooming(a, 780.0f);
+    zoom(a, 200, 2000);
+    CHECK(pool_stats(a).allocated > 0);
+    const PoolStats after = pool_stats(b);
+    CHECK_EQ(after.allocated, before.allocated);
+    CHECK_EQ(after.freed, before.freed);
+}
+
+TEST_CASE("bench/nodes allocated and freed while zooming in and out at 400%") {
+    ScopedContext ctx(800, 600);
+    start_zooming(ctx, 780.0f);
+    zoom(ctx, 240, 2000); // warm up
+    const PoolStats before = pool_stats(ctx);
+    std::vector<double> frame_us;
+    const auto t0 = std::chrono::steady_clock::now();
+    zoom(ctx, 2400, 2000 + 240 * 16, &frame_us);
+    const double seconds = seconds_since(t0);
+    const PoolStats after = pool_stats(ctx);
+    printf("  %.0f nodes allocated, %.0f freed per second (%.1f per frame); %lld live, %lld free; "
+           "frame p50 %.0f us, p99 %.0f us\n",
+           (after.allocated - before.allocated) / seconds, (after.freed - before.freed) / seconds,
+           static_cast<double>(after.allocated - before.allocated) / frame_us.size(), after.live, after.free,
+           percentile(frame_us, 0.5), percentile(frame_us, 0.99));
+    CHECK(after.allocated > before.allocated);
+}
+
+TEST_CASE("node pool stats need a realized context") {
+    long long live = 0;
+    CHECK_EQ(dasher_get_node_pool_stats(nullptr, &live, nullptr, nullptr, nullptr), -1);
+}
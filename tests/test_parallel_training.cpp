@@ -0,0 +1,135 @@
+// Parallel training tests: with LP_TRAINING_THREADS > 1, each training file
+// is split into shards learnt on separate threads, then merged. The merged
+// model must be exactly the one sequential training builds - every node,
+// count and vine - which is checked by comparing the trie each leaves in
+// its PPM snapshot (whose node order may differ, so it is canonicalized),
+// including when counts wrap (as they do, being 16-bit).
+// Also prints training times for 1/2/4/8 threads on the English corpus.
+#include "test_common.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+struct TrainedModel {
+    /// (context hash, count, vine's context hash) for every node, sorted
+    std::vector<std::tuple<uint64_t, uint16_t, uint64_t>> vNodes;
+    std::vector<int> probabilities;
+    double seconds = 0;
+};
+
+// Reads the trie from the snapshot in dir (see PPMLanguageModel.cpp for the format): records
+//  are breadth first, each node's children a contiguous run after those of the node before.
+std::vector<std::tuple<uint64_t, uint16_t, uint64_t>> read_trie(const std::string& dir) {
+    std::filesystem::path file;
+    for (auto& entry : std::filesystem::directory_iterator(dir))
+        if (entry.path().extension() == ".snapshot") file = entry.path();
+    std::ifstream in(file, std::ios::binary);
+    REQUIRE(in);
+    char header[48];
+    in.read(header, sizeof(header));
+    uint32_t iIDLength;
+    uint64_t iNumNodes;
+    memcpy(&iIDLength, header + 28, sizeof(iIDLength));
+    memcpy(&iNumNodes, header + 40, sizeof(iNumNodes));
+    in.seekg(sizeof(header) + iIDLength);
+
+    struct Record {
+        uint32_t iVine, iNumChildren;
+        uint16_t iSymbol, iCount;
+    };
+    std::vector<Record> vRecords(iNumNodes);
+    in.read(reinterpret_cast<char*>(vRecords.data()), iNumNodes * sizeof(Record));
+    REQUIRE(in);
+
+    std::vector<uint64_t> vHashes(iNumNodes);
+    std::vector<std::tuple<uint64_t, uint16_t, uint64_t>> vNodes;
+    vHashes[0] = 0xcbf29ce484222325ULL;
+    vNodes.emplace_back(vHashes[0], vRecords[0].iCount, 0);
+    size_t iParent = 0;
+    uint32_t iRemaining = vRecords[0].iNumChildren;
+    for (size_t i = 1; i < iNumNodes; i++) {
+        while (iRemaining == 0)
+            iRemaining = vRecords[++iParent].iNumChildren;
+        --iRemaining;
+        vHashes[i] = (vHashes[iParent] ^ vRecords[i].iSymbol) * 0x100000001b3ULL;
+        vNodes.emplace_back(vHashes[i], vRecords[i].iCount, vHashes[vRecords[i].iVine - 1]);
+    }
+    std::sort(vNodes.begin(), vNodes.end());
+    return vNodes;
+}
+
+/// \param strUserText if not empty, the user's own training text, learnt after the system's
+TrainedModel train(int iThreads, const char* szAlphabet = nullptr, int iMaxOrder = 0, int iUpdateExclusion = -1,
+                   const std::string& strUserText = "") {
+    ScopedTempDir dir;
+    TrainedModel model;
+    if (!strUserText.empty()) std::ofstream(dir.path + "/training_english_GB.txt") << strUserText;
+    const auto start = std::chrono::steady_clock::now();
+    dasher_ctx* ctx = dasher_create(TEST_DATA_DIR, dir.c_str(), nullptr);
+    REQUIRE(ctx);
+    dasher_set_long_parameter(ctx, dasher_find_parameter_key("LP_TRAINING_THREADS"), iThreads);
+    if (szAlphabet) dasher_set_alphabet_id(ctx, szAlphabet);
+    if (iMaxOrder) dasher_set_long_parameter(ctx, dasher_find_parameter_key("LP_LM_MAX_ORDER"), iMaxOrder);
+    if (iUpdateExclusion >= 0)
+        dasher_set_long_parameter(ctx, dasher_find_parameter_key("LP_LM_UPDATE_EXCLUSION"), iUpdateExclusion);
+    dasher_set_screen_size(ctx, 800, 600);
+    model.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    model.probabilities = probabilities(ctx);
+    dasher_destroy(ctx);
+    model.vNodes = read_trie(dir.path);
+    return model;
+}
+
+} // namespace
+
+TEST_CASE("parallel training builds exactly the sequentially trained model") {
+    int iMaxOrder = 0, iUpdateExclusion = -1;
+    std::string strUserText;
+    SUBCASE("defaults") {}
+    SUBCASE("no update exclusion") {
+        iUpdateExclusion = 0;
+    }
+    SUBCASE("order 2") {
+        iMaxOrder = 2;
+    }
+    SUBCASE("order 8, no update exclusion") {
+        iMaxOrder = 8;
+        iUpdateExclusion = 0;
+    }
+    SUBCASE("counts that wrap") {
+        // (in lines, as shards end at line breaks) each deepest context of this is
+        //  learnt 100000 times, well past 65535
+        for (int i = 0; i < 100000; i++)
+            strUserText += "abc\n";
+    }
+
+    const TrainedModel sequential = train(1, nullptr, iMaxOrder, iUpdateExclusion, strUserText);
+    REQUIRE(sequential.vNodes.size() > 1000);
+    REQUIRE(!sequential.probabilities.empty());
+    for (int iThreads : {2, 3, 4}) {
+        CAPTURE(iThreads);
+        const TrainedModel parallel = train(iThreads, nullptr, iMaxOrder, iUpdateExclusion, strUserText);
+        CHECK(parallel.vNodes == sequential.vNodes);
+        CHECK_EQ(parallel.probabilities, sequential.probabilities);
+    }
+}
+
+TEST_CASE("bench/parallel training of the English corpus at 1/2/4/8 threads") {
+    // (the default alphabet, training_english_GB.txt: the WorldAlphabets ones, with larger
+    //  corpora, have multi-character control nodes that a debug build's alphabet map rejects)
+    const TrainedModel sequential = train(1);
+    REQUIRE(sequential.vNodes.size() > 100000);
+    printf("  %zu nodes\n", sequential.vNodes.size());
+    printf("  1 thread:  %.3fs\n", sequential.seconds);
+    for (int iThreads : {2, 4, 8}) {
+        const TrainedModel parallel = train(iThreads);
+        printf("  %d threads: %.3fs (x%.2f)\n", iThreads, parallel.seconds, sequential.seconds / parallel.seconds);
+        CHECK(parallel.vNodes == sequential.vNodes);
+    }
+}
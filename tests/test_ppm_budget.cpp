@@ -0,0 +1,212 @@
+// PPM node budget tests: with LP_LM_NODE_BUDGET set, CPPMLanguageModel drops
+// its least seen contexts whenever the trie outgrows the budget, rebuilding
+// what is left in fresh storage. Learning the training corpus, over and over,
+// the trie must stay within the budget while predicting a held-out file nearly
+// as well as an unbounded model (the compact one, which predicts as PPM does,
+// to save memory). Contexts live across a prune must stay usable; and a
+// snapshot taken under one budget must not be read back under another.
+//
+// By default that learns 8 MB of three of the files; learning 100 MB takes minutes (more than
+// ctest's timeout in a debug build), so is skipped unless asked for:
+// dasher_ppm_budget_tests --no-skip.
+//
+// Built via dasher_add_test_internal (drives the language models directly).
+
+#include "test_common.h"
+
+#include "DasherCore/LanguageModelling/CompactPPMLanguageModel.h"
+#include "DasherCore/LanguageModelling/PPMLanguageModel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace Dasher;
+
+namespace {
+
+const int NORM = 1 << 16;
+const int UNIFORM = NORM * 50 / 1000;
+const int CORPUS_SYMS = 257; // a symbol (1..256) per byte
+
+// The tail of the English corpus, never learnt
+const size_t HELD_OUT_BYTES = 64 << 10;
+const char HELD_OUT_FILE[] = "training_wa_en_Latn.txt";
+
+// Bits per char on the held out text may be this much more than unbounded
+const double MAX_DEGRADATION = 0.10;
+
+std::vector<symbol> read_symbols(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    REQUIRE(in);
+    std::vector<symbol> out;
+    for (char c; in.get(c);)
+        out.push_back(static_cast<unsigned char>(c) + 1);
+    return out;
+}
+
+// The training files (all, or just those named), each as symbols, less the held out tail of one
+struct Corpus {
+    std::vector<std::vector<symbol>> files;
+    std::vector<symbol> heldOut;
+    explicit Corpus(const std::vector<std::string>& names = {}) {
+        std::vector<std::filesystem::path> paths;
+        for (const auto& entry : std::filesystem::directory_iterator(std::string(TEST_DATA_DIR) + "/Data/training"))
+            if (entry.path().extension() == ".txt" &&
+                (names.empty() ||
+                 std::find(names.begin(), names.end(), entry.path().filename().string()) != names.end()))
+                paths.push_back(entry.path());
+        std::sort(paths.begin(), paths.end());
+        for (const auto& path : paths) {
+            files.push_back(read_symbols(path));
+            if (path.filename() == HELD_OUT_FILE) {
+                std::vector<symbol>& text = files.back();
+                heldOut.assign(text.end() - HELD_OUT_BYTES, text.end());
+                text.resize(text.size() - HELD_OUT_BYTES);
+            }
+        }
+        REQUIRE(heldOut.size() == HELD_OUT_BYTES);
+    }
+};
+
+// Learns each file in a context of its own
+void learn(CLanguageModel& lm, const std::vector<symbol>& text) {
+    CLanguageModel::Context ctx = lm.CreateEmptyContext();
+    for (symbol sym : text)
+        lm.LearnSymbol(ctx, sym);
+    lm.ReleaseContext(ctx);
+}
+
+double bits_per_char(const CLanguageModel& lm, const std::vector<symbol>& text) {
+    CLanguageModel& model = const_cast<CLanguageModel&>(lm);
+    CLanguageModel::Context ctx = model.CreateEmptyContext();
+    std::vector<unsigned int> probs;
+    double bits = 0;
+    for (symbol sym : text) {
+        lm.GetProbs(ctx, probs, NORM, UNIFORM);
+        bits -= std::log2(static_cast<double>(probs[sym]) / NORM);
+        model.EnterSymbol(ctx, sym);
+    }
+    model.ReleaseContext(ctx);
+    return bits / text.size();
+}
+
+// Text over iNumSyms symbols, with short repeats, so contexts of every order recur
+std::vector<symbol> random_text(int iNumSyms, size_t iLength, unsigned int iSeed) {
+    std::mt19937 rng(iSeed);
+    std::vector<symbol> out;
+    for (size_t i = 0; i < iLength; i++) {
+        if (out.size() > 8 && rng() % 2) out.push_back(out[out.size() - 1 - rng() % 8]);
+        else out.push_back(1 + rng() % (iNumSyms - 1));
+    }
+    return out;
+}
+
+// Learns iTrainingBytes in all, cycling through the training files, under a budget of iNodeBudget
+//  nodes: within which the trie must stay, predicting the held out text nearly as well as unbounded
+void learn_within_budget(const Corpus& corpus, size_t iTrainingBytes, long iNodeBudget) {
+    LMSettings bounded(5, true, iNodeBudget), unbounded(5, true);
+    CPPMLanguageModel ppm(&bounded.store, CORPUS_SYMS);
+    CCompactPPMLanguageModel reference(&unbounded.store, CORPUS_SYMS);
+
+    // Bytes the bounded model may take: a PPM node, with its share of the child
+    //  arrays, takes 60-70 (see test_compact_ppm)
+    const size_t iMaxBytes = iNodeBudget * 80;
+    size_t iLearnt = 0, iMaxNodes = 0, iMaxUsage = 0;
+    double ppmSeconds = 0, referenceSeconds = 0;
+    for (size_t i = 0; iLearnt < iTrainingBytes; i = (i + 1) % corpus.files.size()) {
+        const std::vector<symbol>& text = corpus.files[i];
+        const std::vector<symbol> part(text.begin(), text.begin() + std::min(text.size(), iTrainingBytes - iLearnt));
+        auto start = std::chrono::steady_clock::now();
+        learn(ppm, part);
+        ppmSeconds += seconds_since(start);
+        start = std::chrono::steady_clock::now();
+        learn(reference, part);
+        referenceSeconds += seconds_since(start);
+        iLearnt += part.size();
+
+        const size_t iUsage = ppm.GetMemoryUsage();
+        iMaxNodes = std::max(iMaxNodes, ppm.GetNodeCount());
+        iMaxUsage = std::max(iMaxUsage, iUsage);
+        REQUIRE(ppm.GetNodeCount() <= static_cast<size_t>(iNodeBudget));
+        REQUIRE(iUsage <= iMaxBytes);
+    }
+
+    const double bounded_bpc = bits_per_char(ppm, corpus.heldOut);
+    const double unbounded_bpc = bits_per_char(reference, corpus.heldOut);
+    printf("  learnt %zu MB; budget %ld nodes\n", iLearnt >> 20, iNodeBudget);
+    printf("  engine        nodes  max nodes    max MB  train/s  bits/char\n");
+    printf("  bounded   %9zu %10zu %9.1f %8.1f %10.3f\n", ppm.GetNodeCount(), iMaxNodes, iMaxUsage / 1e6,
+           ppmSeconds, bounded_bpc);
+    printf("  unbounded %9zu %10zu %9.1f %8.1f %10.3f\n", reference.GetNodeCount(), reference.GetNodeCount(),
+           reference.GetMemoryUsage() / 1e6, referenceSeconds, unbounded_bpc);
+    printf("  degradation %.3f bits/char (at most %.2f)\n", bounded_bpc - unbounded_bpc, MAX_DEGRADATION);
+    CHECK(bounded_bpc - unbounded_bpc < MAX_DEGRADATION);
+}
+
+} // namespace
+
+// Each learns the files it is given some 1.5 times over, with a budget of some 60% of the nodes
+//  an unbounded model grows to
+TEST_CASE("ppm learning 8 MB stays within its node budget") {
+    const Corpus corpus({"training_wa_de_Latn.txt", HELD_OUT_FILE, "training_wa_fr_Latn.txt"});
+    learn_within_budget(corpus, size_t(8) << 20, 625000);
+}
+
+TEST_CASE("bench/ppm learning 100 MB stays within its node budget" * doctest::skip()) {
+    learn_within_budget(Corpus(), size_t(100) << 20, 4000000);
+}
+
+TEST_CASE("contexts live across a prune stay usable") {
+    for (int iOrder : {3, 5}) {
+        CAPTURE(iOrder);
+        LMSettings settings(iOrder, true, 2000);
+        CPPMLanguageModel ppm(&settings.store, 30);
+
+        // A context after each of the first 500 symbols learnt, kept throughout
+        std::vector<CLanguageModel::Context> live;
+        CLanguageModel::Context ctx = ppm.CreateEmptyContext();
+        std::vector<unsigned int> probs;
+        size_t iPrunes = 0, iLastNodes = 0;
+        for (symbol sym : random_text(30, 20000, 1)) {
+            ppm.LearnSymbol(ctx, sym);
+            if (ppm.GetNodeCount() < iLastNodes) iPrunes++;
+            iLastNodes = ppm.GetNodeCount();
+            REQUIRE(ppm.GetNodeCount() <= 2000);
+            if (live.size() < 500) live.push_back(ppm.CloneContext(ctx));
+        }
+        ppm.ReleaseContext(ctx);
+        CHECK(iPrunes > 5);
+
+        for (CLanguageModel::Context c : live) {
+            ppm.GetProbs(c, probs, NORM, UNIFORM);
+            unsigned int iTotal = 0;
+            for (unsigned int p : probs)
+                iTotal += p;
+            CHECK_EQ(iTotal, static_cast<unsigned int>(NORM));
+            ppm.EnterSymbol(c, 1);
+            ppm.LearnSymbol(c, 2);
+            ppm.ReleaseContext(c);
+        }
+    }
+}
+
+TEST_CASE("snapshots are not shared between node budgets") {
+    ScopedTempDir dir;
+    const std::string strFile = dir.path + "/snapshot.bin";
+    const CPPMLanguageModel::SnapshotKey key{"test", 42};
+    const std::vector<symbol> text = random_text(30, 20000, 2);
+
+    LMSettings bounded(5, true, 2000);
+    CPPMLanguageModel ppm(&bounded.store, 30);
+    learn(ppm, text);
+    REQUIRE(ppm.WriteSnapshot(strFile, key));
+
+    LMSettings same(5, true, 2000), unbounded(5, true);
+    CPPMLanguageModel sameBudget(&same.store, 30), noBudget(&unbounded.store, 30);
+    CHECK(sameBudget.ReadSnapshot(strFile, key));
+    CHECK_EQ(sameBudget.GetNodeCount(), ppm.GetNodeCount());
+    CHECK_FALSE(noBudget.ReadSnapshot(strFile, key));
+}
@@ -0,0 +1,178 @@
+// PPM merge tests: CAbstractPPM::mergePPMProbs computes its uniform, leftover
+// and rounding passes in closed form, reusing scratch space between calls.
+// Its distributions must be bit-identical to those of the original four-pass
+// loop (kept below as the reference), for any alphabet size, order, alpha and
+// beta. Also prints GetProbs calls/sec of both at orders 2-6 for 30-, 100- and
+// 7000-symbol alphabets.
+//
+// Built via dasher_add_test_internal (drives CPPMLanguageModel directly).
+
+#include "test_common.h"
+
+#include "DasherCore/LanguageModelling/PPMLanguageModel.h"
+#include "DasherCore/Parameters.h"
+#include "DasherCore/SettingsStore.h"
+
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace Dasher;
+
+namespace {
+
+const int NORM = 1 << 16;
+const int UNIFORM = NORM * 50 / 1000;
+
+class CTestPPM : public CPPMLanguageModel {
+  public:
+    using CPPMLanguageModel::CPPMLanguageModel;
+
+    // mergePPMProbs as it was: a pass per phase, over every symbol, with integer divides
+    void GetReferenceProbs(Context context, std::vector<unsigned int>& probs, int norm, int iUniform) const {
+        const CPPMContext* ppmcontext = reinterpret_cast<const CPPMContext*>(context);
+        const int iNumSymbols = GetSize();
+        const int alpha = m_pSettingsStore->GetLongParameter(LP_LM_ALPHA);
+        const int beta = m_pSettingsStore->GetLongParameter(LP_LM_BETA);
+        probs.resize(iNumSymbols);
+        std::vector<bool> exclusions(iNumSymbols);
+        unsigned int iToSpend = norm;
+        unsigned int iUniformLeft = iUniform;
+        probs[0] = 0;
+        for (int i = 1; i < iNumSymbols; i++) {
+            probs[i] = iUniformLeft / (iNumSymbols - i);
+            iUniformLeft -= probs[i];
+            iToSpend -= probs[i];
+        }
+        std::vector<SymbolCount> childCounts;
+        for (CPPMnode* pTemp = ppmcontext->head; pTemp; pTemp = pTemp->vine) {
+            childCounts.clear();
+            collectChildCounts(pTemp, childCounts);
+            int iTotal = 0;
+            for (const auto& sc : childCounts)
+                iTotal += sc.count;
+            if (iTotal) {
+                unsigned int size_of_slice = iToSpend;
+                for (const auto& sc : childCounts) {
+                    exclusions[sc.sym] = true;
+                    unsigned int p =
+                        static_cast<myint>(size_of_slice) * (100 * sc.count - beta) / (100 * iTotal + alpha);
+                    probs[sc.sym] += p;
+                    iToSpend -= p;
+                }
+            }
+        }
+        unsigned int size_of_slice = iToSpend;
+        int symbolsleft = iNumSymbols - 1;
+        for (int i = 1; i < iNumSymbols; i++) {
+            unsigned int p = size_of_slice / symbolsleft;
+            probs[i] += p;
+            iToSpend -= p;
+        }
+        int iLeft = iNumSymbols - 1;
+        for (int i = 1; i < iNumSymbols; i++) {
+            unsigned int p = iToSpend / iLeft;
+            probs[i] += p;
+            --iLeft;
+            iToSpend -= p;
+        }
+    }
+};
+
+// Text over iNumSyms symbols (1..iNumSyms-1), Zipf-distributed, with each symbol
+//  also likely to repeat a short while later, so that contexts of every order recur
+std::vector<symbol> text(int iNumSyms, size_t iLength, unsigned int iSeed) {
+    std::mt19937 rng(iSeed);
+    std::vector<double> weights(iNumSyms - 1);
+    for (size_t i = 0; i < weights.size(); i++)
+        weights[i] = 1.0 / std::pow(static_cast<double>(i + 1), 1.1);
+    std::discrete_distribution<int> zipf(weights.begin(), weights.end());
+    std::vector<symbol> out;
+    for (size_t i = 0; i < iLength; i++) {
+        if (out.size() > 8 && rng() % 2) out.push_back(out[out.size() - 1 - rng() % 8]);
+        else out.push_back(zipf(rng) + 1);
+    }
+    return out;
+}
+
+struct Model {
+    CSettingsStore store;
+    std::unique_ptr<CTestPPM> ppm;
+    std::vector<CLanguageModel::Context> contexts; // at every position of some unseen text
+
+    Model(int iNumSyms, int iOrder, size_t iTrainLength = 100000, size_t iContexts = 500) {
+        store.AddParameters(Settings::parameter_defaults);
+        store.SetLongParameter(LP_LM_MAX_ORDER, iOrder);
+        ppm = std::make_unique<CTestPPM>(&store, iNumSyms);
+        CLanguageModel::Context ctx = ppm->CreateEmptyContext();
+        for (symbol sym : text(iNumSyms, iTrainLength, 1))
+            ppm->LearnSymbol(ctx, sym);
+        ppm->ReleaseContext(ctx);
+
+        ctx = ppm->CreateEmptyContext();
+        for (symbol sym : text(iNumSyms, iContexts, 2)) {
+            ppm->EnterSymbol(ctx, sym);
+            contexts.push_back(ppm->CloneContext(ctx));
+        }
+        ppm->ReleaseContext(ctx);
+    }
+    ~Model() {
+        for (CLanguageModel::Context ctx : contexts)
+            ppm->ReleaseContext(ctx);
+    }
+
+    // GetProbs (or the reference) calls per second, over all the contexts
+    double calls_per_second(bool bReference) const {
+        std::vector<unsigned int> probs;
+        size_t iCalls = 0;
+        const auto start = std::chrono::steady_clock::now();
+        double seconds = 0;
+        while (seconds < 0.1) {
+            for (CLanguageModel::Context ctx : contexts) {
+                if (bReference) ppm->GetReferenceProbs(ctx, probs, NORM, UNIFORM);
+                else ppm->GetProbs(ctx, probs, NORM, UNIFORM);
+            }
+            iCalls += contexts.size();
+            seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        return iCalls / seconds;
+    }
+};
+
+} // namespace
+
+TEST_CASE("merged probabilities are bit-identical to the four-pass loop") {
+    for (int iNumSyms : {2, 3, 30, 100, 7000}) {
+        for (int iOrder : {2, 4, 6}) {
+            Model model(iNumSyms, iOrder, 20000, 200);
+            // Defaults, then a beta large enough that rare symbols get "negative" mass, which wraps
+            for (auto [alpha, beta] : {std::pair<int, int>{49, 77}, {1, 250}, {1000, 0}}) {
+                CAPTURE(iNumSyms);
+                CAPTURE(iOrder);
+                CAPTURE(beta);
+                model.store.SetLongParameter(LP_LM_ALPHA, alpha);
+                model.store.SetLongParameter(LP_LM_BETA, beta);
+                std::vector<unsigned int> got, want;
+                for (CLanguageModel::Context ctx : model.contexts) {
+                    model.ppm->GetProbs(ctx, got, NORM, UNIFORM);
+                    model.ppm->GetReferenceProbs(ctx, want, NORM, UNIFORM);
+                    REQUIRE_EQ(got, want);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("bench/GetProbs calls per second at orders 2-6") {
+    printf("  symbols order    before/s     after/s\n");
+    for (int iNumSyms : {30, 100, 7000}) {
+        for (int iOrder = 2; iOrder <= 6; iOrder++) {
+            Model model(iNumSyms, iOrder);
+            const double before = model.calls_per_second(true);
+            const double after = model.calls_per_second(false);
+            printf("  %7d %5d %11.0f %11.0f (x%.2f)\n", iNumSyms, iOrder, before, after, after / before);
+        }
+    }
+}
@@ -0,0 +1,169 @@
+// PPM snapshot tests: the trained PPM trie is cached in the user dir after
+// training, and a later context with the same alphabet, training files and
+// LM settings loads it instead of retraining. Loading must reproduce the
+// trained model exactly; anything stale or corrupt must fall back to training.
+// The snapshot is of the system text only: the user's own is learnt on top.
+// A new snapshot replaces the old by rename, never overwriting it in place.
+#include "test_common.h"
+
+#include <chrono>
+#include <vector>
+
+namespace {
+
+std::vector<std::filesystem::path> snapshot_files(const std::string& dir) {
+    std::vector<std::filesystem::path> out;
+    for (auto& entry : std::filesystem::directory_iterator(dir)) {
+        const std::string name = entry.path().filename().string();
+        if (name.rfind("ppm_", 0) == 0 && entry.path().extension() == ".snapshot") out.push_back(entry.path());
+    }
+    return out;
+}
+
+// Creates a context on user dir `dir`, returning the probabilities at the
+// crosshair and how long it took to become usable (realization, which is
+// where the LM is trained, happens on the first dasher_set_screen_size).
+std::vector<int> create_and_probe(const ScopedTempDir& dir, double* seconds = nullptr) {
+    auto start = std::chrono::steady_clock::now();
+    dasher_ctx* ctx = dasher_create(TEST_DATA_DIR, dir.c_str(), nullptr);
+    REQUIRE(ctx);
+    dasher_set_screen_size(ctx, 800, 600);
+    if (seconds) *seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    auto probs = probabilities(ctx);
+    dasher_destroy(ctx);
+    return probs;
+}
+
+// Creates a context on user dir `dir` as create_and_probe does, returning the messages it shows
+std::vector<std::string> create_and_collect_messages(const ScopedTempDir& dir) {
+    dasher_ctx* ctx = dasher_create(TEST_DATA_DIR, dir.c_str(), nullptr);
+    REQUIRE(ctx);
+    std::vector<std::string> messages;
+    dasher_set_message_callback(
+        ctx,
+        [](int, const char* text, void* user_data) {
+            if (text) static_cast<std::vector<std::string>*>(user_data)->push_back(text);
+        },
+        &messages);
+    dasher_set_screen_size(ctx, 800, 600);
+    run_frames(ctx, 5);
+    dasher_destroy(ctx);
+    return messages;
+}
+
+bool any_starts_with(const std::vector<std::string>& messages, const std::string& prefix) {
+    return std::any_of(messages.begin(), messages.end(),
+                       [&prefix](const std::string& msg) { return msg.rfind(prefix, 0) == 0; });
+}
+
+} // namespace
+
+TEST_CASE("ppm snapshot is written after training") {
+    ScopedTempDir dir;
+    auto probs = create_and_probe(dir);
+    REQUIRE(!probs.empty());
+    CHECK_EQ(snapshot_files(dir.path).size(), 1u);
+}
+
+TEST_CASE("ppm snapshot reload reproduces trained probabilities") {
+    ScopedTempDir dir;
+    double trainSecs = 0, loadSecs = 0;
+    auto trained = create_and_probe(dir, &trainSecs);
+    REQUIRE(snapshot_files(dir.path).size() == 1u);
+    auto loaded = create_and_probe(dir, &loadSecs);
+    printf("  startup: %.3fs training, %.3fs from snapshot\n", trainSecs, loadSecs);
+    REQUIRE(!trained.empty());
+    CHECK_EQ(trained, loaded);
+
+    // A fresh context that never saw the snapshot must agree too.
+    ScopedTempDir other;
+    CHECK_EQ(create_and_probe(other), loaded);
+}
+
+TEST_CASE("corrupt ppm snapshot falls back to training") {
+    ScopedTempDir dir;
+    auto trained = create_and_probe(dir);
+    auto files = snapshot_files(dir.path);
+    REQUIRE(files.size() == 1u);
+    const auto size = std::filesystem::file_size(files[0]);
+
+    SUBCASE("truncated") {
+        std::filesystem::resize_file(files[0], size / 2);
+    }
+    SUBCASE("garbage records") {
+        std::fstream f(files[0], std::ios::in | std::ios::out | std::ios::binary);
+        f.seekp(static_cast<std::streamoff>(size - 64));
+        const std::string junk(64, '\xff');
+        f.write(junk.data(), junk.size());
+    }
+    SUBCASE("different max order") {
+        // iMaxOrder follows the 8-byte magic and three 32-bit fields.
+        std::fstream f(files[0], std::ios::in | std::ios::out | std::ios::binary);
+        f.seekp(20);
+        const int32_t order = 99;
+        f.write(reinterpret_cast<const char*>(&order), sizeof(order));
+    }
+    SUBCASE("wrong magic") {
+        std::fstream f(files[0], std::ios::in | std::ios::out | std::ios::binary);
+        f.write("XXXX", 4);
+    }
+
+    CHECK_EQ(create_and_probe(dir), trained);
+    // Retraining rewrote a valid snapshot.
+    CHECK_EQ(std::filesystem::file_size(files[0]), size);
+}
+
+TEST_CASE("a rewritten ppm snapshot replaces the old one rather than overwriting it") {
+    ScopedTempDir dir, keep;
+    auto trained = create_and_probe(dir);
+    auto files = snapshot_files(dir.path);
+    REQUIRE(files.size() == 1u);
+    const auto size = std::filesystem::file_size(files[0]);
+    std::filesystem::resize_file(files[0], size / 2); // so it is retrained and written again
+    // A second name for the old file: written in place, it would change too
+    const std::filesystem::path old = std::filesystem::path(keep.path) / "old.snapshot";
+    std::error_code ec;
+    std::filesystem::create_hard_link(files[0], old, ec);
+    if (ec) return; // (no hard links on this filesystem)
+
+    CHECK_EQ(create_and_probe(dir), trained);
+    CHECK_EQ(std::filesystem::file_size(files[0]), size);
+    CHECK_EQ(std::filesystem::file_size(old), size / 2);
+    for (auto& entry : std::filesystem::directory_iterator(dir.path))
+        CHECK(entry.path().filename().string().find(".tmp") == std::string::npos);
+}
+
+TEST_CASE("the user's own text is learnt on top of the snapshot, which it leaves valid") {
+    ScopedTempDir dir;
+    const auto without = create_and_probe(dir);
+    auto files = snapshot_files(dir.path);
+    REQUIRE(files.size() == 1u);
+    const auto written = std::filesystem::last_write_time(files[0]);
+
+    // As a session writing would leave it: the user's training text, which changes with every such session
+    std::string text;
+    for (int i = 0; i < 200; i++)
+        text += "qqqq zyxxy jjjj ";
+    std::ofstream(std::filesystem::path(dir.path) / "training_english_GB.txt") << text;
+    dasher_invalidate_file_index();
+    const auto with = create_and_probe(dir);
+    CHECK(with != without);
+    CHECK_EQ(std::filesystem::last_write_time(files[0]), written); // loaded, not retrained and rewritten
+
+    // Exactly as if trained from scratch on both
+    ScopedTempDir other;
+    std::ofstream(std::filesystem::path(other.path) / "training_english_GB.txt") << text;
+    CHECK_EQ(create_and_probe(other), with);
+}
+
+TEST_CASE("without user text, training warns of that, whether or not from the snapshot") {
+    // (the data dir's text is system text, even where the data dir is writable, as in a checkout)
+    ScopedTempDir dir;
+    for (int i = 0; i < 2; i++) {
+        CAPTURE(i); // trained, then loaded from the snapshot
+        const auto messages = create_and_collect_messages(dir);
+        CHECK(any_starts_with(messages, "No user training text found"));
+        CHECK(!any_starts_with(messages, "No training text"));
+        CHECK_EQ(snapshot_files(dir.path).size(), 1u);
+    }
+}
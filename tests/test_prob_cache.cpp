@@ -0,0 +1,125 @@
+// Probability cache tests: the alphabet manager keeps the cumulative
+// probabilities it last computed for each LM context in an LRU cache, keyed by
+// the context's node and order in the trie, the model's generation and the
+// normalisation. Nodes rebuilt for a context seen recently (zooming back out
+// and in again, or resetting) must hit the cache and get exactly what the
+// model would compute; once the model learns, or a setting of the model
+// changes, the old entries must miss (but not when other settings change).
+#include "test_common.h"
+
+#include <vector>
+
+namespace {
+
+struct CacheStats {
+    long long hits = 0, misses = 0;
+};
+
+CacheStats stats(dasher_ctx* ctx) {
+    CacheStats s;
+    REQUIRE_EQ(dasher_get_prob_cache_stats(ctx, &s.hits, &s.misses), 0);
+    return s;
+}
+
+// Steers towards (x, y) for a number of frames
+int64_t steer(dasher_ctx* ctx, float x, float y, int frames, int64_t time_ms) {
+    for (int i = 0; i < frames; i++) {
+        dasher_mouse_move(ctx, x, y);
+        run_frames(ctx, 1, time_ms += 20);
+    }
+    return time_ms;
+}
+
+} // namespace
+
+TEST_CASE("zooming out and back in hits the cache") {
+    ScopedContext ctx(800, 600);
+    dasher_set_speed_percent(ctx, 300);
+    run_frames(ctx, 2);
+    const CacheStats start = stats(ctx);
+    CHECK(start.misses > 0);
+
+    dasher_mouse_move(ctx, 700.0f, 300.0f);
+    dasher_mouse_down(ctx);
+    int64_t time_ms = steer(ctx, 700.0f, 280.0f, 150, 2000);
+    const CacheStats zoomedIn = stats(ctx);
+    CHECK(zoomedIn.misses > start.misses);
+    // Back out (rebuilding parents of the root), then in again, over the same ground
+    time_ms = steer(ctx, 50.0f, 300.0f, 150, time_ms);
+    time_ms = steer(ctx, 700.0f, 280.0f, 150, time_ms);
+    dasher_mouse_up(ctx);
+
+    const CacheStats end = stats(ctx);
+    const long long iLookups = end.hits + end.misses - start.hits - start.misses;
+    printf("  %lld lookups zooming in, out and in: %lld hits (%.0f%%)\n", iLookups, end.hits - start.hits,
+           100.0 * (end.hits - start.hits) / iLookups);
+    CHECK(end.hits > zoomedIn.hits);
+}
+
+TEST_CASE("cached probabilities are those the model computes") {
+    ScopedContext ctx(800, 600), fresh(800, 600);
+    run_frames(ctx, 2);
+    run_frames(fresh, 2);
+    const std::vector<int> expected = probabilities(fresh);
+    REQUIRE(!expected.empty());
+
+    // Rebuilding the root asks for the same context again
+    for (int i = 0; i < 3; i++) {
+        const CacheStats before = stats(ctx);
+        dasher_reset(ctx);
+        run_frames(ctx, 2, 2000 + i * 100);
+        CHECK(stats(ctx).hits > before.hits);
+        CHECK_EQ(probabilities(ctx), expected);
+    }
+}
+
+TEST_CASE("learning invalidates the cache") {
+    ScopedContext ctx(800, 600), fresh(800, 600);
+    run_frames(ctx, 2);
+    const std::vector<int> untrained = probabilities(ctx);
+
+    const char* text = "zzzz zzzz zzzz zzzz zzzz zzzz zzzz zzzz ";
+    REQUIRE_EQ(dasher_import_training_text(ctx, text), 0);
+    REQUIRE_EQ(dasher_import_training_text(fresh, text), 0);
+
+    const CacheStats before = stats(ctx);
+    dasher_reset(ctx);
+    dasher_reset(fresh);
+    run_frames(ctx, 2, 2000);
+    run_frames(fresh, 2, 2000);
+    const CacheStats after = stats(ctx);
+    CHECK(after.misses > before.misses);
+    CHECK_EQ(after.hits, before.hits);
+
+    const std::vector<int> trained = probabilities(ctx);
+    CHECK_EQ(trained, probabilities(fresh));
+    CHECK_NE(trained, untrained);
+}
+
+TEST_CASE("only the settings probabilities depend on clear the cache") {
+    ScopedContext ctx(800, 600), fresh(800, 600);
+    run_frames(ctx, 2);
+
+    // Speed has nothing to do with the model: rebuilding the root still hits
+    CacheStats before = stats(ctx);
+    dasher_set_speed_percent(ctx, 300);
+    dasher_reset(ctx);
+    run_frames(ctx, 2, 2000);
+    CHECK(stats(ctx).hits > before.hits);
+
+    // ...but the LM's alpha changes them all
+    before = stats(ctx);
+    set_long(ctx, "LP_LM_ALPHA", 20);
+    set_long(fresh, "LP_LM_ALPHA", 20);
+    dasher_reset(ctx);
+    dasher_reset(fresh);
+    run_frames(ctx, 2, 2100);
+    run_frames(fresh, 2, 2100);
+    CHECK_EQ(stats(ctx).hits, before.hits);
+    CHECK_EQ(probabilities(ctx), probabilities(fresh));
+}
+
+TEST_CASE("stats need a realized context") {
+    long long hits = -1, misses = -1;
+    CHECK_EQ(dasher_get_prob_cache_stats(nullptr, &hits, &misses), -1);
+}
@@ -0,0 +1,96 @@
+// Render culling tests: each node keeps its children's Hbnds in one array,
+// and the view binary searches it for the first child not wholly above the
+// screen, so the children before it are skipped without being visited. Every
+// node drawn must be counted as visited (or be the root), and skipping must
+// happen as soon as the view zooms past the top children; the visited,
+// drawn and skipped counts are printed zooming into the large Mandarin and
+// Japanese alphabets, where a node has hundreds of children.
+#include "test_common.h"
+
+#include <chrono>
+#include <string>
+
+namespace {
+
+struct Totals {
+    long visited = 0;
+    long drawn = 0;
+    long skipped = 0;
+    int frames = 0;
+};
+
+// Zooms towards the given height on the canvas, adding up the render stats
+Totals zoom(dasher_ctx* ctx, float y, int frames, int64_t start_ms) {
+    Totals totals;
+    dasher_mouse_move(ctx, 700.0f, y);
+    dasher_mouse_down(ctx);
+    dasher_mouse_up(ctx);
+    for (int i = 0; i < frames; i++) {
+        dasher_mouse_move(ctx, 700.0f, y);
+        int* cmds = nullptr;
+        int cmd_count = 0;
+        char** strs = nullptr;
+        int str_count = 0;
+        dasher_frame(ctx, start_ms + i * 16, &cmds, &cmd_count, &strs, &str_count);
+        int visited = 0, drawn = 0, skipped = 0;
+        REQUIRE_EQ(dasher_get_render_stats(ctx, &visited, &drawn, &skipped), 0);
+        // Every node drawn but the root was visited first
+        CHECK(drawn <= visited + 1);
+        totals.visited += visited;
+        totals.drawn += drawn;
+        totals.skipped += skipped;
+        totals.frames++;
+    }
+    dasher_mouse_down(ctx);
+    dasher_mouse_up(ctx);
+    return totals;
+}
+
+} // namespace
+
+TEST_CASE("children above the screen are skipped") {
+    ScopedContext ctx(800, 600);
+    run_frames(ctx, 5);
+    int visited = 0, drawn = 0, skipped = -1;
+    REQUIRE_EQ(dasher_get_render_stats(ctx, &visited, &drawn, &skipped), 0);
+    CHECK(drawn > 20);
+    CHECK_EQ(skipped, 0); // nothing is above the screen yet
+
+    // Zooming towards the bottom leaves the first children above the screen
+    const Totals totals = zoom(ctx, 560.0f, 100, 2000);
+    CHECK(totals.skipped > 0);
+    CHECK(totals.drawn > totals.frames * 10);
+}
+
+TEST_CASE("bench/culling on large alphabets") {
+    const char* alphabets[] = {"Mandarin (trad) via ㄅㄆㄇㄈ (Bopomofo)", "Japanese Canna", "Hiragana ひらがな 83"};
+    for (const char* alphabet : alphabets) {
+        CAPTURE(alphabet);
+        ScopedContext ctx(1280, 800);
+        dasher_set_alphabet_id(ctx, alphabet);
+        REQUIRE(std::string(dasher_get_alphabet_id(ctx)) == alphabet);
+        run_frames(ctx, 5);
+        long visited = 0, drawn = 0, skipped = 0;
+        int frames = 0;
+        const auto t0 = std::chrono::steady_clock::now();
+        // Down the screen, then up it, then down again
+        for (float y : {700.0f, 150.0f, 650.0f}) {
+            const Totals totals = zoom(ctx, y, 150, 2000 + frames * 16);
+            visited += totals.visited;
+            drawn += totals.drawn;
+            skipped += totals.skipped;
+            frames += totals.frames;
+        }
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        printf("  %s: per frame %.0f visited, %.0f drawn, %.0f skipped above the screen (%.3f ms/frame)\n", alphabet,
+               static_cast<double>(visited) / frames, static_cast<double>(drawn) / frames,
+               static_cast<double>(skipped) / frames, ms / frames);
+        CHECK(drawn > 0);
+        CHECK(skipped > 0);
+    }
+}
+
+TEST_CASE("render stats need a realized context") {
+    int visited = 0;
+    CHECK_EQ(dasher_get_render_stats(nullptr, &visited, nullptr, nullptr), -1);
+}
@@ -0,0 +1,103 @@
+// Render settings snapshot tests: the settings read for every node drawn and
+// every frame moved (shape, outline width, nonlinearity, dynamics...) are
+// kept in one packed SRenderSettings, refreshed only when one of them
+// changes, instead of each being looked up in the settings store's map every
+// time. The store counts its lookups (in debug builds): per frame they must
+// stay a handful, whatever the number of nodes drawn; and changing any of the
+// settings must still take effect on the next frame.
+#include "test_common.h"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+// Settings lookups made by count frames
+double lookups_per_frame(dasher_ctx* ctx, int count, int64_t start_ms) {
+    const long long iBefore = dasher_get_settings_lookup_count(ctx);
+    run_frames(ctx, count, start_ms);
+    return static_cast<double>(dasher_get_settings_lookup_count(ctx) - iBefore) / count;
+}
+
+// Nodes drawn by the last frame (needs capture enabled)
+int visible_nodes(dasher_ctx* ctx) {
+    dasher_node_info node = {};
+    node.struct_size = sizeof(node);
+    char** strs = nullptr;
+    int str_count = 0;
+    return dasher_get_visible_nodes(ctx, &node, 1, &strs, &str_count);
+}
+
+std::vector<int> frame_commands(dasher_ctx* ctx, int64_t time_ms) {
+    int* cmds = nullptr;
+    int cmd_count = 0;
+    char** strs = nullptr;
+    int str_count = 0;
+    dasher_frame(ctx, time_ms, &cmds, &cmd_count, &strs, &str_count);
+    return std::vector<int>(cmds, cmds + cmd_count);
+}
+
+} // namespace
+
+TEST_CASE("bench/settings lookups per frame do not grow with the nodes drawn") {
+    for (auto size : {std::make_pair(800, 600), std::make_pair(3840, 2160)}) {
+        CAPTURE(size.first);
+        ScopedContext ctx(size.first, size.second);
+        if (dasher_get_settings_lookup_count(ctx) < 0) {
+            MESSAGE("settings lookups are only counted in debug builds");
+            return;
+        }
+        dasher_set_visible_nodes_enabled(ctx, 1);
+        run_frames(ctx, 20);
+        const double steady = lookups_per_frame(ctx, 50, 2000);
+        const int iNodes = visible_nodes(ctx);
+
+        dasher_mouse_move(ctx, size.first * 0.85f, size.second * 0.45f);
+        dasher_mouse_down(ctx);
+        dasher_mouse_up(ctx);
+        const double moving = lookups_per_frame(ctx, 100, 4000);
+        dasher_mouse_down(ctx);
+        dasher_mouse_up(ctx);
+
+        printf("  %4dx%-4d %4d nodes drawn: %6.1f lookups/frame steady, %6.1f moving\n", size.first, size.second,
+               iNodes, steady, moving);
+        CHECK(iNodes > 20);
+        CHECK(steady < 5);
+        CHECK(moving < 20);
+    }
+}
+
+TEST_CASE("changed render settings take effect on the next frame") {
+    ScopedContext ctx(800, 600);
+    const int64_t time_ms = settle(ctx);
+    const std::vector<int> before = frame_commands(ctx, time_ms);
+    REQUIRE(!before.empty());
+    CHECK_EQ(frame_commands(ctx, time_ms + 16), before);
+
+    for (const char* name : {"LP_SHAPE_TYPE", "LP_OUTLINE_WIDTH", "LP_DASHER_FONTSIZE", "LP_NONLINEAR_X"}) {
+        const std::string strName(name);
+        CAPTURE(strName);
+        const int key = dasher_find_parameter_key(name);
+        REQUIRE(key >= 0);
+        const long old = dasher_get_long_parameter(ctx, key);
+        dasher_set_long_parameter(ctx, key, old + 2);
+        CHECK_NE(frame_commands(ctx, time_ms + 1000), before);
+        dasher_set_long_parameter(ctx, key, old);
+        CHECK_EQ(frame_commands(ctx, time_ms + 1016), before);
+    }
+    for (const char* name : {"BP_DRAW_MOUSE", "BP_DRAW_MOUSE_LINE"}) {
+        const std::string strName(name);
+        CAPTURE(strName);
+        const int key = dasher_find_parameter_key(name);
+        REQUIRE(key >= 0);
+        const bool old = dasher_get_bool_parameter(ctx, key);
+        dasher_set_bool_parameter(ctx, key, !old);
+        CHECK_NE(frame_commands(ctx, time_ms + 2000), before);
+        dasher_set_bool_parameter(ctx, key, old);
+        CHECK_EQ(frame_commands(ctx, time_ms + 2016), before);
+    }
+}
+
+TEST_CASE("lookup count needs a context") {
+    CHECK_EQ(dasher_get_settings_lookup_count(nullptr), -1);
+}
@@ -0,0 +1,125 @@
+// Subtree cache tests: with LP_SUBTREE_CACHE set, the children of nodes
+// collapsed (too small, or offscreen) are parked, with their descendants, and
+// given back when the node is expanded again - as when the user reverses over
+// what they just zoomed away from. Going back and forth (writing, and correcting
+// some of it) must then re-expand nodes from the cache, creating fewer nodes,
+// and write exactly the same text; the cache must keep within its size,
+// evicting the sets least recently parked, and be emptied with the tree. The
+// benchmark goes back and forth at 400% speed, printing the hit rate, nodes
+// created per frame and frame times, with caches of several sizes and none.
+#include "test_common.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct CacheStats {
+    long long hits = 0, misses = 0, evicted = 0, bytes = 0;
+};
+
+CacheStats cache_stats(dasher_ctx* ctx) {
+    CacheStats stats;
+    REQUIRE_EQ(dasher_get_subtree_cache_stats(ctx, &stats.hits, &stats.misses, &stats.evicted, &stats.bytes), 0);
+    return stats;
+}
+
+long long nodes_allocated(dasher_ctx* ctx) {
+    long long count = 0;
+    REQUIRE_EQ(dasher_get_node_pool_stats(ctx, nullptr, nullptr, &count, nullptr), 0);
+    return count;
+}
+
+// Zooms in for 50 frames, then back out for 30, over and over - writing, and correcting
+//  some of it - steering up and down (so the same way each time in); times each frame
+void steer(dasher_ctx* ctx, int frames, int64_t start_ms, std::vector<double>* frame_us = nullptr) {
+    for (int i = 0; i < frames; i++) {
+        const bool in = i % 80 < 50;
+        const auto t0 = std::chrono::steady_clock::now();
+        steer_frame(ctx, i, start_ms, in ? 780.0f : 300.0f, 10);
+        if (frame_us)
+            frame_us->push_back(
+                std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count());
+    }
+}
+
+struct Run {
+    CacheStats stats;
+    long long created = 0; // nodes
+    std::vector<double> frame_us;
+    std::string text;
+};
+
+Run back_and_forth(long cache_kb, int frames) {
+    ScopedContext ctx(800, 600);
+    set_long(ctx, "LP_SUBTREE_CACHE", cache_kb);
+    start_zooming(ctx, 780.0f);
+    Run run;
+    const long long created0 = nodes_allocated(ctx);
+    steer(ctx, frames, 2000, &run.frame_us);
+    dasher_mouse_down(ctx);
+    dasher_mouse_up(ctx);
+    run.stats = cache_stats(ctx);
+    run.created = nodes_allocated(ctx) - created0;
+    run.text = dasher_get_output_text(ctx);
+    return run;
+}
+
+} // namespace
+
+TEST_CASE("going back and forth re-expands nodes from the cache, and writes the same") {
+    const Run off = back_and_forth(0, 800);
+    const Run on = back_and_forth(4096, 800);
+    CHECK_EQ(off.stats.hits, 0);
+    CHECK_EQ(off.stats.misses, 0);
+    CHECK(on.stats.hits > 0);
+    CHECK(on.stats.hits > on.stats.misses);
+    // (what is written anew still needs new nodes)
+    CHECK(on.created * 5 < off.created * 4);
+    CHECK(!off.text.empty());
+    CHECK(on.text == off.text);
+}
+
+TEST_CASE("the cache keeps within its size") {
+    const Run run = back_and_forth(64, 800);
+    CHECK(run.stats.hits > 0);
+    CHECK(run.stats.evicted > 0);
+    CHECK(run.stats.bytes <= 64 * 1024);
+}
+
+TEST_CASE("the cache is emptied with the tree, and when turned off") {
+    ScopedContext ctx(800, 600);
+    set_long(ctx, "LP_SUBTREE_CACHE", 4096);
+    start_zooming(ctx, 780.0f);
+    steer(ctx, 200, 2000);
+    REQUIRE(cache_stats(ctx).bytes > 0);
+    // Changing alphabet rebuilds the tree, deleting every node parked with its parent
+    dasher_set_alphabet_id(ctx, "Hiragana ひらがな 83");
+    CHECK_EQ(cache_stats(ctx).bytes, 0);
+    start_zooming(ctx, 780.0f);
+    steer(ctx, 200, 20000);
+    REQUIRE(cache_stats(ctx).bytes > 0);
+    set_long(ctx, "LP_SUBTREE_CACHE", 0);
+    CHECK_EQ(cache_stats(ctx).bytes, 0);
+    long long live = 0, allocated = 0, freed = 0;
+    REQUIRE_EQ(dasher_get_node_pool_stats(ctx, &live, nullptr, &allocated, &freed), 0);
+    CHECK_EQ(allocated - freed, live);
+}
+
+TEST_CASE("bench/going back and forth at 400%, with and without the subtree cache") {
+    for (long cache_kb : {0L, 256L, 1024L, 4096L}) {
+        const Run run = back_and_forth(cache_kb, 2400);
+        const long long reexpanded = run.stats.hits + run.stats.misses;
+        printf("  %4ld KB: %5.1f%% of %lld re-expansions hit, %lld evicted; %.1f nodes created per frame; "
+               "frame p50 %.0f us, p99 %.0f us\n",
+               cache_kb, reexpanded ? 100.0 * run.stats.hits / reexpanded : 0.0, reexpanded, run.stats.evicted,
+               static_cast<double>(run.created) / run.frame_us.size(), percentile(run.frame_us, 0.50),
+               percentile(run.frame_us, 0.99));
+    }
+}
+
+TEST_CASE("subtree cache stats need a realized context") {
+    long long hits = 0;
+    CHECK_EQ(dasher_get_subtree_cache_stats(nullptr, &hits, nullptr, nullptr, nullptr), -1);
+}
@@ -0,0 +1,140 @@
+// Text metrics tests: a frontend's text measuring callback gives the label
+// sizes the view lays text out by, and each label is measured once per font
+// size bucket, the result cached until the fonts change. So the callback's
+// sizes must change the layout; steady frames must not call back at all;
+// zooming must be served almost entirely from the cache (the hit rate is
+// printed); and changing the font, resizing or invalidating must measure
+// again.
+#include "test_common.h"
+
+#include <set>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Measurer {
+    int calls = 0;
+    int scale = 1; // times the default estimate of half the font size per character
+    std::set<int> sizes;
+
+    static void measure(const char* text, int font_size, int, int* out_width, int* out_height, void* user_data) {
+        Measurer* self = static_cast<Measurer*>(user_data);
+        self->calls++;
+        self->sizes.insert(font_size);
+        *out_width = static_cast<int>(std::strlen(text)) * font_size * self->scale / 2;
+        *out_height = font_size;
+    }
+};
+
+std::vector<int> frame_commands(dasher_ctx* ctx, int64_t time_ms) {
+    int* cmds = nullptr;
+    int cmd_count = 0;
+    char** strs = nullptr;
+    int str_count = 0;
+    dasher_frame(ctx, time_ms, &cmds, &cmd_count, &strs, &str_count);
+    return std::vector<int>(cmds, cmds + cmd_count);
+}
+
+// Text commands' positions
+std::vector<int> text_positions(const std::vector<int>& cmds) {
+    std::vector<int> out;
+    for (size_t i = 0; i + 6 <= cmds.size(); i += 6)
+        if (cmds[i] == 5) out.insert(out.end(), {cmds[i + 1], cmds[i + 2]});
+    return out;
+}
+
+} // namespace
+
+TEST_CASE("measured text sizes lay out the labels") {
+    // (Zoomed in a way, so child labels sit inside their parents' and get pushed clear)
+    ScopedContext plain(800, 600);
+    ScopedContext measured(800, 600);
+    Measurer measurer;
+    measurer.scale = 4;
+    dasher_set_text_measure_callback(measured, &Measurer::measure, &measurer);
+    run_frames(plain, 10);
+    run_frames(measured, 10);
+    const std::vector<int> before = text_positions(frame_commands(plain, 2000));
+    const std::vector<int> after = text_positions(frame_commands(measured, 2000));
+    CHECK(measurer.calls > 0);
+    REQUIRE_EQ(before.size(), after.size());
+    CHECK(before != after);
+
+    // Without the callback, back to the estimate
+    dasher_set_text_measure_callback(measured, nullptr, nullptr);
+    CHECK(text_positions(frame_commands(measured, 2016)) == text_positions(frame_commands(plain, 2016)));
+}
+
+TEST_CASE("bench/text metrics are measured once and cached") {
+    ScopedContext ctx(800, 600);
+    Measurer measurer;
+    dasher_set_text_measure_callback(ctx, &Measurer::measure, &measurer);
+    run_frames(ctx, 20);
+
+    // Steady frames: no calls at all
+    const int iWarm = measurer.calls;
+    CHECK(iWarm > 0);
+    run_frames(ctx, 100, 2000);
+    CHECK_EQ(measurer.calls, iWarm);
+
+    // Zooming: nearly all from the cache
+    long long hits = 0, misses = 0;
+    REQUIRE_EQ(dasher_get_text_metrics_stats(ctx, &hits, &misses), 0);
+    const long long iHits0 = hits, iMisses0 = misses;
+    dasher_mouse_move(ctx, 680.0f, 280.0f);
+    dasher_mouse_down(ctx);
+    dasher_mouse_up(ctx);
+    for (int i = 0; i < 300; i++) {
+        dasher_mouse_move(ctx, 680.0f, 300.0f + 100.0f * ((i / 50) % 2 ? 1 : -1));
+        frame_commands(ctx, 4000 + i * 16);
+    }
+    dasher_mouse_down(ctx);
+    dasher_mouse_up(ctx);
+    REQUIRE_EQ(dasher_get_text_metrics_stats(ctx, &hits, &misses), 0);
+    hits -= iHits0;
+    misses -= iMisses0;
+    const double rate = static_cast<double>(hits) / std::max(1LL, hits + misses);
+    printf("  zooming 300 frames: %lld sizes from the cache, %lld measured (%.1f%% hits), %zu font sizes asked\n", hits,
+           misses, rate * 100, measurer.sizes.size());
+    CHECK(rate > 0.95);
+
+    // Only bucket sizes are measured: below 16 exact, then 8 steps per octave
+    for (int size : measurer.sizes) {
+        CAPTURE(size);
+        int iTop = 0;
+        while (size >> (iTop + 1))
+            iTop++;
+        if (size >= 16) CHECK_EQ(size & ((1 << (iTop - 3)) - 1), 0);
+    }
+}
+
+TEST_CASE("changed fonts are measured again") {
+    ScopedContext ctx(800, 600);
+    Measurer measurer;
+    dasher_set_text_measure_callback(ctx, &Measurer::measure, &measurer);
+    run_frames(ctx, 20);
+    int iCalls = measurer.calls;
+
+    dasher_invalidate_text_metrics(ctx);
+    run_frames(ctx, 2, 2000);
+    CHECK(measurer.calls > iCalls);
+    iCalls = measurer.calls;
+
+    const int fontKey = dasher_find_parameter_key("SP_DASHER_FONT");
+    REQUIRE(fontKey >= 0);
+    dasher_set_string_parameter(ctx, fontKey, "Some Other Font");
+    run_frames(ctx, 2, 3000);
+    CHECK(measurer.calls > iCalls);
+    iCalls = measurer.calls;
+
+    dasher_set_screen_size(ctx, 640, 480);
+    run_frames(ctx, 2, 4000);
+    CHECK(measurer.calls > iCalls);
+}
+
+TEST_CASE("text metrics need a context") {
+    dasher_set_text_measure_callback(nullptr, &Measurer::measure, nullptr);
+    dasher_invalidate_text_metrics(nullptr);
+    CHECK_EQ(dasher_get_text_metrics_stats(nullptr, nullptr, nullptr), -1);
+}
@@ -0,0 +1,88 @@
+// Thread safety tests: contexts share no state on the frame path, so each
+// may be driven on a thread of its own. 16 contexts, created, steered and
+// destroyed on 16 threads at once, must each write exactly what the same
+// steering writes with the context alone - as they would not if, say, one
+// context's nodes counted against another's node budget. Each thread also
+// reads the shared parameter schema and localized strings as it goes. The
+// races this is meant to catch are best seen built with -DDASHER_TSAN=ON.
+#include "test_common.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr int THREADS = 16;
+
+struct Run {
+    bool created = false;
+    std::string text;
+    long long frames = 0; // drawing anything
+};
+
+// Steers as other tests do, but up and down with a period differing for each thread,
+//  so each writes something different
+Run steer(int thread, int frames) {
+    Run run;
+    ScopedContext ctx(800, 600);
+    if (!ctx.ctx) return run;
+    run.created = true;
+    start_zooming(ctx, 780.0f);
+    const int period = 6 + thread;
+    for (int i = 0; i < frames; i++) {
+        if (steer_frame(ctx, i, 2000, 780.0f, period, 250.0f) > 0) run.frames++;
+        if (i % 50 == 0) {
+            dasher_parameter_info info;
+            dasher_get_parameter_info(i % dasher_get_parameter_count(), &info);
+            dasher_get_localized_string(ctx, "BP_BACKGROUND_TRAINING.label");
+        }
+    }
+    dasher_mouse_down(ctx);
+    dasher_mouse_up(ctx);
+    run.text = dasher_get_output_text(ctx);
+    return run;
+}
+
+} // namespace
+
+TEST_CASE("contexts driven on 16 threads at once write as each does alone") {
+    constexpr int FRAMES = 300;
+    std::vector<Run> alone;
+    for (int t = 0; t < THREADS; t++)
+        alone.push_back(steer(t, FRAMES));
+
+    // (doctest's REQUIRE can't throw across threads: results are checked once all have joined)
+    std::vector<Run> together(THREADS);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; t++)
+        threads.emplace_back([&together, t] { together[t] = steer(t, FRAMES); });
+    for (std::thread& thread : threads)
+        thread.join();
+
+    for (int t = 0; t < THREADS; t++) {
+        CAPTURE(t);
+        REQUIRE(alone[t].created);
+        REQUIRE(together[t].created);
+        CHECK(!alone[t].text.empty());
+        CHECK(together[t].text == alone[t].text);
+        CHECK_EQ(together[t].frames, FRAMES);
+    }
+}
+
+TEST_CASE("contexts failing to be created on several threads each get their own error") {
+    std::vector<std::string> errors(THREADS);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; t++)
+        threads.emplace_back([&errors, t] {
+            for (int i = 0; i < 100; i++) {
+                char* error = nullptr;
+                if (dasher_create(nullptr, nullptr, &error) || !error) return;
+                errors[t] = error;
+            }
+        });
+    for (std::thread& thread : threads)
+        thread.join();
+    for (const std::string& error : errors)
+        CHECK(error == "data_dir is NULL");
+}